@@ -457,7 +457,7 @@ impl<'a> Validator<'a> {
             .iter()
             .find_map(|(k, v)| if k.value.tag.is_some() { Some(v) } else { None });
 
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             let key_opt: Option<&str> = if entry.key.is_unit() {
                 None
             } else if let Some(s) = entry.key.as_str() {
@@ -664,7 +664,7 @@ impl<'a> Validator<'a> {
             }
         };
 
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             let key_str = match entry.key.as_str() {
                 Some(s) => s,
                 None => {
@@ -13,7 +13,7 @@
 //!   styx lsp                      - subcommand (bare word)
 //!   styx tree config.styx         - subcommand with file arg
 
-use std::io::{self, IsTerminal, Read};
+use std::io::{self, IsTerminal, Read, Write};
 use std::path::Path;
 
 use facet::Facet;
@@ -123,6 +123,17 @@ enum Command {
         file: String,
     },
 
+    /// Compile to the binary document format
+    Compile {
+        /// Input file
+        #[facet(args::positional)]
+        file: String,
+
+        /// Output file (default: input with a `.styxc` extension, "-" for stdout)
+        #[facet(args::named, args::short = 'o', default)]
+        output: Option<String>,
+    },
+
     /// Show CST structure
     Cst {
         /// Input file
@@ -188,7 +199,7 @@ enum Command {
         #[facet(args::named, default)]
         open: bool,
 
-        /// Clear all cached schemas
+        /// Clear all cached schemas and parsed documents
         #[facet(args::named, default)]
         clear: bool,
     },
@@ -217,7 +228,7 @@ enum Command {
         #[facet(args::named, default)]
         output: Option<String>,
 
-        /// Package name (for Go: defaults to schema basename)
+        /// Package name (Go) or file and symbol prefix (C); defaults to schema basename
         #[facet(args::named, default)]
         package: Option<String>,
     },
@@ -308,6 +319,7 @@ fn print_help() {
     eprintln!("SUBCOMMANDS:");
     eprintln!("    lsp                             Start language server (stdio)");
     eprintln!("    tree <file>                     Show parse tree");
+    eprintln!("    compile <file> [-o <out>]       Compile to binary format (.styxc)");
     eprintln!("    cst <file>                      Show CST structure");
     eprintln!("    extract <binary>                Extract embedded schemas");
     eprintln!("    diff <schema> --crate <name>    Compare against published version");
@@ -317,7 +329,9 @@ fn print_help() {
     eprintln!("    cache [--open|--clear]          Cache management");
     eprintln!("    skill                           Output Claude Code skill");
     eprintln!("    completions <shell>             Generate shell completions (bash, zsh, fish)");
-    eprintln!("    gen <lang> <schema>             Generate code from schema (go)\n");
+    eprintln!("    gen <lang> <schema>             Generate code from schema (go, c)\n");
+    eprintln!("ENVIRONMENT:");
+    eprintln!("    STYX_PARSE_CACHE=<dir>          Reuse parsed files across runs (see 'cache')\n");
     eprintln!("EXAMPLES:");
     eprintln!("    styx config.styx                Format and print to stdout");
     eprintln!("    styx config.styx --in-place     Format file in place");
@@ -361,7 +375,7 @@ fn run_file_mode(args: &[String]) -> Result<(), CliError> {
     };
 
     // Parse
-    let value = styx_tree::parse(&source).map_err(|e| CliError::ParseDiagnostic {
+    let value = parse_value_cached(&source).map_err(|e| CliError::ParseDiagnostic {
         error: e,
         source: source.clone(),
         filename: filename.clone(),
@@ -416,6 +430,7 @@ fn run_subcommand_mode(args: &[String]) -> Result<(), CliError> {
         Some(Command::Lexemes { file }) => run_lexemes(&file),
         Some(Command::Events { file }) => run_events(&file),
         Some(Command::Tree { format, file }) => run_tree(&format, &file),
+        Some(Command::Compile { file, output }) => run_compile(&file, output.as_deref()),
         Some(Command::Cst { file }) => run_cst(&file),
         Some(Command::Extract { binary }) => run_extract(&binary),
         Some(Command::Diff {
@@ -506,6 +521,12 @@ impl From<styx_gen_go::GenError> for CliError {
     }
 }
 
+impl From<styx_gen_c::GenError> for CliError {
+    fn from(e: styx_gen_c::GenError) -> Self {
+        CliError::Io(io::Error::other(e.to_string()))
+    }
+}
+
 // ============================================================================
 // Subcommand implementations
 // ============================================================================
@@ -583,6 +604,40 @@ fn run_tree(format: &str, file: &str) -> Result<(), CliError> {
     Ok(())
 }
 
+fn run_compile(file: &str, output: Option<&str>) -> Result<(), CliError> {
+    let source = read_input(Some(file))?;
+    let filename = if file == "-" { "<stdin>" } else { file };
+    let doc =
+        styx_tree::Document::parse_cached(&source).map_err(|e| CliError::ParseDiagnostic {
+            error: e,
+            source: source.clone(),
+            filename: filename.to_string(),
+        })?;
+
+    let output = match output {
+        Some(output) => output.to_string(),
+        None if file == "-" => {
+            return Err(CliError::Usage(
+                "--output is required when compiling from stdin".into(),
+            ));
+        }
+        None => Path::new(file)
+            .with_extension("styxc")
+            .to_string_lossy()
+            .into_owned(),
+    };
+
+    let bytes = doc
+        .compile()
+        .map_err(|e| CliError::Io(io::Error::new(io::ErrorKind::InvalidData, e)))?;
+    if output == "-" {
+        io::stdout().write_all(&bytes)?;
+    } else {
+        std::fs::write(&output, &bytes)?;
+    }
+    Ok(())
+}
+
 fn run_cst(file: &str) -> Result<(), CliError> {
     let source = read_input(Some(file))?;
     let parsed = styx_cst::parse(&source);
@@ -652,50 +707,59 @@ fn run_gen(
     output: Option<&str>,
     package: Option<&str>,
 ) -> Result<(), CliError> {
-    match language.to_lowercase().as_str() {
-        "go" => {
-            // Load and parse schema
-            let schema_content = std::fs::read_to_string(schema_file).map_err(|e| {
-                CliError::Io(io::Error::new(
-                    e.kind(),
-                    format!("schema file '{}': {}", schema_file, e),
-                ))
-            })?;
+    let language = language.to_lowercase();
+    if !matches!(language.as_str(), "go" | "c") {
+        return Err(CliError::Usage(format!(
+            "unknown language '{}', expected: go, c",
+            language
+        )));
+    }
 
-            let schema: facet_styx::SchemaFile = facet_styx::from_str(&schema_content)
-                .map_err(|e| CliError::Parse(format!("failed to parse schema: {}", e)))?;
+    // Load and parse schema
+    let schema_content = std::fs::read_to_string(schema_file).map_err(|e| {
+        CliError::Io(io::Error::new(
+            e.kind(),
+            format!("schema file '{}': {}", schema_file, e),
+        ))
+    })?;
 
-            // Determine package name
-            let pkg_name = package.unwrap_or_else(|| {
-                Path::new(schema_file)
-                    .file_stem()
-                    .and_then(|s| s.to_str())
-                    .unwrap_or("config")
-            });
+    let schema: facet_styx::SchemaFile = facet_styx::from_str(&schema_content)
+        .map_err(|e| CliError::Parse(format!("failed to parse schema: {}", e)))?;
 
-            // Sanitize package name for Go (replace hyphens with underscores)
-            let sanitized_pkg_name = pkg_name.replace('-', "_");
+    // Determine package name
+    let pkg_name = package.unwrap_or_else(|| {
+        Path::new(schema_file)
+            .file_stem()
+            .and_then(|s| s.to_str())
+            .unwrap_or("config")
+    });
 
-            // Determine output directory
-            let output_dir = output.unwrap_or(".");
+    // Sanitize package name for Go and C (replace hyphens with underscores)
+    let sanitized_pkg_name = pkg_name.replace('-', "_");
 
-            // Generate Go code
-            styx_gen_go::generate(&schema, &sanitized_pkg_name, output_dir)?;
+    // Determine output directory
+    let output_dir = output.unwrap_or(".");
 
-            eprintln!("Generated Go code in {}/", output_dir);
-            Ok(())
-        }
-        _ => Err(CliError::Usage(format!(
-            "unknown language '{}', expected: go",
-            language
-        ))),
+    if language == "c" {
+        styx_gen_c::generate(&schema, &sanitized_pkg_name, output_dir)?;
+        eprintln!("Generated C code in {}/", output_dir);
+    } else {
+        styx_gen_go::generate(&schema, &sanitized_pkg_name, output_dir)?;
+        eprintln!("Generated Go code in {}/", output_dir);
     }
+    Ok(())
 }
 
 fn run_cache(open: bool, clear: bool) -> Result<(), CliError> {
     use styx_lsp::cache;
 
+    let parse_cache = styx_tree::ParseCache::from_env();
+
     if clear {
+        if let Some(parse_cache) = &parse_cache {
+            let (count, size) = parse_cache.clear()?;
+            println!("Cleared {} cached documents ({} bytes)", count, size);
+        }
         match cache::clear_cache() {
             Ok((count, size)) => {
                 println!("Cleared {} cached schemas ({} bytes)", count, size);
@@ -753,6 +817,19 @@ fn run_cache(open: bool, clear: bool) -> Result<(), CliError> {
         println!("(cache directory does not exist)");
     }
 
+    match &parse_cache {
+        Some(parse_cache) => {
+            let (count, size) = parse_cache.stats()?;
+            println!(
+                "Parse cache: {} ({} documents, {} bytes)",
+                parse_cache.dir().display(),
+                count,
+                size
+            );
+        }
+        None => println!("Parse cache: off (set STYX_PARSE_CACHE to enable)"),
+    }
+
     Ok(())
 }
 
@@ -805,17 +882,17 @@ enum SchemaRef {
 fn strip_schema_declaration(value: &Value) -> Value {
     if let Some(obj) = value.as_object() {
         let filtered_entries: Vec<_> = obj
-            .entries
+            .entries()
             .iter()
             .filter(|e| !e.key.is_schema_tag())
             .cloned()
             .collect();
         Value {
             tag: value.tag.clone(),
-            payload: Some(Payload::Object(styx_tree::Object {
-                entries: filtered_entries,
-                span: obj.span,
-            })),
+            payload: Some(Payload::Object(styx_tree::Object::new(
+                filtered_entries,
+                obj.span,
+            ))),
             span: value.span,
         }
     } else {
@@ -828,7 +905,7 @@ fn find_schema_declaration(value: &Value) -> Result<SchemaRef, CliError> {
         CliError::Validation("document root must be an object for validation".into())
     })?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.is_schema_tag() {
             if let Some(path) = entry.value.as_str() {
                 return Ok(SchemaRef::External(path.to_string()));
@@ -982,6 +1059,17 @@ fn extract_embedded_schema(
 // I/O helpers
 // ============================================================================
 
+/// Parse a document to its root value, through the parse cache named by
+/// `STYX_PARSE_CACHE` when it is set.
+fn parse_value_cached(source: &str) -> Result<Value, styx_tree::BuildError> {
+    let doc = styx_tree::Document::parse_cached(source)?;
+    Ok(Value {
+        tag: None,
+        payload: Some(Payload::Object(doc.root)),
+        span: None,
+    })
+}
+
 fn read_input(file: Option<&str>) -> Result<String, io::Error> {
     match file {
         Some("-") | None => {
@@ -1124,7 +1212,7 @@ fn print_tree(value: &Value, indent: usize) {
             }
             Some(Payload::Object(o)) => {
                 println!("{pad}Object {{");
-                for entry in &o.entries {
+                for entry in o.entries() {
                     print!("{pad}  key: ");
                     print_tree_inline(&entry.key);
                     println!();
@@ -1158,7 +1246,7 @@ fn print_payload(payload: &Payload, indent: usize) {
         }
         Payload::Object(o) => {
             println!("{pad}Object {{");
-            for entry in &o.entries {
+            for entry in o.entries() {
                 print!("{pad}  key: ");
                 print_tree_inline(&entry.key);
                 println!();
@@ -1218,7 +1306,7 @@ fn print_sexp(value: &Value, indent: usize) {
             .map(|s| format!("[{}, {}]", s.start, s.end))
             .unwrap_or_else(|| "[-1, -1]".to_string());
         println!("{pad}(document {span}");
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             print_sexp_entry(entry, indent + 1);
         }
         print!("{pad})");
@@ -1284,11 +1372,11 @@ fn print_sexp_value(value: &Value, indent: usize) {
         }
         (None, Some(Payload::Object(obj))) => {
             print!("{pad}(object {span}");
-            if obj.entries.is_empty() {
+            if obj.entries().is_empty() {
                 print!(")");
             } else {
                 println!();
-                for entry in &obj.entries {
+                for entry in obj.entries() {
                     print_sexp_entry(entry, indent + 1);
                 }
                 print!("{pad})");
@@ -1338,11 +1426,11 @@ fn print_sexp_payload(payload: &Payload, indent: usize) {
                 .map(|s| format!("[{}, {}]", s.start, s.end))
                 .unwrap_or_else(|| "[-1, -1]".to_string());
             print!("{pad}(object {span}");
-            if obj.entries.is_empty() {
+            if obj.entries().is_empty() {
                 print!(")");
             } else {
                 println!();
-                for entry in &obj.entries {
+                for entry in obj.entries() {
                     print_sexp_entry(entry, indent + 1);
                 }
                 print!("{pad})");
@@ -1382,7 +1470,7 @@ fn payload_to_json(payload: &Payload) -> serde_json::Value {
         }
         Payload::Object(o) => {
             let mut obj = serde_json::Map::new();
-            for entry in &o.entries {
+            for entry in o.entries() {
                 let key = if entry.key.is_unit() {
                     "@".to_string()
                 } else if let Some(s) = entry.key.as_str() {
@@ -1630,11 +1718,11 @@ index = "{STAGING_INDEX}"
 
 fn extract_meta_field(value: &Value, field: &str) -> Option<String> {
     if let Some(Payload::Object(obj)) = &value.payload {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if entry.key.as_str() == Some("meta")
                 && let Some(Payload::Object(meta_obj)) = &entry.value.payload
             {
-                for meta_entry in &meta_obj.entries {
+                for meta_entry in meta_obj.entries() {
                     if meta_entry.key.as_str() == Some(field)
                         && let Some(Payload::Scalar(s)) = &meta_entry.value.payload
                     {
@@ -1841,11 +1929,11 @@ fn extract_schema_map(value: &Value) -> std::collections::HashMap<Option<String>
     let mut map = std::collections::HashMap::new();
 
     if let Some(Payload::Object(obj)) = &value.payload {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if entry.key.as_str() == Some("schema")
                 && let Some(Payload::Object(schema_obj)) = &entry.value.payload
             {
-                for schema_entry in &schema_obj.entries {
+                for schema_entry in schema_obj.entries() {
                     let key = if schema_entry.key.is_unit() {
                         None
                     } else {
@@ -1924,7 +2012,7 @@ fn extract_object_fields(value: &Value) -> std::collections::HashMap<String, &Va
     let mut fields = std::collections::HashMap::new();
 
     if let Some(Payload::Object(obj)) = &value.payload {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(name) = entry.key.as_str() {
                 fields.insert(name.to_string(), &entry.value);
             }
@@ -1972,7 +2060,7 @@ fn extract_enum_variants(value: &Value) -> Vec<String> {
     let mut variants = Vec::new();
 
     if let Some(Payload::Object(obj)) = &value.payload {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(name) = entry.key.as_str() {
                 variants.push(name.to_string());
             }
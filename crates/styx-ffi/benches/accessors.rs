@@ -0,0 +1,203 @@
+//! Cost of the C API, called from Rust the way a C caller would.
+//!
+//! Run with `cargo bench -p styx-ffi`. See `examples/bench.c` for the same
+//! measurements taken from C, including allocation counts.
+
+use std::ffi::CString;
+use std::hint::black_box;
+
+use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use styx_ffi::*;
+use styx_testhelpers::bench_corpus;
+
+fn parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ffi_parse_n");
+    for input in bench_corpus() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| {
+                b.iter(|| unsafe {
+                    let result = styx_parse_n(source.as_ptr().cast(), source.len(), 0);
+                    assert!(result.error.is_null());
+                    styx_free_document(result.document);
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+/// Loading the compiled form of each input against parsing its text, both
+/// ending in a full `StyxDocument`.
+fn load(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ffi_load");
+    for input in bench_corpus() {
+        let source = &input.source;
+        let result = unsafe { styx_parse_n(source.as_ptr().cast(), source.len(), 0) };
+        assert!(result.error.is_null());
+        let mut len = 0;
+        let compiled = unsafe { styx_document_compile(result.document, &mut len) };
+        assert!(!compiled.is_null());
+        unsafe { styx_free_document(result.document) };
+
+        group.throughput(Throughput::Bytes(source.len() as u64));
+        group.bench_function(BenchmarkId::new("parse_n", input.name), |b| {
+            b.iter(|| unsafe {
+                let result = styx_parse_n(source.as_ptr().cast(), source.len(), 0);
+                assert!(result.error.is_null());
+                styx_free_document(result.document);
+            })
+        });
+        group.bench_function(BenchmarkId::new("load_compiled", input.name), |b| {
+            b.iter(|| unsafe {
+                let result = styx_load_compiled(black_box(compiled), len);
+                assert!(result.error.is_null());
+                styx_free_document(result.document);
+            })
+        });
+        unsafe { styx_free_bytes(compiled, len) };
+    }
+    group.finish();
+}
+
+/// Visit every value through the borrowed accessors, touching scalar text.
+unsafe fn walk_value(value: *const StyxValue) -> usize {
+    unsafe {
+        match styx_value_payload_kind(value) {
+            StyxPayloadKind::Scalar => styx_value_scalar_view(value).len,
+            StyxPayloadKind::Object => walk_object(styx_value_as_object(value)),
+            StyxPayloadKind::Sequence => {
+                let seq = styx_value_as_sequence(value);
+                (0..styx_sequence_len(seq))
+                    .map(|i| walk_value(styx_sequence_get(seq, i)))
+                    .sum()
+            }
+            _ => 0,
+        }
+    }
+}
+
+unsafe fn walk_object(obj: *const StyxObject) -> usize {
+    unsafe {
+        (0..styx_object_len(obj))
+            .map(|i| styx_object_key_view_at(obj, i).len + walk_value(styx_object_value_at(obj, i)))
+            .sum()
+    }
+}
+
+fn walk(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ffi_walk");
+    for input in bench_corpus() {
+        let result = unsafe { styx_parse_n(input.source.as_ptr().cast(), input.source.len(), 0) };
+        assert!(result.error.is_null());
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_function(BenchmarkId::from_parameter(input.name), |b| {
+            b.iter(|| unsafe { walk_object(styx_document_root(black_box(result.document))) })
+        });
+        unsafe { styx_free_document(result.document) };
+    }
+    group.finish();
+}
+
+/// Scratch stacks for `walk_value_bulk`, reused across documents.
+#[derive(Default)]
+struct Scratch {
+    entries: Vec<StyxEntryView>,
+    items: Vec<*const StyxValue>,
+}
+
+/// Like `walk_value`, but fetches each container's children in one call.
+unsafe fn walk_value_bulk(value: *const StyxValue, scratch: &mut Scratch) -> usize {
+    unsafe {
+        match styx_value_payload_kind(value) {
+            StyxPayloadKind::Scalar => styx_value_scalar_view(value).len,
+            StyxPayloadKind::Object => walk_object_bulk(styx_value_as_object(value), scratch),
+            StyxPayloadKind::Sequence => {
+                let seq = styx_value_as_sequence(value);
+                let base = scratch.items.len();
+                let len = styx_sequence_len(seq);
+                scratch.items.resize(base + len, std::ptr::null());
+                styx_sequence_items(seq, scratch.items[base..].as_mut_ptr(), len);
+                let mut total = 0;
+                for i in base..base + len {
+                    total += walk_value_bulk(scratch.items[i], scratch);
+                }
+                scratch.items.truncate(base);
+                total
+            }
+            _ => 0,
+        }
+    }
+}
+
+unsafe fn walk_object_bulk(obj: *const StyxObject, scratch: &mut Scratch) -> usize {
+    unsafe {
+        let base = scratch.entries.len();
+        let len = styx_object_len(obj);
+        let empty = StyxEntryView {
+            key: StyxStr {
+                ptr: std::ptr::null(),
+                len: 0,
+            },
+            value: std::ptr::null(),
+        };
+        scratch.entries.resize(base + len, empty);
+        styx_object_entries(obj, scratch.entries[base..].as_mut_ptr(), len);
+        let mut total = 0;
+        for i in base..base + len {
+            let entry = scratch.entries[i];
+            total += entry.key.len + walk_value_bulk(entry.value, scratch);
+        }
+        scratch.entries.truncate(base);
+        total
+    }
+}
+
+fn walk_bulk(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ffi_walk_bulk");
+    for input in bench_corpus() {
+        let result = unsafe { styx_parse_n(input.source.as_ptr().cast(), input.source.len(), 0) };
+        assert!(result.error.is_null());
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        let mut scratch = Scratch::default();
+        group.bench_function(BenchmarkId::from_parameter(input.name), |b| {
+            b.iter(|| unsafe {
+                walk_object_bulk(styx_document_root(black_box(result.document)), &mut scratch)
+            })
+        });
+        unsafe { styx_free_document(result.document) };
+    }
+    group.finish();
+}
+
+fn lookup(c: &mut Criterion) {
+    let source = styx_testhelpers::wide_object(20_000);
+    let result = unsafe { styx_parse_n(source.as_ptr().cast(), source.len(), 0) };
+    assert!(result.error.is_null());
+    let key = CString::new("key_19999").unwrap();
+
+    let mut group = c.benchmark_group("ffi_lookup");
+    group.bench_function("document_get", |b| {
+        b.iter(|| unsafe { styx_document_get(result.document, black_box(key.as_ptr())) })
+    });
+    group.bench_function("path_eval", |b| {
+        let path = unsafe { styx_path_compile(key.as_ptr()) };
+        b.iter(|| unsafe { styx_path_eval(result.document, black_box(path)) });
+        unsafe { styx_path_free(path) };
+    });
+    group.bench_function("scalar_copy", |b| {
+        let value = unsafe { styx_document_get(result.document, key.as_ptr()) };
+        b.iter(|| unsafe { styx_free_string(styx_value_scalar(black_box(value))) })
+    });
+    group.bench_function("scalar_view", |b| {
+        let value = unsafe { styx_document_get(result.document, key.as_ptr()) };
+        b.iter(|| unsafe { styx_value_scalar_view(black_box(value)) })
+    });
+    group.finish();
+    unsafe { styx_free_document(result.document) };
+}
+
+criterion_group!(benches, parse, load, walk, walk_bulk, lookup);
+criterion_main!(benches);
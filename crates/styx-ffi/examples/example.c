@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <styx.h>
 
 int main(void) {
@@ -57,6 +58,18 @@ int main(void) {
         }
     }
 
+    // Typed reads parse the stored text in place
+    int64_t years = 0;
+    if (styx_value_as_i64(styx_document_get(result.document, "age"), &years) ==
+        STYX_SCALAR_STATUS_OK) {
+        printf("age + 1: %lld\n", (long long)(years + 1));
+    }
+    bool flag;
+    if (styx_value_as_bool(styx_document_get(result.document, "name"), &flag) ==
+        STYX_SCALAR_STATUS_INVALID) {
+        printf("name is not a boolean\n");
+    }
+
     // Access nested value
     const struct StyxValue *city = styx_document_get(result.document, "address.city");
     if (city) {
@@ -67,37 +80,34 @@ int main(void) {
         }
     }
 
-    // Access sequence
+    // Access sequence, fetching all item pointers in one call
     const struct StyxValue *tags = styx_document_get(result.document, "tags");
     if (tags) {
         const struct StyxSequence *seq = styx_value_as_sequence(tags);
         if (seq) {
-            uintptr_t len = styx_sequence_len(seq);
-            printf("tags (%zu items):", (size_t)len);
-            for (uintptr_t i = 0; i < len; i++) {
-                const struct StyxValue *item = styx_sequence_get(seq, i);
-                if (item) {
-                    char *text = styx_value_scalar(item);
-                    if (text) {
-                        printf(" %s", text);
-                        styx_free_string(text);
-                    }
+            const struct StyxValue *items[8];
+            size_t len = styx_sequence_items(seq, items, 8);
+            printf("tags (%zu items):", len);
+            for (size_t i = 0; i < len && i < 8; i++) {
+                // Borrowed views avoid an allocation per read
+                struct StyxStr text = styx_value_scalar_view(items[i]);
+                if (text.ptr) {
+                    printf(" %.*s", (int)text.len, text.ptr);
                 }
             }
             printf("\n");
         }
     }
 
-    // Iterate over root object
+    // Iterate over root object, fetching all entries in one call
     printf("\nIterating over root object:\n");
     const struct StyxObject *root = styx_document_root(result.document);
-    uintptr_t len = styx_object_len(root);
-    for (uintptr_t i = 0; i < len; i++) {
-        const struct StyxValue *key = styx_object_key_at(root, i);
-        const struct StyxValue *value = styx_object_value_at(root, i);
-
-        char *key_text = styx_value_scalar(key);
-        enum StyxPayloadKind kind = styx_value_payload_kind(value);
+    size_t len = styx_object_entries(root, NULL, 0);
+    struct StyxEntryView *entries = malloc(len * sizeof *entries);
+    len = styx_object_entries(root, entries, len);
+    for (size_t i = 0; i < len; i++) {
+        struct StyxStr key_text = entries[i].key;
+        enum StyxPayloadKind kind = styx_value_payload_kind(entries[i].value);
 
         const char *kind_str;
         switch (kind) {
@@ -108,9 +118,340 @@ int main(void) {
             default: kind_str = "unknown"; break;
         }
 
-        printf("  %s: %s\n", key_text ? key_text : "(null)", kind_str);
+        if (key_text.ptr) {
+            printf("  %.*s: %s\n", (int)key_text.len, key_text.ptr, kind_str);
+        } else {
+            printf("  (null): %s\n", kind_str);
+        }
+    }
+    free(entries);
+
+    // Compile paths once, resolve them in a single batch call
+    printf("\nCompiled paths:\n");
+    const char *path_strs[] = {"name", "address.zip", "tags[2]", "missing"};
+    enum { PATH_COUNT = sizeof(path_strs) / sizeof(path_strs[0]) };
+    const struct StyxPath *paths[PATH_COUNT];
+    const struct StyxValue *values[PATH_COUNT];
+    for (size_t i = 0; i < PATH_COUNT; i++) {
+        paths[i] = styx_path_compile(path_strs[i]);
+    }
+    size_t found = styx_path_eval_batch(result.document, paths, PATH_COUNT, values);
+    for (size_t i = 0; i < PATH_COUNT; i++) {
+        struct StyxStr text = styx_value_scalar_view(values[i]);
+        if (text.ptr) {
+            printf("  %s = %.*s\n", path_strs[i], (int)text.len, text.ptr);
+        } else {
+            printf("  %s not found\n", path_strs[i]);
+        }
+        styx_path_free((struct StyxPath *)paths[i]);
+    }
+    printf("  (%zu of %d found)\n", found, PATH_COUNT);
+
+    // Stream events without building a tree, stopping once "zip" is found
+    printf("\nStreaming events:\n");
+    struct StyxEventReader *reader = styx_reader_new(source, strlen(source), 0);
+    struct StyxEvent ev;
+    bool want_value = false;
+    while (styx_reader_next(reader, &ev)) {
+        if (ev.kind == STYX_EVENT_KEY && ev.text.ptr) {
+            want_value = ev.text.len == 3 && memcmp(ev.text.ptr, "zip", 3) == 0;
+        } else if (ev.kind == STYX_EVENT_SCALAR && want_value) {
+            printf("  zip = %.*s (bytes %u..%u)\n", (int)ev.text.len, ev.text.ptr,
+                   ev.span_start, ev.span_end);
+            break;
+        }
+    }
+    styx_reader_free(reader);
+
+    // Parse a large generated document across threads
+    printf("\nParallel parse:\n");
+    size_t big_cap = 1u << 20, big_len = 0;
+    char *big = malloc(big_cap);
+    for (int i = 0; big_len + 64 < big_cap; i++) {
+        big_len += (size_t)snprintf(big + big_len, big_cap - big_len,
+                                    "entry%d { id %d, name item%d }\n", i, i, i);
+    }
+    struct StyxParseResult big_result = styx_parse_parallel(big, big_len, 0, 4);
+    if (big_result.document) {
+        printf("  %zu root entries\n",
+               (size_t)styx_object_len(styx_document_root(big_result.document)));
+        styx_free_document(big_result.document);
+    } else {
+        printf("  error: %s\n", big_result.error);
+        styx_free_string(big_result.error);
+    }
+    free(big);
+
+    // Parse a batch of small documents in one call, across threads
+    printf("\nBatch parse:\n");
+    enum { BATCH = 1000 };
+    static char messages[BATCH][48];
+    StyxStr inputs[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        int n = snprintf(messages[i], sizeof messages[i], "id %d\nkind %s\n", i,
+                         i == 500 ? "{broken" : "ping");
+        inputs[i] = (StyxStr){messages[i], (size_t)n};
+    }
+    static struct StyxParseResult batch[BATCH];
+    size_t batch_ok = styx_parse_batch(inputs, BATCH, 0, 0, batch);
+    printf("  %zu of %d parsed\n", batch_ok, BATCH);
+    for (int i = 0; i < BATCH; i++) {
+        if (!batch[i].document) {
+            printf("  message %d: %s\n", i, batch[i].error);
+        }
+        styx_free_document(batch[i].document);
+        styx_free_string(batch[i].error);
+    }
+
+    // Parse lazily: nested objects are parsed when first read
+    printf("\nLazy parse:\n");
+    struct StyxParseResult lazy = styx_parse_lazy(source, strlen(source), 0);
+    if (lazy.document) {
+        StyxStr lazy_city =
+            styx_value_scalar_view(styx_document_get(lazy.document, "address.city"));
+        printf("  address.city = %.*s\n", (int)lazy_city.len, lazy_city.ptr);
+        // Errors inside nested objects surface when they are read
+        char *address_error = styx_object_error(
+            styx_value_as_object(styx_document_get(lazy.document, "address")));
+        printf("  address parsed: %s\n", address_error ? address_error : "ok");
+        styx_free_string(address_error);
+        styx_free_document(lazy.document);
+    } else {
+        printf("  error: %s\n", lazy.error);
+        styx_free_string(lazy.error);
+    }
+
+    // Share a reloadable config between threads: readers acquire the current
+    // version, a reload publishes a new one, and old versions live on until
+    // their last reader releases them
+    printf("\nSnapshots:\n");
+    StyxSnapshotCell *cell = styx_snapshot_cell_new();
+    styx_snapshot_publish(cell, styx_parse("port 8080").document);
+    const StyxSnapshot *before = styx_snapshot_acquire(cell);
+    styx_snapshot_publish(cell, styx_parse("port 9090").document);
+    const StyxSnapshot *after = styx_snapshot_acquire(cell);
+    StyxStr port_before =
+        styx_value_scalar_view(styx_document_get(styx_snapshot_document(before), "port"));
+    StyxStr port_after =
+        styx_value_scalar_view(styx_document_get(styx_snapshot_document(after), "port"));
+    printf("  held: port %.*s, current: port %.*s\n", (int)port_before.len, port_before.ptr,
+           (int)port_after.len, port_after.ptr);
+    styx_snapshot_release(before);
+    styx_snapshot_release(after);
+    styx_snapshot_cell_free(cell);
+
+    // Select every match at once, from a document or while parsing
+    printf("\nSelectors:\n");
+    static const char fleet_src[] =
+        "servers (\n"
+        "  {name api, role web, port 8080}\n"
+        "  {name db, role store, port 5432}\n"
+        "  {name edge, role web, port 443}\n"
+        ")\n"
+        "admin {contact @email\"ops@example.com\"}\n";
+    StyxSelector *web_ports = NULL;
+    char *select_error = styx_selector_compile("servers[*][role=web].port", &web_ports);
+    if (select_error) {
+        printf("  error: %s\n", select_error);
+        styx_free_string(select_error);
+    } else {
+        struct StyxParseResult fleet = styx_parse(fleet_src);
+        StyxSelection *ports = styx_select(fleet.document, web_ports);
+        for (size_t i = 0; i < styx_selection_len(ports); i++) {
+            StyxStr port = styx_value_scalar_view(styx_selection_get(ports, i));
+            printf("  web port: %.*s\n", (int)port.len, port.ptr);
+        }
+        styx_selection_free(ports);
+        styx_free_document(fleet.document);
+        styx_selector_free(web_ports);
+    }
+    StyxSelector *emails = NULL;
+    styx_free_string(styx_selector_compile("..[@email]", &emails));
+    StyxSelection *streamed = NULL;
+    select_error = styx_select_source(emails, fleet_src, sizeof(fleet_src) - 1, 0, &streamed);
+    if (select_error) {
+        printf("  error: %s\n", select_error);
+        styx_free_string(select_error);
+    } else {
+        for (size_t i = 0; i < styx_selection_len(streamed); i++) {
+            StyxStr email = styx_value_scalar_view(styx_selection_get(streamed, i));
+            printf("  streamed email: %.*s\n", (int)email.len, email.ptr);
+        }
+        styx_selection_free(streamed);
+    }
+    styx_selector_free(emails);
+
+    // Compile a schema once, then validate documents against it: without a
+    // violations list the check stops at the first problem
+    printf("\nSchemas:\n");
+    static const char schema_src[] =
+        "schema {\n"
+        "  @ @object{name @string, port @int{min 1, max 65535}, debug @optional(@bool)}\n"
+        "}\n";
+    StyxSchema *schema = NULL;
+    char *schema_error = styx_schema_compile(schema_src, sizeof(schema_src) - 1, 0, &schema);
+    if (schema_error) {
+        printf("  error: %s\n", schema_error);
+        styx_free_string(schema_error);
+    } else {
+        struct StyxParseResult good = styx_parse("name api\nport 8080\n");
+        struct StyxParseResult bad = styx_parse("name api\nport 0\ndebug maybe\n");
+        printf("  good: %s\n", styx_schema_validate(schema, good.document, NULL) ? "valid" : "invalid");
+        StyxViolations *violations = NULL;
+        if (!styx_schema_validate(schema, bad.document, &violations)) {
+            for (size_t i = 0; i < styx_violations_len(violations); i++) {
+                StyxViolation v = styx_violations_get(violations, i);
+                printf("  bad: %.*s: %.*s\n", (int)v.path.len, v.path.ptr, (int)v.message.len,
+                       v.message.ptr);
+            }
+            styx_violations_free(violations);
+        }
+        styx_free_document(good.document);
+        styx_free_document(bad.document);
+
+        // Validate while parsing: rejected at "port 0", before "debug" is read
+        static const char stream_src[] = "name api\nport 0\ndebug maybe\n";
+        char *rejected = styx_schema_check(schema, stream_src, sizeof(stream_src) - 1, 0);
+        printf("  streamed: %s\n", rejected ? rejected : "valid");
+        styx_free_string(rejected);
+        static const char checked_src[] = "name api\nport 443\n";
+        struct StyxParseResult checked =
+            styx_schema_parse(schema, checked_src, sizeof(checked_src) - 1, 0);
+        printf("  parsed: %s\n", checked.document ? "valid" : checked.error);
+        styx_free_document(checked.document);
+        styx_free_string(checked.error);
+        styx_schema_free(schema);
+    }
+
+    // Report every syntax error without allocating, formatting on demand
+    printf("\nStructured errors:\n");
+    {
+        static const char broken[] = "a 1\na 2\nb \"\\q\"\nc.d {}\nc.e {}\nc.d.x 1\n";
+        StyxError errors[8];
+        size_t count = styx_check_syntax(broken, sizeof(broken) - 1, 0, errors, 8);
+        for (size_t i = 0; i < count && i < 8; i++) {
+            char message[128];
+            styx_error_message(&errors[i], broken, sizeof(broken) - 1, message, sizeof message);
+            StyxPosition at = styx_error_position(&errors[i], broken, sizeof(broken) - 1);
+            printf("  %u:%u code %d: %s\n", at.line, at.column, (int)errors[i].code, message);
+        }
+
+        StyxError error;
+        StyxDocument *doc = styx_parse_ex(broken, sizeof(broken) - 1, 0, &error);
+        printf("  styx_parse_ex: %s, code %d\n", doc ? "ok" : "failed", (int)error.code);
+        styx_free_document(doc);
+    }
+
+    // Parse a stream of small messages, reusing buffers and document storage
+    printf("\nReusable parser:\n");
+    {
+        static const char *const messages[] = {"id 1\nkind ping", "id 2\nkind pong", "id 3 {"};
+        StyxParser *parser = styx_parser_new();
+        for (size_t i = 0; i < 3; i++) {
+            StyxParseResult r = styx_parser_parse(parser, messages[i], strlen(messages[i]), 0);
+            if (r.document) {
+                struct StyxStr kind = styx_value_scalar_view(styx_document_get(r.document, "kind"));
+                printf("  message %zu: %.*s\n", i + 1, (int)kind.len, kind.ptr);
+            } else {
+                printf("  message %zu: %s\n", i + 1, r.error);
+                styx_free_string(r.error);
+            }
+            styx_parser_recycle(parser, r.document);
+        }
+        styx_parser_free(parser);
+    }
+
+    // See what a parse costs
+    {
+        StyxParseStats stats;
+        StyxParseResult r = styx_parse_with_stats(source, strlen(source), 0, &stats);
+        printf("\nStats: %llu bytes, %llu tokens, %llu events, %llu nodes, %llu allocations\n",
+               (unsigned long long)stats.bytes, (unsigned long long)stats.tokens,
+               (unsigned long long)stats.events, (unsigned long long)stats.nodes,
+               (unsigned long long)stats.allocations);
+        styx_free_document(r.document);
+    }
+
+    // Stream a document straight into a buffer, then read it back
+    printf("\nWriter:\n");
+    {
+        StyxBuffer out = {NULL, 0, 0};
+        StyxWriter *w = styx_writer_new_buffer(&out, 0);
+        styx_writer_key(w, "name", 4);
+        styx_writer_scalar(w, "my app", 6);
+        styx_writer_key(w, "server", 6);
+        styx_writer_begin_object(w);
+        styx_writer_key(w, "host", 4);
+        styx_writer_scalar(w, "localhost", 9);
+        styx_writer_key(w, "ports", 5);
+        styx_writer_begin_sequence(w);
+        styx_writer_int(w, 8080);
+        styx_writer_int(w, 8443);
+        styx_writer_end(w);
+        styx_writer_end(w);
+        styx_writer_key(w, "mode", 4);
+        styx_writer_tag(w, "debug", 5);
+        styx_writer_unit(w);
+        if (styx_writer_finish(w)) {
+            printf("%.*s", (int)out.len, out.data);
+            StyxParseResult r = styx_parse_n(out.data, out.len, 0);
+            struct StyxStr host = styx_value_scalar_view(styx_document_get(r.document, "server.host"));
+            printf("  read back server.host: %.*s\n", (int)host.len, host.ptr);
+            styx_free_document(r.document);
+        } else {
+            printf("  error: %s\n", styx_writer_error(w));
+        }
+        styx_writer_free(w);
+        free(out.data);
+    }
+
+    static const char *const kinds[] = {"added", "removed", "changed"};
+
+    // Hot-reload an edit: change "age 30" to "age 31" and reparse only that entry
+    printf("\nIncremental reparse:\n");
+    size_t source_len = strlen(source);
+    char *edited = malloc(source_len + 1);
+    memcpy(edited, source, source_len + 1);
+    size_t edit_start = (size_t)(strstr(edited, "30") - edited);
+    edited[edit_start + 1] = '1';
+    struct StyxChanges *changes = NULL;
+    char *error = styx_document_reparse(result.document, edited, source_len, 0, edit_start,
+                                        edit_start + 2, 2, &changes);
+    if (error) {
+        printf("  error: %s\n", error);
+        styx_free_string(error);
+    } else {
+        for (size_t i = 0; i < styx_changes_len(changes); i++) {
+            struct StyxChange change = styx_changes_get(changes, i);
+            printf("  %s %.*s\n", kinds[change.kind], (int)change.path.len, change.path.ptr);
+        }
+        struct StyxStr age_text = styx_value_scalar_view(styx_document_get(result.document, "age"));
+        printf("  age is now %.*s\n", (int)age_text.len, age_text.ptr);
+        styx_changes_free(changes);
+    }
+    free(edited);
 
-        if (key_text) styx_free_string(key_text);
+    // Compare against a new version of the config
+    printf("\nDiff:\n");
+    struct StyxParseResult next = styx_parse(
+        "name Alice\n"
+        "age 31\n"
+        "tags (developer rust python)\n"
+        "address {\n"
+        "  city \"New York\"\n"
+        "  zip 10002\n"
+        "}\n"
+        "email alice@example.com\n");
+    if (next.document) {
+        struct StyxChanges *diff = styx_document_diff(result.document, next.document);
+        for (size_t i = 0; i < styx_changes_len(diff); i++) {
+            struct StyxChange change = styx_changes_get(diff, i);
+            printf("  %s %.*s\n", kinds[change.kind], (int)change.path.len, change.path.ptr);
+        }
+        styx_changes_free(diff);
+        styx_free_document(next.document);
+    } else {
+        styx_free_string(next.error);
     }
 
     // Clean up
@@ -0,0 +1,161 @@
+/**
+ * Example usage of the Styx C++ header.
+ *
+ * Compile with (from the examples directory):
+ *   c++ -std=c++17 -o example_cpp example.cpp -I../include -L../../../target/release -lstyx_ffi
+ *
+ * Run with:
+ *   # macOS
+ *   DYLD_LIBRARY_PATH=../../../target/release ./example_cpp
+ *   # Linux
+ *   LD_LIBRARY_PATH=../../../target/release ./example_cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <styx.hpp>
+
+// Scalar parsing is constexpr, so it can be checked at compile time.
+static_assert(styx::detail::parse_int<int64_t>("-9223372036854775808") == INT64_MIN);
+static_assert(!styx::detail::parse_int<uint8_t>("256"));
+static_assert(styx::detail::parse_bool("true") == true);
+
+int main() {
+    const char *source =
+        "name Alice\n"
+        "age 30\n"
+        "ratio 0.75\n"
+        "admin true\n"
+        "tags (developer rust python)\n"
+        "address {\n"
+        "  city \"New York\"\n"
+        "  zip 10001\n"
+        "}\n";
+
+    styx::document doc = [&] {
+        try {
+            return styx::document::parse(source);
+        } catch (const styx::parse_error &e) {
+            std::fprintf(stderr, "Parse error: %s\n", e.what());
+            std::exit(1);
+        }
+    }();
+
+    // String views borrow from the document: no copies
+    std::string_view name = doc["name"].as<std::string_view>().value_or("?");
+    std::printf("name: %.*s\n", (int)name.size(), name.data());
+
+    // Typed getters parse in place
+    std::printf("age: %d\n", doc["age"].as<int>().value_or(-1));
+    std::printf("ratio: %.2f\n", doc["ratio"].as<double>().value_or(0.0));
+    std::printf("admin: %s\n", doc["admin"].as<bool>().value_or(false) ? "yes" : "no");
+    std::printf("zip: %u\n", doc["address.zip"].as<uint32_t>().value_or(0));
+    std::printf("name as int: %s\n", doc["name"].as<int>() ? "parsed" : "not a number");
+
+    // Range-for over sequences and objects
+    std::printf("tags:");
+    for (styx::value tag : doc["tags"].as_sequence()) {
+        std::string_view text = tag.as<std::string_view>().value_or("");
+        std::printf(" %.*s", (int)text.size(), text.data());
+    }
+    std::printf("\n");
+
+    std::printf("root keys:");
+    for (auto [key, value] : doc.root()) {
+        std::printf(" %.*s%s", (int)key.size(), key.data(), value.is_object() ? "{}" : "");
+    }
+    std::printf("\n");
+
+    // Compiled paths are RAII too
+    styx::path city("address.city");
+    std::string_view text = doc[city].as<std::string_view>().value_or("?");
+    std::printf("address.city: %.*s\n", (int)text.size(), text.data());
+
+    // Documents are move-only and freed on scope exit
+    styx::document moved = std::move(doc);
+    std::printf("moved root has %zu entries\n", moved.root().size());
+
+    // Reparse after an edit: "age 30" becomes "age 31"
+    std::string edited = source;
+    std::size_t at = edited.find("30");
+    edited.replace(at, 2, "31");
+    styx::changes changed = moved.reparse(edited, at, at + 2, 2);
+    for (std::size_t i = 0; i < changed.size(); i++) {
+        std::printf("changed: %.*s\n", (int)changed[i].path.size(), changed[i].path.data());
+    }
+    std::printf("age: %d\n", moved["age"].as<int>().value_or(-1));
+
+    // Diff against another version
+    styx::document next = styx::document::parse(edited + "email alice@example.com\n");
+    styx::changes diff = moved.diff(next);
+    for (std::size_t i = 0; i < diff.size(); i++) {
+        std::printf("diff: %.*s\n", (int)diff[i].path.size(), diff[i].path.data());
+    }
+
+    // Share versions between threads: held snapshots outlive a reload
+    styx::snapshot_cell config;
+    config.publish(styx::document::parse("port 8080"));
+    styx::snapshot held = config.acquire();
+    config.publish(styx::document::parse("port 9090"));
+    std::printf("held port %d, current port %d\n", held["port"].as<int>().value_or(-1),
+                config.acquire()["port"].as<int>().value_or(-1));
+
+    // Parse a batch of independent documents across threads
+    std::vector<std::string_view> payloads = {"id 1", "id 2", "id {", "id 4"};
+    std::vector<std::string> batch_errors;
+    std::vector<std::optional<styx::document>> batch =
+        styx::document::parse_batch(payloads, 0, &batch_errors);
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        if (!batch[i]) {
+            std::printf("batch %zu: %s\n", i, batch_errors[i].c_str());
+        }
+    }
+
+    // Select every match, from a document or straight from source
+    styx::selector names("servers[*].name");
+    styx::document fleet = styx::document::parse("servers ({name api} {name db})\n");
+    styx::selection found = names.select(fleet);
+    for (std::size_t i = 0; i < found.size(); i++) {
+        std::printf("server: %s\n", std::string(found[i].as<std::string_view>().value_or("?")).c_str());
+    }
+    std::printf("streamed %zu ports\n", styx::selector("..port").select("a {port 1}\nb {port 2}\n").size());
+
+    // Compile a schema once and validate many documents against it
+    styx::schema schema = styx::schema::compile("schema {@ @object{port @int{min 1}}}\n");
+    std::printf("port 80: %s\n", schema.is_valid(styx::document::parse("port 80")) ? "ok" : "bad");
+    for (const styx::violation &v : schema.validate(styx::document::parse("port 0"))) {
+        std::printf("port 0: %s: %s\n", v.path.c_str(), v.message.c_str());
+    }
+    // Or validate while parsing, stopping at the first violation
+    std::printf("streamed: %s\n", schema.check("port 0\nmore {a b}").value_or("valid").c_str());
+    std::printf("parsed port %d\n", schema.parse("port 443")["port"].as<int>().value_or(-1));
+
+    // Collect syntax errors without exceptions
+    std::string_view broken = "a 1\na 2\n";
+    for (const StyxError &e : styx::check_syntax(broken)) {
+        std::printf("syntax: %s\n", styx::error_message(e, broken).c_str());
+    }
+    StyxError error;
+    std::printf("try_parse: %s\n", styx::document::try_parse(broken, error) ? "ok" : "failed");
+
+    // Reuse one parser for many small messages
+    styx::parser messages;
+    for (const char *message : {"id 1\nkind ping", "id 2\nkind pong"}) {
+        styx::document doc = messages.parse(message);
+        std::string_view kind = doc["kind"].text().value_or("?");
+        std::printf("message: %.*s\n", (int)kind.size(), kind.data());
+        messages.recycle(std::move(doc));
+    }
+
+    // Stream a document into a string without building a tree
+    std::string written;
+    styx::writer writer(written, true);
+    writer.key("id").value(7).key("tags").begin_sequence().scalar("a b").scalar("c").end();
+    writer.key("limits").begin_object().key("rate").value(2.5).key("burst").value(10).end();
+    writer.finish();
+    std::printf("written: %s", written.c_str());
+    styx::document read_back = styx::document::parse(written);
+    std::string_view tag = read_back["tags"].as_sequence()[0].text().value_or("?");
+    std::printf("read back: %.*s\n", (int)tag.size(), tag.data());
+    return 0;
+}
@@ -109,106 +109,1605 @@ typedef enum StyxPayloadKind {
     STYX_PAYLOAD_KIND_OBJECT = 3
 } StyxPayloadKind;
 
+/**
+ * @brief Kind of a streaming parse event (see styx_reader_next()).
+ *
+ * Structural events come in matching START/END pairs. An entry is
+ * ENTRY_START, KEY, its value, then ENTRY_END. A tagged value is TAG_START,
+ * its payload (if any), then TAG_END.
+ */
+typedef enum StyxEventKind {
+    STYX_EVENT_DOCUMENT_START = 0,
+    STYX_EVENT_DOCUMENT_END = 1,
+    STYX_EVENT_OBJECT_START = 2,
+    STYX_EVENT_OBJECT_END = 3,
+    STYX_EVENT_SEQUENCE_START = 4,
+    STYX_EVENT_SEQUENCE_END = 5,
+    STYX_EVENT_ENTRY_START = 6,
+    STYX_EVENT_ENTRY_END = 7,
+    /** Entry key; `text` is NULL for a unit key, `tag` set if tagged. */
+    STYX_EVENT_KEY = 8,
+    /** Scalar value in `text`. */
+    STYX_EVENT_SCALAR = 9,
+    /** Unit value `@`. */
+    STYX_EVENT_UNIT = 10,
+    /** Start of a tag; name in `tag`. */
+    STYX_EVENT_TAG_START = 11,
+    STYX_EVENT_TAG_END = 12,
+    /** Line comment, including the leading `//`. */
+    STYX_EVENT_COMMENT = 13,
+    /** Doc comment lines without `/// `, joined with newlines. */
+    STYX_EVENT_DOC_COMMENT = 14,
+    /** Parse error; message in `text`. Parsing continues after errors. */
+    STYX_EVENT_ERROR = 15
+} StyxEventKind;
+
+/**
+ * @brief Kind of a scalar.
+ */
+typedef enum StyxScalarKind {
+    /** Bare (unquoted) scalar. */
+    STYX_SCALAR_KIND_BARE = 0,
+    /** Quoted string `"..."`. */
+    STYX_SCALAR_KIND_QUOTED = 1,
+    /** Raw string `r#"..."#`. */
+    STYX_SCALAR_KIND_RAW = 2,
+    /** Heredoc `<<DELIM...DELIM`. */
+    STYX_SCALAR_KIND_HEREDOC = 3
+} StyxScalarKind;
+
+/**
+ * @brief Outcome of a typed scalar read (see styx_value_as_i64()).
+ */
+typedef enum StyxScalarStatus {
+    /** The value was parsed and written to the output. */
+    STYX_SCALAR_STATUS_OK = 0,
+    /** The value is NULL or not a scalar. */
+    STYX_SCALAR_STATUS_NOT_SCALAR = 1,
+    /** The scalar text is not a value of the requested type. */
+    STYX_SCALAR_STATUS_INVALID = 2,
+    /** The scalar is a number that does not fit the requested type. */
+    STYX_SCALAR_STATUS_OUT_OF_RANGE = 3
+} StyxScalarStatus;
+
+/**
+ * @brief How the value at a path changed (see styx_document_diff()).
+ */
+typedef enum StyxChangeKind {
+    /** The path is new. */
+    STYX_CHANGE_KIND_ADDED = 0,
+    /** The path no longer exists. */
+    STYX_CHANGE_KIND_REMOVED = 1,
+    /** The path holds a different value. */
+    STYX_CHANGE_KIND_CHANGED = 2
+} StyxChangeKind;
+
+/**
+ * @brief Machine-readable kind of an error (see StyxError).
+ *
+ * Codes 1 to 17 mirror the parser's error kinds; codes from 128 are raised
+ * before or after parsing.
+ */
+typedef enum StyxErrorCode {
+    /** No error. */
+    STYX_ERROR_CODE_NONE = 0,
+    /** Unexpected token. */
+    STYX_ERROR_CODE_UNEXPECTED_TOKEN = 1,
+    /** Unclosed object (missing `}`). */
+    STYX_ERROR_CODE_UNCLOSED_OBJECT = 2,
+    /** Unclosed sequence (missing `)`). */
+    STYX_ERROR_CODE_UNCLOSED_SEQUENCE = 3,
+    /** Invalid escape sequence in a quoted string; the span covers it. */
+    STYX_ERROR_CODE_INVALID_ESCAPE = 4,
+    /** Expected a key. */
+    STYX_ERROR_CODE_EXPECTED_KEY = 5,
+    /** Expected a value. */
+    STYX_ERROR_CODE_EXPECTED_VALUE = 6,
+    /** Unexpected end of input. */
+    STYX_ERROR_CODE_UNEXPECTED_EOF = 7,
+    /** Duplicate key; the related span is the first occurrence. */
+    STYX_ERROR_CODE_DUPLICATE_KEY = 8,
+    /** Invalid tag name. */
+    STYX_ERROR_CODE_INVALID_TAG_NAME = 9,
+    /** Invalid key. */
+    STYX_ERROR_CODE_INVALID_KEY = 10,
+    /** Doc comment not followed by an entry. */
+    STYX_ERROR_CODE_DANGLING_DOC_COMMENT = 11,
+    /** Entry has too many atoms. */
+    STYX_ERROR_CODE_TOO_MANY_ATOMS = 12,
+    /** A dotted path reopens an object closed by a sibling. */
+    STYX_ERROR_CODE_REOPENED_PATH = 13,
+    /** A dotted path nests into a key that holds a terminal value. */
+    STYX_ERROR_CODE_NEST_INTO_TERMINAL = 14,
+    /** Comma in a sequence. */
+    STYX_ERROR_CODE_COMMA_IN_SEQUENCE = 15,
+    /** Missing whitespace between a bare scalar and a block. */
+    STYX_ERROR_CODE_MISSING_WHITESPACE_BEFORE_BLOCK = 16,
+    /** Content after the root object. */
+    STYX_ERROR_CODE_TRAILING_CONTENT = 17,
+    /** The source pointer was NULL. */
+    STYX_ERROR_CODE_NULL_SOURCE = 128,
+    /** The source is not valid UTF-8. */
+    STYX_ERROR_CODE_INVALID_UTF8 = 129,
+    /** A structure was left open at the end of input. */
+    STYX_ERROR_CODE_UNCLOSED_STRUCTURE = 130,
+    /** The document does not have an object at the root. */
+    STYX_ERROR_CODE_UNEXPECTED_EVENT = 131,
+    /** The document is empty. */
+    STYX_ERROR_CODE_EMPTY_DOCUMENT = 132,
+    /** The document is too large for 32-bit offsets. */
+    STYX_ERROR_CODE_TOO_LARGE = 133
+} StyxErrorCode;
+
 /** @brief Opaque handle to a parsed Styx document. */
 typedef struct StyxDocument StyxDocument;
 
-/** @brief Opaque handle to a Styx value. */
-typedef struct StyxValue StyxValue;
+/** @brief Opaque handle to a Styx value. */
+typedef struct StyxValue StyxValue;
+
+/** @brief Opaque handle to a Styx object. */
+typedef struct StyxObject StyxObject;
+
+/** @brief Opaque handle to a Styx sequence. */
+typedef struct StyxSequence StyxSequence;
+
+/** @brief Opaque handle to a compiled path (see styx_path_compile()). */
+typedef struct StyxPath StyxPath;
+
+/**
+ * @brief A borrowed, length-delimited UTF-8 string.
+ *
+ * Views point into storage owned by the document they were obtained from and
+ * stay valid until that document is freed. They are NOT null-terminated;
+ * use `len` (e.g. `printf("%.*s", (int)s.len, s.ptr)`).
+ * `ptr` is NULL when the string is absent.
+ */
+typedef struct StyxStr {
+    /** @brief Pointer to the first byte, or NULL if absent. */
+    const char *STYX_NULLABLE ptr;
+    /** @brief Length in bytes. */
+    size_t len;
+} StyxStr;
+
+/**
+ * @brief One object entry (see styx_object_entries()).
+ *
+ * Borrowed from the document, like StyxStr.
+ */
+typedef struct StyxEntryView {
+    /** @brief Scalar text of the key; `ptr` is NULL for unit or tag-only keys. */
+    StyxStr key;
+    /** @brief The entry's value. */
+    const StyxValue *STYX_NONNULL value;
+} StyxEntryView;
+
+/** @brief Opaque handle to a list of changed paths. */
+typedef struct StyxChanges StyxChanges;
+
+/**
+ * @brief One changed path (see styx_changes_get()).
+ *
+ * `path` is borrowed from the StyxChanges list it came from.
+ */
+typedef struct StyxChange {
+    /** @brief How the value changed. */
+    StyxChangeKind kind;
+    /** @brief The path, in styx_document_get() syntax; NULL if absent. */
+    StyxStr path;
+} StyxChange;
+
+/** @brief Opaque handle to a compiled selector (see styx_selector_compile()). */
+typedef struct StyxSelector StyxSelector;
+
+/** @brief Opaque handle to the values a selector matched. */
+typedef struct StyxSelection StyxSelection;
+
+/** @brief Opaque handle to a compiled schema (see styx_schema_compile()). */
+typedef struct StyxSchema StyxSchema;
+
+/** @brief Opaque handle to a list of schema violations. */
+typedef struct StyxViolations StyxViolations;
+
+/**
+ * @brief One place where a document does not match its schema (see
+ * styx_violations_get()).
+ *
+ * `path` and `message` are borrowed from the StyxViolations list they came
+ * from.
+ */
+typedef struct StyxViolation {
+    /** @brief Path to the value, in styx_document_get() syntax; empty for the root. */
+    StyxStr path;
+    /** @brief What is wrong with the value. */
+    StyxStr message;
+    /** @brief Byte offset of the start of the value (inclusive), or 0 if unknown. */
+    uint32_t span_start;
+    /** @brief Byte offset of the end of the value (exclusive), or 0 if unknown. */
+    uint32_t span_end;
+} StyxViolation;
+
+/**
+ * @brief What a parse did and where its time went (see
+ * styx_parse_with_stats()).
+ */
+typedef struct StyxParseStats {
+    /** @brief Length of the source in bytes. */
+    uint64_t bytes;
+    /** @brief Tokens produced by the tokenizer, including whitespace and comments. */
+    uint64_t tokens;
+    /** @brief Lexemes produced by the lexer. */
+    uint64_t lexemes;
+    /** @brief Events produced by the parser. */
+    uint64_t events;
+    /** @brief Values in the document, counting keys and the root. */
+    uint64_t nodes;
+    /** @brief Heap blocks the finished document retains: strings and entry or item lists. */
+    uint64_t allocations;
+    /** @brief Total capacity of those blocks in bytes. */
+    uint64_t allocated_bytes;
+    /** @brief Nanoseconds spent tokenizing. */
+    uint64_t tokenize_ns;
+    /** @brief Estimated nanoseconds spent turning tokens into lexemes. */
+    uint64_t lex_ns;
+    /** @brief Estimated nanoseconds spent turning lexemes into events. */
+    uint64_t parse_ns;
+    /** @brief Nanoseconds spent building the tree. */
+    uint64_t build_ns;
+} StyxParseStats;
+
+/** @brief Opaque handle to a parser that reuses its buffers. */
+typedef struct StyxParser StyxParser;
+
+/** @brief Opaque handle to a streaming event reader. */
+typedef struct StyxEventReader StyxEventReader;
+
+/** @brief Opaque handle to a streaming writer. */
+typedef struct StyxWriter StyxWriter;
+
+/**
+ * @brief A growable byte buffer that a StyxWriter appends to.
+ *
+ * Start from `{NULL, 0, 0}` or from memory allocated with malloc(). The
+ * writer grows `data` with realloc(); release it with free(). The bytes are
+ * not null-terminated.
+ */
+typedef struct StyxBuffer {
+    /** @brief The bytes written so far, or NULL. */
+    char *STYX_NULLABLE data;
+    /** @brief Number of bytes written. */
+    size_t len;
+    /** @brief Allocated size of `data`. */
+    size_t capacity;
+} StyxBuffer;
+
+/**
+ * @brief Output callback for styx_writer_new_callback().
+ *
+ * Receives the next `len` bytes of output. Return false to stop the writer.
+ */
+typedef bool (*StyxWriteFn)(void *STYX_NULLABLE context, const char *STYX_NONNULL data, size_t len);
+
+/** @brief Opaque handle to the current version of a shared document. */
+typedef struct StyxSnapshotCell StyxSnapshotCell;
+
+/** @brief Opaque handle to an immutable, reference-counted document version. */
+typedef struct StyxSnapshot StyxSnapshot;
+
+/**
+ * @brief A streaming parse event.
+ *
+ * String views point into the source buffer or into the reader, and are valid
+ * only until the next styx_reader_next() call on the same reader.
+ */
+typedef struct StyxEvent {
+    /** @brief The kind of event. */
+    StyxEventKind kind;
+    /** @brief Scalar kind, for KEY and SCALAR events. */
+    StyxScalarKind scalar_kind;
+    /** @brief Byte offset of the start of the event (inclusive). */
+    uint32_t span_start;
+    /** @brief Byte offset of the end of the event (exclusive). */
+    uint32_t span_end;
+    /** @brief Scalar, comment or error text (see StyxEventKind), or NULL. */
+    StyxStr text;
+    /** @brief Tag name for TAG_START and tagged KEY events, or NULL. */
+    StyxStr tag;
+} StyxEvent;
+
+/**
+ * @brief Result of a parse operation.
+ *
+ * After parsing, exactly one of `document` or `error` will be non-null.
+ * The caller must free whichever is non-null using the appropriate free function.
+ */
+typedef struct StyxParseResult {
+    /**
+     * @brief The parsed document, or NULL if parsing failed.
+     * @note Must be freed with styx_free_document() when done.
+     */
+    StyxDocument *STYX_NULLABLE document;
+
+    /**
+     * @brief Error message if parsing failed, or NULL on success.
+     * @note Must be freed with styx_free_string() when done.
+     */
+    char *STYX_NULLABLE error;
+} StyxParseResult;
+
+/**
+ * @brief A parse error, reported without allocating.
+ *
+ * Holds only a code and byte offsets into the source. Format it with
+ * styx_error_message() and locate it with styx_error_position(), passing
+ * the buffer that was parsed.
+ */
+typedef struct StyxError {
+    /** @brief What went wrong (STYX_ERROR_CODE_NONE on success). */
+    StyxErrorCode code;
+    /** @brief Byte offset of the start of the error (inclusive). */
+    uint32_t span_start;
+    /** @brief Byte offset of the end of the error (exclusive). */
+    uint32_t span_end;
+    /** @brief Start of the first occurrence for DUPLICATE_KEY, else 0. */
+    uint32_t related_start;
+    /** @brief End of the first occurrence for DUPLICATE_KEY, else 0. */
+    uint32_t related_end;
+    /**
+     * @brief For REOPENED_PATH and NEST_INTO_TERMINAL, how many leading
+     *        segments of the dotted key at the span name the path, else 0.
+     */
+    uint32_t path_segments;
+} StyxError;
+
+/** @brief A 1-based line and column (see styx_error_position()). */
+typedef struct StyxPosition {
+    /** @brief Line number, counting from 1. */
+    uint32_t line;
+    /** @brief Column in characters, counting from 1. */
+    uint32_t column;
+} StyxPosition;
+
+/* ==========================================================================
+ * Parsing functions
+ * ========================================================================== */
+
+/**
+ * @brief Parse a Styx document from a UTF-8 string.
+ *
+ * @param source A null-terminated UTF-8 string containing the Styx document.
+ * @return A StyxParseResult. Check if `document` is non-null for success.
+ *
+ * @note The caller must free the result:
+ *       - On success: call styx_free_document(result.document)
+ *       - On failure: call styx_free_string(result.error)
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parse(const char *STYX_NONNULL source);
+
+/**
+ * @brief Flag for styx_parse_n(): the buffer is known to be valid UTF-8.
+ *
+ * Skips the UTF-8 validation pass. Passing invalid UTF-8 with this flag set
+ * is undefined behavior.
+ */
+#define STYX_PARSE_TRUSTED_UTF8 (1u << 0)
+
+/**
+ * @brief Parse a Styx document from a length-delimited buffer.
+ *
+ * Unlike styx_parse(), the buffer does not need to be null-terminated, so
+ * documents can be parsed straight out of mmapped files or network buffers.
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @return A StyxParseResult. Check if `document` is non-null for success.
+ *
+ * @note The caller must free the result as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parse_n(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Parse a large Styx document on several threads.
+ *
+ * The document is split between top-level entries and the pieces are parsed
+ * concurrently. The result (including any error) is identical to
+ * styx_parse_n(). Small documents are parsed on the calling thread.
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @param threads Maximum number of threads, or 0 for the number of CPUs.
+ * @return A StyxParseResult. Check if `document` is non-null for success.
+ *
+ * @note The caller must free the result as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parse_parallel(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    size_t threads);
+
+/**
+ * @brief Parse many independent documents on several threads.
+ *
+ * Each result is identical to what styx_parse_n() returns for that input.
+ * Worker threads take inputs from a shared queue, so a few large documents
+ * do not hold up the rest, and each thread reuses its parser state across
+ * the documents it parses. A batch also costs one call instead of `count`.
+ *
+ * @param inputs `count` sources, each of `len` bytes of UTF-8 (`ptr` may be
+ *               NULL if `len` is 0).
+ * @param count The number of inputs.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0; applies to every input.
+ * @param threads Maximum number of threads, or 0 for the number of CPUs.
+ * @param out Receives `count` results, `out[i]` for `inputs[i]`.
+ * @return The number of inputs that parsed successfully.
+ *
+ * @note The caller must free every result as for styx_parse().
+ */
+STYX_API
+size_t styx_parse_batch(
+    const StyxStr *STYX_NULLABLE inputs,
+    size_t count,
+    uint32_t flags,
+    size_t threads,
+    StyxParseResult *STYX_NULLABLE out);
+
+/**
+ * @brief Parse a Styx document, deferring nested objects until first read.
+ *
+ * Only the top level is parsed up front; each nested object is parsed the
+ * first time an accessor reads it. The source is copied, so the buffer may
+ * be freed after the call.
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @return A StyxParseResult. Check if `document` is non-null for success.
+ *
+ * @note Errors inside nested objects are not reported here. An object that
+ *       fails to parse has no entries, and styx_object_error() returns why.
+ *       Use styx_parse_n() when the whole document must be checked up front.
+ * @note The caller must free the result as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parse_lazy(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Parse a document, recording per-phase counts and timings.
+ *
+ * The result is identical to styx_parse_n(). To time the tokenizer, lexer,
+ * parser and tree builder separately, they run as separate passes, so this
+ * takes two to three times as long; no other function pays for it.
+ *
+ * The numbers are estimates. The lexing and parsing times are one pass less
+ * the pass before it, and the allocation counts are the heap blocks the
+ * finished document retains, not every allocation the parse made.
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @param stats Filled in even if parsing fails (with zero node and
+ *              allocation counts), unless the source is not UTF-8. May be NULL.
+ * @return A StyxParseResult, to be freed as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parse_with_stats(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    StyxParseStats *STYX_NULLABLE stats);
+
+/**
+ * @brief Cache parsed documents on disk.
+ *
+ * Once set, styx_parse(), styx_parse_n() and styx_parse_ex() store every
+ * document they parse in the compiled format (see styx_document_compile()),
+ * in a file named after a hash of the source and the library version, and
+ * load it from there the next time the same source is parsed, in this or a
+ * later process. Sources under 1 KiB and sources that fail to parse are not
+ * stored. The directory is created on first use and may be deleted at any
+ * time; I/O errors only cost a parse.
+ *
+ * @param dir Directory for cache entries, or NULL to stop caching.
+ * @return false (leaving the setting unchanged) if `dir` is not a valid path.
+ */
+STYX_API
+bool styx_set_parse_cache(const char *STYX_NULLABLE dir);
+
+/**
+ * @brief Free a parsed document.
+ *
+ * @param doc The document to free, or NULL (no-op if NULL).
+ *
+ * @warning After calling this function, the document pointer and any
+ *          pointers obtained from it (values, objects, sequences) are invalid.
+ */
+STYX_API
+void styx_free_document(StyxDocument *STYX_NULLABLE doc);
+
+/**
+ * @brief Free a string returned by the library.
+ *
+ * @param s The string to free, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_free_string(char *STYX_NULLABLE s);
+
+/* ==========================================================================
+ * Structured errors
+ *
+ * These report errors as plain StyxError values instead of heap-allocated
+ * strings, so a failed parse allocates nothing for the caller to free.
+ * ========================================================================== */
+
+/**
+ * @brief Parse a Styx document, reporting failure as a StyxError.
+ *
+ * Like styx_parse_n(), this uses the parse cache if one is set (see
+ * styx_set_parse_cache()).
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @param error Receives the first error, or STYX_ERROR_CODE_NONE on success
+ *              (may be NULL).
+ * @return The document, or NULL if parsing failed.
+ *
+ * @note A non-null result must be freed with styx_free_document().
+ */
+STYX_API STYX_NODISCARD
+StyxDocument *STYX_NULLABLE styx_parse_ex(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    StyxError *STYX_NULLABLE error);
+
+/**
+ * @brief Collect the syntax errors in a buffer without building a document.
+ *
+ * The parser runs to the end of the input, so one call reports every error
+ * it recovers from, in source order.
+ *
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @param errors Receives the first `capacity` errors (may be NULL if
+ *               `capacity` is 0).
+ * @param capacity The number of StyxError slots in `errors`.
+ * @return The total number of errors, which may exceed `capacity`; 0 if the
+ *         source is well-formed.
+ */
+STYX_API STYX_NODISCARD
+size_t styx_check_syntax(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    StyxError *STYX_NULLABLE errors,
+    size_t capacity);
+
+/**
+ * @brief Format an error as a message, like the strings from styx_parse().
+ *
+ * Follows snprintf(): writes at most `capacity` bytes including the null
+ * terminator, truncating at a character boundary, and returns the full
+ * length so the caller can retry with a larger buffer.
+ *
+ * @param error The error to format.
+ * @param source The buffer that was parsed, used to recover escape
+ *               sequences and paths (may be NULL to leave them blank).
+ * @param len The number of bytes in `source`.
+ * @param buf Destination buffer (may be NULL if `capacity` is 0).
+ * @param capacity The size of `buf` in bytes.
+ * @return The length of the message, excluding the null terminator.
+ */
+STYX_API
+size_t styx_error_message(
+    const StyxError *STYX_NONNULL error,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    char *STYX_NULLABLE buf,
+    size_t capacity);
+
+/**
+ * @brief Compute the line and column where an error starts.
+ *
+ * The source is scanned up to the error, so this costs time proportional to
+ * the offset and is only worth calling when the position is shown.
+ *
+ * @param error The error to locate.
+ * @param source The buffer that was parsed (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @return The 1-based line and column (in characters) of `span_start`.
+ */
+STYX_API STYX_NODISCARD
+StyxPosition styx_error_position(
+    const StyxError *STYX_NONNULL error,
+    const char *STYX_NULLABLE source,
+    size_t len);
+
+/* ==========================================================================
+ * Reusable parsers
+ *
+ * Parsing many small documents with styx_parse_n() allocates and frees the
+ * same parser state every time. A StyxParser keeps it between calls, and
+ * documents handed back with styx_parser_recycle() lend their storage to the
+ * next parse:
+ *
+ *   StyxParser *parser = styx_parser_new();
+ *   for (each message) {
+ *       StyxParseResult r = styx_parser_parse(parser, buf, len, 0);
+ *       ... use r.document ...
+ *       styx_parser_recycle(parser, r.document);
+ *   }
+ *   styx_parser_free(parser);
+ *
+ * A parser must not be used from two threads at once; use one per thread.
+ * ========================================================================== */
+
+/**
+ * @brief Create a parser that keeps its buffers between documents.
+ *
+ * @return A new parser. Free it with styx_parser_free().
+ */
+STYX_API STYX_NODISCARD
+StyxParser *STYX_NONNULL styx_parser_new(void);
+
+/**
+ * @brief Parse a document, reusing the parser's buffers.
+ *
+ * The result is identical to styx_parse_n() on the same input.
+ *
+ * @param parser The parser.
+ * @param source Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `source`.
+ * @param flags Bitwise OR of `STYX_PARSE_*` flags, or 0.
+ * @return A StyxParseResult. Check if `document` is non-null for success.
+ *
+ * @note Free the result as for styx_parse(), or pass the document to
+ *       styx_parser_recycle().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_parser_parse(
+    StyxParser *STYX_NONNULL parser,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Free a document, keeping its storage for later parses.
+ *
+ * The document may come from any parsing function. If `parser` is NULL the
+ * document is simply freed.
+ *
+ * @param parser The parser to give the storage to (may be NULL).
+ * @param doc The document to free (may be NULL).
+ */
+STYX_API
+void styx_parser_recycle(StyxParser *STYX_NULLABLE parser, StyxDocument *STYX_NULLABLE doc);
+
+/**
+ * @brief Free the buffers and recycled storage a parser has kept.
+ *
+ * Use this after an unusually large document to give its memory back.
+ *
+ * @param parser The parser (may be NULL).
+ */
+STYX_API
+void styx_parser_reset(StyxParser *STYX_NULLABLE parser);
+
+/**
+ * @brief Free a parser. Documents it returned stay valid.
+ *
+ * @param parser The parser to free (may be NULL).
+ */
+STYX_API
+void styx_parser_free(StyxParser *STYX_NULLABLE parser);
+
+/* ==========================================================================
+ * Compiled documents
+ * ========================================================================== */
+
+/**
+ * @brief Serialize a document to the compiled binary format.
+ *
+ * Compiled documents load without any text parsing; produce them ahead of
+ * time (e.g. with `styx compile`) to cut start-up cost for large configs.
+ *
+ * @param doc The document.
+ * @param out_len Receives the length of the returned buffer.
+ * @return The compiled bytes, or NULL if doc or out_len is NULL or the
+ *         document is too large for the format's 32-bit offsets.
+ *
+ * @note Free the buffer with styx_free_bytes().
+ */
+STYX_API STYX_NODISCARD
+uint8_t *STYX_NULLABLE styx_document_compile(
+    const StyxDocument *STYX_NULLABLE doc,
+    size_t *STYX_NULLABLE out_len);
+
+/**
+ * @brief Free a buffer returned by styx_document_compile().
+ *
+ * @param bytes The buffer (may be NULL).
+ * @param len The length written to out_len by styx_document_compile().
+ */
+STYX_API
+void styx_free_bytes(uint8_t *STYX_NULLABLE bytes, size_t len);
+
+/**
+ * @brief Load a document from compiled bytes.
+ *
+ * The data is validated and decoded; no text is parsed. The result is a copy
+ * like any parsed document, built several times faster than styx_parse_n()
+ * builds it from text (see the `ffi_load` benchmark).
+ *
+ * @param data Pointer to the compiled bytes (may be NULL if len is 0).
+ * @param len Length of the data in bytes.
+ * @return A StyxParseResult, to be freed as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_load_compiled(const uint8_t *STYX_NULLABLE data, size_t len);
+
+/**
+ * @brief Load a compiled document from a file.
+ *
+ * The file is read into memory and decoded as for styx_load_compiled().
+ *
+ * @param path A null-terminated path to a file produced by styx_document_compile()
+ *             or `styx compile`.
+ * @return A StyxParseResult, to be freed as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_load_compiled_file(const char *STYX_NONNULL path);
+
+/* ==========================================================================
+ * Streaming events
+ * ========================================================================== */
+
+/**
+ * @brief Create a streaming event reader over a buffer.
+ *
+ * The reader parses one event per styx_reader_next() call and never builds a
+ * tree, so memory use stays constant regardless of input size, and the caller
+ * can stop as soon as it has what it needs.
+ *
+ * @param source Pointer to the document bytes (may be NULL if len is 0).
+ * @param len Length of the document in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags (0 for none).
+ * @return A reader, or NULL if the buffer is not valid UTF-8.
+ *
+ * @note The buffer is NOT copied: it must stay alive and unmodified until the
+ *       reader is freed with styx_reader_free().
+ */
+STYX_API STYX_NODISCARD
+StyxEventReader *STYX_NULLABLE styx_reader_new(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Read the next event.
+ *
+ * @param reader The reader.
+ * @param out Receives the event.
+ * @return true if an event was read, false once the stream is exhausted.
+ *
+ * @example
+ * ```c
+ * StyxEvent ev;
+ * while (styx_reader_next(reader, &ev)) {
+ *     if (ev.kind == STYX_EVENT_SCALAR)
+ *         printf("%.*s\n", (int)ev.text.len, ev.text.ptr);
+ * }
+ * ```
+ */
+STYX_API
+bool styx_reader_next(
+    StyxEventReader *STYX_NULLABLE reader,
+    StyxEvent *STYX_NULLABLE out);
+
+/**
+ * @brief Free an event reader.
+ *
+ * @param reader The reader to free (may be NULL).
+ */
+STYX_API
+void styx_reader_free(StyxEventReader *STYX_NULLABLE reader);
+
+/* ==========================================================================
+ * Writing
+ *
+ * A StyxWriter turns push calls into Styx text as they are made, without
+ * building a tree, into either a growable buffer or a callback. The root is
+ * an object, so a document is a series of keys, each followed by its value:
+ *
+ *   StyxBuffer out = {NULL, 0, 0};
+ *   StyxWriter *w = styx_writer_new_buffer(&out, 0);
+ *   styx_writer_key(w, "name", 4);
+ *   styx_writer_scalar(w, "my app", 6);
+ *   styx_writer_key(w, "ports", 5);
+ *   styx_writer_begin_sequence(w);
+ *   styx_writer_int(w, 8080);
+ *   styx_writer_int(w, 8443);
+ *   styx_writer_end(w);
+ *   if (!styx_writer_finish(w)) {
+ *       fprintf(stderr, "%s\n", styx_writer_error(w));
+ *   }
+ *   styx_writer_free(w);
+ *   ... out.data[0..out.len] is `name "my app"\nports (8080 8443)\n` ...
+ *   free(out.data);
+ *
+ * Scalars and keys are written bare when they read back unchanged, and
+ * quoted and escaped otherwise. Errors are sticky: after the first failed
+ * call (a value without a key, an unbalanced end, a failed allocation or
+ * callback...) every call returns false and styx_writer_error() says why.
+ * ========================================================================== */
+
+/**
+ * @brief Flag for styx_writer_new_buffer() and styx_writer_new_callback():
+ *        write nested objects on one line, as `{a 1, b 2}`.
+ */
+#define STYX_WRITE_COMPACT (1u << 0)
+
+/**
+ * @brief Create a writer that appends to a buffer.
+ *
+ * @param buffer The buffer to append to. It must outlive the writer.
+ * @param flags Bitwise OR of `STYX_WRITE_*` flags, or 0.
+ * @return A writer, or NULL if `buffer` is NULL. Free it with styx_writer_free().
+ */
+STYX_API STYX_NODISCARD
+StyxWriter *STYX_NULLABLE styx_writer_new_buffer(
+    StyxBuffer *STYX_NONNULL buffer,
+    uint32_t flags);
+
+/**
+ * @brief Create a writer that hands its output to a callback.
+ *
+ * Output is passed to `write` in chunks of about 64 KiB, and the rest by
+ * styx_writer_finish().
+ *
+ * @param write The callback.
+ * @param context Passed to every `write` call.
+ * @param flags Bitwise OR of `STYX_WRITE_*` flags, or 0.
+ * @return A writer, or NULL if `write` is NULL. Free it with styx_writer_free().
+ */
+STYX_API STYX_NODISCARD
+StyxWriter *STYX_NULLABLE styx_writer_new_callback(
+    StyxWriteFn STYX_NONNULL write,
+    void *STYX_NULLABLE context,
+    uint32_t flags);
+
+/**
+ * @brief Write an entry's key. Keys containing `.` are quoted, so they are
+ *        never read back as dotted paths.
+ *
+ * @param writer The writer (may be NULL).
+ * @param key Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `key`.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_key(StyxWriter *STYX_NULLABLE writer, const char *STYX_NULLABLE key, size_t len);
+
+/**
+ * @brief Write a scalar, bare if possible and quoted otherwise.
+ *
+ * @param writer The writer (may be NULL).
+ * @param text Pointer to `len` bytes of UTF-8 (may be NULL if `len` is 0).
+ * @param len The number of bytes in `text`.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_scalar(StyxWriter *STYX_NULLABLE writer, const char *STYX_NULLABLE text, size_t len);
+
+/**
+ * @brief Write an integer scalar.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_int(StyxWriter *STYX_NULLABLE writer, int64_t value);
+
+/**
+ * @brief Write a float scalar in the shortest form that reads back exactly,
+ *        using exponent form for very large and very small magnitudes.
+ * @return false if `value` is NaN or infinite, or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_float(StyxWriter *STYX_NULLABLE writer, double value);
+
+/**
+ * @brief Write `true` or `false`.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_bool(StyxWriter *STYX_NULLABLE writer, bool value);
+
+/**
+ * @brief Write a unit value: `@` in a sequence, nothing after a key or tag.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_unit(StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Write a tag. The next value is its payload; a tag followed by a
+ *        unit, a key or styx_writer_end() stands alone as `@name`.
+ *
+ * @param writer The writer (may be NULL).
+ * @param name Pointer to `len` bytes: a letter or `_`, then letters, digits, `_` or `-`.
+ * @param len The number of bytes in `name`.
+ * @return false if the name is invalid, the previous call was also a tag,
+ *         or this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_tag(StyxWriter *STYX_NULLABLE writer, const char *STYX_NULLABLE name, size_t len);
+
+/**
+ * @brief Open a nested object as the next value.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_begin_object(StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Open a sequence as the next value.
+ * @return false if this or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_begin_sequence(StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Close the innermost open object or sequence.
+ * @return false if nothing is open, or an earlier call failed.
+ */
+STYX_API
+bool styx_writer_end(StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Finish the document and flush output staged for the callback.
+ * @return true if the whole document was written; false if an object or
+ *         sequence is still open, or any call failed.
+ */
+STYX_API
+bool styx_writer_finish(StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Describe the first call that failed.
+ *
+ * @param writer The writer (may be NULL).
+ * @return A static message, or NULL if nothing has failed. Do not free it.
+ */
+STYX_API STYX_NODISCARD
+const char *STYX_NULLABLE styx_writer_error(const StyxWriter *STYX_NULLABLE writer);
+
+/**
+ * @brief Free a writer. Buffer output stays in the buffer; output staged for
+ *        a callback is dropped unless styx_writer_finish() was called.
+ *
+ * @param writer The writer to free (may be NULL).
+ */
+STYX_API
+void styx_writer_free(StyxWriter *STYX_NULLABLE writer);
+
+/* ==========================================================================
+ * Document access
+ * ========================================================================== */
+
+/**
+ * @brief Get the root object of a document.
+ *
+ * @param doc The document.
+ * @return The root object, or NULL if doc is NULL.
+ *
+ * @note The returned pointer is valid as long as the document is not freed.
+ */
+STYX_API STYX_NODISCARD
+const StyxObject *STYX_NULLABLE styx_document_root(
+    const StyxDocument *STYX_NULLABLE doc);
+
+/**
+ * @brief Get a value by path from a document.
+ *
+ * Paths use `.` for object access and `[n]` for sequence indexing.
+ * Example: "server.hosts[0].name"
+ *
+ * @param doc The document.
+ * @param path A null-terminated path string.
+ * @return The value at the path, or NULL if not found or invalid path.
+ *
+ * @note The returned pointer is valid as long as the document is not freed.
+ */
+STYX_API STYX_NODISCARD
+const StyxValue *STYX_NULLABLE styx_document_get(
+    const StyxDocument *STYX_NULLABLE doc,
+    const char *STYX_NONNULL path);
+
+/**
+ * @brief Build the key index of every wide object in a document.
+ *
+ * Objects with many entries build a hashed key index on their first lookup,
+ * making styx_object_get() and styx_document_get() constant time per segment.
+ * Call this to build them all up front, e.g. before sharing the document
+ * between threads.
+ *
+ * @param doc The document, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_document_build_indexes(const StyxDocument *STYX_NULLABLE doc);
+
+/* ==========================================================================
+ * Change tracking
+ * ========================================================================== */
+
+/**
+ * @brief Update a document in place after an edit to its source.
+ *
+ * The edit replaced bytes `edit_start..edit_end` of the old source with
+ * `new_len` bytes; `source` is the whole new source. Only the top-level
+ * entries the edit touches are re-tokenized and rebuilt, the rest of the tree
+ * is kept. The result is the same as parsing the new source from scratch.
+ *
+ * @param doc The document, previously parsed from the source before the edit.
+ * @param source Pointer to the new source (may be NULL if len is 0).
+ * @param len Length of the new source in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags, as for styx_parse_n().
+ * @param edit_start Start of the replaced range in the old source.
+ * @param edit_end End of the replaced range in the old source (exclusive).
+ * @param new_len Length of the replacement text in bytes.
+ * @param changes If not NULL, receives the list of added, removed and
+ *                changed paths (NULL on error).
+ * @return NULL on success, or an error message. On error the document is
+ *         left unchanged.
+ *
+ * @note Free a returned error with styx_free_string() and `*changes` with
+ *       styx_changes_free(). Views and value pointers previously obtained
+ *       from `doc` are invalidated.
+ */
+STYX_API STYX_NODISCARD
+char *STYX_NULLABLE styx_document_reparse(
+    StyxDocument *STYX_NULLABLE doc,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    size_t edit_start,
+    size_t edit_end,
+    size_t new_len,
+    StyxChanges *STYX_NULLABLE *STYX_NULLABLE changes);
+
+/**
+ * @brief List the paths whose values differ between two documents.
+ *
+ * Every object carries a structural hash computed while it was parsed, so
+ * identical subtrees are skipped without being walked and the cost follows
+ * the size of the difference, not of the documents. Spans, layout and doc
+ * comments are ignored; entries are matched by key.
+ *
+ * @param old The old document.
+ * @param new_doc The new document.
+ * @return The added, removed and changed paths, or NULL if either document
+ *         is NULL.
+ *
+ * @note Free the list with styx_changes_free().
+ */
+STYX_API STYX_NODISCARD
+StyxChanges *STYX_NULLABLE styx_document_diff(
+    const StyxDocument *STYX_NULLABLE old,
+    const StyxDocument *STYX_NULLABLE new_doc);
+
+/**
+ * @brief Get the number of changes in a list.
+ *
+ * @param changes The list, or NULL.
+ * @return The number of changes, or 0 if changes is NULL.
+ */
+STYX_API STYX_NODISCARD
+size_t styx_changes_len(const StyxChanges *STYX_NULLABLE changes);
+
+/**
+ * @brief Get the change at an index.
+ *
+ * @param changes The list.
+ * @param index Index of the change.
+ * @return The change; its `path.ptr` is NULL if changes is NULL or index is
+ *         out of range.
+ *
+ * @note The path view is valid until the list is freed.
+ */
+STYX_API STYX_NODISCARD
+StyxChange styx_changes_get(
+    const StyxChanges *STYX_NULLABLE changes,
+    size_t index);
+
+/**
+ * @brief Free a list of changes.
+ *
+ * @param changes The list to free, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_changes_free(StyxChanges *STYX_NULLABLE changes);
+
+/* ==========================================================================
+ * Snapshots
+ *
+ * A snapshot cell shares the current version of a document between threads,
+ * e.g. a configuration that is reloaded while workers read it:
+ *
+ *   // writer, on reload
+ *   styx_snapshot_publish(cell, styx_parse_n(src, len, 0).document);
+ *
+ *   // reader, per request
+ *   const StyxSnapshot *snap = styx_snapshot_acquire(cell);
+ *   const StyxValue *port = styx_document_get(styx_snapshot_document(snap), "port");
+ *   ...
+ *   styx_snapshot_release(snap);
+ *
+ * Readers never take a lock, and a version is freed once it has been replaced
+ * and its last reader has released it.
+ * ========================================================================== */
+
+/**
+ * @brief Create an empty snapshot cell.
+ *
+ * @return A new cell. Free it with styx_snapshot_cell_free().
+ */
+STYX_API STYX_NODISCARD
+StyxSnapshotCell *STYX_NONNULL styx_snapshot_cell_new(void);
+
+/**
+ * @brief Make a document the current version of a cell.
+ *
+ * Takes ownership of `doc`: it must not be used or freed by the caller
+ * afterwards. Key indexes are built before publishing, except in objects of
+ * a styx_parse_lazy() document that have not been read yet, which stay
+ * unparsed. Snapshots of the previous version stay valid until released.
+ * Publishers are serialized; each waits only for readers in the middle of
+ * styx_snapshot_acquire().
+ *
+ * @param cell The cell (no-op if NULL, apart from freeing `doc`).
+ * @param doc The new version, or NULL to empty the cell.
+ */
+STYX_API
+void styx_snapshot_publish(
+    const StyxSnapshotCell *STYX_NULLABLE cell,
+    StyxDocument *STYX_NULLABLE doc);
+
+/**
+ * @brief Take a reference to the current version of a cell.
+ *
+ * Lock-free, and safe to call from any number of threads at once, including
+ * while another thread publishes.
+ *
+ * @param cell The cell, or NULL.
+ * @return The current snapshot, or NULL if the cell is NULL or empty.
+ *
+ * @note Release the snapshot with styx_snapshot_release().
+ */
+STYX_API STYX_NODISCARD
+const StyxSnapshot *STYX_NULLABLE styx_snapshot_acquire(
+    const StyxSnapshotCell *STYX_NULLABLE cell);
+
+/**
+ * @brief Take another reference to a snapshot (e.g. to hand it to another
+ * thread).
+ *
+ * @param snapshot The snapshot, or NULL.
+ * @return `snapshot`. Release each reference with styx_snapshot_release().
+ */
+STYX_API
+const StyxSnapshot *STYX_NULLABLE styx_snapshot_retain(
+    const StyxSnapshot *STYX_NULLABLE snapshot);
+
+/**
+ * @brief Release a reference to a snapshot.
+ *
+ * @param snapshot The snapshot, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_snapshot_release(const StyxSnapshot *STYX_NULLABLE snapshot);
+
+/**
+ * @brief Get a snapshot's document.
+ *
+ * The document is immutable and may be read concurrently from any number of
+ * threads with the accessor functions.
+ *
+ * @param snapshot The snapshot, or NULL.
+ * @return The document, or NULL if snapshot is NULL. Valid until the snapshot
+ *         is released.
+ *
+ * @note Never pass it to styx_free_document() or styx_document_reparse().
+ */
+STYX_API STYX_NODISCARD
+const StyxDocument *STYX_NULLABLE styx_snapshot_document(
+    const StyxSnapshot *STYX_NULLABLE snapshot);
+
+/**
+ * @brief Free a snapshot cell and its reference to the current version.
+ *
+ * Snapshots already acquired stay valid until released.
+ *
+ * @param cell The cell to free, or NULL (no-op if NULL).
+ *
+ * @note No other thread may be using the cell.
+ */
+STYX_API
+void styx_snapshot_cell_free(StyxSnapshotCell *STYX_NULLABLE cell);
+
+/* ==========================================================================
+ * Compiled paths
+ * ========================================================================== */
 
-/** @brief Opaque handle to a Styx object. */
-typedef struct StyxObject StyxObject;
+/**
+ * @brief Compile a path for repeated lookups.
+ *
+ * Uses the same syntax as styx_document_get(). Segments are split, indices
+ * parsed and key hashes computed once, so evaluating the path against many
+ * documents only walks the tree. A compiled path is immutable and may be
+ * shared between threads.
+ *
+ * @param path A null-terminated path string (e.g., "server.hosts[0].name").
+ * @return A compiled path, or NULL if path is NULL or not valid UTF-8.
+ *
+ * @note Free the path with styx_path_free().
+ */
+STYX_API STYX_NODISCARD
+StyxPath *STYX_NULLABLE styx_path_compile(const char *STYX_NULLABLE path);
 
-/** @brief Opaque handle to a Styx sequence. */
-typedef struct StyxSequence StyxSequence;
+/**
+ * @brief Free a compiled path.
+ *
+ * @param path The path to free (may be NULL).
+ */
+STYX_API
+void styx_path_free(StyxPath *STYX_NULLABLE path);
 
 /**
- * @brief Result of a parse operation.
+ * @brief Resolve a compiled path against a document.
  *
- * After parsing, exactly one of `document` or `error` will be non-null.
- * The caller must free whichever is non-null using the appropriate free function.
+ * Equivalent to styx_document_get() with the path's source string.
+ *
+ * @param doc The document.
+ * @param path The compiled path.
+ * @return The value at the path, or NULL if not found.
+ *
+ * @note The returned pointer is valid as long as the document is not freed.
  */
-typedef struct StyxParseResult {
-    /**
-     * @brief The parsed document, or NULL if parsing failed.
-     * @note Must be freed with styx_free_document() when done.
-     */
-    StyxDocument *STYX_NULLABLE document;
+STYX_API STYX_NODISCARD
+const StyxValue *STYX_NULLABLE styx_path_eval(
+    const StyxDocument *STYX_NULLABLE doc,
+    const StyxPath *STYX_NULLABLE path);
 
-    /**
-     * @brief Error message if parsing failed, or NULL on success.
-     * @note Must be freed with styx_free_string() when done.
-     */
-    char *STYX_NULLABLE error;
-} StyxParseResult;
+/**
+ * @brief Resolve a compiled path starting at a value.
+ *
+ * Equivalent to styx_value_get() with the path's source string.
+ *
+ * @param value The starting value.
+ * @param path The compiled path.
+ * @return The value at the path, or NULL if not found.
+ *
+ * @note The returned pointer is valid as long as the parent document is not freed.
+ */
+STYX_API STYX_NODISCARD
+const StyxValue *STYX_NULLABLE styx_path_eval_value(
+    const StyxValue *STYX_NULLABLE value,
+    const StyxPath *STYX_NULLABLE path);
+
+/**
+ * @brief Resolve several compiled paths against a document in one call.
+ *
+ * @param doc The document.
+ * @param paths Array of @p count compiled paths (entries may be NULL).
+ * @param count Number of paths.
+ * @param out Array of @p count slots; out[i] receives the value for
+ *            paths[i], or NULL if it was not found.
+ * @return The number of paths that were found.
+ *
+ * @note The returned pointers are valid as long as the document is not freed.
+ */
+STYX_API
+size_t styx_path_eval_batch(
+    const StyxDocument *STYX_NULLABLE doc,
+    const StyxPath *STYX_NULLABLE const *STYX_NULLABLE paths,
+    size_t count,
+    const StyxValue *STYX_NULLABLE *STYX_NULLABLE out);
 
 /* ==========================================================================
- * Parsing functions
+ * Selectors
+ *
+ * A selector picks out every value matching a pattern, where a path picks
+ * out at most one. On top of path syntax it adds wildcards (`.*`, `[*]`),
+ * recursive descent (`..name`, `..*`) and filters on the value just
+ * matched (`[@env]`, `[@tag=env]`, `[name=web]`):
+ *
+ *   StyxSelector *sel = NULL;
+ *   char *error = styx_selector_compile("servers[*][role=web].port", &sel);
+ *   ...
+ *   StyxSelection *ports = styx_select(doc, sel);
+ *   for (size_t i = 0; i < styx_selection_len(ports); i++) { ... }
+ *   styx_selection_free(ports);
+ *
+ * styx_select_source() and styx_reader_select() match while parsing and
+ * only build the subtrees that match. Compiled selectors are immutable and
+ * may be shared between threads.
  * ========================================================================== */
 
 /**
- * @brief Parse a Styx document from a UTF-8 string.
+ * @brief Compile a selector.
  *
- * @param source A null-terminated UTF-8 string containing the Styx document.
- * @return A StyxParseResult. Check if `document` is non-null for success.
+ * @param text A null-terminated selector (e.g., "hosts[*].port").
+ * @param selector Receives the compiled selector, or NULL on error.
+ * @return NULL on success, or an error message giving the byte offset of
+ *         the problem.
  *
- * @note The caller must free the result:
- *       - On success: call styx_free_document(result.document)
- *       - On failure: call styx_free_string(result.error)
+ * @note Free a returned error with styx_free_string() and `*selector` with
+ *       styx_selector_free().
  */
 STYX_API STYX_NODISCARD
-StyxParseResult styx_parse(const char *STYX_NONNULL source);
+char *STYX_NULLABLE styx_selector_compile(
+    const char *STYX_NULLABLE text,
+    StyxSelector *STYX_NULLABLE *STYX_NULLABLE selector);
 
 /**
- * @brief Free a parsed document.
- *
- * @param doc The document to free, or NULL (no-op if NULL).
+ * @brief Free a compiled selector.
  *
- * @warning After calling this function, the document pointer and any
- *          pointers obtained from it (values, objects, sequences) are invalid.
+ * @param selector The selector to free (may be NULL).
  */
 STYX_API
-void styx_free_document(StyxDocument *STYX_NULLABLE doc);
+void styx_selector_free(StyxSelector *STYX_NULLABLE selector);
 
 /**
- * @brief Free a string returned by the library.
+ * @brief Select every matching value in a document.
  *
- * @param s The string to free, or NULL (no-op if NULL).
+ * Matches are in document order; the root object is never a match.
+ *
+ * @param doc The document.
+ * @param selector The compiled selector.
+ * @return The matches, or NULL if either argument is NULL.
+ *
+ * @note The values borrow from the document, which must outlive the
+ *       selection. Free the selection with styx_selection_free().
+ */
+STYX_API STYX_NODISCARD
+StyxSelection *STYX_NULLABLE styx_select(
+    const StyxDocument *STYX_NULLABLE doc,
+    const StyxSelector *STYX_NULLABLE selector);
+
+/**
+ * @brief Select matching values while parsing a source.
+ *
+ * The document is never built: events outside a match are skipped, and
+ * only matched subtrees are turned into values. Gives the same matches as
+ * styx_parse_n() followed by styx_select().
+ *
+ * @param selector The compiled selector.
+ * @param source Pointer to the source (may be NULL if len is 0).
+ * @param len Length of the source in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags, as for styx_parse_n().
+ * @param selection Receives the matches, or NULL on error.
+ * @return NULL on success, or the parse error.
+ *
+ * @note Free a returned error with styx_free_string() and `*selection` with
+ *       styx_selection_free(). The selection owns its values.
+ */
+STYX_API STYX_NODISCARD
+char *STYX_NULLABLE styx_select_source(
+    const StyxSelector *STYX_NULLABLE selector,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    StyxSelection *STYX_NULLABLE *STYX_NULLABLE selection);
+
+/**
+ * @brief Select matching values from the rest of an event reader's stream.
+ *
+ * Works like styx_select_source() on the reader's stream. Selector steps
+ * start at the document root, so it must be called before any
+ * styx_reader_next() (or earlier styx_reader_select()) call on the reader;
+ * otherwise it returns an error and reads nothing. The reader is left
+ * exhausted.
+ *
+ * @param reader The event reader.
+ * @param selector The compiled selector.
+ * @param selection Receives the matches, or NULL on error.
+ * @return NULL on success, or the parse error, or an error if the reader
+ *         has already returned events.
+ *
+ * @note Free a returned error with styx_free_string() and `*selection` with
+ *       styx_selection_free(). The selection owns its values.
+ */
+STYX_API STYX_NODISCARD
+char *STYX_NULLABLE styx_reader_select(
+    StyxEventReader *STYX_NULLABLE reader,
+    const StyxSelector *STYX_NULLABLE selector,
+    StyxSelection *STYX_NULLABLE *STYX_NULLABLE selection);
+
+/**
+ * @brief Get the number of values in a selection.
+ *
+ * @param selection The selection, or NULL.
+ * @return The number of values, or 0 if selection is NULL.
+ */
+STYX_API STYX_NODISCARD
+size_t styx_selection_len(const StyxSelection *STYX_NULLABLE selection);
+
+/**
+ * @brief Get the value at an index in a selection.
+ *
+ * @param selection The selection.
+ * @param index Zero-based index.
+ * @return The value, or NULL if selection is NULL or index is out of range.
+ *
+ * @note The pointer is valid as long as the selection is not freed (and,
+ *       for styx_select(), the document).
+ */
+STYX_API STYX_NODISCARD
+const StyxValue *STYX_NULLABLE styx_selection_get(
+    const StyxSelection *STYX_NULLABLE selection,
+    size_t index);
+
+/**
+ * @brief Free a selection.
+ *
+ * @param selection The selection to free (may be NULL).
  */
 STYX_API
-void styx_free_string(char *STYX_NULLABLE s);
+void styx_selection_free(StyxSelection *STYX_NULLABLE selection);
 
 /* ==========================================================================
- * Document access
+ * Schemas
+ *
+ * A schema file is compiled once into a validation program: type references
+ * are resolved, constraints parsed and each object type gets a precomputed
+ * key table. The compiled schema is immutable and may validate documents on
+ * any number of threads at once:
+ *
+ *   StyxSchema *schema = NULL;
+ *   char *error = styx_schema_compile(src, len, 0, &schema);
+ *   ...
+ *   if (!styx_schema_validate(schema, doc, NULL)) { reject(doc); }
+ *
+ * styx_schema_check() and styx_schema_parse() validate while parsing, and
+ * stop at the first violation without building the rest of the document.
  * ========================================================================== */
 
 /**
- * @brief Get the root object of a document.
+ * @brief Compile a schema file.
  *
- * @param doc The document.
- * @return The root object, or NULL if doc is NULL.
+ * The source is a schema file with a `schema` block, whose `@` entry
+ * describes the document root. Every type reference must name a built-in
+ * type or a type defined in the block. `pattern` constraints are accepted
+ * but not enforced.
  *
- * @note The returned pointer is valid as long as the document is not freed.
+ * @param source Pointer to the schema source (may be NULL if len is 0).
+ * @param len Length of the source in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags, as for styx_parse_n().
+ * @param schema Receives the compiled schema, or NULL on error.
+ * @return NULL on success, or an error message.
+ *
+ * @note Free a returned error with styx_free_string() and `*schema` with
+ *       styx_schema_free().
  */
 STYX_API STYX_NODISCARD
-const StyxObject *STYX_NULLABLE styx_document_root(
-    const StyxDocument *STYX_NULLABLE doc);
+char *STYX_NULLABLE styx_schema_compile(
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags,
+    StyxSchema *STYX_NULLABLE *STYX_NULLABLE schema);
 
 /**
- * @brief Get a value by path from a document.
+ * @brief Free a compiled schema.
  *
- * Paths use `.` for object access and `[n]` for sequence indexing.
- * Example: "server.hosts[0].name"
+ * @param schema The schema to free (may be NULL).
+ */
+STYX_API
+void styx_schema_free(StyxSchema *STYX_NULLABLE schema);
+
+/**
+ * @brief Validate a document against a schema's root type.
  *
- * @param doc The document.
- * @param path A null-terminated path string.
- * @return The value at the path, or NULL if not found or invalid path.
+ * With `violations` NULL, validation stops at the first violation and
+ * builds no messages, which is the fast path for accept/reject decisions.
  *
- * @note The returned pointer is valid as long as the document is not freed.
+ * @param schema The compiled schema.
+ * @param doc The document to validate.
+ * @param violations If not NULL, receives the list of violations (NULL when
+ *                   the document is valid).
+ * @return true if the document matches the schema; false if it does not or
+ *         either argument is NULL.
+ *
+ * @note Free `*violations` with styx_violations_free().
  */
-STYX_API STYX_NODISCARD
-const StyxValue *STYX_NULLABLE styx_document_get(
+STYX_API
+bool styx_schema_validate(
+    const StyxSchema *STYX_NULLABLE schema,
     const StyxDocument *STYX_NULLABLE doc,
-    const char *STYX_NONNULL path);
+    StyxViolations *STYX_NULLABLE *STYX_NULLABLE violations);
+
+/**
+ * @brief Parse a document and check it against a schema in one pass,
+ *        without building a tree.
+ *
+ * The document is rejected at the first parse error or violation, so an
+ * invalid document costs only the part read up to it.
+ *
+ * @param schema The compiled schema.
+ * @param source Pointer to the document source (may be NULL if len is 0).
+ * @param len Length of the source in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags, as for styx_parse_n().
+ * @return NULL if the document is valid, or the first error, with
+ *         violations formatted as "path: message".
+ *
+ * @note Free a returned error with styx_free_string().
+ */
+STYX_API STYX_NODISCARD
+char *STYX_NULLABLE styx_schema_check(
+    const StyxSchema *STYX_NULLABLE schema,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Parse a document that must be valid against a schema.
+ *
+ * Validation runs while the document is parsed; at the first violation the
+ * partial document is discarded and the violation returned as the error.
+ *
+ * @param schema The compiled schema.
+ * @param source Pointer to the document source (may be NULL if len is 0).
+ * @param len Length of the source in bytes.
+ * @param flags Bitwise OR of STYX_PARSE_* flags, as for styx_parse_n().
+ * @return Parse result; free it as for styx_parse().
+ */
+STYX_API STYX_NODISCARD
+StyxParseResult styx_schema_parse(
+    const StyxSchema *STYX_NULLABLE schema,
+    const char *STYX_NULLABLE source,
+    size_t len,
+    uint32_t flags);
+
+/**
+ * @brief Get the number of violations in a list.
+ *
+ * @param violations The list, or NULL.
+ * @return The number of violations, or 0 if violations is NULL.
+ */
+STYX_API STYX_NODISCARD
+size_t styx_violations_len(const StyxViolations *STYX_NULLABLE violations);
+
+/**
+ * @brief Get the violation at an index.
+ *
+ * @param violations The list.
+ * @param index Index of the violation.
+ * @return The violation; its `path.ptr` and `message.ptr` are NULL if
+ *         violations is NULL or index is out of range.
+ *
+ * @note The string views are valid until the list is freed.
+ */
+STYX_API STYX_NODISCARD
+StyxViolation styx_violations_get(
+    const StyxViolations *STYX_NULLABLE violations,
+    size_t index);
+
+/**
+ * @brief Free a list of violations.
+ *
+ * @param violations The list to free, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_violations_free(StyxViolations *STYX_NULLABLE violations);
 
 /* ==========================================================================
  * Value inspection
@@ -258,6 +1757,93 @@ char *STYX_NULLABLE styx_value_tag(const StyxValue *STYX_NULLABLE value);
 STYX_API STYX_NODISCARD
 char *STYX_NULLABLE styx_value_scalar(const StyxValue *STYX_NULLABLE value);
 
+/**
+ * @brief Get the tag name of a value without allocating.
+ *
+ * @param value The value to inspect.
+ * @return A view of the tag name, with `ptr == NULL` if there is no tag.
+ *
+ * @note The view is valid as long as the parent document is not freed.
+ */
+STYX_API STYX_NODISCARD
+StyxStr styx_value_tag_view(const StyxValue *STYX_NULLABLE value);
+
+/**
+ * @brief Get the scalar text content of a value without allocating.
+ *
+ * @param value The value to inspect.
+ * @return A view of the scalar text, with `ptr == NULL` if not a scalar.
+ *
+ * @note The view is valid as long as the parent document is not freed.
+ */
+STYX_API STYX_NODISCARD
+StyxStr styx_value_scalar_view(const StyxValue *STYX_NULLABLE value);
+
+/**
+ * @brief Parse a value's scalar text as a signed decimal integer.
+ *
+ * Reads the stored text in place, with no allocation. Accepts an optional
+ * `+` or `-` sign followed by ASCII digits.
+ *
+ * @param value The value to read.
+ * @param out Receives the number on success (unchanged otherwise); may be
+ *        NULL to only check the value.
+ * @return STYX_SCALAR_STATUS_OK, or why the value could not be read.
+ *
+ * @example
+ * ```c
+ * int64_t port = 8080; // kept unless "port" holds a valid integer
+ * styx_value_as_i64(styx_document_get(doc, "port"), &port);
+ * ```
+ */
+STYX_API
+StyxScalarStatus styx_value_as_i64(
+    const StyxValue *STYX_NULLABLE value,
+    int64_t *STYX_NULLABLE out);
+
+/**
+ * @brief Parse a value's scalar text as an unsigned decimal integer.
+ *
+ * As styx_value_as_i64(); negative numbers (other than `-0`) are
+ * STYX_SCALAR_STATUS_OUT_OF_RANGE.
+ */
+STYX_API
+StyxScalarStatus styx_value_as_u64(
+    const StyxValue *STYX_NULLABLE value,
+    uint64_t *STYX_NULLABLE out);
+
+/**
+ * @brief Parse a value's scalar text as a floating-point number.
+ *
+ * Accepts decimal and exponent forms with an optional sign, and `inf`,
+ * `infinity` or `nan` in any case. Finite numbers beyond the range of a
+ * double are STYX_SCALAR_STATUS_OUT_OF_RANGE; numbers too small round to zero.
+ */
+STYX_API
+StyxScalarStatus styx_value_as_f64(
+    const StyxValue *STYX_NULLABLE value,
+    double *STYX_NULLABLE out);
+
+/**
+ * @brief Parse scalar text, such as StyxEvent::text, as a floating-point number.
+ *
+ * Accepts the same spellings as styx_value_as_f64(). Unlike strtod(), the
+ * result does not depend on the C locale's decimal separator.
+ *
+ * @param text The text; STYX_SCALAR_STATUS_NOT_SCALAR if `ptr` is NULL.
+ * @param out Receives the number, or NULL to only check the text.
+ */
+STYX_API
+StyxScalarStatus styx_str_as_f64(StyxStr text, double *STYX_NULLABLE out);
+
+/**
+ * @brief Parse a value's scalar text as `true` or `false`.
+ */
+STYX_API
+StyxScalarStatus styx_value_as_bool(
+    const StyxValue *STYX_NULLABLE value,
+    bool *STYX_NULLABLE out);
+
 /**
  * @brief Get the object payload of a value.
  *
@@ -309,6 +1895,21 @@ const StyxValue *STYX_NULLABLE styx_value_get(
 STYX_API STYX_NODISCARD
 size_t styx_object_len(const StyxObject *STYX_NULLABLE obj);
 
+/**
+ * @brief Get the error that stopped a lazily parsed object from parsing.
+ *
+ * Objects from styx_parse_lazy() are parsed on first read, so their errors
+ * surface late: such an object has no entries. This parses the object if it
+ * has not been read yet and reports what went wrong.
+ *
+ * @param obj The object, or NULL.
+ * @return The error message, or NULL if the object parsed or obj is NULL.
+ *
+ * @note Must be freed with styx_free_string() when not NULL.
+ */
+STYX_API STYX_NODISCARD
+char *STYX_NULLABLE styx_object_error(const StyxObject *STYX_NULLABLE obj);
+
 /**
  * @brief Get a value from an object by key.
  *
@@ -323,6 +1924,17 @@ const StyxValue *STYX_NULLABLE styx_object_get(
     const StyxObject *STYX_NULLABLE obj,
     const char *STYX_NONNULL key);
 
+/**
+ * @brief Build the key index of an object now, regardless of its size.
+ *
+ * Lookups into objects below the size threshold are linear scans, which is
+ * usually faster for a handful of keys; use this to force an index anyway.
+ *
+ * @param obj The object, or NULL (no-op if NULL).
+ */
+STYX_API
+void styx_object_build_index(const StyxObject *STYX_NULLABLE obj);
+
 /**
  * @brief Get the key at a given index in an object.
  *
@@ -337,6 +1949,21 @@ const StyxValue *STYX_NULLABLE styx_object_key_at(
     const StyxObject *STYX_NULLABLE obj,
     size_t index);
 
+/**
+ * @brief Get the scalar text of the key at a given index, without allocating.
+ *
+ * @param obj The object.
+ * @param index The index (must be < styx_object_len(obj)).
+ * @return A view of the key text, with `ptr == NULL` if the index is out of
+ *         bounds or the key is not a scalar (use styx_object_key_at() for those).
+ *
+ * @note The view is valid as long as the parent document is not freed.
+ */
+STYX_API STYX_NODISCARD
+StyxStr styx_object_key_view_at(
+    const StyxObject *STYX_NULLABLE obj,
+    size_t index);
+
 /**
  * @brief Get the value at a given index in an object.
  *
@@ -351,6 +1978,26 @@ const StyxValue *STYX_NULLABLE styx_object_value_at(
     const StyxObject *STYX_NULLABLE obj,
     size_t index);
 
+/**
+ * @brief Fetch up to `cap` entries of an object in one call.
+ *
+ * Cheaper than calling styx_object_key_view_at() and styx_object_value_at()
+ * per index for large objects.
+ *
+ * @param obj The object, or NULL.
+ * @param out Array of at least `cap` entries (may be NULL if `cap` is 0).
+ * @param cap Capacity of `out`.
+ * @return The total number of entries in the object, which may exceed `cap`
+ *         (only the first `cap` are written). Pass `cap` 0 to size `out`.
+ *
+ * @note The views are valid as long as the parent document is not freed.
+ */
+STYX_API
+size_t styx_object_entries(
+    const StyxObject *STYX_NULLABLE obj,
+    StyxEntryView *STYX_NULLABLE out,
+    size_t cap);
+
 /* ==========================================================================
  * Sequence access
  * ========================================================================== */
@@ -378,6 +2025,23 @@ const StyxValue *STYX_NULLABLE styx_sequence_get(
     const StyxSequence *STYX_NULLABLE seq,
     size_t index);
 
+/**
+ * @brief Fetch up to `cap` item pointers of a sequence in one call.
+ *
+ * @param seq The sequence, or NULL.
+ * @param out Array of at least `cap` pointers (may be NULL if `cap` is 0).
+ * @param cap Capacity of `out`.
+ * @return The total number of items in the sequence, which may exceed `cap`
+ *         (only the first `cap` are written). Pass `cap` 0 to size `out`.
+ *
+ * @note The pointers are valid as long as the parent document is not freed.
+ */
+STYX_API
+size_t styx_sequence_items(
+    const StyxSequence *STYX_NULLABLE seq,
+    const StyxValue *STYX_NULLABLE *STYX_NULLABLE out,
+    size_t cap);
+
 STYX_EXTERN_C_END
 
 #endif /* STYX_H */
@@ -0,0 +1,1089 @@
+/**
+ * @file styx.hpp
+ * @brief Header-only C++17 wrapper over the Styx C API.
+ *
+ * Adds RAII ownership, `std::string_view` accessors backed by the borrowed
+ * views of styx.h (no copies), range-for iteration over objects and
+ * sequences, and typed getters that parse scalars in place.
+ *
+ * @example
+ * ```cpp
+ * auto doc = styx::document::parse("server {host localhost, port 8080}");
+ * auto port = doc["server.port"].as<uint16_t>().value_or(80);
+ * for (auto [key, value] : doc.root()) {
+ *     std::cout << key << "\n";
+ * }
+ * ```
+ *
+ * All views (`value`, `object`, `sequence`, and the `std::string_view`s they
+ * return) borrow from the owning `styx::document` (or `styx::snapshot`) and
+ * are invalidated when it is destroyed.
+ */
+
+#ifndef STYX_HPP
+#define STYX_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "styx.h"
+
+namespace styx {
+
+/* ==========================================================================
+ * Scalar parsing
+ * ========================================================================== */
+
+namespace detail {
+
+inline constexpr std::string_view view(StyxStr s) noexcept {
+    return s.ptr ? std::string_view(s.ptr, s.len) : std::string_view();
+}
+
+/** Parse a decimal integer with an optional sign, like Rust's `str::parse`. */
+template <typename T>
+constexpr std::optional<T> parse_int(std::string_view text) noexcept {
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>);
+    using U = std::make_unsigned_t<T>;
+
+    bool negative = false;
+    std::size_t i = 0;
+    if (!text.empty() && (text[0] == '+' || text[0] == '-')) {
+        negative = text[0] == '-';
+        i = 1;
+    }
+    if (i == text.size() || (negative && std::is_unsigned_v<T>)) {
+        return std::nullopt;
+    }
+
+    // Largest magnitude representable with this sign.
+    U limit = std::numeric_limits<T>::max();
+    if (negative) {
+        limit = U(limit) + 1;
+    }
+
+    U magnitude = 0;
+    for (; i < text.size(); i++) {
+        char c = text[i];
+        if (c < '0' || c > '9') {
+            return std::nullopt;
+        }
+        U digit = U(c - '0');
+        if (magnitude > (limit - digit) / 10) {
+            return std::nullopt;
+        }
+        magnitude = U(magnitude * 10 + digit);
+    }
+
+    if constexpr (std::is_signed_v<T>) {
+        if (negative) {
+            // Two's complement negation, valid for the minimum value too.
+            return T(U(0) - magnitude);
+        }
+    }
+    return T(magnitude);
+}
+
+/** Parse `true` or `false`. */
+constexpr std::optional<bool> parse_bool(std::string_view text) noexcept {
+    if (text == "true") {
+        return true;
+    }
+    if (text == "false") {
+        return false;
+    }
+    return std::nullopt;
+}
+
+/** Parse a floating-point number (decimal or exponent form, `inf`, `nan`). */
+template <typename T>
+std::optional<T> parse_float(std::string_view text) noexcept {
+    // from_chars rejects a leading '+', which Rust's parser accepts.
+    if (!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+    }
+    T out{};
+    const char *end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, out);
+    if (ec != std::errc() || ptr != end || text.empty()) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+} // namespace detail
+
+/* ==========================================================================
+ * Errors
+ * ========================================================================== */
+
+/** @brief Thrown when a document fails to parse. */
+class parse_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/** @brief Thrown by writer::finish() when writing failed. */
+class write_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Format `error` against the source it came from (see
+ * styx_error_message()).
+ */
+inline std::string error_message(const StyxError &error, std::string_view source) {
+    std::string message(styx_error_message(&error, source.data(), source.size(), nullptr, 0),
+                        '\0');
+    styx_error_message(&error, source.data(), source.size(), message.data(), message.size() + 1);
+    return message;
+}
+
+/** @brief Every syntax error in `source`, in source order (see styx_check_syntax()). */
+inline std::vector<StyxError> check_syntax(std::string_view source) {
+    std::vector<StyxError> errors(8);
+    std::size_t count =
+        styx_check_syntax(source.data(), source.size(), 0, errors.data(), errors.size());
+    if (count > errors.size()) {
+        errors.resize(count);
+        count = styx_check_syntax(source.data(), source.size(), 0, errors.data(), errors.size());
+    }
+    errors.resize(count);
+    return errors;
+}
+
+/* ==========================================================================
+ * Views
+ * ========================================================================== */
+
+class object;
+class sequence;
+
+/**
+ * @brief A borrowed Styx value. Null (falsy) when a lookup found nothing.
+ */
+class value {
+public:
+    constexpr value() noexcept = default;
+    constexpr explicit value(const StyxValue *raw) noexcept : raw_(raw) {}
+
+    /** @brief Whether this refers to a value. */
+    constexpr explicit operator bool() const noexcept { return raw_ != nullptr; }
+
+    /** @brief The underlying C handle. */
+    constexpr const StyxValue *raw() const noexcept { return raw_; }
+
+    StyxPayloadKind kind() const noexcept { return styx_value_payload_kind(raw_); }
+    bool is_unit() const noexcept { return styx_value_is_unit(raw_); }
+    bool is_scalar() const noexcept { return kind() == STYX_PAYLOAD_KIND_SCALAR; }
+    bool is_object() const noexcept { return kind() == STYX_PAYLOAD_KIND_OBJECT; }
+    bool is_sequence() const noexcept { return kind() == STYX_PAYLOAD_KIND_SEQUENCE; }
+
+    /** @brief The tag name without `@`, or nullopt if untagged. */
+    std::optional<std::string_view> tag() const noexcept {
+        StyxStr s = styx_value_tag_view(raw_);
+        if (!s.ptr) {
+            return std::nullopt;
+        }
+        return detail::view(s);
+    }
+
+    /** @brief The scalar text, or nullopt if not a scalar. */
+    std::optional<std::string_view> text() const noexcept {
+        StyxStr s = styx_value_scalar_view(raw_);
+        if (!s.ptr) {
+            return std::nullopt;
+        }
+        return detail::view(s);
+    }
+
+    /**
+     * @brief Interpret the scalar as `T`, parsed in place.
+     *
+     * Supports `std::string_view`, `bool` (`true`/`false`), integer types
+     * (decimal, range-checked) and floating-point types. Returns nullopt if
+     * this is not a scalar or the text does not parse as `T`.
+     */
+    template <typename T>
+    std::optional<T> as() const noexcept {
+        auto s = text();
+        if (!s) {
+            return std::nullopt;
+        }
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return s;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return detail::parse_bool(*s);
+        } else if constexpr (std::is_integral_v<T>) {
+            return detail::parse_int<T>(*s);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return detail::parse_float<T>(*s);
+        } else {
+            static_assert(!sizeof(T), "unsupported type for styx::value::as<T>()");
+        }
+    }
+
+    /** @brief This value as an object (empty view if not an object). */
+    object as_object() const noexcept;
+
+    /** @brief This value as a sequence (empty view if not a sequence). */
+    sequence as_sequence() const noexcept;
+
+    /** @brief Look up a dotted path (see styx_value_get()). */
+    value operator[](const char *path) const noexcept {
+        return value(styx_value_get(raw_, path));
+    }
+    value operator[](const std::string &path) const noexcept { return (*this)[path.c_str()]; }
+
+private:
+    const StyxValue *raw_ = nullptr;
+};
+
+/** @brief One object entry. `key` has a null `data()` for a unit key. */
+struct entry {
+    std::string_view key;
+    styx::value value;
+};
+
+/**
+ * @brief A borrowed Styx object, iterable as a range of `entry`.
+ *
+ * begin() fetches every entry view in one styx_object_entries() call, so
+ * iterating costs one crossing into the library rather than two per entry.
+ */
+class object {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = entry;
+
+        iterator() noexcept = default;
+        iterator(std::shared_ptr<const std::vector<StyxEntryView>> views,
+                 std::size_t index) noexcept
+            : views_(std::move(views)), index_(index) {}
+
+        entry operator*() const noexcept {
+            const StyxEntryView &view = (*views_)[index_];
+            return entry{detail::view(view.key), styx::value(view.value)};
+        }
+        iterator &operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++index_;
+            return old;
+        }
+        bool operator==(const iterator &other) const noexcept {
+            return index_ == other.index_;
+        }
+        bool operator!=(const iterator &other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        std::shared_ptr<const std::vector<StyxEntryView>> views_;
+        std::size_t index_ = 0;
+    };
+
+    constexpr object() noexcept = default;
+    constexpr explicit object(const StyxObject *raw) noexcept : raw_(raw) {}
+
+    constexpr explicit operator bool() const noexcept { return raw_ != nullptr; }
+    constexpr const StyxObject *raw() const noexcept { return raw_; }
+
+    std::size_t size() const noexcept { return styx_object_len(raw_); }
+    bool empty() const noexcept { return size() == 0; }
+
+    iterator begin() const {
+        auto views = std::make_shared<std::vector<StyxEntryView>>(size());
+        entries(views->data(), views->size());
+        return iterator(std::move(views), 0);
+    }
+    iterator end() const noexcept { return iterator(nullptr, size()); }
+
+    /** @brief Look up a direct child by key. */
+    styx::value get(const char *key) const noexcept {
+        return styx::value(styx_object_get(raw_, key));
+    }
+    styx::value get(const std::string &key) const noexcept { return get(key.c_str()); }
+
+    /** @brief Build the key index now instead of on first lookup. */
+    void build_index() const noexcept { styx_object_build_index(raw_); }
+
+    /**
+     * @brief Why a lazily parsed object failed to parse (see styx_object_error()).
+     * @return The error, or nothing if the object parsed.
+     */
+    std::optional<std::string> error() const {
+        char *error = styx_object_error(raw_);
+        if (!error) {
+            return std::nullopt;
+        }
+        std::string message = error;
+        styx_free_string(error);
+        return message;
+    }
+
+    /**
+     * @brief Fetch up to `cap` entries in one call (see styx_object_entries()).
+     * @return The total number of entries, which may exceed `cap`.
+     */
+    std::size_t entries(StyxEntryView *out, std::size_t cap) const noexcept {
+        return styx_object_entries(raw_, out, cap);
+    }
+
+private:
+    const StyxObject *raw_ = nullptr;
+};
+
+/**
+ * @brief A borrowed Styx sequence, iterable as a range of `value`.
+ *
+ * begin() fetches every item pointer in one styx_sequence_items() call.
+ */
+class sequence {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = styx::value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = styx::value;
+
+        iterator() noexcept = default;
+        iterator(std::shared_ptr<const std::vector<const StyxValue *>> items,
+                 std::size_t index) noexcept
+            : items_(std::move(items)), index_(index) {}
+
+        styx::value operator*() const noexcept { return styx::value((*items_)[index_]); }
+        iterator &operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++index_;
+            return old;
+        }
+        bool operator==(const iterator &other) const noexcept {
+            return index_ == other.index_;
+        }
+        bool operator!=(const iterator &other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        std::shared_ptr<const std::vector<const StyxValue *>> items_;
+        std::size_t index_ = 0;
+    };
+
+    constexpr sequence() noexcept = default;
+    constexpr explicit sequence(const StyxSequence *raw) noexcept : raw_(raw) {}
+
+    constexpr explicit operator bool() const noexcept { return raw_ != nullptr; }
+    constexpr const StyxSequence *raw() const noexcept { return raw_; }
+
+    std::size_t size() const noexcept { return styx_sequence_len(raw_); }
+    bool empty() const noexcept { return size() == 0; }
+
+    iterator begin() const {
+        auto pointers = std::make_shared<std::vector<const StyxValue *>>(size());
+        items(pointers->data(), pointers->size());
+        return iterator(std::move(pointers), 0);
+    }
+    iterator end() const noexcept { return iterator(nullptr, size()); }
+
+    /** @brief The item at `index`, or a null value if out of bounds. */
+    styx::value operator[](std::size_t index) const noexcept {
+        return styx::value(styx_sequence_get(raw_, index));
+    }
+
+    /**
+     * @brief Fetch up to `cap` item pointers in one call (see styx_sequence_items()).
+     * @return The total number of items, which may exceed `cap`.
+     */
+    std::size_t items(const StyxValue **out, std::size_t cap) const noexcept {
+        return styx_sequence_items(raw_, out, cap);
+    }
+
+private:
+    const StyxSequence *raw_ = nullptr;
+};
+
+inline object value::as_object() const noexcept { return object(styx_value_as_object(raw_)); }
+
+inline sequence value::as_sequence() const noexcept {
+    return sequence(styx_value_as_sequence(raw_));
+}
+
+/* ==========================================================================
+ * Owning types
+ * ========================================================================== */
+
+/**
+ * @brief A compiled path (see styx_path_compile()), move-only.
+ */
+class path {
+public:
+    explicit path(const char *text) : raw_(styx_path_compile(text)) {}
+    explicit path(const std::string &text) : path(text.c_str()) {}
+
+    path(path &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    path &operator=(path &&other) noexcept {
+        if (this != &other) {
+            styx_path_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    path(const path &) = delete;
+    path &operator=(const path &) = delete;
+    ~path() { styx_path_free(raw_); }
+
+    const StyxPath *raw() const noexcept { return raw_; }
+
+    /** @brief Resolve this path starting at `start`. */
+    styx::value eval(styx::value start) const noexcept {
+        return styx::value(styx_path_eval_value(start.raw(), raw_));
+    }
+
+private:
+    StyxPath *raw_;
+};
+
+/** @brief One changed path (see styx_changes_get()). */
+struct change {
+    StyxChangeKind kind;
+    std::string_view path;
+};
+
+/**
+ * @brief Paths changed by document::reparse() or document::diff(), move-only.
+ */
+class changes {
+public:
+    explicit changes(StyxChanges *raw) noexcept : raw_(raw) {}
+
+    changes(changes &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    changes &operator=(changes &&other) noexcept {
+        if (this != &other) {
+            styx_changes_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    changes(const changes &) = delete;
+    changes &operator=(const changes &) = delete;
+    ~changes() { styx_changes_free(raw_); }
+
+    std::size_t size() const noexcept { return styx_changes_len(raw_); }
+    bool empty() const noexcept { return size() == 0; }
+
+    change operator[](std::size_t index) const noexcept {
+        StyxChange raw = styx_changes_get(raw_, index);
+        return {raw.kind, detail::view(raw.path)};
+    }
+
+private:
+    StyxChanges *raw_;
+};
+
+/**
+ * @brief Values matched by a selector::select() call, move-only.
+ */
+class selection {
+public:
+    explicit selection(StyxSelection *raw) noexcept : raw_(raw) {}
+
+    selection(selection &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    selection &operator=(selection &&other) noexcept {
+        if (this != &other) {
+            styx_selection_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    selection(const selection &) = delete;
+    selection &operator=(const selection &) = delete;
+    ~selection() { styx_selection_free(raw_); }
+
+    std::size_t size() const noexcept { return styx_selection_len(raw_); }
+    bool empty() const noexcept { return size() == 0; }
+
+    styx::value operator[](std::size_t index) const noexcept {
+        return styx::value(styx_selection_get(raw_, index));
+    }
+
+private:
+    StyxSelection *raw_;
+};
+
+/**
+ * @brief An owned, parsed Styx document, move-only.
+ */
+class document {
+public:
+    /**
+     * @brief Parse `source`.
+     * @throws styx::parse_error if the document is invalid.
+     */
+    static document parse(std::string_view source) {
+        return from_result(styx_parse_n(source.data(), source.size(), 0));
+    }
+
+    /**
+     * @brief Parse `source`, recording per-phase counts and timings in
+     * `stats` (see styx_parse_with_stats()).
+     * @throws styx::parse_error if the document is invalid.
+     */
+    static document parse_with_stats(std::string_view source, StyxParseStats &stats) {
+        return from_result(styx_parse_with_stats(source.data(), source.size(), 0, &stats));
+    }
+
+    /**
+     * @brief Parse `source` on up to `threads` threads (0 = all CPUs).
+     * @throws styx::parse_error if the document is invalid.
+     */
+    static document parse_parallel(std::string_view source, std::size_t threads = 0) {
+        return from_result(styx_parse_parallel(source.data(), source.size(), 0, threads));
+    }
+
+    /**
+     * @brief Parse every source on up to `threads` threads (0 = all CPUs),
+     * without throwing (see styx_parse_batch()).
+     *
+     * Element `i` holds the document for `sources[i]`, or nothing if it
+     * failed to parse; `errors`, if given, receives each failure's message
+     * (empty for successes).
+     */
+    static std::vector<std::optional<document>>
+    parse_batch(const std::vector<std::string_view> &sources, std::size_t threads = 0,
+                std::vector<std::string> *errors = nullptr) {
+        std::vector<StyxStr> inputs;
+        inputs.reserve(sources.size());
+        for (std::string_view source : sources) {
+            inputs.push_back({source.data(), source.size()});
+        }
+        std::vector<StyxParseResult> results(sources.size());
+        styx_parse_batch(inputs.data(), inputs.size(), 0, threads, results.data());
+        std::vector<std::optional<document>> docs;
+        docs.reserve(results.size());
+        if (errors) {
+            errors->assign(results.size(), std::string());
+        }
+        for (std::size_t i = 0; i < results.size(); i++) {
+            if (results[i].document) {
+                docs.emplace_back(document(results[i].document));
+                continue;
+            }
+            if (errors && results[i].error) {
+                (*errors)[i] = results[i].error;
+            }
+            styx_free_string(results[i].error);
+            docs.emplace_back(std::nullopt);
+        }
+        return docs;
+    }
+
+    /**
+     * @brief Parse `source`, deferring nested objects until first read.
+     * @throws styx::parse_error if the top level is invalid.
+     */
+    static document parse_lazy(std::string_view source) {
+        return from_result(styx_parse_lazy(source.data(), source.size(), 0));
+    }
+
+    /**
+     * @brief Parse `source` without throwing; on failure `error` describes
+     * why (see styx_parse_ex()).
+     */
+    static std::optional<document> try_parse(std::string_view source, StyxError &error) {
+        StyxDocument *raw = styx_parse_ex(source.data(), source.size(), 0, &error);
+        if (!raw) {
+            return std::nullopt;
+        }
+        return document(raw);
+    }
+
+    /** @brief Take ownership of a document from the C API. */
+    explicit document(StyxDocument *raw) noexcept : raw_(raw) {}
+
+    document(document &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    document &operator=(document &&other) noexcept {
+        if (this != &other) {
+            styx_free_document(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    document(const document &) = delete;
+    document &operator=(const document &) = delete;
+    ~document() { styx_free_document(raw_); }
+
+    const StyxDocument *raw() const noexcept { return raw_; }
+
+    /** @brief Give up ownership; the caller must call styx_free_document(). */
+    StyxDocument *release() noexcept { return std::exchange(raw_, nullptr); }
+
+    /** @brief The root object. */
+    object root() const noexcept { return object(styx_document_root(raw_)); }
+
+    /** @brief Look up a dotted path (see styx_document_get()). */
+    styx::value operator[](const char *path) const noexcept {
+        return styx::value(styx_document_get(raw_, path));
+    }
+    styx::value operator[](const std::string &path) const noexcept {
+        return (*this)[path.c_str()];
+    }
+
+    /** @brief Resolve a compiled path. */
+    styx::value operator[](const styx::path &path) const noexcept {
+        return styx::value(styx_path_eval(raw_, path.raw()));
+    }
+
+    /** @brief Build every wide object's key index up front. */
+    void build_indexes() const noexcept { styx_document_build_indexes(raw_); }
+
+    /** @brief Paths whose values differ from this document to `next`. */
+    styx::changes diff(const document &next) const {
+        return styx::changes(styx_document_diff(raw_, next.raw_));
+    }
+
+    /**
+     * @brief Update in place after bytes `edit_start..edit_end` of the old
+     * source were replaced by `new_len` bytes, giving `source`.
+     *
+     * Invalidates all views into the document.
+     * @throws styx::parse_error if the new source is invalid (the document
+     * is left unchanged).
+     */
+    styx::changes reparse(std::string_view source, std::size_t edit_start,
+                          std::size_t edit_end, std::size_t new_len) {
+        StyxChanges *list = nullptr;
+        char *error = styx_document_reparse(raw_, source.data(), source.size(), 0, edit_start,
+                                            edit_end, new_len, &list);
+        if (error) {
+            std::string message = error;
+            styx_free_string(error);
+            throw parse_error(message);
+        }
+        return styx::changes(list);
+    }
+
+private:
+    friend class parser;
+
+    static document from_result(StyxParseResult result) {
+        if (!result.document) {
+            std::string message = result.error ? result.error : "unknown error";
+            styx_free_string(result.error);
+            throw parse_error(message);
+        }
+        return document(result.document);
+    }
+
+    StyxDocument *raw_;
+};
+
+/**
+ * @brief Cache documents parsed by document::parse() in `dir`, or stop
+ * caching if `dir` is null (see styx_set_parse_cache()).
+ */
+inline bool set_parse_cache(const char *dir) noexcept { return styx_set_parse_cache(dir); }
+
+/**
+ * @brief A parser that reuses its buffers across documents (see
+ * styx_parser_new()), move-only. Use one per thread.
+ */
+class parser {
+public:
+    parser() : raw_(styx_parser_new()) {}
+
+    parser(parser &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    parser &operator=(parser &&other) noexcept {
+        if (this != &other) {
+            styx_parser_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    parser(const parser &) = delete;
+    parser &operator=(const parser &) = delete;
+    ~parser() { styx_parser_free(raw_); }
+
+    /**
+     * @brief Parse `source`, as document::parse() but reusing buffers.
+     * @throws styx::parse_error if the document is invalid.
+     */
+    document parse(std::string_view source) {
+        return document::from_result(styx_parser_parse(raw_, source.data(), source.size(), 0));
+    }
+
+    /** @brief Free `doc`, keeping its storage for later parses. */
+    void recycle(document doc) noexcept { styx_parser_recycle(raw_, doc.release()); }
+
+    /** @brief Free the buffers and storage kept so far. */
+    void reset() noexcept { styx_parser_reset(raw_); }
+
+private:
+    StyxParser *raw_;
+};
+
+/**
+ * @brief A compiled selector (see styx_selector_compile()), move-only.
+ *
+ * Immutable once compiled, so one instance may select on many threads.
+ */
+class selector {
+public:
+    /**
+     * @brief Compile the selector `text`.
+     * @throws styx::parse_error if the selector is invalid.
+     */
+    explicit selector(const std::string &text) {
+        char *error = styx_selector_compile(text.c_str(), &raw_);
+        if (error) {
+            std::string message = error;
+            styx_free_string(error);
+            throw parse_error(message);
+        }
+    }
+
+    selector(selector &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    selector &operator=(selector &&other) noexcept {
+        if (this != &other) {
+            styx_selector_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    selector(const selector &) = delete;
+    selector &operator=(const selector &) = delete;
+    ~selector() { styx_selector_free(raw_); }
+
+    const StyxSelector *raw() const noexcept { return raw_; }
+
+    /** @brief Every match in `doc`, borrowed from it. */
+    selection select(const document &doc) const noexcept {
+        return selection(styx_select(doc.raw(), raw_));
+    }
+
+    /**
+     * @brief Every match in `source`, selected while parsing it.
+     * @throws styx::parse_error if the source is invalid.
+     */
+    selection select(std::string_view source) const {
+        StyxSelection *raw = nullptr;
+        char *error = styx_select_source(raw_, source.data(), source.size(), 0, &raw);
+        if (error) {
+            std::string message = error;
+            styx_free_string(error);
+            throw parse_error(message);
+        }
+        return selection(raw);
+    }
+
+private:
+    StyxSelector *raw_ = nullptr;
+};
+
+/** @brief One schema violation (see styx_violations_get()). */
+struct violation {
+    std::string path;
+    std::string message;
+    std::uint32_t span_start;
+    std::uint32_t span_end;
+};
+
+/**
+ * @brief A compiled schema (see styx_schema_compile()), move-only.
+ *
+ * Immutable once compiled, so one instance may validate on many threads.
+ */
+class schema {
+public:
+    /**
+     * @brief Compile the schema file `source`.
+     * @throws styx::parse_error if the schema is invalid.
+     */
+    static schema compile(std::string_view source) {
+        StyxSchema *raw = nullptr;
+        char *error = styx_schema_compile(source.data(), source.size(), 0, &raw);
+        if (error) {
+            std::string message = error;
+            styx_free_string(error);
+            throw parse_error(message);
+        }
+        return schema(raw);
+    }
+
+    schema(schema &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    schema &operator=(schema &&other) noexcept {
+        if (this != &other) {
+            styx_schema_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    schema(const schema &) = delete;
+    schema &operator=(const schema &) = delete;
+    ~schema() { styx_schema_free(raw_); }
+
+    const StyxSchema *raw() const noexcept { return raw_; }
+
+    /** @brief Whether `doc` matches; stops at the first violation. */
+    bool is_valid(const document &doc) const noexcept {
+        return styx_schema_validate(raw_, doc.raw(), nullptr);
+    }
+
+    /** @brief Every violation in `doc` (empty if it is valid). */
+    std::vector<violation> validate(const document &doc) const {
+        StyxViolations *list = nullptr;
+        std::vector<violation> out;
+        if (!styx_schema_validate(raw_, doc.raw(), &list)) {
+            for (std::size_t i = 0; i < styx_violations_len(list); i++) {
+                StyxViolation v = styx_violations_get(list, i);
+                out.push_back({std::string(detail::view(v.path)),
+                               std::string(detail::view(v.message)), v.span_start, v.span_end});
+            }
+            styx_violations_free(list);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Parse and check `source` without building a tree.
+     * @return The first parse error or violation, or nothing if valid.
+     */
+    std::optional<std::string> check(std::string_view source) const {
+        char *error = styx_schema_check(raw_, source.data(), source.size(), 0);
+        if (!error) {
+            return std::nullopt;
+        }
+        std::string message = error;
+        styx_free_string(error);
+        return message;
+    }
+
+    /**
+     * @brief Parse `source`, validating it as it is parsed.
+     * @throws styx::parse_error at the first parse error or violation.
+     */
+    document parse(std::string_view source) const {
+        StyxParseResult result = styx_schema_parse(raw_, source.data(), source.size(), 0);
+        if (!result.document) {
+            std::string message = result.error ? result.error : "unknown error";
+            styx_free_string(result.error);
+            throw parse_error(message);
+        }
+        return document(result.document);
+    }
+
+private:
+    explicit schema(StyxSchema *raw) noexcept : raw_(raw) {}
+
+    StyxSchema *raw_;
+};
+
+/**
+ * @brief A reference-counted, immutable document version (see
+ * styx_snapshot_acquire()). Copying takes another reference.
+ */
+class snapshot {
+public:
+    /** @brief Take ownership of a reference from the C API (may be null). */
+    explicit snapshot(const StyxSnapshot *raw = nullptr) noexcept : raw_(raw) {}
+
+    snapshot(const snapshot &other) noexcept : raw_(styx_snapshot_retain(other.raw_)) {}
+    snapshot(snapshot &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    snapshot &operator=(snapshot other) noexcept {
+        std::swap(raw_, other.raw_);
+        return *this;
+    }
+    ~snapshot() { styx_snapshot_release(raw_); }
+
+    /** @brief Whether a version was acquired (the cell was not empty). */
+    explicit operator bool() const noexcept { return raw_ != nullptr; }
+
+    const StyxDocument *raw_document() const noexcept { return styx_snapshot_document(raw_); }
+
+    /** @brief The root object. */
+    object root() const noexcept { return object(styx_document_root(raw_document())); }
+
+    /** @brief Look up a dotted path (see styx_document_get()). */
+    styx::value operator[](const char *path) const noexcept {
+        return styx::value(styx_document_get(raw_document(), path));
+    }
+    styx::value operator[](const std::string &path) const noexcept {
+        return (*this)[path.c_str()];
+    }
+
+    /** @brief Resolve a compiled path. */
+    styx::value operator[](const styx::path &path) const noexcept {
+        return styx::value(styx_path_eval(raw_document(), path.raw()));
+    }
+
+private:
+    const StyxSnapshot *raw_;
+};
+
+/**
+ * @brief The current version of a document shared between threads, move-only.
+ *
+ * `acquire()` is lock-free and may be called from any thread while another
+ * thread calls `publish()`.
+ */
+class snapshot_cell {
+public:
+    snapshot_cell() : raw_(styx_snapshot_cell_new()) {}
+
+    snapshot_cell(snapshot_cell &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    snapshot_cell &operator=(snapshot_cell &&other) noexcept {
+        if (this != &other) {
+            styx_snapshot_cell_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    snapshot_cell(const snapshot_cell &) = delete;
+    snapshot_cell &operator=(const snapshot_cell &) = delete;
+    ~snapshot_cell() { styx_snapshot_cell_free(raw_); }
+
+    /** @brief Make `doc` the current version. */
+    void publish(document doc) noexcept { styx_snapshot_publish(raw_, doc.release()); }
+
+    /** @brief The current version (empty if nothing was published). */
+    snapshot acquire() const noexcept { return snapshot(styx_snapshot_acquire(raw_)); }
+
+private:
+    StyxSnapshotCell *raw_;
+};
+
+/* ==========================================================================
+ * Writing
+ * ========================================================================== */
+
+/**
+ * @brief A streaming writer that appends Styx text to a string (see
+ * styx_writer_new_callback()), move-only.
+ *
+ * Calls chain and errors are sticky, so only finish() needs checking:
+ *
+ *   std::string out;
+ *   styx::writer w(out);
+ *   w.key("name").scalar("my app").key("port").value(8080);
+ *   w.finish();
+ */
+class writer {
+public:
+    /** @brief Append to `out`, which must outlive the writer. */
+    explicit writer(std::string &out, bool compact = false)
+        : raw_(styx_writer_new_callback(&writer::append, &out, compact ? STYX_WRITE_COMPACT : 0)) {}
+
+    writer(writer &&other) noexcept : raw_(std::exchange(other.raw_, nullptr)) {}
+    writer &operator=(writer &&other) noexcept {
+        if (this != &other) {
+            styx_writer_free(raw_);
+            raw_ = std::exchange(other.raw_, nullptr);
+        }
+        return *this;
+    }
+    writer(const writer &) = delete;
+    writer &operator=(const writer &) = delete;
+    ~writer() { styx_writer_free(raw_); }
+
+    writer &key(std::string_view key) noexcept {
+        (void)styx_writer_key(raw_, key.data(), key.size());
+        return *this;
+    }
+    writer &scalar(std::string_view text) noexcept {
+        (void)styx_writer_scalar(raw_, text.data(), text.size());
+        return *this;
+    }
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    writer &value(T value) noexcept {
+        if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(std::int64_t)) {
+            if (value > std::numeric_limits<std::int64_t>::max()) {
+                char digits[24];
+                auto end = std::to_chars(digits, digits + sizeof digits, value).ptr;
+                return scalar(std::string_view(digits, std::size_t(end - digits)));
+            }
+        }
+        (void)styx_writer_int(raw_, static_cast<std::int64_t>(value));
+        return *this;
+    }
+    writer &value(double value) noexcept {
+        (void)styx_writer_float(raw_, value);
+        return *this;
+    }
+    writer &value(bool value) noexcept {
+        (void)styx_writer_bool(raw_, value);
+        return *this;
+    }
+    writer &unit() noexcept {
+        (void)styx_writer_unit(raw_);
+        return *this;
+    }
+    writer &tag(std::string_view name) noexcept {
+        (void)styx_writer_tag(raw_, name.data(), name.size());
+        return *this;
+    }
+    writer &begin_object() noexcept {
+        (void)styx_writer_begin_object(raw_);
+        return *this;
+    }
+    writer &begin_sequence() noexcept {
+        (void)styx_writer_begin_sequence(raw_);
+        return *this;
+    }
+    writer &end() noexcept {
+        (void)styx_writer_end(raw_);
+        return *this;
+    }
+
+    /**
+     * @brief Finish the document, flushing the rest of it to the string.
+     * @throws styx::write_error if any call failed or something is still open.
+     */
+    void finish() {
+        if (!styx_writer_finish(raw_)) {
+            const char *message = styx_writer_error(raw_);
+            throw write_error(message ? message : "unknown error");
+        }
+    }
+
+private:
+    static bool append(void *context, const char *data, std::size_t len) noexcept {
+        try {
+            static_cast<std::string *>(context)->append(data, len);
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    StyxWriter *raw_;
+};
+
+} // namespace styx
+
+#endif /* STYX_HPP */
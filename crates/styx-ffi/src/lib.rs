@@ -3,11 +3,18 @@
 //!
 //! This crate provides a C-compatible API for parsing Styx documents.
 
-use std::ffi::{CStr, CString};
+use std::ffi::{CStr, CString, c_void};
 use std::os::raw::c_char;
 use std::ptr;
+use std::sync::atomic::{AtomicPtr, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, PoisonError, RwLock};
 
-use styx_tree::{BuildError, Document, Object, Payload, Sequence, Value};
+use styx_parse::{Event, EventKind, ParseErrorKind, Parser, ScalarKind, Span};
+use styx_tree::{
+    BuildError, Change, ChangeKind, CompiledSchema, Document, DocumentParser, Edit, EventSelector,
+    Object, ParseCache, ParseStats, Path, Payload, SchemaViolation, Selector, Sequence,
+    ValidateError, Value,
+};
 
 /// Opaque handle to a parsed Styx document.
 pub struct StyxDocument {
@@ -32,6 +39,61 @@ pub struct StyxSequence {
     inner: *const Sequence,
 }
 
+/// Opaque handle to a compiled path.
+pub struct StyxPath {
+    inner: Path,
+}
+
+/// Opaque handle to a list of changed paths.
+pub struct StyxChanges {
+    inner: Vec<Change>,
+}
+
+/// Opaque handle to a compiled selector.
+pub struct StyxSelector {
+    inner: Selector,
+}
+
+/// Opaque handle to the values a selector matched.
+pub struct StyxSelection {
+    /// Borrowed from a document, or pointing into `owned`.
+    values: Vec<*const Value>,
+    /// Values selected from a stream, which no document owns.
+    #[allow(dead_code)]
+    owned: Vec<Value>,
+}
+
+/// Opaque handle to a compiled schema.
+pub struct StyxSchema {
+    inner: CompiledSchema,
+}
+
+/// Opaque handle to a list of schema violations.
+pub struct StyxViolations {
+    inner: Vec<SchemaViolation>,
+}
+
+/// Opaque handle to an immutable, reference-counted document version.
+///
+/// Handed out as `Arc::into_raw` pointers by `styx_snapshot_acquire`.
+pub struct StyxSnapshot {
+    document: StyxDocument,
+}
+
+/// Opaque handle to the current document version shared by many threads.
+pub struct StyxSnapshotCell {
+    /// `Arc::into_raw` of the current snapshot, or null. The cell owns one
+    /// reference.
+    current: AtomicPtr<StyxSnapshot>,
+    /// Acquires in flight, by the parity of `epoch` when they started.
+    readers: [AtomicUsize; 2],
+    /// Flipped by publishers so old readers drain from one counter while new
+    /// ones use the other.
+    epoch: AtomicUsize,
+    /// Serializes publishers; readers never take it.
+    publish: Mutex<()>,
+}
+
 /// Result of a parse operation.
 #[repr(C)]
 pub struct StyxParseResult {
@@ -41,6 +103,43 @@ pub struct StyxParseResult {
     pub error: *mut c_char,
 }
 
+/// A borrowed, length-delimited UTF-8 string.
+///
+/// Points into storage owned by a `StyxDocument` and is not null-terminated.
+/// `ptr` is null when the string is absent.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct StyxStr {
+    /// Pointer to the first byte (null if absent).
+    pub ptr: *const c_char,
+    /// Length in bytes.
+    pub len: usize,
+}
+
+impl StyxStr {
+    const NULL: StyxStr = StyxStr {
+        ptr: ptr::null(),
+        len: 0,
+    };
+
+    fn borrow(s: &str) -> Self {
+        StyxStr {
+            ptr: s.as_ptr() as *const c_char,
+            len: s.len(),
+        }
+    }
+}
+
+/// One object entry, as filled in by `styx_object_entries`.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct StyxEntryView {
+    /// Scalar text of the key (null for unit or tag-only keys).
+    pub key: StyxStr,
+    /// The entry's value.
+    pub value: *const StyxValue,
+}
+
 /// Type of a Styx value's payload.
 #[repr(C)]
 pub enum StyxPayloadKind {
@@ -54,10 +153,516 @@ pub enum StyxPayloadKind {
     Object,
 }
 
+/// How the value at a path changed.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub enum StyxChangeKind {
+    /// The path is new.
+    Added,
+    /// The path no longer exists.
+    Removed,
+    /// The path holds a different value.
+    Changed,
+}
+
+/// One changed path, as returned by `styx_changes_get`.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct StyxChange {
+    /// How the value changed.
+    pub kind: StyxChangeKind,
+    /// The path, in `styx_document_get` syntax (null if absent).
+    pub path: StyxStr,
+}
+
+/// One schema violation, as returned by `styx_violations_get`.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct StyxViolation {
+    /// Path to the offending value, in `styx_document_get` syntax (empty for
+    /// the root, null if absent).
+    pub path: StyxStr,
+    /// What is wrong with the value (null if absent).
+    pub message: StyxStr,
+    /// Byte offset of the start of the value (inclusive), or 0 if unknown.
+    pub span_start: u32,
+    /// Byte offset of the end of the value (exclusive), or 0 if unknown.
+    pub span_end: u32,
+}
+
+impl From<ChangeKind> for StyxChangeKind {
+    fn from(kind: ChangeKind) -> Self {
+        match kind {
+            ChangeKind::Added => StyxChangeKind::Added,
+            ChangeKind::Removed => StyxChangeKind::Removed,
+            ChangeKind::Changed => StyxChangeKind::Changed,
+        }
+    }
+}
+
+/// Machine-readable kind of an error, as stored in `StyxError`.
+///
+/// Codes 1 to 17 mirror the parser's error kinds; codes from 128 are raised
+/// before or after parsing.
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum StyxErrorCode {
+    /// No error.
+    None = 0,
+    /// Unexpected token.
+    UnexpectedToken = 1,
+    /// Unclosed object (missing `}`).
+    UnclosedObject = 2,
+    /// Unclosed sequence (missing `)`).
+    UnclosedSequence = 3,
+    /// Invalid escape sequence in a quoted string; the span covers it.
+    InvalidEscape = 4,
+    /// Expected a key.
+    ExpectedKey = 5,
+    /// Expected a value.
+    ExpectedValue = 6,
+    /// Unexpected end of input.
+    UnexpectedEof = 7,
+    /// Duplicate key; the related span is the first occurrence.
+    DuplicateKey = 8,
+    /// Invalid tag name.
+    InvalidTagName = 9,
+    /// Invalid key.
+    InvalidKey = 10,
+    /// Doc comment not followed by an entry.
+    DanglingDocComment = 11,
+    /// Entry has too many atoms.
+    TooManyAtoms = 12,
+    /// A dotted path reopens an object closed by a sibling.
+    ReopenedPath = 13,
+    /// A dotted path nests into a key that holds a terminal value.
+    NestIntoTerminal = 14,
+    /// Comma in a sequence.
+    CommaInSequence = 15,
+    /// Missing whitespace between a bare scalar and a block.
+    MissingWhitespaceBeforeBlock = 16,
+    /// Content after the root object.
+    TrailingContent = 17,
+    /// The source pointer was null.
+    NullSource = 128,
+    /// The source is not valid UTF-8.
+    InvalidUtf8 = 129,
+    /// A structure was left open at the end of input.
+    UnclosedStructure = 130,
+    /// The document does not have an object at the root.
+    UnexpectedEvent = 131,
+    /// The document is empty.
+    EmptyDocument = 132,
+    /// The document is too large for 32-bit offsets.
+    TooLarge = 133,
+}
+
+/// A parse error, reported without allocating.
+///
+/// Holds only a code and byte offsets into the source; the message and the
+/// line and column are computed from the source on request with
+/// `styx_error_message` and `styx_error_position`.
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct StyxError {
+    /// What went wrong (`None` on success).
+    pub code: StyxErrorCode,
+    /// Byte offset of the start of the error (inclusive).
+    pub span_start: u32,
+    /// Byte offset of the end of the error (exclusive).
+    pub span_end: u32,
+    /// Start of the first occurrence, for `DuplicateKey` (0 otherwise).
+    pub related_start: u32,
+    /// End of the first occurrence, for `DuplicateKey` (0 otherwise).
+    pub related_end: u32,
+    /// For `ReopenedPath` and `NestIntoTerminal`, how many leading segments
+    /// of the dotted key at the span name the offending path (0 otherwise).
+    pub path_segments: u32,
+}
+
+/// A 1-based line and column, as computed by `styx_error_position`.
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct StyxPosition {
+    /// Line number, counting from 1.
+    pub line: u32,
+    /// Column in characters, counting from 1.
+    pub column: u32,
+}
+
+impl StyxError {
+    const NONE: StyxError = StyxError::new(StyxErrorCode::None, Span { start: 0, end: 0 });
+
+    const fn new(code: StyxErrorCode, span: Span) -> Self {
+        StyxError {
+            code,
+            span_start: span.start,
+            span_end: span.end,
+            related_start: 0,
+            related_end: 0,
+            path_segments: 0,
+        }
+    }
+
+    fn from_parse(kind: &ParseErrorKind, span: Span) -> Self {
+        let code = match kind {
+            ParseErrorKind::UnexpectedToken => StyxErrorCode::UnexpectedToken,
+            ParseErrorKind::UnclosedObject => StyxErrorCode::UnclosedObject,
+            ParseErrorKind::UnclosedSequence => StyxErrorCode::UnclosedSequence,
+            ParseErrorKind::InvalidEscape(_) => StyxErrorCode::InvalidEscape,
+            ParseErrorKind::ExpectedKey => StyxErrorCode::ExpectedKey,
+            ParseErrorKind::ExpectedValue => StyxErrorCode::ExpectedValue,
+            ParseErrorKind::UnexpectedEof => StyxErrorCode::UnexpectedEof,
+            ParseErrorKind::DuplicateKey { original } => {
+                return StyxError {
+                    related_start: original.start,
+                    related_end: original.end,
+                    ..StyxError::new(StyxErrorCode::DuplicateKey, span)
+                };
+            }
+            ParseErrorKind::InvalidTagName => StyxErrorCode::InvalidTagName,
+            ParseErrorKind::InvalidKey => StyxErrorCode::InvalidKey,
+            ParseErrorKind::DanglingDocComment => StyxErrorCode::DanglingDocComment,
+            ParseErrorKind::TooManyAtoms => StyxErrorCode::TooManyAtoms,
+            ParseErrorKind::ReopenedPath { closed_path } => {
+                return StyxError {
+                    path_segments: closed_path.len() as u32,
+                    ..StyxError::new(StyxErrorCode::ReopenedPath, span)
+                };
+            }
+            ParseErrorKind::NestIntoTerminal { terminal_path } => {
+                return StyxError {
+                    path_segments: terminal_path.len() as u32,
+                    ..StyxError::new(StyxErrorCode::NestIntoTerminal, span)
+                };
+            }
+            ParseErrorKind::CommaInSequence => StyxErrorCode::CommaInSequence,
+            ParseErrorKind::MissingWhitespaceBeforeBlock => {
+                StyxErrorCode::MissingWhitespaceBeforeBlock
+            }
+            ParseErrorKind::TrailingContent => StyxErrorCode::TrailingContent,
+        };
+        StyxError::new(code, span)
+    }
+
+    fn from_build(e: &BuildError) -> Self {
+        let code = match e {
+            BuildError::Parse(kind, span) => return StyxError::from_parse(kind, *span),
+            BuildError::UnexpectedEvent(_) => StyxErrorCode::UnexpectedEvent,
+            BuildError::UnclosedStructure => StyxErrorCode::UnclosedStructure,
+            BuildError::EmptyDocument => StyxErrorCode::EmptyDocument,
+            BuildError::TooLarge => StyxErrorCode::TooLarge,
+        };
+        StyxError::new(code, Span { start: 0, end: 0 })
+    }
+
+    fn from_source(message: &str) -> Self {
+        let code = if message == "source is null" {
+            StyxErrorCode::NullSource
+        } else {
+            StyxErrorCode::InvalidUtf8
+        };
+        StyxError::new(code, Span { start: 0, end: 0 })
+    }
+
+    /// Format the error as the string-returning calls would, reading
+    /// escape sequences and paths back from the source text at the span.
+    fn message(&self, source: &[u8]) -> String {
+        let text = source
+            .get(self.span_start as usize..self.span_end as usize)
+            .and_then(|bytes| std::str::from_utf8(bytes).ok())
+            .unwrap_or("");
+        let path = || -> Vec<String> {
+            text.split('.')
+                .take(self.path_segments as usize)
+                .map(str::to_string)
+                .collect()
+        };
+        let kind = match self.code {
+            StyxErrorCode::None => return "no error".to_string(),
+            StyxErrorCode::NullSource => return "source is null".to_string(),
+            StyxErrorCode::InvalidUtf8 => return "source is not valid UTF-8".to_string(),
+            StyxErrorCode::UnclosedStructure => {
+                return format_error(&BuildError::UnclosedStructure);
+            }
+            StyxErrorCode::UnexpectedEvent => {
+                return format_error(&BuildError::UnexpectedEvent(
+                    "expected object at root".to_string(),
+                ));
+            }
+            StyxErrorCode::EmptyDocument => return format_error(&BuildError::EmptyDocument),
+            StyxErrorCode::TooLarge => return format_error(&BuildError::TooLarge),
+            StyxErrorCode::UnexpectedToken => ParseErrorKind::UnexpectedToken,
+            StyxErrorCode::UnclosedObject => ParseErrorKind::UnclosedObject,
+            StyxErrorCode::UnclosedSequence => ParseErrorKind::UnclosedSequence,
+            StyxErrorCode::InvalidEscape => ParseErrorKind::InvalidEscape(text.to_string()),
+            StyxErrorCode::ExpectedKey => ParseErrorKind::ExpectedKey,
+            StyxErrorCode::ExpectedValue => ParseErrorKind::ExpectedValue,
+            StyxErrorCode::UnexpectedEof => ParseErrorKind::UnexpectedEof,
+            StyxErrorCode::DuplicateKey => ParseErrorKind::DuplicateKey {
+                original: Span {
+                    start: self.related_start,
+                    end: self.related_end,
+                },
+            },
+            StyxErrorCode::InvalidTagName => ParseErrorKind::InvalidTagName,
+            StyxErrorCode::InvalidKey => ParseErrorKind::InvalidKey,
+            StyxErrorCode::DanglingDocComment => ParseErrorKind::DanglingDocComment,
+            StyxErrorCode::TooManyAtoms => ParseErrorKind::TooManyAtoms,
+            StyxErrorCode::ReopenedPath => ParseErrorKind::ReopenedPath {
+                closed_path: path(),
+            },
+            StyxErrorCode::NestIntoTerminal => ParseErrorKind::NestIntoTerminal {
+                terminal_path: path(),
+            },
+            StyxErrorCode::CommaInSequence => ParseErrorKind::CommaInSequence,
+            StyxErrorCode::MissingWhitespaceBeforeBlock => {
+                ParseErrorKind::MissingWhitespaceBeforeBlock
+            }
+            StyxErrorCode::TrailingContent => ParseErrorKind::TrailingContent,
+        };
+        let span = Span {
+            start: self.span_start,
+            end: self.span_end,
+        };
+        format_error(&BuildError::Parse(kind, span))
+    }
+}
+
+/// Kind of a streaming parse event.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub enum StyxEventKind {
+    /// Start of document.
+    DocumentStart,
+    /// End of document.
+    DocumentEnd,
+    /// Start of an object.
+    ObjectStart,
+    /// End of an object.
+    ObjectEnd,
+    /// Start of a sequence.
+    SequenceStart,
+    /// End of a sequence.
+    SequenceEnd,
+    /// Start of an entry.
+    EntryStart,
+    /// End of an entry.
+    EntryEnd,
+    /// An entry key.
+    Key,
+    /// A scalar value.
+    Scalar,
+    /// Unit value.
+    Unit,
+    /// Start of a tag.
+    TagStart,
+    /// End of a tag.
+    TagEnd,
+    /// Line comment.
+    Comment,
+    /// Doc comment.
+    DocComment,
+    /// Parse error.
+    Error,
+}
+
+/// Kind of a scalar.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub enum StyxScalarKind {
+    /// Bare (unquoted) scalar.
+    Bare,
+    /// Quoted string.
+    Quoted,
+    /// Raw string.
+    Raw,
+    /// Heredoc.
+    Heredoc,
+}
+
+impl From<ScalarKind> for StyxScalarKind {
+    fn from(kind: ScalarKind) -> Self {
+        match kind {
+            ScalarKind::Bare => StyxScalarKind::Bare,
+            ScalarKind::Quoted => StyxScalarKind::Quoted,
+            ScalarKind::Raw => StyxScalarKind::Raw,
+            ScalarKind::Heredoc => StyxScalarKind::Heredoc,
+        }
+    }
+}
+
+/// Outcome of a typed scalar read such as `styx_value_as_i64`.
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum StyxScalarStatus {
+    /// The value was parsed and written to the output.
+    Ok,
+    /// The value is not a scalar.
+    NotScalar,
+    /// The scalar text is not a value of the requested type.
+    Invalid,
+    /// The scalar is a number that does not fit the requested type.
+    OutOfRange,
+}
+
+/// A streaming parse event.
+///
+/// Strings point into the source buffer or the reader, and are valid until
+/// the next `styx_reader_next` call on the same reader.
+#[repr(C)]
+pub struct StyxEvent {
+    /// The kind of event.
+    pub kind: StyxEventKind,
+    /// Scalar kind, for `Key` and `Scalar` events.
+    pub scalar_kind: StyxScalarKind,
+    /// Byte offset of the start of the event (inclusive).
+    pub span_start: u32,
+    /// Byte offset of the end of the event (exclusive).
+    pub span_end: u32,
+    /// Scalar text (`Key`, `Scalar`), comment text (`Comment`, `DocComment`)
+    /// or error message (`Error`). Null otherwise, and for unit keys.
+    pub text: StyxStr,
+    /// Tag name, for `TagStart` and tagged `Key` events.
+    pub tag: StyxStr,
+}
+
+/// What a parse did and where its time went (see `styx_parse_with_stats`).
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+pub struct StyxParseStats {
+    /// Length of the source in bytes.
+    pub bytes: u64,
+    /// Tokens produced by the tokenizer, including whitespace and comments.
+    pub tokens: u64,
+    /// Lexemes produced by the lexer.
+    pub lexemes: u64,
+    /// Events produced by the parser.
+    pub events: u64,
+    /// Values in the document, counting keys and the root.
+    pub nodes: u64,
+    /// Heap blocks the finished document retains; temporary allocations made
+    /// during the parse are not counted.
+    pub allocations: u64,
+    /// Total capacity of those blocks in bytes.
+    pub allocated_bytes: u64,
+    /// Nanoseconds spent tokenizing.
+    pub tokenize_ns: u64,
+    /// Estimated nanoseconds spent turning tokens into lexemes.
+    pub lex_ns: u64,
+    /// Estimated nanoseconds spent turning lexemes into events.
+    pub parse_ns: u64,
+    /// Nanoseconds spent building the tree.
+    pub build_ns: u64,
+}
+
+impl From<ParseStats> for StyxParseStats {
+    fn from(stats: ParseStats) -> Self {
+        let ns = |d: std::time::Duration| d.as_nanos().min(u64::MAX as u128) as u64;
+        StyxParseStats {
+            bytes: stats.bytes as u64,
+            tokens: stats.tokens as u64,
+            lexemes: stats.lexemes as u64,
+            events: stats.events as u64,
+            nodes: stats.nodes as u64,
+            allocations: stats.allocations as u64,
+            allocated_bytes: stats.allocated_bytes as u64,
+            tokenize_ns: ns(stats.tokenize_time),
+            lex_ns: ns(stats.lex_time),
+            parse_ns: ns(stats.parse_time),
+            build_ns: ns(stats.build_time),
+        }
+    }
+}
+
+/// Opaque handle to a reusable parser.
+pub struct StyxParser {
+    inner: DocumentParser,
+    /// Emptied handles from `styx_parser_recycle`, reused for results. Boxed
+    /// because the handles themselves are what gets reused.
+    #[allow(clippy::vec_box)]
+    spare: Vec<Box<StyxDocument>>,
+}
+
+/// Document handles a `StyxParser` keeps for reuse.
+const MAX_SPARE_DOCUMENTS: usize = 64;
+
+/// Opaque handle to a streaming event reader.
+pub struct StyxEventReader {
+    /// Borrows the caller's buffer, which must outlive the reader.
+    parser: Parser<'static>,
+    /// The last event returned, keeping its unescaped text alive.
+    current: Option<Event<'static>>,
+    /// Joined doc comment lines or the formatted error message.
+    scratch: String,
+    /// Some event has been consumed, so the stream no longer starts at the
+    /// document root.
+    started: bool,
+}
+
+/// A growable byte buffer that a `StyxWriter` appends to.
+///
+/// `data` is null or memory from `malloc`/`realloc`; the writer grows it with
+/// `realloc` and the caller releases it with `free`. The bytes are not
+/// null-terminated.
+#[repr(C)]
+pub struct StyxBuffer {
+    /// The bytes written so far, or null.
+    pub data: *mut c_char,
+    /// Number of bytes written.
+    pub len: usize,
+    /// Allocated size of `data`.
+    pub capacity: usize,
+}
+
+/// Output callback for `styx_writer_new_callback`. Receives the next `len`
+/// bytes of output and returns false to stop the writer.
+pub type StyxWriteFn =
+    Option<unsafe extern "C" fn(context: *mut c_void, data: *const c_char, len: usize) -> bool>;
+
+/// Opaque handle to a streaming writer.
+pub struct StyxWriter {
+    sink: WriterSink,
+    /// Open containers, starting with the implicit root object. Empty once
+    /// the writer is finished.
+    stack: Vec<WriterFrame>,
+    /// The last call was `styx_writer_tag`, so the next value is its payload.
+    tagged: bool,
+    compact: bool,
+    /// The first thing that went wrong; every later call fails.
+    error: Option<&'static CStr>,
+}
+
+enum WriterSink {
+    Buffer(*mut StyxBuffer),
+    Callback {
+        write: unsafe extern "C" fn(*mut c_void, *const c_char, usize) -> bool,
+        context: *mut c_void,
+        /// Output not yet handed to `write`.
+        staged: Vec<u8>,
+    },
+}
+
+#[derive(Clone, Copy)]
+enum WriterFrame {
+    /// `keyed` is set between a key and its value.
+    Object {
+        entries: usize,
+        keyed: bool,
+    },
+    Sequence {
+        items: usize,
+    },
+}
+
 // =============================================================================
 // Parsing
 // =============================================================================
 
+/// Flag for `styx_parse_n`: the caller guarantees the buffer is valid UTF-8,
+/// so the UTF-8 validation pass is skipped.
+pub const STYX_PARSE_TRUSTED_UTF8: u32 = 1 << 0;
+
 /// Parse a Styx document from a UTF-8 string.
 ///
 /// # Safety
@@ -68,49 +673,291 @@ pub enum StyxPayloadKind {
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn styx_parse(source: *const c_char) -> StyxParseResult {
     if source.is_null() {
-        let error = CString::new("source is null").unwrap();
-        return StyxParseResult {
-            document: ptr::null_mut(),
-            error: error.into_raw(),
+        return error_result("source is null");
+    }
+
+    match unsafe { CStr::from_ptr(source) }.to_str() {
+        Ok(source) => parse_result(source),
+        Err(_) => error_result("source is not valid UTF-8"),
+    }
+}
+
+/// Parse a Styx document from a buffer of `len` bytes.
+///
+/// The buffer does not need to be null-terminated. Unless `flags` contains
+/// `STYX_PARSE_TRUSTED_UTF8`, the buffer is validated as UTF-8 first.
+///
+/// # Safety
+/// - `source` must point to at least `len` readable bytes (it may be null if `len` is 0).
+/// - If `flags` contains `STYX_PARSE_TRUSTED_UTF8`, the bytes must be valid UTF-8.
+/// - The returned `StyxParseResult` must be freed as for `styx_parse`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_n(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> StyxParseResult {
+    match unsafe { source_str(source, len, flags) } {
+        Ok(source) => parse_result(source),
+        Err(message) => error_result(message),
+    }
+}
+
+/// Parse a Styx document from a buffer of `len` bytes using up to `threads`
+/// threads.
+///
+/// The document is split between top-level entries and the pieces are parsed
+/// concurrently; the result is identical to `styx_parse_n`. `threads == 0`
+/// uses the number of available CPUs. Small documents are parsed on the
+/// calling thread.
+///
+/// # Safety
+/// Same requirements as `styx_parse_n`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_parallel(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    threads: usize,
+) -> StyxParseResult {
+    match unsafe { source_str(source, len, flags) } {
+        Ok(source) => match Document::parse_parallel(source, threads) {
+            Ok(doc) => document_result(doc),
+            Err(e) => error_result(&format_error(&e)),
+        },
+        Err(message) => error_result(message),
+    }
+}
+
+/// Parse `count` independent documents using up to `threads` threads.
+///
+/// `out[i]` receives the result for `inputs[i]`, exactly as `styx_parse_n`
+/// would return it with the same `flags`. Worker threads take inputs from a
+/// shared queue, so a few large documents do not hold up the rest, and each
+/// thread reuses its parser state across the documents it parses.
+/// `threads == 0` uses the number of available CPUs. Returns the number of
+/// documents that parsed successfully.
+///
+/// # Safety
+/// - `inputs` must point to `count` `StyxStr`s, each meeting the
+///   requirements `styx_parse_n` has for `source` and `len`.
+/// - `out` must point to writable space for `count` `StyxParseResult`s.
+/// - Every result written to `out` must be freed as for `styx_parse`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_batch(
+    inputs: *const StyxStr,
+    count: usize,
+    flags: u32,
+    threads: usize,
+    out: *mut StyxParseResult,
+) -> usize {
+    if count == 0 || inputs.is_null() || out.is_null() {
+        return 0;
+    }
+    let inputs = unsafe { std::slice::from_raw_parts(inputs, count) };
+
+    // Inputs that fail UTF-8 checks parse as empty and are reported below.
+    let mut rejected = vec![None; count];
+    let sources: Vec<&str> = inputs
+        .iter()
+        .zip(&mut rejected)
+        .map(
+            |(input, rejected)| match unsafe { source_str(input.ptr, input.len, flags) } {
+                Ok(source) => source,
+                Err(message) => {
+                    *rejected = Some(message);
+                    ""
+                }
+            },
+        )
+        .collect();
+
+    let mut parsed = 0;
+    let results = Document::parse_batch(&sources, threads);
+    for (i, (result, rejected)) in results.into_iter().zip(rejected).enumerate() {
+        let result = match (rejected, result) {
+            (Some(message), _) => error_result(message),
+            (None, Ok(doc)) => {
+                parsed += 1;
+                document_result(doc)
+            }
+            (None, Err(e)) => error_result(&format_error(&e)),
         };
+        unsafe { out.add(i).write(result) };
     }
+    parsed
+}
 
-    let source = match unsafe { CStr::from_ptr(source) }.to_str() {
-        Ok(s) => s,
-        Err(_) => {
-            let error = CString::new("source is not valid UTF-8").unwrap();
-            return StyxParseResult {
-                document: ptr::null_mut(),
-                error: error.into_raw(),
-            };
-        }
+/// Parse a Styx document from a buffer of `len` bytes, deferring nested
+/// objects until they are first read.
+///
+/// The source is copied, so the buffer may be freed after the call. Nested
+/// objects are only brace-matched up front and parsed when an accessor first
+/// reads them, so errors inside them are not reported here; call
+/// `styx_object_error` on an object to check it.
+///
+/// # Safety
+/// Same requirements as `styx_parse_n`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_lazy(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> StyxParseResult {
+    match unsafe { source_str(source, len, flags) } {
+        Ok(source) => match Document::parse_lazy(source) {
+            Ok(doc) => document_result(doc),
+            Err(e) => error_result(&format_error(&e)),
+        },
+        Err(message) => error_result(message),
+    }
+}
+
+/// Parse a Styx document from a buffer of `len` bytes, recording what each
+/// phase of the parse did in `stats`.
+///
+/// The result is identical to `styx_parse_n`, but the phases run as
+/// separate passes so they can be timed, which makes this two to three times
+/// slower. The lexing and parsing times are estimated by subtracting one pass
+/// from the next, and the allocation counts are the blocks the finished
+/// document retains, found by walking it, not every allocation the parse
+/// made. `stats` is filled in on failure too, with zero node and allocation
+/// counts. Other parsing functions do no bookkeeping at all.
+///
+/// # Safety
+/// - Same requirements as `styx_parse_n`.
+/// - `stats` must be a valid pointer to a writable `StyxParseStats`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_with_stats(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    stats: *mut StyxParseStats,
+) -> StyxParseResult {
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_result(message),
     };
+    let (result, parse_stats) = Document::parse_with_stats(source);
+    if !stats.is_null() {
+        unsafe { stats.write(parse_stats.into()) };
+    }
+    match result {
+        Ok(doc) => document_result(doc),
+        Err(e) => error_result(&format_error(&e)),
+    }
+}
 
-    match Document::parse(source) {
-        Ok(doc) => {
-            let boxed = Box::new(StyxDocument { inner: doc });
-            StyxParseResult {
-                document: Box::into_raw(boxed),
-                error: ptr::null_mut(),
-            }
-        }
-        Err(e) => {
-            let error_msg = format_error(&e);
-            let error =
-                CString::new(error_msg).unwrap_or_else(|_| CString::new("unknown error").unwrap());
-            StyxParseResult {
-                document: ptr::null_mut(),
-                error: error.into_raw(),
-            }
+/// The cache used by `styx_parse`, `styx_parse_n` and `styx_parse_ex`, if one
+/// is configured.
+static PARSE_CACHE: RwLock<Option<Arc<ParseCache>>> = RwLock::new(None);
+
+/// Cache parsed documents on disk, in the directory `dir`.
+///
+/// Once set, `styx_parse`, `styx_parse_n` and `styx_parse_ex` store each
+/// document they parse
+/// in the compiled format under a hash of its source, and load it from there
+/// when the same source is parsed again, in this or a later process. Sources
+/// under 1 KiB and sources that fail to parse are never stored. Pass null to
+/// stop using the cache. Returns false (leaving the setting unchanged) if
+/// `dir` is not a valid path.
+///
+/// # Safety
+/// - `dir` must be a valid null-terminated string, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_set_parse_cache(dir: *const c_char) -> bool {
+    let cache = if dir.is_null() {
+        None
+    } else {
+        let dir = unsafe { CStr::from_ptr(dir) };
+        #[cfg(unix)]
+        let dir = {
+            use std::os::unix::ffi::OsStrExt;
+            std::ffi::OsStr::from_bytes(dir.to_bytes())
+        };
+        #[cfg(not(unix))]
+        let Ok(dir) = dir.to_str() else {
+            return false;
+        };
+        if dir.is_empty() {
+            return false;
         }
+        Some(Arc::new(ParseCache::new(dir)))
+    };
+    *PARSE_CACHE.write().unwrap_or_else(PoisonError::into_inner) = cache;
+    true
+}
+
+/// View a caller buffer as `&str`, honouring `STYX_PARSE_TRUSTED_UTF8`.
+///
+/// # Safety
+/// As for `styx_parse_n`; the returned string borrows the caller's buffer.
+unsafe fn source_str<'a>(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> Result<&'a str, &'static str> {
+    let bytes: &[u8] = if len == 0 {
+        &[]
+    } else if source.is_null() {
+        return Err("source is null");
+    } else {
+        unsafe { std::slice::from_raw_parts(source as *const u8, len) }
+    };
+
+    if flags & STYX_PARSE_TRUSTED_UTF8 != 0 {
+        return Ok(unsafe { std::str::from_utf8_unchecked(bytes) });
+    }
+
+    std::str::from_utf8(bytes).map_err(|_| "source is not valid UTF-8")
+}
+
+/// Parse `source` through the configured parse cache, if there is one.
+fn cached_parse(source: &str) -> Result<Document, BuildError> {
+    let cache = PARSE_CACHE
+        .read()
+        .unwrap_or_else(PoisonError::into_inner)
+        .clone();
+    match cache {
+        Some(cache) => cache.parse(source),
+        None => Document::parse(source),
+    }
+}
+
+fn parse_result(source: &str) -> StyxParseResult {
+    match cached_parse(source) {
+        Ok(doc) => document_result(doc),
+        Err(e) => error_result(&format_error(&e)),
+    }
+}
+
+fn document_result(doc: Document) -> StyxParseResult {
+    let boxed = Box::new(StyxDocument { inner: doc });
+    StyxParseResult {
+        document: Box::into_raw(boxed),
+        error: ptr::null_mut(),
     }
 }
 
+fn error_result(message: &str) -> StyxParseResult {
+    StyxParseResult {
+        document: ptr::null_mut(),
+        error: error_string(message),
+    }
+}
+
+fn error_string(message: &str) -> *mut c_char {
+    CString::new(message)
+        .unwrap_or_else(|_| CString::new("unknown error").unwrap())
+        .into_raw()
+}
+
 fn format_error(e: &BuildError) -> String {
     match e {
         BuildError::UnexpectedEvent(msg) => format!("unexpected event: {}", msg),
         BuildError::UnclosedStructure => "unclosed structure".to_string(),
         BuildError::EmptyDocument => "empty document".to_string(),
+        BuildError::TooLarge => "document is too large".to_string(),
         BuildError::Parse(kind, span) => {
             format!("parse error at {}-{}: {}", span.start, span.end, kind)
         }
@@ -132,54 +979,2131 @@ pub unsafe extern "C" fn styx_free_document(doc: *mut StyxDocument) {
 /// Free a string returned by the library.
 ///
 /// # Safety
-/// - `s` must be a valid pointer returned by a styx_* function, or null.
+/// - `s` must be a valid pointer returned by a styx_* function, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_free_string(s: *mut c_char) {
+    if !s.is_null() {
+        drop(unsafe { CString::from_raw(s) });
+    }
+}
+
+// =============================================================================
+// Structured errors
+// =============================================================================
+
+/// Parse a Styx document from a buffer of `len` bytes, reporting failure as
+/// a `StyxError` instead of a formatted string.
+///
+/// Returns the document, or null with the first error written to `*error`.
+/// On success `error->code` is `STYX_ERROR_CODE_NONE`. Nothing is allocated
+/// for the error; use `styx_error_message` to format it.
+///
+/// # Safety
+/// - Same requirements as `styx_parse_n`.
+/// - `error` must be null or point to writable storage for one `StyxError`.
+/// - A non-null result must be freed with `styx_free_document`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parse_ex(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    error: *mut StyxError,
+) -> *mut StyxDocument {
+    let parsed = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => cached_parse(source).map_err(|e| StyxError::from_build(&e)),
+        Err(message) => Err(StyxError::from_source(message)),
+    };
+    let (doc, report) = match parsed {
+        Ok(doc) => (
+            Box::into_raw(Box::new(StyxDocument { inner: doc })),
+            StyxError::NONE,
+        ),
+        Err(e) => (ptr::null_mut(), e),
+    };
+    if !error.is_null() {
+        unsafe { *error = report };
+    }
+    doc
+}
+
+/// Check a buffer of `len` bytes for syntax errors without building a
+/// document.
+///
+/// Runs the parser to the end, writing the first `capacity` errors to
+/// `errors` in source order, and returns the total number found (0 if the
+/// source is well-formed). Pass `capacity == 0` to only count them.
+///
+/// # Safety
+/// - Same requirements as `styx_parse_n` for `source`, `len` and `flags`.
+/// - `errors` must point to writable storage for `capacity` `StyxError`s (it
+///   may be null if `capacity` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_check_syntax(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    errors: *mut StyxError,
+    capacity: usize,
+) -> usize {
+    let out: &mut [StyxError] = if errors.is_null() || capacity == 0 {
+        &mut []
+    } else {
+        unsafe { std::slice::from_raw_parts_mut(errors, capacity) }
+    };
+
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => {
+            if let Some(slot) = out.first_mut() {
+                *slot = StyxError::from_source(message);
+            }
+            return 1;
+        }
+    };
+
+    let mut count = 0;
+    let mut parser = Parser::new(source);
+    while let Some(event) = parser.next_event() {
+        if let EventKind::Error { kind } = &event.kind {
+            if let Some(slot) = out.get_mut(count) {
+                *slot = StyxError::from_parse(kind, event.span);
+            }
+            count += 1;
+        }
+    }
+    count
+}
+
+/// Format an error as a message, like the strings returned by `styx_parse`.
+///
+/// Writes at most `capacity` bytes to `buf`, always null-terminated when
+/// `capacity > 0` and truncated at a character boundary, and returns the
+/// length of the full message excluding the terminator (as `snprintf`
+/// does). Escape sequences and paths are read back from the source, so pass
+/// the buffer that was parsed; with a null `source` they are left blank.
+///
+/// # Safety
+/// - `error` must be a valid pointer to a `StyxError` filled in by this
+///   library.
+/// - `source` must be null or point to at least `len` readable bytes.
+/// - `buf` must point to at least `capacity` writable bytes (it may be null
+///   if `capacity` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_error_message(
+    error: *const StyxError,
+    source: *const c_char,
+    len: usize,
+    buf: *mut c_char,
+    capacity: usize,
+) -> usize {
+    if error.is_null() {
+        return 0;
+    }
+    let source = unsafe { source_bytes(source, len) };
+    let message = unsafe { &*error }.message(source);
+
+    if !buf.is_null() && capacity > 0 {
+        let mut n = message.len().min(capacity - 1);
+        while !message.is_char_boundary(n) {
+            n -= 1;
+        }
+        unsafe {
+            ptr::copy_nonoverlapping(message.as_ptr(), buf as *mut u8, n);
+            *buf.add(n) = 0;
+        }
+    }
+    message.len()
+}
+
+/// Compute the line and column where an error starts.
+///
+/// Lines and columns count from 1; columns count characters, not bytes.
+/// Offsets past the end of the buffer are clamped to it. Returns `{0, 0}`
+/// if `error` is null.
+///
+/// # Safety
+/// - `error` must be null or a valid pointer to a `StyxError`.
+/// - `source` must point to at least `len` readable bytes (it may be null if
+///   `len` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_error_position(
+    error: *const StyxError,
+    source: *const c_char,
+    len: usize,
+) -> StyxPosition {
+    if error.is_null() {
+        return StyxPosition { line: 0, column: 0 };
+    }
+    let source = unsafe { source_bytes(source, len) };
+    let offset = (unsafe { &*error }.span_start as usize).min(source.len());
+    let before = &source[..offset];
+    let line_start = before
+        .iter()
+        .rposition(|&b| b == b'\n')
+        .map_or(0, |i| i + 1);
+    // Count characters by skipping UTF-8 continuation bytes.
+    let column = before[line_start..]
+        .iter()
+        .filter(|&&b| b & 0xC0 != 0x80)
+        .count();
+    StyxPosition {
+        line: before.iter().filter(|&&b| b == b'\n').count() as u32 + 1,
+        column: column as u32 + 1,
+    }
+}
+
+/// View an optional caller buffer as bytes, without UTF-8 validation.
+///
+/// # Safety
+/// `source` must be null or point to at least `len` readable bytes.
+unsafe fn source_bytes<'a>(source: *const c_char, len: usize) -> &'a [u8] {
+    if source.is_null() || len == 0 {
+        &[]
+    } else {
+        unsafe { std::slice::from_raw_parts(source as *const u8, len) }
+    }
+}
+
+// =============================================================================
+// Reusable parsers
+// =============================================================================
+
+/// Create a parser that keeps its buffers between documents.
+///
+/// Parsing many small documents with one parser avoids most of the
+/// allocations `styx_parse_n` makes for each of them, more so when finished
+/// documents are handed back with `styx_parser_recycle`.
+///
+/// The returned parser must be freed with `styx_parser_free`.
+#[unsafe(no_mangle)]
+pub extern "C" fn styx_parser_new() -> *mut StyxParser {
+    Box::into_raw(Box::new(StyxParser {
+        inner: DocumentParser::new(),
+        spare: Vec::new(),
+    }))
+}
+
+/// Parse a document from a buffer of `len` bytes, reusing `parser`'s buffers
+/// and the storage of documents given back with `styx_parser_recycle`.
+///
+/// The result is identical to `styx_parse_n`.
+///
+/// # Safety
+/// - `parser` must be a valid pointer returned by `styx_parser_new`, and not
+///   be used from two threads at once.
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - The returned `StyxParseResult` must be freed as for `styx_parse`, or its
+///   document passed to `styx_parser_recycle`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parser_parse(
+    parser: *mut StyxParser,
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> StyxParseResult {
+    let Some(parser) = (unsafe { parser.as_mut() }) else {
+        return error_result("parser is null");
+    };
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_result(message),
+    };
+    match parser.inner.parse(source) {
+        Ok(doc) => match parser.spare.pop() {
+            Some(mut boxed) => {
+                boxed.inner = doc;
+                StyxParseResult {
+                    document: Box::into_raw(boxed),
+                    error: ptr::null_mut(),
+                }
+            }
+            None => document_result(doc),
+        },
+        Err(e) => error_result(&format_error(&e)),
+    }
+}
+
+/// Free a document, keeping its storage in `parser` for later parses.
+///
+/// The document may come from any parsing function. If `parser` is null the
+/// document is simply freed.
+///
+/// # Safety
+/// - `parser` must be a valid pointer returned by `styx_parser_new`, or null.
+/// - `doc` must be a valid document pointer, or null, and must not be used
+///   after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parser_recycle(parser: *mut StyxParser, doc: *mut StyxDocument) {
+    if doc.is_null() {
+        return;
+    }
+    let mut boxed = unsafe { Box::from_raw(doc) };
+    let Some(parser) = (unsafe { parser.as_mut() }) else {
+        return;
+    };
+    let empty = Document {
+        root: Object::new(Vec::new(), None),
+        leading_comments: Vec::new(),
+    };
+    parser
+        .inner
+        .recycle(std::mem::replace(&mut boxed.inner, empty));
+    if parser.spare.len() < MAX_SPARE_DOCUMENTS {
+        parser.spare.push(boxed);
+    }
+}
+
+/// Free all buffers and recycled storage `parser` has kept, as if it were
+/// new.
+///
+/// # Safety
+/// `parser` must be a valid pointer returned by `styx_parser_new`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parser_reset(parser: *mut StyxParser) {
+    if let Some(parser) = unsafe { parser.as_mut() } {
+        parser.inner.reset();
+        parser.spare = Vec::new();
+    }
+}
+
+/// Free a parser. Documents it returned stay valid.
+///
+/// # Safety
+/// - `parser` must be a pointer returned by `styx_parser_new`, or null.
+/// - `parser` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_parser_free(parser: *mut StyxParser) {
+    if !parser.is_null() {
+        drop(unsafe { Box::from_raw(parser) });
+    }
+}
+
+// =============================================================================
+// Compiled documents
+// =============================================================================
+
+/// Serialize a document to the compiled binary format.
+///
+/// Writes the length to `out_len` and returns the bytes, to be freed with
+/// `styx_free_bytes`. Returns null if `doc` or `out_len` is null, or if the
+/// document is too large for the format's 32-bit offsets.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+/// - `out_len` must be a valid pointer to a writable `size_t`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_compile(
+    doc: *const StyxDocument,
+    out_len: *mut usize,
+) -> *mut u8 {
+    if doc.is_null() || out_len.is_null() {
+        return ptr::null_mut();
+    }
+    let doc = unsafe { &*doc };
+    let Ok(bytes) = doc.inner.compile() else {
+        return ptr::null_mut();
+    };
+    let bytes = bytes.into_boxed_slice();
+    unsafe { *out_len = bytes.len() };
+    Box::into_raw(bytes) as *mut u8
+}
+
+/// Free bytes returned by `styx_document_compile`.
+///
+/// # Safety
+/// - `bytes` and `len` must come from the same `styx_document_compile` call, or `bytes` must be null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_free_bytes(bytes: *mut u8, len: usize) {
+    if !bytes.is_null() {
+        drop(unsafe { Box::from_raw(ptr::slice_from_raw_parts_mut(bytes, len)) });
+    }
+}
+
+/// Load a document from compiled bytes (see `styx_document_compile`).
+///
+/// No text is parsed; the data is validated and decoded into a document,
+/// several times faster than `styx_parse_n` builds it from text (see the
+/// `ffi_load` benchmark).
+///
+/// # Safety
+/// - `data` must point to at least `len` readable bytes (it may be null if `len` is 0).
+/// - The returned `StyxParseResult` must be freed as for `styx_parse`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_load_compiled(data: *const u8, len: usize) -> StyxParseResult {
+    let bytes: &[u8] = if len == 0 {
+        &[]
+    } else if data.is_null() {
+        return error_result("data is null");
+    } else {
+        unsafe { std::slice::from_raw_parts(data, len) }
+    };
+    load_compiled(bytes)
+}
+
+/// Load a compiled document from a file.
+///
+/// The file is read into memory, then validated and decoded into a document
+/// as for `styx_load_compiled`; no text is parsed.
+///
+/// # Safety
+/// - `path` must be a valid null-terminated UTF-8 string.
+/// - The returned `StyxParseResult` must be freed as for `styx_parse`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_load_compiled_file(path: *const c_char) -> StyxParseResult {
+    if path.is_null() {
+        return error_result("path is null");
+    }
+    let path = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return error_result("path is not valid UTF-8"),
+    };
+    match std::fs::read(path) {
+        Ok(bytes) => load_compiled(&bytes),
+        Err(e) => error_result(&format!("{path}: {e}")),
+    }
+}
+
+fn load_compiled(bytes: &[u8]) -> StyxParseResult {
+    match Document::from_compiled(bytes) {
+        Ok(doc) => document_result(doc),
+        Err(e) => error_result(&e.to_string()),
+    }
+}
+
+// =============================================================================
+// Streaming events
+// =============================================================================
+
+/// Create a streaming event reader over a buffer of `len` bytes.
+///
+/// The reader parses lazily, one event per `styx_reader_next` call, and never
+/// builds a tree. `flags` takes the same values as for `styx_parse_n`.
+/// Returns null if the buffer is not valid UTF-8.
+///
+/// # Safety
+/// - `source` must point to at least `len` readable bytes (it may be null if `len` is 0).
+/// - The buffer must stay alive and unmodified until the reader is freed.
+/// - If `flags` contains `STYX_PARSE_TRUSTED_UTF8`, the bytes must be valid UTF-8.
+/// - The returned reader must be freed with `styx_reader_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_reader_new(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> *mut StyxEventReader {
+    let bytes: &'static [u8] = if len == 0 {
+        &[]
+    } else if source.is_null() {
+        return ptr::null_mut();
+    } else {
+        unsafe { std::slice::from_raw_parts(source as *const u8, len) }
+    };
+
+    let source = if flags & STYX_PARSE_TRUSTED_UTF8 != 0 {
+        unsafe { std::str::from_utf8_unchecked(bytes) }
+    } else {
+        match std::str::from_utf8(bytes) {
+            Ok(source) => source,
+            Err(_) => return ptr::null_mut(),
+        }
+    };
+
+    Box::into_raw(Box::new(StyxEventReader {
+        parser: Parser::new(source),
+        current: None,
+        scratch: String::new(),
+        started: false,
+    }))
+}
+
+/// Read the next event into `out`.
+///
+/// Returns false (leaving `out` untouched) once the stream is exhausted.
+///
+/// # Safety
+/// - `reader` must be a valid pointer to a `StyxEventReader`, or null.
+/// - `out` must be a valid pointer to a writable `StyxEvent`, or null.
+/// - Strings in `out` are valid until the next call on `reader` or until it is freed.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_reader_next(
+    reader: *mut StyxEventReader,
+    out: *mut StyxEvent,
+) -> bool {
+    if reader.is_null() || out.is_null() {
+        return false;
+    }
+    let reader = unsafe { &mut *reader };
+    reader.started = true;
+    let Some(event) = reader.parser.next_event() else {
+        reader.current = None;
+        return false;
+    };
+    let event = reader.current.insert(event);
+    let scratch = &mut reader.scratch;
+
+    let mut text = StyxStr::NULL;
+    let mut tag = StyxStr::NULL;
+    let mut scalar_kind = StyxScalarKind::Bare;
+    let kind = match &event.kind {
+        EventKind::DocumentStart => StyxEventKind::DocumentStart,
+        EventKind::DocumentEnd => StyxEventKind::DocumentEnd,
+        EventKind::ObjectStart => StyxEventKind::ObjectStart,
+        EventKind::ObjectEnd => StyxEventKind::ObjectEnd,
+        EventKind::SequenceStart => StyxEventKind::SequenceStart,
+        EventKind::SequenceEnd => StyxEventKind::SequenceEnd,
+        EventKind::EntryStart => StyxEventKind::EntryStart,
+        EventKind::EntryEnd => StyxEventKind::EntryEnd,
+        EventKind::Key {
+            tag: key_tag,
+            payload,
+            kind,
+        } => {
+            if let Some(name) = key_tag {
+                tag = StyxStr::borrow(name);
+            }
+            if let Some(payload) = payload {
+                text = StyxStr::borrow(payload);
+            }
+            scalar_kind = (*kind).into();
+            StyxEventKind::Key
+        }
+        EventKind::Scalar { value, kind } => {
+            text = StyxStr::borrow(value);
+            scalar_kind = (*kind).into();
+            StyxEventKind::Scalar
+        }
+        EventKind::Unit => StyxEventKind::Unit,
+        EventKind::TagStart { name } => {
+            tag = StyxStr::borrow(name);
+            StyxEventKind::TagStart
+        }
+        EventKind::TagEnd => StyxEventKind::TagEnd,
+        EventKind::Comment { text: comment } => {
+            text = StyxStr::borrow(comment);
+            StyxEventKind::Comment
+        }
+        EventKind::DocComment { lines } => {
+            scratch.clear();
+            for (i, line) in lines.iter().enumerate() {
+                if i > 0 {
+                    scratch.push('\n');
+                }
+                scratch.push_str(line);
+            }
+            text = StyxStr::borrow(scratch);
+            StyxEventKind::DocComment
+        }
+        EventKind::Error { kind } => {
+            scratch.clear();
+            use std::fmt::Write;
+            let _ = write!(scratch, "{kind}");
+            text = StyxStr::borrow(scratch);
+            StyxEventKind::Error
+        }
+    };
+
+    unsafe {
+        out.write(StyxEvent {
+            kind,
+            scalar_kind,
+            span_start: event.span.start,
+            span_end: event.span.end,
+            text,
+            tag,
+        });
+    }
+    true
+}
+
+/// Free an event reader.
+///
+/// # Safety
+/// - `reader` must be a pointer returned by `styx_reader_new`, or null.
+/// - `reader` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_reader_free(reader: *mut StyxEventReader) {
+    if !reader.is_null() {
+        drop(unsafe { Box::from_raw(reader) });
+    }
+}
+
+// =============================================================================
+// Writing
+// =============================================================================
+
+/// Flag for `styx_writer_new_buffer` and `styx_writer_new_callback`: write
+/// nested objects on one line (`{a 1, b 2}`) instead of one entry per line.
+pub const STYX_WRITE_COMPACT: u32 = 1 << 0;
+
+/// Callback output is handed over in chunks of about this many bytes.
+const WRITER_CHUNK: usize = 64 * 1024;
+
+unsafe extern "C" {
+    fn realloc(ptr: *mut c_void, size: usize) -> *mut c_void;
+}
+
+/// The byte can start a bare scalar (ASCII only).
+const WRITE_START: u8 = 1 << 0;
+/// The byte can continue a bare scalar (ASCII only).
+const WRITE_BARE: u8 = 1 << 1;
+/// The byte can continue a bare key, which excludes the `.` of dotted paths.
+const WRITE_KEY: u8 = 1 << 2;
+/// The byte must be escaped inside a quoted scalar.
+const WRITE_ESCAPE: u8 = 1 << 3;
+
+/// Byte classes for deciding between bare and quoted output, mirroring the
+/// tokenizer's rules for bare scalars.
+static WRITE_CLASSES: [u8; 256] = build_write_classes();
+
+const fn build_write_classes() -> [u8; 256] {
+    let mut table = [0u8; 256];
+    let mut i = 0;
+    while i < 0x80 {
+        let b = i as u8;
+        if b < 0x20 || b == 0x7f || b == b'"' || b == b'\\' {
+            table[i] |= WRITE_ESCAPE;
+        }
+        if b > b' ' && b < 0x7f && !matches!(b, b'{' | b'}' | b'(' | b')' | b',' | b'"' | b'>') {
+            table[i] |= WRITE_BARE;
+            if b != b'.' {
+                table[i] |= WRITE_KEY;
+            }
+            if !matches!(b, b'=' | b'@' | b'/') {
+                table[i] |= WRITE_START;
+            }
+        }
+        i += 1;
+    }
+    table
+}
+
+/// Whether `text` reads back as the same bare scalar. Keys may not contain
+/// `.`, which would make them dotted paths.
+fn writes_bare(text: &str, key: bool) -> bool {
+    let bytes = text.as_bytes();
+    match bytes {
+        [] | [b'r', b'#', ..] | [b'<', b'<', ..] => return false,
+        [first, ..] if first.is_ascii() && WRITE_CLASSES[*first as usize] & WRITE_START == 0 => {
+            return false;
+        }
+        _ => {}
+    }
+    let class = if key { WRITE_KEY } else { WRITE_BARE };
+    match bytes
+        .iter()
+        .position(|&b| WRITE_CLASSES[b as usize] & class == 0)
+    {
+        None => true,
+        // Past the ASCII fast path, only Unicode whitespace ends a scalar.
+        Some(i) => text[i..].chars().all(|c| {
+            if c.is_ascii() {
+                WRITE_CLASSES[c as usize] & class != 0
+            } else {
+                !c.is_whitespace()
+            }
+        }),
+    }
+}
+
+impl StyxWriter {
+    fn new(sink: WriterSink, flags: u32) -> Self {
+        StyxWriter {
+            sink,
+            stack: vec![WriterFrame::Object {
+                entries: 0,
+                keyed: false,
+            }],
+            tagged: false,
+            compact: flags & STYX_WRITE_COMPACT != 0,
+            error: None,
+        }
+    }
+
+    fn fail(&mut self, message: &'static CStr) -> bool {
+        self.error.get_or_insert(message);
+        false
+    }
+
+    #[inline]
+    fn put(&mut self, bytes: &[u8]) {
+        if bytes.is_empty() || self.error.is_some() {
+            return;
+        }
+        let failed = match &mut self.sink {
+            WriterSink::Buffer(buffer) => {
+                let buffer = unsafe { &mut **buffer };
+                let needed = buffer.len + bytes.len();
+                if needed > buffer.capacity {
+                    let capacity = needed.max(buffer.capacity * 2).max(256);
+                    let data = unsafe { realloc(buffer.data as *mut c_void, capacity) };
+                    if data.is_null() {
+                        self.error = Some(c"out of memory");
+                        return;
+                    }
+                    buffer.data = data as *mut c_char;
+                    buffer.capacity = capacity;
+                }
+                unsafe {
+                    ptr::copy_nonoverlapping(
+                        bytes.as_ptr(),
+                        (buffer.data as *mut u8).add(buffer.len),
+                        bytes.len(),
+                    );
+                }
+                buffer.len = needed;
+                false
+            }
+            WriterSink::Callback {
+                write,
+                context,
+                staged,
+            } => {
+                if staged.len() + bytes.len() <= WRITER_CHUNK {
+                    staged.extend_from_slice(bytes);
+                    false
+                } else {
+                    let flushed = staged.is_empty()
+                        || unsafe { write(*context, staged.as_ptr().cast(), staged.len()) };
+                    staged.clear();
+                    if !flushed {
+                        true
+                    } else if bytes.len() < WRITER_CHUNK {
+                        staged.extend_from_slice(bytes);
+                        false
+                    } else {
+                        !unsafe { write(*context, bytes.as_ptr().cast(), bytes.len()) }
+                    }
+                }
+            }
+        };
+        if failed {
+            self.error = Some(c"write callback failed");
+        }
+    }
+
+    /// Start a new line indented by `levels`.
+    fn newline(&mut self, levels: usize) {
+        self.put(b"\n");
+        for _ in 0..levels {
+            self.put(b"    ");
+        }
+    }
+
+    fn quoted(&mut self, text: &[u8]) {
+        self.put(b"\"");
+        let mut run = 0;
+        for (i, &b) in text.iter().enumerate() {
+            if WRITE_CLASSES[b as usize] & WRITE_ESCAPE == 0 {
+                continue;
+            }
+            self.put(&text[run..i]);
+            run = i + 1;
+            match b {
+                b'"' => self.put(b"\\\""),
+                b'\\' => self.put(b"\\\\"),
+                b'\n' => self.put(b"\\n"),
+                b'\r' => self.put(b"\\r"),
+                b'\t' => self.put(b"\\t"),
+                _ => {
+                    const HEX: &[u8; 16] = b"0123456789abcdef";
+                    let hex = [HEX[(b >> 4) as usize], HEX[(b & 0xf) as usize]];
+                    self.put(b"\\u{");
+                    self.put(&hex);
+                    self.put(b"}");
+                }
+            }
+        }
+        self.put(&text[run..]);
+        self.put(b"\"");
+    }
+
+    /// Check that a value may come next and write the space before it.
+    /// Returns whether the value is a tag's payload.
+    fn begin_value(&mut self) -> Option<bool> {
+        if self.error.is_some() {
+            return None;
+        }
+        if std::mem::take(&mut self.tagged) {
+            return Some(true);
+        }
+        match self.stack.last_mut() {
+            Some(WriterFrame::Object { keyed, .. }) if *keyed => {
+                *keyed = false;
+                self.put(b" ");
+            }
+            Some(WriterFrame::Object { .. }) => {
+                self.fail(c"value without a key");
+                return None;
+            }
+            Some(WriterFrame::Sequence { items }) => {
+                *items += 1;
+                if *items > 1 {
+                    self.put(b" ");
+                }
+            }
+            None => {
+                self.fail(c"writer is finished");
+                return None;
+            }
+        }
+        Some(false)
+    }
+
+    fn key(&mut self, key: &str) -> bool {
+        if self.error.is_some() {
+            return false;
+        }
+        self.tagged = false;
+        let depth = self.stack.len();
+        let Some(WriterFrame::Object { entries, keyed }) = self.stack.last_mut() else {
+            return self.fail(c"key outside an object");
+        };
+        *entries += 1;
+        *keyed = true;
+        let first = *entries == 1;
+        if depth == 1 {
+            if !first {
+                self.put(b"\n");
+            }
+        } else if !self.compact {
+            self.newline(depth - 1);
+        } else if !first {
+            self.put(b", ");
+        }
+        if writes_bare(key, true) {
+            self.put(key.as_bytes());
+        } else {
+            self.quoted(key.as_bytes());
+        }
+        self.error.is_none()
+    }
+
+    fn scalar(&mut self, text: &str) -> bool {
+        let Some(tagged) = self.begin_value() else {
+            return false;
+        };
+        // A bare scalar right after a tag would read as part of its name.
+        if !tagged && writes_bare(text, false) {
+            self.put(text.as_bytes());
+        } else {
+            self.quoted(text.as_bytes());
+        }
+        self.error.is_none()
+    }
+
+    fn number(&mut self, text: &[u8]) -> bool {
+        let Some(tagged) = self.begin_value() else {
+            return false;
+        };
+        if tagged {
+            self.quoted(text);
+        } else {
+            self.put(text);
+        }
+        self.error.is_none()
+    }
+
+    fn unit(&mut self) -> bool {
+        if self.error.is_some() {
+            return false;
+        }
+        if std::mem::take(&mut self.tagged) {
+            return true;
+        }
+        // An entry with nothing after its key is already a unit.
+        if let Some(WriterFrame::Object { keyed, .. }) = self.stack.last_mut()
+            && *keyed
+        {
+            *keyed = false;
+            return true;
+        }
+        self.begin_value().is_some() && {
+            self.put(b"@");
+            self.error.is_none()
+        }
+    }
+
+    fn tag(&mut self, name: &str) -> bool {
+        let mut chars = name.chars();
+        let valid = matches!(chars.next(), Some(c) if c.is_ascii_alphabetic() || c == '_')
+            && chars.all(|c| c.is_ascii_alphanumeric() || c == '_' || c == '-');
+        if !valid {
+            return self.fail(c"invalid tag name");
+        }
+        // A value has at most one tag.
+        if self.tagged {
+            return self.fail(c"value already tagged");
+        }
+        if self.begin_value().is_none() {
+            return false;
+        }
+        self.put(b"@");
+        self.put(name.as_bytes());
+        self.tagged = true;
+        self.error.is_none()
+    }
+
+    fn begin(&mut self, frame: WriterFrame) -> bool {
+        if self.begin_value().is_none() {
+            return false;
+        }
+        self.put(match frame {
+            WriterFrame::Object { .. } => b"{",
+            WriterFrame::Sequence { .. } => b"(",
+        });
+        self.stack.push(frame);
+        self.error.is_none()
+    }
+
+    fn end(&mut self) -> bool {
+        if self.error.is_some() {
+            return false;
+        }
+        self.tagged = false;
+        if self.stack.len() < 2 {
+            return self.fail(c"nothing to end");
+        }
+        match self.stack.pop() {
+            Some(WriterFrame::Object { entries, .. }) => {
+                if entries > 0 && !self.compact {
+                    self.newline(self.stack.len() - 1);
+                }
+                self.put(b"}");
+            }
+            _ => self.put(b")"),
+        }
+        self.error.is_none()
+    }
+
+    fn finish(&mut self) -> bool {
+        if self.error.is_some() {
+            return false;
+        }
+        match self.stack.as_slice() {
+            [] => return self.fail(c"writer is finished"),
+            [WriterFrame::Object { entries, .. }] => {
+                if *entries > 0 {
+                    self.put(b"\n");
+                }
+            }
+            _ => return self.fail(c"unclosed object or sequence"),
+        }
+        self.stack.clear();
+        self.tagged = false;
+        if let WriterSink::Callback {
+            write,
+            context,
+            staged,
+        } = &mut self.sink
+            && !staged.is_empty()
+        {
+            let flushed = unsafe { write(*context, staged.as_ptr().cast(), staged.len()) };
+            staged.clear();
+            if !flushed {
+                return self.fail(c"write callback failed");
+            }
+        }
+        self.error.is_none()
+    }
+}
+
+/// Run `f` on the writer behind `writer`, failing if it is null.
+unsafe fn with_writer(writer: *mut StyxWriter, f: impl FnOnce(&mut StyxWriter) -> bool) -> bool {
+    if writer.is_null() {
+        return false;
+    }
+    f(unsafe { &mut *writer })
+}
+
+/// Run `f` on the writer and the UTF-8 text of `len` bytes at `text`.
+unsafe fn with_writer_text(
+    writer: *mut StyxWriter,
+    text: *const c_char,
+    len: usize,
+    f: impl FnOnce(&mut StyxWriter, &str) -> bool,
+) -> bool {
+    unsafe {
+        with_writer(writer, |writer| match source_str(text, len, 0) {
+            Ok(text) => f(writer, text),
+            Err(_) if text.is_null() => writer.fail(c"text is null"),
+            Err(_) => writer.fail(c"text is not valid UTF-8"),
+        })
+    }
+}
+
+/// Create a writer that appends Styx text to `buffer`.
+///
+/// The writer emits output as it is pushed, without building a tree. The
+/// document's root is an object, so writing starts with
+/// `styx_writer_key`. `flags` is a bitwise OR of `STYX_WRITE_*` flags, or 0.
+/// Returns null if `buffer` is null.
+///
+/// # Safety
+/// - `buffer` must point to a valid `StyxBuffer` whose `data` is null or was
+///   allocated with `malloc`, and must outlive the writer.
+/// - The returned writer must be freed with `styx_writer_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_new_buffer(
+    buffer: *mut StyxBuffer,
+    flags: u32,
+) -> *mut StyxWriter {
+    if buffer.is_null() {
+        return ptr::null_mut();
+    }
+    Box::into_raw(Box::new(StyxWriter::new(WriterSink::Buffer(buffer), flags)))
+}
+
+/// Create a writer that hands Styx text to `write` in chunks.
+///
+/// Output is staged internally and passed to `write` whenever about 64 KiB
+/// have built up, and by `styx_writer_finish`. Returns null if `write` is
+/// null.
+///
+/// # Safety
+/// - `write` must be safe to call with `context` until the writer is freed.
+/// - The returned writer must be freed with `styx_writer_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_new_callback(
+    write: StyxWriteFn,
+    context: *mut c_void,
+    flags: u32,
+) -> *mut StyxWriter {
+    let Some(write) = write else {
+        return ptr::null_mut();
+    };
+    Box::into_raw(Box::new(StyxWriter::new(
+        WriterSink::Callback {
+            write,
+            context,
+            staged: Vec::new(),
+        },
+        flags,
+    )))
+}
+
+/// Write an entry's key. Keys that cannot be written bare (including any
+/// containing `.`) are quoted.
+///
+/// Every writer call returns false once something has gone wrong; see
+/// `styx_writer_error`.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+/// - `key` must point to at least `len` readable bytes of UTF-8 (it may be null if `len` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_key(
+    writer: *mut StyxWriter,
+    key: *const c_char,
+    len: usize,
+) -> bool {
+    unsafe { with_writer_text(writer, key, len, StyxWriter::key) }
+}
+
+/// Write a scalar, bare if it reads back unchanged and quoted otherwise.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+/// - `text` must point to at least `len` readable bytes of UTF-8 (it may be null if `len` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_scalar(
+    writer: *mut StyxWriter,
+    text: *const c_char,
+    len: usize,
+) -> bool {
+    unsafe { with_writer_text(writer, text, len, StyxWriter::scalar) }
+}
+
+/// Write an integer scalar.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_int(writer: *mut StyxWriter, value: i64) -> bool {
+    unsafe {
+        with_writer(writer, |writer| {
+            let mut digits = [0u8; 20];
+            let mut n = value.unsigned_abs();
+            let mut start = digits.len();
+            loop {
+                start -= 1;
+                digits[start] = b'0' + (n % 10) as u8;
+                n /= 10;
+                if n == 0 {
+                    break;
+                }
+            }
+            if value < 0 {
+                start -= 1;
+                digits[start] = b'-';
+            }
+            writer.number(&digits[start..])
+        })
+    }
+}
+
+/// Write a float scalar in the shortest form that reads back as the same
+/// value. Fails for NaN and infinities, which Styx has no spelling for.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_float(writer: *mut StyxWriter, value: f64) -> bool {
+    unsafe {
+        with_writer(writer, |writer| {
+            if !value.is_finite() {
+                return writer.fail(c"float is not finite");
+            }
+            // `Debug` is the shortest text that parses back to the same bits,
+            // and switches to exponent form (`1e300`, `5e-324`) where `Display`
+            // would spell out hundreds of digits.
+            use std::io::Write;
+            let mut text = [0u8; 64];
+            let mut cursor = &mut text[..];
+            if write!(cursor, "{value:?}").is_err() {
+                return writer.fail(c"float does not fit the format buffer");
+            }
+            let len = 64 - cursor.len();
+            writer.number(&text[..len])
+        })
+    }
+}
+
+/// Write `true` or `false`.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_bool(writer: *mut StyxWriter, value: bool) -> bool {
+    unsafe {
+        with_writer(writer, |writer| {
+            writer.scalar(if value { "true" } else { "false" })
+        })
+    }
+}
+
+/// Write a unit value: `@` in a sequence, nothing after a key or a tag.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_unit(writer: *mut StyxWriter) -> bool {
+    unsafe { with_writer(writer, StyxWriter::unit) }
+}
+
+/// Write a tag. The next value written is its payload; a tag followed by a
+/// unit, a key or `styx_writer_end` stands alone (`@name`). A value takes
+/// one tag, so a second tag in a row fails.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+/// - `name` must point to at least `len` readable bytes of UTF-8 (it may be null if `len` is 0).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_tag(
+    writer: *mut StyxWriter,
+    name: *const c_char,
+    len: usize,
+) -> bool {
+    unsafe { with_writer_text(writer, name, len, StyxWriter::tag) }
+}
+
+/// Open a nested object as the next value; close it with `styx_writer_end`.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_begin_object(writer: *mut StyxWriter) -> bool {
+    unsafe {
+        with_writer(writer, |writer| {
+            writer.begin(WriterFrame::Object {
+                entries: 0,
+                keyed: false,
+            })
+        })
+    }
+}
+
+/// Open a sequence as the next value; close it with `styx_writer_end`.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_begin_sequence(writer: *mut StyxWriter) -> bool {
+    unsafe {
+        with_writer(writer, |writer| {
+            writer.begin(WriterFrame::Sequence { items: 0 })
+        })
+    }
+}
+
+/// Close the innermost open object or sequence.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_end(writer: *mut StyxWriter) -> bool {
+    unsafe { with_writer(writer, StyxWriter::end) }
+}
+
+/// Finish the document and hand any staged output to the callback.
+///
+/// Fails if an object or sequence is still open. Returns true if the whole
+/// document was written.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_finish(writer: *mut StyxWriter) -> bool {
+    unsafe { with_writer(writer, StyxWriter::finish) }
+}
+
+/// Describe the first call that failed, or return null if none has.
+///
+/// # Safety
+/// - `writer` must be a valid pointer to a `StyxWriter`, or null.
+/// - The returned string is static and must not be freed.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_error(writer: *const StyxWriter) -> *const c_char {
+    if writer.is_null() {
+        return ptr::null();
+    }
+    match unsafe { &*writer }.error {
+        Some(message) => message.as_ptr(),
+        None => ptr::null(),
+    }
+}
+
+/// Free a writer. Output written to a buffer stays there; output staged for
+/// a callback since the last chunk is dropped unless the writer was finished.
+///
+/// # Safety
+/// - `writer` must be a pointer returned by `styx_writer_new_buffer` or
+///   `styx_writer_new_callback`, or null.
+/// - `writer` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_writer_free(writer: *mut StyxWriter) {
+    if !writer.is_null() {
+        drop(unsafe { Box::from_raw(writer) });
+    }
+}
+
+// =============================================================================
+// Document access
+// =============================================================================
+
+/// Get the root object of a document.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`.
+/// - The returned pointer is valid as long as `doc` is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_root(doc: *const StyxDocument) -> *const StyxObject {
+    if doc.is_null() {
+        return ptr::null();
+    }
+    let doc = unsafe { &*doc };
+    &doc.inner.root as *const Object as *const StyxObject
+}
+
+/// Get a value by path from a document.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`.
+/// - `path` must be a valid null-terminated UTF-8 string.
+/// - The returned pointer is valid as long as `doc` is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_get(
+    doc: *const StyxDocument,
+    path: *const c_char,
+) -> *const StyxValue {
+    if doc.is_null() || path.is_null() {
+        return ptr::null();
+    }
+    let doc = unsafe { &*doc };
+    let path = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return ptr::null(),
+    };
+    match doc.inner.get(path) {
+        Some(value) => value as *const Value as *const StyxValue,
+        None => ptr::null(),
+    }
+}
+
+/// Build the key index of every wide object in a document.
+///
+/// Key indexes are otherwise built lazily by the first lookup into a wide
+/// object. Call this before sharing a document between threads so readers
+/// never pay for (or race to) the first build.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_build_indexes(doc: *const StyxDocument) {
+    if doc.is_null() {
+        return;
+    }
+    let doc = unsafe { &*doc };
+    doc.inner.build_indexes();
+}
+
+// =============================================================================
+// Change tracking
+// =============================================================================
+
+/// Update a document in place after an edit to its source.
+///
+/// `edit_start..edit_end` is the byte range of the old source that was
+/// replaced, and `new_len` the length of the replacement; `source`/`len` is
+/// the whole new source. Only the top-level entries the edit touches are
+/// reparsed. If `changes` is not null, it receives the paths whose values were
+/// added, removed or changed.
+///
+/// Returns null on success, or an error message (the document is unchanged,
+/// and `*changes` is set to null).
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument` parsed from the source
+///   before the edit, and not be in use by any other thread.
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - `changes` must be null or valid for writes.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+/// - `*changes`, if set, must be freed with `styx_changes_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_reparse(
+    doc: *mut StyxDocument,
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    edit_start: usize,
+    edit_end: usize,
+    new_len: usize,
+    changes: *mut *mut StyxChanges,
+) -> *mut c_char {
+    if !changes.is_null() {
+        unsafe { *changes = ptr::null_mut() };
+    }
+    if doc.is_null() {
+        return error_string("document is null");
+    }
+    let doc = unsafe { &mut *doc };
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_string(message),
+    };
+    let edit = Edit {
+        range: edit_start..edit_end,
+        new_len,
+    };
+    match doc.inner.reparse(source, &edit) {
+        Ok(list) => {
+            if !changes.is_null() {
+                let boxed = Box::new(StyxChanges { inner: list });
+                unsafe { *changes = Box::into_raw(boxed) };
+            }
+            ptr::null_mut()
+        }
+        Err(e) => error_string(&format_error(&e)),
+    }
+}
+
+/// List the paths whose values differ between two documents.
+///
+/// Identical subtrees are skipped by comparing their structural hashes, so the
+/// cost follows the size of the difference. Spans and doc comments are
+/// ignored.
+///
+/// # Safety
+/// - `old` and `new` must be valid pointers to `StyxDocument`s, or null.
+/// - The returned list (null if either document is null) must be freed with
+///   `styx_changes_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_document_diff(
+    old: *const StyxDocument,
+    new: *const StyxDocument,
+) -> *mut StyxChanges {
+    if old.is_null() || new.is_null() {
+        return ptr::null_mut();
+    }
+    let (old, new) = unsafe { (&*old, &*new) };
+    let boxed = Box::new(StyxChanges {
+        inner: old.inner.diff(&new.inner),
+    });
+    Box::into_raw(boxed)
+}
+
+/// Get the number of changes in a list.
+///
+/// # Safety
+/// - `changes` must be a valid pointer to a `StyxChanges`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_changes_len(changes: *const StyxChanges) -> usize {
+    if changes.is_null() {
+        return 0;
+    }
+    unsafe { &*changes }.inner.len()
+}
+
+/// Get the change at `index`.
+///
+/// Returns a change with a null `path` if `changes` is null or `index` is out
+/// of range.
+///
+/// # Safety
+/// - `changes` must be a valid pointer to a `StyxChanges`, or null.
+/// - The path view is valid as long as `changes` is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_changes_get(changes: *const StyxChanges, index: usize) -> StyxChange {
+    let change = (!changes.is_null())
+        .then(|| unsafe { &*changes }.inner.get(index))
+        .flatten();
+    match change {
+        Some(change) => StyxChange {
+            kind: change.kind.into(),
+            path: StyxStr::borrow(&change.path),
+        },
+        None => StyxChange {
+            kind: StyxChangeKind::Changed,
+            path: StyxStr::NULL,
+        },
+    }
+}
+
+/// Free a list of changes.
+///
+/// # Safety
+/// - `changes` must be a pointer returned by `styx_document_diff` or through
+///   `styx_document_reparse`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_changes_free(changes: *mut StyxChanges) {
+    if !changes.is_null() {
+        drop(unsafe { Box::from_raw(changes) });
+    }
+}
+
+// =============================================================================
+// Snapshots
+// =============================================================================
+
+/// Create an empty snapshot cell.
+///
+/// A cell holds the current version of a document for many reader threads:
+/// readers take a reference with `styx_snapshot_acquire`, a writer replaces
+/// the version with `styx_snapshot_publish`, and each version is freed when
+/// its last reference is released.
+///
+/// The returned cell must be freed with `styx_snapshot_cell_free`.
+#[unsafe(no_mangle)]
+pub extern "C" fn styx_snapshot_cell_new() -> *mut StyxSnapshotCell {
+    Box::into_raw(Box::new(StyxSnapshotCell {
+        current: AtomicPtr::new(ptr::null_mut()),
+        readers: [AtomicUsize::new(0), AtomicUsize::new(0)],
+        epoch: AtomicUsize::new(0),
+        publish: Mutex::new(()),
+    }))
+}
+
+/// Make `doc` the current version of `cell`, taking ownership of it.
+///
+/// Key indexes are built before the document is published, so readers never
+/// pay for them; objects of a `styx_parse_lazy` document that have not been
+/// read yet stay unparsed and index themselves on first read. Readers that acquired the previous version keep it until they
+/// release it. Passing a null `doc` empties the cell. Waits only for readers
+/// that are in the middle of `styx_snapshot_acquire`, never for snapshots
+/// held by readers.
+///
+/// # Safety
+/// - `cell` must be a valid pointer returned by `styx_snapshot_cell_new`.
+/// - `doc` must be a pointer returned by a parse function, or null. It must
+///   not be used or freed afterwards.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_publish(
+    cell: *const StyxSnapshotCell,
+    doc: *mut StyxDocument,
+) {
+    if cell.is_null() {
+        if !doc.is_null() {
+            drop(unsafe { Box::from_raw(doc) });
+        }
+        return;
+    }
+    let cell = unsafe { &*cell };
+    let next = if doc.is_null() {
+        ptr::null_mut()
+    } else {
+        let document = *unsafe { Box::from_raw(doc) };
+        document.inner.build_indexes();
+        Arc::into_raw(Arc::new(StyxSnapshot { document })) as *mut StyxSnapshot
+    };
+
+    let _guard = cell.publish.lock().unwrap_or_else(PoisonError::into_inner);
+    let old = cell.current.swap(next, Ordering::SeqCst);
+    // A reader that loaded `old` registered in one of the counters before the
+    // swap, so once each counter has been seen at zero it holds its own
+    // reference. Flipping the epoch first moves new readers to the other
+    // counter, so the one being waited on drains.
+    for _ in 0..2 {
+        let parity = cell.epoch.fetch_add(1, Ordering::SeqCst) & 1;
+        while cell.readers[parity].load(Ordering::SeqCst) != 0 {
+            std::hint::spin_loop();
+        }
+    }
+    if !old.is_null() {
+        unsafe { Arc::decrement_strong_count(old) };
+    }
+}
+
+/// Take a reference to the current version of `cell`.
+///
+/// Lock-free: a few atomic operations, safe to call from any number of
+/// threads concurrently with each other and with `styx_snapshot_publish`.
+///
+/// # Safety
+/// - `cell` must be a valid pointer returned by `styx_snapshot_cell_new`.
+/// - The returned snapshot, if not null, must be released with
+///   `styx_snapshot_release`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_acquire(
+    cell: *const StyxSnapshotCell,
+) -> *const StyxSnapshot {
+    if cell.is_null() {
+        return ptr::null();
+    }
+    let cell = unsafe { &*cell };
+    let readers = &cell.readers[cell.epoch.load(Ordering::SeqCst) & 1];
+    readers.fetch_add(1, Ordering::SeqCst);
+    let current = cell.current.load(Ordering::SeqCst);
+    if !current.is_null() {
+        unsafe { Arc::increment_strong_count(current) };
+    }
+    readers.fetch_sub(1, Ordering::SeqCst);
+    current
+}
+
+/// Take another reference to an acquired snapshot, e.g. to hand it to
+/// another thread. Returns `snapshot`.
+///
+/// # Safety
+/// - `snapshot` must be a snapshot that has not been released, or null.
+/// - Each reference must be released with `styx_snapshot_release`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_retain(
+    snapshot: *const StyxSnapshot,
+) -> *const StyxSnapshot {
+    if !snapshot.is_null() {
+        unsafe { Arc::increment_strong_count(snapshot) };
+    }
+    snapshot
+}
+
+/// Release a reference to a snapshot. The version is freed when its last
+/// reference is released and it is no longer current.
+///
+/// # Safety
+/// - `snapshot` must be a snapshot that has not been released, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_release(snapshot: *const StyxSnapshot) {
+    if !snapshot.is_null() {
+        unsafe { Arc::decrement_strong_count(snapshot) };
+    }
+}
+
+/// Get a snapshot's document.
+///
+/// The document is immutable and may be read from any number of threads at
+/// once with the borrowed accessors. It must not be passed to functions that
+/// modify or free it.
+///
+/// # Safety
+/// - `snapshot` must be a snapshot that has not been released, or null.
+/// - The returned pointer is valid until the snapshot is released.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_document(
+    snapshot: *const StyxSnapshot,
+) -> *const StyxDocument {
+    if snapshot.is_null() {
+        return ptr::null();
+    }
+    unsafe { &(*snapshot).document }
+}
+
+/// Free a snapshot cell, releasing its reference to the current version.
+///
+/// Snapshots acquired from it stay valid until released.
+///
+/// # Safety
+/// - `cell` must be a pointer returned by `styx_snapshot_cell_new`, or null.
+/// - No other thread may be using the cell.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_snapshot_cell_free(cell: *mut StyxSnapshotCell) {
+    if cell.is_null() {
+        return;
+    }
+    let cell = unsafe { Box::from_raw(cell) };
+    let current = cell.current.into_inner();
+    if !current.is_null() {
+        unsafe { Arc::decrement_strong_count(current) };
+    }
+}
+
+// =============================================================================
+// Compiled paths
+// =============================================================================
+
+/// Compile a path for repeated lookups.
+///
+/// Returns null if `path` is null or not valid UTF-8.
+///
+/// # Safety
+/// - `path` must be a valid null-terminated string, or null.
+/// - The returned path must be freed with `styx_path_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_path_compile(path: *const c_char) -> *mut StyxPath {
+    if path.is_null() {
+        return ptr::null_mut();
+    }
+    let path = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return ptr::null_mut(),
+    };
+    Box::into_raw(Box::new(StyxPath {
+        inner: Path::compile(path),
+    }))
+}
+
+/// Free a compiled path.
+///
+/// # Safety
+/// - `path` must be a pointer returned by `styx_path_compile`, or null.
+/// - `path` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_path_free(path: *mut StyxPath) {
+    if !path.is_null() {
+        drop(unsafe { Box::from_raw(path) });
+    }
+}
+
+/// Resolve a compiled path against a document.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+/// - `path` must be a valid pointer to a `StyxPath`, or null.
+/// - The returned pointer is valid as long as `doc` is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_path_eval(
+    doc: *const StyxDocument,
+    path: *const StyxPath,
+) -> *const StyxValue {
+    if doc.is_null() || path.is_null() {
+        return ptr::null();
+    }
+    let doc = unsafe { &*doc };
+    let path = unsafe { &*path };
+    match path.inner.eval_document(&doc.inner) {
+        Some(value) => value as *const Value as *const StyxValue,
+        None => ptr::null(),
+    }
+}
+
+/// Resolve a compiled path starting at a value.
+///
+/// # Safety
+/// - `value` must be a valid pointer to a `StyxValue`, or null.
+/// - `path` must be a valid pointer to a `StyxPath`, or null.
+/// - The returned pointer is valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_path_eval_value(
+    value: *const StyxValue,
+    path: *const StyxPath,
+) -> *const StyxValue {
+    if value.is_null() || path.is_null() {
+        return ptr::null();
+    }
+    let value = unsafe { &*(value as *const Value) };
+    let path = unsafe { &*path };
+    match path.inner.eval(value) {
+        Some(v) => v as *const Value as *const StyxValue,
+        None => ptr::null(),
+    }
+}
+
+/// Resolve `count` compiled paths against a document in one call.
+///
+/// `out[i]` receives the value for `paths[i]`, or null if it was not found
+/// (or `paths[i]` is null). Returns the number of paths that were found.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+/// - `paths` must point to `count` `StyxPath` pointers (each may be null).
+/// - `out` must point to writable space for `count` value pointers.
+/// - The pointers written to `out` are valid as long as `doc` is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_path_eval_batch(
+    doc: *const StyxDocument,
+    paths: *const *const StyxPath,
+    count: usize,
+    out: *mut *const StyxValue,
+) -> usize {
+    if count == 0 || paths.is_null() || out.is_null() {
+        return 0;
+    }
+    let paths = unsafe { std::slice::from_raw_parts(paths, count) };
+    let out = unsafe { std::slice::from_raw_parts_mut(out, count) };
+    if doc.is_null() {
+        out.fill(ptr::null());
+        return 0;
+    }
+    let doc = unsafe { &*doc };
+    let mut found = 0;
+    for (path, slot) in paths.iter().zip(out.iter_mut()) {
+        let value = if path.is_null() {
+            None
+        } else {
+            unsafe { &**path }.inner.eval_document(&doc.inner)
+        };
+        *slot = match value {
+            Some(value) => {
+                found += 1;
+                value as *const Value as *const StyxValue
+            }
+            None => ptr::null(),
+        };
+    }
+    found
+}
+
+// =============================================================================
+// Selectors
+// =============================================================================
+
+/// Compile a selector such as `hosts[*].port` or `..[@tag=env]`.
+///
+/// On success `*selector` receives the compiled selector and null is
+/// returned. On failure `*selector` is set to null and an error message,
+/// including the byte offset of the problem, is returned.
+///
+/// # Safety
+/// - `text` must be a valid null-terminated string, or null.
+/// - `selector` must be valid for writes, or null.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+/// - `*selector`, if set, must be freed with `styx_selector_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_selector_compile(
+    text: *const c_char,
+    selector: *mut *mut StyxSelector,
+) -> *mut c_char {
+    if selector.is_null() {
+        return error_string("selector is null");
+    }
+    unsafe { *selector = ptr::null_mut() };
+    if text.is_null() {
+        return error_string("text is null");
+    }
+    let text = match unsafe { CStr::from_ptr(text) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return error_string("invalid UTF-8"),
+    };
+    match Selector::compile(text) {
+        Ok(compiled) => {
+            let boxed = Box::new(StyxSelector { inner: compiled });
+            unsafe { *selector = Box::into_raw(boxed) };
+            ptr::null_mut()
+        }
+        Err(e) => error_string(&e.to_string()),
+    }
+}
+
+/// Free a compiled selector.
+///
+/// # Safety
+/// - `selector` must be a pointer returned through `styx_selector_compile`, or null.
+/// - `selector` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_selector_free(selector: *mut StyxSelector) {
+    if !selector.is_null() {
+        drop(unsafe { Box::from_raw(selector) });
+    }
+}
+
+/// Select every value in a document that matches a selector, in document
+/// order. The root object itself is never a match.
+///
+/// Returns null if either argument is null.
+///
+/// # Safety
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+/// - `selector` must be a valid pointer to a `StyxSelector`, or null.
+/// - The values in the selection are valid as long as `doc` is valid.
+/// - The returned selection must be freed with `styx_selection_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_select(
+    doc: *const StyxDocument,
+    selector: *const StyxSelector,
+) -> *mut StyxSelection {
+    if doc.is_null() || selector.is_null() {
+        return ptr::null_mut();
+    }
+    let doc = unsafe { &*doc };
+    let selector = unsafe { &*selector };
+    let values = selector
+        .inner
+        .select(&doc.inner)
+        .into_iter()
+        .map(|value| value as *const Value)
+        .collect();
+    Box::into_raw(Box::new(StyxSelection {
+        values,
+        owned: Vec::new(),
+    }))
+}
+
+/// Select matching values while parsing, without building the document.
+///
+/// Only the matched subtrees are built; the rest of the source is skipped
+/// event by event. On success `*selection` receives the matches and null is
+/// returned. On failure `*selection` is set to null and the parse error is
+/// returned.
+///
+/// # Safety
+/// - `selector` must be a valid pointer to a `StyxSelector`, or null.
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - `selection` must be valid for writes, or null.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+/// - `*selection`, if set, must be freed with `styx_selection_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_select_source(
+    selector: *const StyxSelector,
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    selection: *mut *mut StyxSelection,
+) -> *mut c_char {
+    if selection.is_null() {
+        return error_string("selection is null");
+    }
+    unsafe { *selection = ptr::null_mut() };
+    if selector.is_null() {
+        return error_string("selector is null");
+    }
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_string(message),
+    };
+    match unsafe { &*selector }.inner.select_source(source) {
+        Ok(values) => {
+            unsafe { *selection = owned_selection(values) };
+            ptr::null_mut()
+        }
+        Err(e) => error_string(&format_error(&e)),
+    }
+}
+
+/// Select matching values from the rest of an event reader's stream.
+///
+/// The reader is drained: later `styx_reader_next` calls return false.
+/// Selector steps start at the document root, so this must be called before
+/// any `styx_reader_next` (or earlier `styx_reader_select`) call; otherwise
+/// it fails without consuming anything. Results and errors are reported as
+/// for `styx_select_source`.
+///
+/// # Safety
+/// - `reader` must be a valid pointer to a `StyxEventReader`, or null.
+/// - `selector` must be a valid pointer to a `StyxSelector`, or null.
+/// - `selection` must be valid for writes, or null.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+/// - `*selection`, if set, must be freed with `styx_selection_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_reader_select(
+    reader: *mut StyxEventReader,
+    selector: *const StyxSelector,
+    selection: *mut *mut StyxSelection,
+) -> *mut c_char {
+    if selection.is_null() {
+        return error_string("selection is null");
+    }
+    unsafe { *selection = ptr::null_mut() };
+    if reader.is_null() || selector.is_null() {
+        return error_string("reader or selector is null");
+    }
+    let reader = unsafe { &mut *reader };
+    // Mid-stream, the next object would be taken for the root.
+    if std::mem::replace(&mut reader.started, true) {
+        return error_string("reader is past the start of the document");
+    }
+    let mut events = EventSelector::new(&unsafe { &*selector }.inner);
+    reader.current = None;
+    while let Some(event) = reader.parser.next_event() {
+        events.event(&event);
+    }
+    match events.finish() {
+        Ok(values) => {
+            unsafe { *selection = owned_selection(values) };
+            ptr::null_mut()
+        }
+        Err(e) => error_string(&format_error(&e)),
+    }
+}
+
+fn owned_selection(owned: Vec<Value>) -> *mut StyxSelection {
+    let values = owned.iter().map(|value| value as *const Value).collect();
+    Box::into_raw(Box::new(StyxSelection { values, owned }))
+}
+
+/// Get the number of values in a selection.
+///
+/// # Safety
+/// - `selection` must be a valid pointer to a `StyxSelection`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_selection_len(selection: *const StyxSelection) -> usize {
+    if selection.is_null() {
+        return 0;
+    }
+    unsafe { &*selection }.values.len()
+}
+
+/// Get the value at `index` in a selection.
+///
+/// Returns null if `selection` is null or `index` is out of range.
+///
+/// # Safety
+/// - `selection` must be a valid pointer to a `StyxSelection`, or null.
+/// - The returned pointer is valid as long as `selection` is valid (and,
+///   for `styx_select`, its document).
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_selection_get(
+    selection: *const StyxSelection,
+    index: usize,
+) -> *const StyxValue {
+    if selection.is_null() {
+        return ptr::null();
+    }
+    match unsafe { &*selection }.values.get(index) {
+        Some(&value) => value as *const StyxValue,
+        None => ptr::null(),
+    }
+}
+
+/// Free a selection.
+///
+/// # Safety
+/// - `selection` must be a pointer returned by `styx_select` or through
+///   `styx_select_source` or `styx_reader_select`, or null.
+/// - `selection` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_selection_free(selection: *mut StyxSelection) {
+    if !selection.is_null() {
+        drop(unsafe { Box::from_raw(selection) });
+    }
+}
+
+// =============================================================================
+// Schemas
+// =============================================================================
+
+/// Compile a schema file for repeated validation.
+///
+/// On success `*schema` receives the compiled schema and null is returned.
+/// On failure `*schema` is set to null and an error message is returned.
+///
+/// # Safety
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - `schema` must be valid for writes, or null.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+/// - `*schema`, if set, must be freed with `styx_schema_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_schema_compile(
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+    schema: *mut *mut StyxSchema,
+) -> *mut c_char {
+    if schema.is_null() {
+        return error_string("schema is null");
+    }
+    unsafe { *schema = ptr::null_mut() };
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_string(message),
+    };
+    match CompiledSchema::parse(source) {
+        Ok(compiled) => {
+            let boxed = Box::new(StyxSchema { inner: compiled });
+            unsafe { *schema = Box::into_raw(boxed) };
+            ptr::null_mut()
+        }
+        Err(e) => error_string(&e.to_string()),
+    }
+}
+
+/// Free a compiled schema.
+///
+/// # Safety
+/// - `schema` must be a pointer returned through `styx_schema_compile`, or null.
+/// - `schema` must not be used after this call.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_schema_free(schema: *mut StyxSchema) {
+    if !schema.is_null() {
+        drop(unsafe { Box::from_raw(schema) });
+    }
+}
+
+/// Validate a document against a compiled schema's root type.
+///
+/// Returns whether the document is valid. If `violations` is not null it
+/// receives the list of violations (null when the document is valid);
+/// otherwise validation stops at the first violation.
+///
+/// # Safety
+/// - `schema` must be a valid pointer to a `StyxSchema`, or null.
+/// - `doc` must be a valid pointer to a `StyxDocument`, or null.
+/// - `violations` must be null or valid for writes.
+/// - `*violations`, if set, must be freed with `styx_violations_free`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_schema_validate(
+    schema: *const StyxSchema,
+    doc: *const StyxDocument,
+    violations: *mut *mut StyxViolations,
+) -> bool {
+    if !violations.is_null() {
+        unsafe { *violations = ptr::null_mut() };
+    }
+    if schema.is_null() || doc.is_null() {
+        return false;
+    }
+    let (schema, doc) = unsafe { (&*schema, &*doc) };
+    if violations.is_null() {
+        return schema.inner.is_valid(&doc.inner);
+    }
+    match schema.inner.validate(&doc.inner) {
+        Ok(()) => true,
+        Err(list) => {
+            let boxed = Box::new(StyxViolations { inner: list });
+            unsafe { *violations = Box::into_raw(boxed) };
+            false
+        }
+    }
+}
+
+/// Parse a document and check it against a compiled schema in one pass,
+/// without building a tree.
+///
+/// Returns null if the source parses and is valid; otherwise the first
+/// parse error or violation (as `path: message`), reported as soon as it
+/// is reached.
+///
+/// # Safety
+/// - `schema` must be a valid pointer to a `StyxSchema`, or null.
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - The returned string, if not null, must be freed with `styx_free_string`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_schema_check(
+    schema: *const StyxSchema,
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> *mut c_char {
+    if schema.is_null() {
+        return error_string("schema is null");
+    }
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_string(message),
+    };
+    match unsafe { &*schema }.inner.check_source(source) {
+        Ok(()) => ptr::null_mut(),
+        Err(e) => error_string(&validate_message(&e)),
+    }
+}
+
+/// Parse a document, keeping it only if it is valid against a compiled
+/// schema.
+///
+/// Validation runs while the document is parsed and abandons it at the
+/// first violation; the error is then the violation, as `path: message`.
+///
+/// # Safety
+/// - `schema` must be a valid pointer to a `StyxSchema`, or null.
+/// - `source`, `len` and `flags` are as for `styx_parse_n`.
+/// - The returned `StyxParseResult` must be freed as for `styx_parse`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_schema_parse(
+    schema: *const StyxSchema,
+    source: *const c_char,
+    len: usize,
+    flags: u32,
+) -> StyxParseResult {
+    if schema.is_null() {
+        return error_result("schema is null");
+    }
+    let source = match unsafe { source_str(source, len, flags) } {
+        Ok(source) => source,
+        Err(message) => return error_result(message),
+    };
+    match unsafe { &*schema }.inner.parse_validated(source) {
+        Ok(doc) => document_result(doc),
+        Err(e) => error_result(&validate_message(&e)),
+    }
+}
+
+fn validate_message(e: &ValidateError) -> String {
+    match e {
+        ValidateError::Parse(e) => format_error(e),
+        ValidateError::Schema(v) => v.to_string(),
+    }
+}
+
+/// Get the number of violations in a list.
+///
+/// # Safety
+/// - `violations` must be a valid pointer to a `StyxViolations`, or null.
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn styx_free_string(s: *mut c_char) {
-    if !s.is_null() {
-        drop(unsafe { CString::from_raw(s) });
+pub unsafe extern "C" fn styx_violations_len(violations: *const StyxViolations) -> usize {
+    if violations.is_null() {
+        return 0;
     }
+    unsafe { &*violations }.inner.len()
 }
 
-// =============================================================================
-// Document access
-// =============================================================================
-
-/// Get the root object of a document.
+/// Get the violation at `index`.
+///
+/// Returns a violation with null `path` and `message` if `violations` is
+/// null or `index` is out of range.
 ///
 /// # Safety
-/// - `doc` must be a valid pointer to a `StyxDocument`.
-/// - The returned pointer is valid as long as `doc` is valid.
+/// - `violations` must be a valid pointer to a `StyxViolations`, or null.
+/// - The string views are valid as long as `violations` is valid.
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn styx_document_root(doc: *const StyxDocument) -> *const StyxObject {
-    if doc.is_null() {
-        return ptr::null();
+pub unsafe extern "C" fn styx_violations_get(
+    violations: *const StyxViolations,
+    index: usize,
+) -> StyxViolation {
+    let violation = (!violations.is_null())
+        .then(|| unsafe { &*violations }.inner.get(index))
+        .flatten();
+    match violation {
+        Some(v) => StyxViolation {
+            path: StyxStr::borrow(&v.path),
+            message: StyxStr::borrow(&v.message),
+            span_start: v.span.map_or(0, |s| s.start),
+            span_end: v.span.map_or(0, |s| s.end),
+        },
+        None => StyxViolation {
+            path: StyxStr::NULL,
+            message: StyxStr::NULL,
+            span_start: 0,
+            span_end: 0,
+        },
     }
-    let doc = unsafe { &*doc };
-    &doc.inner.root as *const Object as *const StyxObject
 }
 
-/// Get a value by path from a document.
+/// Free a list of violations.
 ///
 /// # Safety
-/// - `doc` must be a valid pointer to a `StyxDocument`.
-/// - `path` must be a valid null-terminated UTF-8 string.
-/// - The returned pointer is valid as long as `doc` is valid.
+/// - `violations` must be a pointer returned through `styx_schema_validate`,
+///   or null.
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn styx_document_get(
-    doc: *const StyxDocument,
-    path: *const c_char,
-) -> *const StyxValue {
-    if doc.is_null() || path.is_null() {
-        return ptr::null();
-    }
-    let doc = unsafe { &*doc };
-    let path = match unsafe { CStr::from_ptr(path) }.to_str() {
-        Ok(s) => s,
-        Err(_) => return ptr::null(),
-    };
-    match doc.inner.get(path) {
-        Some(value) => value as *const Value as *const StyxValue,
-        None => ptr::null(),
+pub unsafe extern "C" fn styx_violations_free(violations: *mut StyxViolations) {
+    if !violations.is_null() {
+        drop(unsafe { Box::from_raw(violations) });
     }
 }
 
@@ -256,6 +3180,192 @@ pub unsafe extern "C" fn styx_value_scalar(value: *const StyxValue) -> *mut c_ch
     }
 }
 
+/// Get the tag name of a value without allocating.
+///
+/// # Safety
+/// - `value` must be a valid pointer to a `StyxValue`.
+/// - The returned view is valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_tag_view(value: *const StyxValue) -> StyxStr {
+    if value.is_null() {
+        return StyxStr::NULL;
+    }
+    let value = unsafe { &*(value as *const Value) };
+    value
+        .tag_name()
+        .map(StyxStr::borrow)
+        .unwrap_or(StyxStr::NULL)
+}
+
+/// Get the scalar text of a value without allocating.
+///
+/// # Safety
+/// - `value` must be a valid pointer to a `StyxValue`.
+/// - The returned view is valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_scalar_view(value: *const StyxValue) -> StyxStr {
+    if value.is_null() {
+        return StyxStr::NULL;
+    }
+    let value = unsafe { &*(value as *const Value) };
+    value
+        .scalar_text()
+        .map(StyxStr::borrow)
+        .unwrap_or(StyxStr::NULL)
+}
+
+/// Parse a value's scalar text as a signed decimal integer, without
+/// allocating.
+///
+/// Accepts an optional `+` or `-` sign followed by ASCII digits, as Rust's
+/// `str::parse` does. On success the result is written to `out`; otherwise
+/// `out` is left unchanged.
+///
+/// # Safety
+/// - `value` must be a valid pointer to a `StyxValue`, or null.
+/// - `out` must be valid for writes, or null to only check the value.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_as_i64(
+    value: *const StyxValue,
+    out: *mut i64,
+) -> StyxScalarStatus {
+    unsafe { read_scalar(value, out, |text| text.parse().map_err(int_status)) }
+}
+
+/// Parse a value's scalar text as an unsigned decimal integer, without
+/// allocating.
+///
+/// As `styx_value_as_i64`; negative numbers are out of range.
+///
+/// # Safety
+/// Same requirements as `styx_value_as_i64`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_as_u64(
+    value: *const StyxValue,
+    out: *mut u64,
+) -> StyxScalarStatus {
+    unsafe {
+        read_scalar(value, out, |text| match text.strip_prefix('-') {
+            // Only the sign stands in the way: "-0" is zero, anything else is
+            // below the range.
+            Some(digits) if !digits.starts_with(['+', '-']) => match digits.parse::<u64>() {
+                Ok(0) => Ok(0),
+                Ok(_) => Err(StyxScalarStatus::OutOfRange),
+                Err(e) => Err(int_status(e)),
+            },
+            _ => text.parse().map_err(int_status),
+        })
+    }
+}
+
+/// Parse a value's scalar text as a floating-point number, without
+/// allocating.
+///
+/// Accepts decimal and exponent forms with an optional sign, as well as `inf`,
+/// `infinity` and `nan` (in any case). Finite numbers too large for a double
+/// are out of range; numbers too small round to zero.
+///
+/// # Safety
+/// Same requirements as `styx_value_as_i64`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_as_f64(
+    value: *const StyxValue,
+    out: *mut f64,
+) -> StyxScalarStatus {
+    unsafe { read_scalar(value, out, parse_f64) }
+}
+
+/// Parse scalar text, such as an event's `text`, as a floating-point number.
+///
+/// Accepts the same spellings as `styx_value_as_f64`, and unlike `strtod`
+/// does not depend on the C locale. A null `text.ptr` is `NotScalar`.
+///
+/// # Safety
+/// - `text` must be null or point to `text.len` readable bytes.
+/// - `out` must be valid for writes, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_str_as_f64(text: StyxStr, out: *mut f64) -> StyxScalarStatus {
+    if text.ptr.is_null() {
+        return StyxScalarStatus::NotScalar;
+    }
+    let bytes = unsafe { std::slice::from_raw_parts(text.ptr as *const u8, text.len) };
+    let Ok(text) = std::str::from_utf8(bytes) else {
+        return StyxScalarStatus::Invalid;
+    };
+    match parse_f64(text) {
+        Ok(number) => {
+            if !out.is_null() {
+                unsafe { out.write(number) };
+            }
+            StyxScalarStatus::Ok
+        }
+        Err(status) => status,
+    }
+}
+
+fn parse_f64(text: &str) -> Result<f64, StyxScalarStatus> {
+    let number: f64 = text.parse().map_err(|_| StyxScalarStatus::Invalid)?;
+    // Finite spellings never contain an `i`.
+    if number.is_infinite() && !text.bytes().any(|b| b.eq_ignore_ascii_case(&b'i')) {
+        return Err(StyxScalarStatus::OutOfRange);
+    }
+    Ok(number)
+}
+
+/// Parse a value's scalar text as `true` or `false`.
+///
+/// # Safety
+/// Same requirements as `styx_value_as_i64`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_value_as_bool(
+    value: *const StyxValue,
+    out: *mut bool,
+) -> StyxScalarStatus {
+    unsafe {
+        read_scalar(value, out, |text| match text {
+            "true" => Ok(true),
+            "false" => Ok(false),
+            _ => Err(StyxScalarStatus::Invalid),
+        })
+    }
+}
+
+/// Parse a value's scalar text with `parse` and store the result in `out`.
+///
+/// # Safety
+/// As for `styx_value_as_i64`.
+unsafe fn read_scalar<T>(
+    value: *const StyxValue,
+    out: *mut T,
+    parse: impl FnOnce(&str) -> Result<T, StyxScalarStatus>,
+) -> StyxScalarStatus {
+    if value.is_null() {
+        return StyxScalarStatus::NotScalar;
+    }
+    let value = unsafe { &*(value as *const Value) };
+    let Some(text) = value.scalar_text() else {
+        return StyxScalarStatus::NotScalar;
+    };
+    match parse(text) {
+        Ok(parsed) => {
+            if !out.is_null() {
+                unsafe { out.write(parsed) };
+            }
+            StyxScalarStatus::Ok
+        }
+        Err(status) => status,
+    }
+}
+
+fn int_status(error: std::num::ParseIntError) -> StyxScalarStatus {
+    match error.kind() {
+        std::num::IntErrorKind::PosOverflow | std::num::IntErrorKind::NegOverflow => {
+            StyxScalarStatus::OutOfRange
+        }
+        _ => StyxScalarStatus::Invalid,
+    }
+}
+
 /// Get the object payload of a value (null if not an object).
 ///
 /// # Safety
@@ -332,8 +3442,30 @@ pub unsafe extern "C" fn styx_object_len(obj: *const StyxObject) -> usize {
     obj.len()
 }
 
+/// Get the error that stopped an object from `styx_parse_lazy` from parsing.
+///
+/// Parses the object first if it has not been read yet. Returns null if the
+/// object parsed (or was never lazy); otherwise the caller must free the
+/// returned string with `styx_free_string()`.
+///
+/// # Safety
+/// - `obj` must be a valid pointer to a `StyxObject`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_object_error(obj: *const StyxObject) -> *mut c_char {
+    if obj.is_null() {
+        return ptr::null_mut();
+    }
+    let obj = unsafe { &*(obj as *const Object) };
+    match obj.try_entries() {
+        Ok(_) => ptr::null_mut(),
+        Err(e) => error_string(&format_error(e)),
+    }
+}
+
 /// Get a value from an object by key.
 ///
+/// Wide objects answer this from a hashed key index (built on first use).
+///
 /// # Safety
 /// - `obj` must be a valid pointer to a `StyxObject`.
 /// - `key` must be a valid null-terminated UTF-8 string.
@@ -357,6 +3489,19 @@ pub unsafe extern "C" fn styx_object_get(
     }
 }
 
+/// Build the key index of an object now, regardless of its size.
+///
+/// # Safety
+/// - `obj` must be a valid pointer to a `StyxObject`, or null.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_object_build_index(obj: *const StyxObject) {
+    if obj.is_null() {
+        return;
+    }
+    let obj = unsafe { &*(obj as *const Object) };
+    obj.build_index();
+}
+
 /// Get the key at a given index in an object.
 ///
 /// # Safety
@@ -372,12 +3517,33 @@ pub unsafe extern "C" fn styx_object_key_at(
         return ptr::null();
     }
     let obj = unsafe { &*(obj as *const Object) };
-    match obj.entries.get(index) {
+    match obj.entries().get(index) {
         Some(entry) => &entry.key as *const Value as *const StyxValue,
         None => ptr::null(),
     }
 }
 
+/// Get the scalar text of the key at a given index in an object, without allocating.
+///
+/// The view is null if the index is out of bounds or the key has no scalar
+/// text (unit or tag-only keys); use `styx_object_key_at` to inspect those.
+///
+/// # Safety
+/// - `obj` must be a valid pointer to a `StyxObject`.
+/// - The returned view is valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_object_key_view_at(obj: *const StyxObject, index: usize) -> StyxStr {
+    if obj.is_null() {
+        return StyxStr::NULL;
+    }
+    let obj = unsafe { &*(obj as *const Object) };
+    obj.entries()
+        .get(index)
+        .and_then(|entry| entry.key.scalar_text())
+        .map(StyxStr::borrow)
+        .unwrap_or(StyxStr::NULL)
+}
+
 /// Get the value at a given index in an object.
 ///
 /// # Safety
@@ -393,12 +3559,49 @@ pub unsafe extern "C" fn styx_object_value_at(
         return ptr::null();
     }
     let obj = unsafe { &*(obj as *const Object) };
-    match obj.entries.get(index) {
+    match obj.entries().get(index) {
         Some(entry) => &entry.value as *const Value as *const StyxValue,
         None => ptr::null(),
     }
 }
 
+/// Copy up to `cap` entries of an object into `out` in one call.
+///
+/// Each entry's key is a borrowed view (null for unit or tag-only keys, as
+/// with `styx_object_key_view_at`). Returns the total number of entries, which
+/// may exceed `cap`; call with `cap == 0` to size the buffer.
+///
+/// # Safety
+/// - `obj` must be a valid pointer to a `StyxObject`, or null.
+/// - `out` must point to space for at least `cap` entries (it may be null if `cap` is 0).
+/// - The returned views are valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_object_entries(
+    obj: *const StyxObject,
+    out: *mut StyxEntryView,
+    cap: usize,
+) -> usize {
+    if obj.is_null() {
+        return 0;
+    }
+    let obj = unsafe { &*(obj as *const Object) };
+    let count = obj.entries().len().min(cap);
+    if count > 0 {
+        let out = unsafe { std::slice::from_raw_parts_mut(out, count) };
+        for (slot, entry) in out.iter_mut().zip(obj.entries()) {
+            *slot = StyxEntryView {
+                key: entry
+                    .key
+                    .scalar_text()
+                    .map(StyxStr::borrow)
+                    .unwrap_or(StyxStr::NULL),
+                value: &entry.value as *const Value as *const StyxValue,
+            };
+        }
+    }
+    obj.entries().len()
+}
+
 // =============================================================================
 // Sequence access
 // =============================================================================
@@ -436,3 +3639,582 @@ pub unsafe extern "C" fn styx_sequence_get(
         None => ptr::null(),
     }
 }
+
+/// Copy pointers to up to `cap` items of a sequence into `out` in one call.
+///
+/// Returns the total number of items, which may exceed `cap`; call with
+/// `cap == 0` to size the buffer.
+///
+/// # Safety
+/// - `seq` must be a valid pointer to a `StyxSequence`, or null.
+/// - `out` must point to space for at least `cap` pointers (it may be null if `cap` is 0).
+/// - The returned pointers are valid as long as the parent document is valid.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn styx_sequence_items(
+    seq: *const StyxSequence,
+    out: *mut *const StyxValue,
+    cap: usize,
+) -> usize {
+    if seq.is_null() {
+        return 0;
+    }
+    let seq = unsafe { &*(seq as *const Sequence) };
+    let count = seq.items.len().min(cap);
+    if count > 0 {
+        let out = unsafe { std::slice::from_raw_parts_mut(out, count) };
+        for (slot, item) in out.iter_mut().zip(&seq.items) {
+            *slot = item as *const Value as *const StyxValue;
+        }
+    }
+    seq.items.len()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    unsafe extern "C" {
+        fn free(ptr: *mut c_void);
+    }
+
+    /// Write `value` as the entry `x`, parse the output and read it back.
+    fn float_round_trip(value: f64) -> (String, f64) {
+        unsafe {
+            let mut out = StyxBuffer {
+                data: ptr::null_mut(),
+                len: 0,
+                capacity: 0,
+            };
+            let writer = styx_writer_new_buffer(&mut out, 0);
+            assert!(styx_writer_key(writer, c"x".as_ptr(), 1));
+            assert!(styx_writer_float(writer, value), "writing {value:?}");
+            assert!(styx_writer_finish(writer));
+            styx_writer_free(writer);
+            let text =
+                std::str::from_utf8(std::slice::from_raw_parts(out.data as *const u8, out.len))
+                    .unwrap()
+                    .to_owned();
+            let result = styx_parse_n(out.data, out.len, 0);
+            assert!(result.error.is_null(), "parsing {text:?}");
+            let mut back = f64::NAN;
+            let status =
+                styx_value_as_f64(styx_document_get(result.document, c"x".as_ptr()), &mut back);
+            assert_eq!(status, StyxScalarStatus::Ok, "reading {text:?}");
+            styx_free_document(result.document);
+            free(out.data as *mut c_void);
+            (text, back)
+        }
+    }
+
+    #[test]
+    fn test_writer_float_round_trips() {
+        for value in [
+            0.0,
+            -0.0,
+            0.1,
+            -2.5,
+            1.0,
+            123456789.125,
+            1e300,
+            -1e300,
+            1e-300,
+            f64::MAX,
+            f64::MIN,
+            f64::MIN_POSITIVE,
+            f64::EPSILON,
+            5e-324,
+            -5e-324,
+            2.225_073_858_507_201e-308,
+        ] {
+            let (text, back) = float_round_trip(value);
+            assert_eq!(
+                back.to_bits(),
+                value.to_bits(),
+                "{value:?} came back from {text:?}"
+            );
+            assert!(text.len() < 32, "{value:?} written as {text:?}");
+        }
+        assert_eq!(float_round_trip(1e300).0, "x 1e300\n");
+        assert_eq!(float_round_trip(5e-324).0, "x 5e-324\n");
+    }
+
+    #[test]
+    fn test_reader_select_needs_document_start() {
+        unsafe {
+            let source = "a {x 1}\nb {x 2}";
+            let mut selector = ptr::null_mut();
+            assert!(styx_selector_compile(c"a.x".as_ptr(), &mut selector).is_null());
+            let select = |reader| {
+                let mut selection = ptr::null_mut();
+                let error = styx_reader_select(reader, selector, &mut selection);
+                let len = styx_selection_len(selection);
+                styx_selection_free(selection);
+                if !error.is_null() {
+                    styx_free_string(error);
+                    return None;
+                }
+                Some(len)
+            };
+
+            let reader = styx_reader_new(source.as_ptr().cast(), source.len(), 0);
+            assert_eq!(select(reader), Some(1));
+            // Drained by the first call.
+            assert_eq!(select(reader), None);
+            styx_reader_free(reader);
+
+            // One event in, the first nested object would pass for the root.
+            let reader = styx_reader_new(source.as_ptr().cast(), source.len(), 0);
+            let mut event = std::mem::MaybeUninit::<StyxEvent>::uninit();
+            assert!(styx_reader_next(reader, event.as_mut_ptr()));
+            assert_eq!(select(reader), None);
+            assert!(styx_reader_next(reader, event.as_mut_ptr()));
+            styx_reader_free(reader);
+            styx_selector_free(selector);
+        }
+    }
+
+    #[test]
+    fn test_writer_float_rejects_non_finite() {
+        unsafe {
+            let mut out = StyxBuffer {
+                data: ptr::null_mut(),
+                len: 0,
+                capacity: 0,
+            };
+            for value in [f64::NAN, f64::INFINITY, f64::NEG_INFINITY] {
+                let writer = styx_writer_new_buffer(&mut out, 0);
+                styx_writer_key(writer, c"x".as_ptr(), 1);
+                assert!(!styx_writer_float(writer, value));
+                assert!(!styx_writer_finish(writer));
+                styx_writer_free(writer);
+            }
+            free(out.data as *mut c_void);
+        }
+    }
+
+    #[test]
+    fn test_object_error_reports_deferred_failures() {
+        unsafe {
+            let source = "good {x 1}\nbad {x 1, x 2}\n";
+            let result = styx_parse_lazy(source.as_ptr().cast(), source.len(), 0);
+            assert!(result.error.is_null());
+            let object =
+                |key: &CStr| styx_value_as_object(styx_document_get(result.document, key.as_ptr()));
+
+            assert!(styx_object_error(object(c"good")).is_null());
+            assert_eq!(styx_object_len(object(c"good")), 1);
+
+            let error = styx_object_error(object(c"bad"));
+            assert!(!error.is_null());
+            let message = CStr::from_ptr(error).to_str().unwrap().to_owned();
+            styx_free_string(error);
+            assert!(message.contains("parse error"), "{message}");
+            assert_eq!(styx_object_len(object(c"bad")), 0);
+
+            assert!(styx_object_error(styx_document_root(result.document)).is_null());
+            assert!(styx_object_error(ptr::null()).is_null());
+            styx_free_document(result.document);
+        }
+    }
+
+    /// Run `calls` against a fresh writer and return what it wrote.
+    fn written(flags: u32, calls: impl FnOnce(*mut StyxWriter)) -> String {
+        unsafe {
+            let mut out = StyxBuffer {
+                data: ptr::null_mut(),
+                len: 0,
+                capacity: 0,
+            };
+            let writer = styx_writer_new_buffer(&mut out, flags);
+            calls(writer);
+            let finished = styx_writer_finish(writer);
+            let error = styx_writer_error(writer);
+            assert!(
+                finished,
+                "writer failed: {:?}",
+                (!error.is_null()).then(|| CStr::from_ptr(error))
+            );
+            styx_writer_free(writer);
+            let text =
+                String::from_utf8_lossy(std::slice::from_raw_parts(out.data as *const u8, out.len))
+                    .into_owned();
+            free(out.data as *mut c_void);
+            text
+        }
+    }
+
+    /// Render a value without spans or scalar syntax, so trees that differ
+    /// only in quoting compare equal.
+    fn shape(value: &Value) -> String {
+        let mut out = String::new();
+        if let Some(tag) = &value.tag {
+            out.push('@');
+            out.push_str(&tag.name);
+        }
+        match &value.payload {
+            None if value.tag.is_none() => out.push('@'),
+            None => {}
+            Some(Payload::Scalar(scalar)) => out.push_str(&format!("{:?}", scalar.text)),
+            Some(Payload::Sequence(seq)) => {
+                let items: Vec<_> = seq.items.iter().map(shape).collect();
+                out.push_str(&format!("({})", items.join(" ")));
+            }
+            Some(Payload::Object(obj)) => out.push_str(&object_shape(obj)),
+        }
+        out
+    }
+
+    fn object_shape(obj: &Object) -> String {
+        let entries: Vec<_> = obj
+            .entries()
+            .iter()
+            .map(|e| format!("{} {}", shape(&e.key), shape(&e.value)))
+            .collect();
+        format!("{{{}}}", entries.join(", "))
+    }
+
+    #[test]
+    fn test_writer_output_round_trips() {
+        let key = |w, k: &str| unsafe { assert!(styx_writer_key(w, k.as_ptr().cast(), k.len())) };
+        let scalar =
+            |w, s: &str| unsafe { assert!(styx_writer_scalar(w, s.as_ptr().cast(), s.len())) };
+        let tag = |w, t: &str| unsafe { assert!(styx_writer_tag(w, t.as_ptr().cast(), t.len())) };
+        let calls = |w: *mut StyxWriter| unsafe {
+            key(w, "plain");
+            scalar(w, "hello");
+            key(w, "with space");
+            scalar(w, "two words");
+            key(w, "a.b");
+            scalar(w, "dotted key");
+            key(w, "escapes");
+            scalar(
+                w,
+                "say \"hi\" \\ line\nbreak\ttab\r\u{1}\u{7f} h\u{e9}llo \u{2603}",
+            );
+            key(w, "lookalikes");
+            assert!(styx_writer_begin_sequence(w));
+            for text in [
+                "",
+                "@",
+                "@tag",
+                "{x}",
+                "(y)",
+                "a,b",
+                "//c",
+                "r#\"raw\"#",
+                "<<EOT",
+                ">",
+                "a>b",
+                "=",
+                "true",
+                "-0",
+                "1e400",
+            ] {
+                scalar(w, text);
+            }
+            assert!(styx_writer_end(w));
+            key(w, "tags");
+            assert!(styx_writer_begin_object(w));
+            key(w, "alone");
+            tag(w, "ok");
+            key(w, "text");
+            tag(w, "t");
+            scalar(w, "payload");
+            key(w, "number");
+            tag(w, "n");
+            assert!(styx_writer_int(w, -42));
+            key(w, "object");
+            tag(w, "point");
+            assert!(styx_writer_begin_object(w));
+            key(w, "x");
+            assert!(styx_writer_int(w, 1));
+            assert!(styx_writer_end(w));
+            key(w, "sequence");
+            tag(w, "list-of_2");
+            assert!(styx_writer_begin_sequence(w));
+            tag(w, "a");
+            assert!(styx_writer_unit(w));
+            tag(w, "b");
+            assert!(styx_writer_unit(w));
+            assert!(styx_writer_end(w));
+            assert!(styx_writer_end(w));
+            key(w, "nested");
+            assert!(styx_writer_begin_object(w));
+            key(w, "deep");
+            assert!(styx_writer_begin_sequence(w));
+            assert!(styx_writer_begin_object(w));
+            key(w, "k");
+            assert!(styx_writer_unit(w));
+            assert!(styx_writer_end(w));
+            assert!(styx_writer_begin_sequence(w));
+            assert!(styx_writer_end(w));
+            assert!(styx_writer_begin_object(w));
+            assert!(styx_writer_end(w));
+            assert!(styx_writer_unit(w));
+            assert!(styx_writer_bool(w, false));
+            assert!(styx_writer_end(w));
+            assert!(styx_writer_end(w));
+            key(w, "unit");
+            assert!(styx_writer_unit(w));
+        };
+        let expected = concat!(
+            r##"{"plain" "hello", "with space" "two words", "a.b" "dotted key", "escapes" "##,
+            r##""say \"hi\" \\ line\nbreak\ttab\r\u{1}\u{7f} héllo ☃", "lookalikes" "##,
+            r##"("" "@" "@tag" "{x}" "(y)" "a,b" "//c" "r#\"raw\"#" "<<EOT" ">" "a>b" "=""##,
+            r##" "true" "-0" "1e400"), "tags" {"alone" @ok, "text" @t"payload", "##,
+            r##""number" @n"-42", "object" @point{"x" "1"}, "sequence" @list-of_2(@a @b)}, "##,
+            r##""nested" {"deep" ({"k" @} () {} @ "false")}, "unit" @}"##,
+        );
+        for flags in [0, STYX_WRITE_COMPACT] {
+            let text = written(flags, calls);
+            let doc = Document::parse(&text).unwrap_or_else(|e| panic!("{e:?} in {text}"));
+            assert_eq!(object_shape(&doc.root), expected, "{text}");
+        }
+    }
+
+    #[test]
+    fn test_writer_rejects_a_second_tag() {
+        unsafe {
+            let mut out = StyxBuffer {
+                data: ptr::null_mut(),
+                len: 0,
+                capacity: 0,
+            };
+            let writer = styx_writer_new_buffer(&mut out, 0);
+            assert!(styx_writer_key(writer, c"x".as_ptr(), 1));
+            assert!(styx_writer_tag(writer, c"a".as_ptr(), 1));
+            assert!(!styx_writer_tag(writer, c"b".as_ptr(), 1));
+            assert_eq!(
+                CStr::from_ptr(styx_writer_error(writer)),
+                c"value already tagged"
+            );
+            assert!(!styx_writer_finish(writer));
+            styx_writer_free(writer);
+            free(out.data as *mut c_void);
+        }
+    }
+
+    /// The `port` of a snapshot's document.
+    unsafe fn snapshot_port(snapshot: *const StyxSnapshot) -> u64 {
+        unsafe {
+            let doc = styx_snapshot_document(snapshot);
+            let mut port = 0;
+            let status = styx_value_as_u64(styx_document_get(doc, c"port".as_ptr()), &mut port);
+            assert_eq!(status, StyxScalarStatus::Ok);
+            port
+        }
+    }
+
+    unsafe fn publish_port(cell: *const StyxSnapshotCell, port: u64) {
+        let source = CString::new(format!("port {port}")).unwrap();
+        unsafe { styx_snapshot_publish(cell, styx_parse(source.as_ptr()).document) };
+    }
+
+    #[test]
+    fn test_snapshot_outlives_publish_until_released() {
+        unsafe {
+            let cell = styx_snapshot_cell_new();
+            assert!(styx_snapshot_acquire(cell).is_null());
+            publish_port(cell, 1);
+            let old = styx_snapshot_acquire(cell);
+            // Watch the old version without holding a reference to it.
+            let watch = Arc::downgrade(&std::mem::ManuallyDrop::new(Arc::from_raw(old)));
+
+            publish_port(cell, 2);
+            let new = styx_snapshot_acquire(cell);
+            assert_eq!(snapshot_port(new), 2);
+            assert_eq!(snapshot_port(old), 1);
+            assert!(watch.upgrade().is_some());
+
+            assert_eq!(styx_snapshot_retain(old), old);
+            styx_snapshot_release(old);
+            assert_eq!(snapshot_port(old), 1);
+            styx_snapshot_release(old);
+            assert!(watch.upgrade().is_none());
+
+            // The cell's reference goes with it; readers keep theirs.
+            styx_snapshot_cell_free(cell);
+            assert_eq!(snapshot_port(new), 2);
+            styx_snapshot_release(new);
+        }
+    }
+
+    #[test]
+    fn test_snapshot_readers_see_consistent_versions() {
+        let cell = styx_snapshot_cell_new();
+        unsafe { publish_port(cell, 0) };
+        let shared = cell as usize;
+        let done = std::sync::atomic::AtomicBool::new(false);
+        std::thread::scope(|scope| {
+            for _ in 0..4 {
+                scope.spawn(|| unsafe {
+                    let cell = shared as *const StyxSnapshotCell;
+                    let mut last = 0;
+                    while !done.load(Ordering::Acquire) {
+                        let snapshot = styx_snapshot_acquire(cell);
+                        let port = snapshot_port(snapshot);
+                        assert!(port >= last, "went back from {last} to {port}");
+                        last = port;
+                        styx_snapshot_release(snapshot);
+                    }
+                });
+            }
+            for port in 1..=200 {
+                unsafe { publish_port(cell, port) };
+            }
+            done.store(true, Ordering::Release);
+        });
+        unsafe {
+            let snapshot = styx_snapshot_acquire(cell);
+            assert_eq!(snapshot_port(snapshot), 200);
+            styx_snapshot_release(snapshot);
+            styx_snapshot_cell_free(cell);
+        }
+    }
+
+    /// Parse `x <value>` and read `x` with a typed reader, starting from `init`.
+    fn read_typed<T: Copy>(
+        value: &str,
+        read: unsafe extern "C" fn(*const StyxValue, *mut T) -> StyxScalarStatus,
+        init: T,
+    ) -> (StyxScalarStatus, T) {
+        let source = format!("x {value}");
+        unsafe {
+            let result = styx_parse_n(source.as_ptr().cast(), source.len(), 0);
+            assert!(result.error.is_null(), "parsing {source:?}");
+            let mut out = init;
+            let status = read(styx_document_get(result.document, c"x".as_ptr()), &mut out);
+            styx_free_document(result.document);
+            (status, out)
+        }
+    }
+
+    #[test]
+    fn test_value_as_i64() {
+        use StyxScalarStatus::*;
+        for (value, expected) in [
+            ("0", (Ok, 0)),
+            ("-0", (Ok, 0)),
+            ("+5", (Ok, 5)),
+            ("-42", (Ok, -42)),
+            ("9223372036854775807", (Ok, i64::MAX)),
+            ("-9223372036854775808", (Ok, i64::MIN)),
+            ("9223372036854775808", (OutOfRange, 7)),
+            ("-9223372036854775809", (OutOfRange, 7)),
+            ("99999999999999999999999", (OutOfRange, 7)),
+            ("1.5", (Invalid, 7)),
+            ("1e3", (Invalid, 7)),
+            ("0x10", (Invalid, 7)),
+            ("--1", (Invalid, 7)),
+            ("+-1", (Invalid, 7)),
+            ("\"\"", (Invalid, 7)),
+            ("\" 1\"", (Invalid, 7)),
+            ("(1 2)", (NotScalar, 7)),
+            ("{a 1}", (NotScalar, 7)),
+            ("@", (NotScalar, 7)),
+        ] {
+            assert_eq!(read_typed(value, styx_value_as_i64, 7), expected, "{value}");
+        }
+        let mut out = 7;
+        assert_eq!(
+            unsafe { styx_value_as_i64(ptr::null(), &mut out) },
+            NotScalar
+        );
+        assert_eq!(out, 7);
+    }
+
+    #[test]
+    fn test_value_as_u64() {
+        use StyxScalarStatus::*;
+        for (value, expected) in [
+            ("0", (Ok, 0)),
+            ("-0", (Ok, 0)),
+            ("+5", (Ok, 5)),
+            ("18446744073709551615", (Ok, u64::MAX)),
+            ("18446744073709551616", (OutOfRange, 7)),
+            ("-1", (OutOfRange, 7)),
+            ("-99999999999999999999999", (OutOfRange, 7)),
+            ("-", (Invalid, 7)),
+            ("--0", (Invalid, 7)),
+            ("-+0", (Invalid, 7)),
+            ("1.0", (Invalid, 7)),
+            ("(1)", (NotScalar, 7)),
+            ("{}", (NotScalar, 7)),
+        ] {
+            assert_eq!(read_typed(value, styx_value_as_u64, 7), expected, "{value}");
+        }
+    }
+
+    #[test]
+    fn test_value_as_f64() {
+        use StyxScalarStatus::*;
+        for (value, status, expected) in [
+            ("1.5", Ok, 1.5),
+            ("-0", Ok, -0.0),
+            ("+5", Ok, 5.0),
+            ("2.5e-3", Ok, 2.5e-3),
+            ("1E3", Ok, 1e3),
+            ("1e-400", Ok, 0.0),
+            ("1.7976931348623157e308", Ok, f64::MAX),
+            ("inf", Ok, f64::INFINITY),
+            ("-Infinity", Ok, f64::NEG_INFINITY),
+            ("1e400", OutOfRange, 7.0),
+            ("-1e400", OutOfRange, 7.0),
+            ("1_000", Invalid, 7.0),
+            ("0x1p3", Invalid, 7.0),
+            ("infinite", Invalid, 7.0),
+            ("\"\"", Invalid, 7.0),
+            ("(1.5)", NotScalar, 7.0),
+            ("{a 1.5}", NotScalar, 7.0),
+        ] {
+            let (got, out) = read_typed(value, styx_value_as_f64, 7.0);
+            assert_eq!(got, status, "{value}");
+            assert_eq!(out.to_bits(), expected.to_bits(), "{value} read as {out}");
+        }
+        for value in ["nan", "NaN", "-nan"] {
+            let (got, out) = read_typed(value, styx_value_as_f64, 7.0);
+            assert_eq!(got, Ok, "{value}");
+            assert!(out.is_nan(), "{value} read as {out}");
+        }
+    }
+
+    #[test]
+    fn test_value_as_bool() {
+        use StyxScalarStatus::*;
+        for (value, expected) in [
+            ("true", (Ok, true)),
+            ("false", (Ok, false)),
+            ("\"true\"", (Ok, true)),
+            ("True", (Invalid, false)),
+            ("1", (Invalid, false)),
+            ("yes", (Invalid, false)),
+            ("(true)", (NotScalar, false)),
+            ("@", (NotScalar, false)),
+        ] {
+            assert_eq!(
+                read_typed(value, styx_value_as_bool, false),
+                expected,
+                "{value}"
+            );
+        }
+    }
+
+    #[test]
+    fn test_parse_ex_uses_the_parse_cache() {
+        let dir = std::env::temp_dir().join(format!("styx-ffi-cache-{}", std::process::id()));
+        let source: String = (0..100).map(|i| format!("key{i} value{i}\n")).collect();
+        let entry = ParseCache::new(&dir).entry_path(&source);
+
+        let c_dir = CString::new(dir.to_str().unwrap()).unwrap();
+        assert!(unsafe { styx_set_parse_cache(c_dir.as_ptr()) });
+        let mut error = StyxError::NONE;
+        let doc = unsafe { styx_parse_ex(source.as_ptr().cast(), source.len(), 0, &mut error) };
+        assert!(unsafe { styx_set_parse_cache(ptr::null()) });
+
+        assert!(!doc.is_null());
+        assert_eq!(error.code, StyxErrorCode::None);
+        unsafe { styx_free_document(doc) };
+        assert!(entry.exists(), "{} was not stored", entry.display());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
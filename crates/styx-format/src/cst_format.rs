@@ -1878,7 +1878,7 @@ mod proptests {
                 }
                 styx_tree::Payload::Object(obj) => {
                     obj.span = None;
-                    for entry in &mut obj.entries {
+                    for entry in obj.entries_mut() {
                         strip_spans(&mut entry.key);
                         strip_spans(&mut entry.value);
                     }
@@ -122,8 +122,8 @@ impl ValueFormatter {
 
     fn format_object_inner(&mut self, obj: &Object, after_tag: bool) {
         // Use heuristics: multiline if more than 2 entries or any entry has nested structure
-        let force_multiline = obj.entries.len() > 2
-            || obj.entries.iter().any(|e| {
+        let force_multiline = obj.entries().len() > 2
+            || obj.entries().iter().any(|e| {
                 e.value
                     .payload
                     .as_ref()
@@ -146,7 +146,7 @@ impl ValueFormatter {
     }
 
     fn format_object_entries(&mut self, obj: &Object) {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             self.format_entry(entry);
         }
     }
@@ -252,10 +252,7 @@ mod tests {
     fn obj_value(entries: Vec<Entry>) -> Value {
         Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries,
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(entries, None))),
             span: None,
         }
     }
@@ -283,10 +280,10 @@ mod tests {
     fn test_format_nested_object() {
         let inner = Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: vec![entry("name", scalar("Alice")), entry("age", scalar("30"))],
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(
+                vec![entry("name", scalar("Alice")), entry("age", scalar("30"))],
+                None,
+            ))),
             span: None,
         };
 
@@ -341,10 +338,7 @@ mod tests {
     fn obj_multiline(entries: Vec<Entry>) -> Value {
         Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries,
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(entries, None))),
             span: None,
         }
     }
@@ -353,10 +347,7 @@ mod tests {
     fn obj_inline(entries: Vec<Entry>) -> Value {
         Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries,
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(entries, None))),
             span: None,
         }
     }
@@ -368,10 +359,7 @@ mod tests {
                 name: tag_name.to_string(),
                 span: None,
             }),
-            payload: Some(Payload::Object(Object {
-                entries,
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(entries, None))),
             span: None,
         }
     }
@@ -650,13 +638,13 @@ mod tests {
     fn test_edge_case_17_nested_doc_comments() {
         let inner = Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: vec![
+            payload: Some(Payload::Object(Object::new(
+                vec![
                     entry_with_doc("host", scalar("localhost"), "The server hostname"),
                     entry_with_doc("port", scalar("8080"), "The server port"),
                 ],
-                span: None,
-            })),
+                None,
+            ))),
             span: None,
         };
         let obj = obj_multiline(vec![entry_with_doc(
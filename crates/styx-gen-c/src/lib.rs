@@ -0,0 +1,1324 @@
+#![doc = include_str!("../README.md")]
+//! C code generation from Styx schemas.
+
+use facet_styx::SchemaFile;
+use std::collections::{BTreeMap, BTreeSet};
+use std::fmt::Write as _;
+use std::path::Path;
+
+mod error;
+mod phf;
+mod types;
+
+pub use error::GenError;
+use phf::PerfectHash;
+use types::{CType, FieldType, Presence, StructField, TypeMapper, c_identifier};
+
+/// Generate C code from a Styx schema.
+///
+/// Writes `<prefix>.h`, declaring a plain struct for every object type, and
+/// `<prefix>.c`, which fills them straight from the `styx.h` event reader
+/// without building a document. Keys are dispatched through perfect hash
+/// tables computed here. The header can be included from C and C++.
+pub fn generate(schema: &SchemaFile, prefix: &str, output_dir: &str) -> Result<(), GenError> {
+    let mut mapper = TypeMapper::new();
+
+    // Collect all type definitions from the schema
+    for (name_opt, schema_type) in &schema.schema {
+        let type_name = match name_opt {
+            Some(name) => name.clone(),
+            None => "Root".to_string(), // Root type gets default name
+        };
+        mapper.register_type(&type_name, schema_type)?;
+    }
+
+    let generator = Generator::new(mapper.types(), prefix)?;
+
+    let header_path = Path::new(output_dir).join(format!("{}.h", prefix));
+    std::fs::write(&header_path, generator.header()?)
+        .map_err(|e| GenError::Io(format!("failed to write {}: {}", header_path.display(), e)))?;
+
+    let source_path = Path::new(output_dir).join(format!("{}.c", prefix));
+    std::fs::write(&source_path, generator.source()?)
+        .map_err(|e| GenError::Io(format!("failed to write {}: {}", source_path.display(), e)))?;
+
+    Ok(())
+}
+
+/// Emits the header and source for one set of types.
+struct Generator<'a> {
+    types: &'a BTreeMap<String, CType>,
+    /// Prefix of functions and constants, e.g. `app`.
+    prefix: &'a str,
+    /// Prefix of type names, e.g. `App`.
+    type_prefix: String,
+    /// Struct names, each after the structs it contains by value.
+    structs: Vec<&'a str>,
+    /// Struct and enum names that some field refers to, plus the root.
+    used: BTreeSet<&'a str>,
+    /// The struct filled by `<prefix>_parse`.
+    root: Option<&'a str>,
+}
+
+impl<'a> Generator<'a> {
+    fn new(types: &'a BTreeMap<String, CType>, prefix: &'a str) -> Result<Self, GenError> {
+        let mut generator = Generator {
+            types,
+            prefix,
+            type_prefix: types::to_pascal_case(prefix),
+            structs: Vec::new(),
+            used: BTreeSet::new(),
+            root: None,
+        };
+
+        // The root type is "Root", the default name for the @ type; fall back
+        // to the first struct if the schema has none.
+        generator.root = match types.get_key_value("Root") {
+            Some((name, CType::Struct { .. })) => Some(name.as_str()),
+            _ => types.iter().find_map(|(name, c_type)| match c_type {
+                CType::Struct { .. } => Some(name.as_str()),
+                _ => None,
+            }),
+        };
+
+        let mut visiting = BTreeSet::new();
+        for name in types.keys() {
+            generator.order_struct(name, &mut visiting)?;
+        }
+
+        let mut used: BTreeSet<&'a str> = generator.root.into_iter().collect();
+        for c_type in types.values() {
+            if let CType::Struct { fields, .. } = c_type {
+                for field in fields {
+                    if let FieldType::Named(name) = generator.item_type(&field.ty)? {
+                        used.insert(name);
+                    }
+                }
+            }
+        }
+        generator.used = used;
+
+        Ok(generator)
+    }
+
+    /// Append `name` to `structs` after the structs it holds by value.
+    fn order_struct(
+        &mut self,
+        name: &'a str,
+        visiting: &mut BTreeSet<&'a str>,
+    ) -> Result<(), GenError> {
+        let Some(CType::Struct { fields, .. }) = self.types.get(name) else {
+            return Ok(());
+        };
+        if self.structs.contains(&name) {
+            return Ok(());
+        }
+        if !visiting.insert(name) {
+            return Err(GenError::TypeMapping(format!(
+                "`{}` contains itself; recursive types are not supported",
+                name
+            )));
+        }
+        for field in fields {
+            if let FieldType::Named(inner) = self.resolve(&field.ty)? {
+                self.order_struct(inner, visiting)?;
+            }
+        }
+        visiting.remove(name);
+        self.structs.push(name);
+        Ok(())
+    }
+
+    /// Follow aliases to the underlying field type. Named types that remain
+    /// are structs or enums.
+    fn resolve(&self, ty: &'a FieldType) -> Result<&'a FieldType, GenError> {
+        let mut ty = ty;
+        for _ in 0..32 {
+            let FieldType::Named(name) = ty else {
+                return Ok(ty);
+            };
+            match self.types.get(name) {
+                Some(CType::Alias(inner)) => ty = inner,
+                Some(_) => return Ok(ty),
+                None => {
+                    return Err(GenError::TypeMapping(format!("unknown type `{}`", name)));
+                }
+            }
+        }
+        Err(GenError::TypeMapping(format!("alias cycle at {:?}", ty)))
+    }
+
+    /// The resolved type of a field, or of its items for sequences.
+    fn item_type(&self, ty: &'a FieldType) -> Result<&'a FieldType, GenError> {
+        match self.resolve(ty)? {
+            FieldType::Seq(item) => self.resolve(item),
+            other => Ok(other),
+        }
+    }
+
+    fn is_struct(&self, name: &str) -> bool {
+        matches!(self.types.get(name), Some(CType::Struct { .. }))
+    }
+
+    fn type_name(&self, name: &str) -> String {
+        format!("{}{}", self.type_prefix, name)
+    }
+
+    /// C type of a resolved, non-sequence field type.
+    fn c_type(&self, ty: &FieldType) -> String {
+        match ty {
+            FieldType::String => "char *".to_string(),
+            FieldType::Int => "int64_t".to_string(),
+            FieldType::Float => "double".to_string(),
+            FieldType::Bool | FieldType::Unit => "bool".to_string(),
+            FieldType::Named(name) => self.type_name(name),
+            FieldType::Seq(_) | FieldType::Unsupported(_) => unreachable!("{:?}", ty),
+        }
+    }
+
+    fn enum_constant(&self, enum_name: &str, variant: &str) -> String {
+        format!(
+            "{}_{}_{}",
+            self.prefix,
+            to_snake_case(enum_name),
+            c_identifier(variant)
+        )
+        .to_uppercase()
+    }
+
+    // =========================================================================
+    // Header
+    // =========================================================================
+
+    fn header(&self) -> Result<String, GenError> {
+        let mut out = String::new();
+        let guard = format!("{}_H", self.prefix.to_uppercase());
+        let error_type = self.type_name("Error");
+
+        writeln!(out, "/* Code generated by styx gen c. DO NOT EDIT. */")?;
+        writeln!(out)?;
+        writeln!(out, "#ifndef {}", guard)?;
+        writeln!(out, "#define {}", guard)?;
+        writeln!(out)?;
+        writeln!(out, "#include <stdbool.h>")?;
+        writeln!(out, "#include <stddef.h>")?;
+        writeln!(out, "#include <stdint.h>")?;
+        writeln!(out)?;
+        writeln!(out, "#ifdef __cplusplus")?;
+        writeln!(out, "extern \"C\" {{")?;
+        writeln!(out, "#endif")?;
+        writeln!(out)?;
+
+        writeln!(out, "/** Why parsing failed. */")?;
+        writeln!(out, "typedef struct {} {{", error_type)?;
+        writeln!(out, "    /** What went wrong, null-terminated. */")?;
+        writeln!(out, "    char message[128];")?;
+        writeln!(
+            out,
+            "    /** Byte offset of the start of the offending input. */"
+        )?;
+        writeln!(out, "    uint32_t span_start;")?;
+        writeln!(
+            out,
+            "    /** Byte offset of the end of the offending input. */"
+        )?;
+        writeln!(out, "    uint32_t span_end;")?;
+        writeln!(out, "}} {};", error_type)?;
+        writeln!(out)?;
+
+        // Enums first: structs hold them by value
+        for (name, c_type) in self.types {
+            if let CType::Enum { variants, doc } = c_type {
+                write_doc(&mut out, "", doc.as_deref())?;
+                writeln!(out, "typedef enum {} {{", self.type_name(name))?;
+                for (i, variant) in variants.iter().enumerate() {
+                    write_doc(&mut out, "    ", variant.doc.as_deref())?;
+                    let comma = if i + 1 < variants.len() { "," } else { "" };
+                    writeln!(
+                        out,
+                        "    {} = {}{}",
+                        self.enum_constant(name, &variant.name),
+                        i,
+                        comma
+                    )?;
+                }
+                writeln!(out, "}} {};", self.type_name(name))?;
+                writeln!(out)?;
+            }
+        }
+
+        for name in &self.structs {
+            writeln!(
+                out,
+                "typedef struct {} {};",
+                self.type_name(name),
+                self.type_name(name)
+            )?;
+        }
+        if !self.structs.is_empty() {
+            writeln!(out)?;
+        }
+
+        for name in &self.structs {
+            let Some(CType::Struct { fields, doc }) = self.types.get(*name) else {
+                continue;
+            };
+            write_doc(&mut out, "", doc.as_deref())?;
+            writeln!(out, "struct {} {{", self.type_name(name))?;
+            for field in fields {
+                self.write_member(&mut out, field)?;
+            }
+            if fields.is_empty() {
+                writeln!(out, "    /** Unused; the object has no fields. */")?;
+                writeln!(out, "    char unused_;")?;
+            }
+            writeln!(out, "}};")?;
+            writeln!(out)?;
+        }
+
+        if let Some(root) = self.root {
+            let root_type = self.type_name(root);
+            writeln!(out, "/**")?;
+            writeln!(
+                out,
+                " * Parse `{}` from `len` bytes of Styx source.",
+                root_type
+            )?;
+            writeln!(out, " *")?;
+            writeln!(
+                out,
+                " * Fills `*out` directly from the event stream. On failure returns false,"
+            )?;
+            writeln!(
+                out,
+                " * describes the problem in `*error` (if not NULL) and leaves `*out` zeroed."
+            )?;
+            writeln!(
+                out,
+                " * On success, release `*out` with {}_{}_free().",
+                self.prefix,
+                to_snake_case(root)
+            )?;
+            writeln!(out, " */")?;
+            writeln!(
+                out,
+                "bool {}_parse(const char *source, size_t len, {} *out, {} *error);",
+                self.prefix, root_type, error_type
+            )?;
+            writeln!(out)?;
+            writeln!(
+                out,
+                "/** Read and parse `{}` from a .styx file, as {}_parse(). */",
+                root_type, self.prefix
+            )?;
+            writeln!(
+                out,
+                "bool {}_load_file(const char *path, {} *out, {} *error);",
+                self.prefix, root_type, error_type
+            )?;
+            writeln!(out)?;
+        }
+
+        for name in &self.structs {
+            writeln!(
+                out,
+                "/** Free everything owned by `*value` and zero it (no-op if NULL). */"
+            )?;
+            writeln!(
+                out,
+                "void {}_{}_free({} *value);",
+                self.prefix,
+                to_snake_case(name),
+                self.type_name(name)
+            )?;
+            writeln!(out)?;
+        }
+
+        writeln!(out, "#ifdef __cplusplus")?;
+        writeln!(out, "}}")?;
+        writeln!(out, "#endif")?;
+        writeln!(out)?;
+        writeln!(out, "#endif /* {} */", guard)?;
+        Ok(out)
+    }
+
+    fn write_member(&self, out: &mut String, field: &StructField) -> Result<(), GenError> {
+        let name = &field.c_name;
+        match self.resolve(&field.ty)? {
+            FieldType::Unsupported(what) => {
+                write_doc(out, "    ", field.doc.as_deref())?;
+                writeln!(
+                    out,
+                    "    /* `{}`: {} are not supported; the value is skipped. */",
+                    field.styx_name, what
+                )?;
+            }
+            FieldType::Seq(item) => {
+                let item = self.c_type(self.resolve(item)?);
+                write_doc(out, "    ", field.doc.as_deref())?;
+                writeln!(out, "    {};", declare(&pointer_to(&item), name))?;
+                writeln!(out, "    /** Number of items in `{}`. */", name)?;
+                writeln!(out, "    size_t {}_len;", name)?;
+            }
+            ty => {
+                if field.presence == Presence::Optional && *ty != FieldType::Unit {
+                    writeln!(out, "    /** Whether `{}` was present. */", name)?;
+                    writeln!(out, "    bool has_{};", name)?;
+                }
+                write_doc(out, "    ", field.doc.as_deref())?;
+                writeln!(out, "    {};", declare(&self.c_type(ty), name))?;
+            }
+        }
+        Ok(())
+    }
+
+    // =========================================================================
+    // Source
+    // =========================================================================
+
+    fn source(&self) -> Result<String, GenError> {
+        let mut out = String::new();
+        let used_structs: Vec<&str> = self
+            .structs
+            .iter()
+            .copied()
+            .filter(|name| self.used.contains(name))
+            .collect();
+        let used_enums: Vec<&str> = self
+            .used
+            .iter()
+            .copied()
+            .filter(|name| matches!(self.types.get(*name), Some(CType::Enum { .. })))
+            .collect();
+
+        writeln!(out, "/* Code generated by styx gen c. DO NOT EDIT. */")?;
+        writeln!(out)?;
+        writeln!(out, "#include \"{}.h\"", self.prefix)?;
+        writeln!(out)?;
+        writeln!(out, "#include <errno.h>")?;
+        writeln!(out, "#include <stdio.h>")?;
+        writeln!(out, "#include <stdlib.h>")?;
+        writeln!(out, "#include <string.h>")?;
+        writeln!(out)?;
+        writeln!(out, "#include \"styx.h\"")?;
+        writeln!(out)?;
+
+        out.push_str(&RUNTIME.replace("ERROR_TYPE", &self.type_name("Error")));
+        let needs = self.helpers_needed(&used_structs)?;
+        for (helper, code) in HELPERS {
+            if needs.contains(helper) {
+                out.push_str(code);
+            }
+        }
+
+        // Key tables
+        for name in used_structs.iter().chain(&used_enums) {
+            let names: Vec<&str> = match &self.types[*name] {
+                CType::Struct { fields, .. } => {
+                    fields.iter().map(|f| f.styx_name.as_str()).collect()
+                }
+                CType::Enum { variants, .. } => variants.iter().map(|v| v.name.as_str()).collect(),
+                CType::Alias(_) => continue,
+            };
+            write_table(&mut out, &to_snake_case(name), &names)?;
+        }
+
+        // Which fields were seen, kept until the whole document is read
+        // because dotted keys can reopen an object.
+        for name in &used_structs {
+            let Some(CType::Struct { fields, .. }) = self.types.get(*name) else {
+                continue;
+            };
+            let seen = format!("{}Seen", self.type_name(name));
+            writeln!(out, "typedef struct {} {{", seen)?;
+            writeln!(out, "    bool fields[{}];", fields.len().max(1))?;
+            for field in fields {
+                if let FieldType::Named(inner) = self.resolve(&field.ty)?
+                    && self.is_struct(inner)
+                {
+                    writeln!(out, "    {}Seen {};", self.type_name(inner), field.c_name)?;
+                }
+            }
+            writeln!(out, "}} {};", seen)?;
+            writeln!(out)?;
+        }
+
+        for name in &used_enums {
+            writeln!(
+                out,
+                "static bool read_{}(Cursor *c, {} *out);",
+                to_snake_case(name),
+                self.type_name(name)
+            )?;
+        }
+        for name in &used_structs {
+            let (snake, ty) = (to_snake_case(name), self.type_name(name));
+            writeln!(
+                out,
+                "static bool parse_{}(Cursor *c, {} *out, {}Seen *seen);",
+                snake, ty, ty
+            )?;
+            writeln!(
+                out,
+                "static bool finish_{}(Cursor *c, {} *out, const {}Seen *seen);",
+                snake, ty, ty
+            )?;
+        }
+        writeln!(out)?;
+
+        for name in &used_enums {
+            self.write_enum_reader(&mut out, name)?;
+        }
+        for name in &used_structs {
+            self.write_struct_parser(&mut out, name)?;
+            self.write_struct_finisher(&mut out, name)?;
+        }
+        for name in &self.structs {
+            self.write_free(&mut out, name)?;
+        }
+        if let Some(root) = self.root {
+            self.write_entry_points(&mut out, root)?;
+        }
+
+        Ok(out)
+    }
+
+    /// Names of the optional runtime helpers the parsers call.
+    fn helpers_needed(&self, structs: &[&str]) -> Result<BTreeSet<&'static str>, GenError> {
+        let mut needs = BTreeSet::new();
+        for name in structs {
+            let Some(CType::Struct { fields, .. }) = self.types.get(*name) else {
+                continue;
+            };
+            for field in fields {
+                let ty = self.item_type(&field.ty)?;
+                match ty {
+                    FieldType::String => {
+                        needs.insert("copy_string");
+                        needs.insert("read_string");
+                    }
+                    FieldType::Int => {
+                        needs.insert("scalar_text");
+                        needs.insert("read_i64");
+                    }
+                    FieldType::Float => {
+                        needs.insert("read_f64");
+                    }
+                    FieldType::Bool => {
+                        needs.insert("read_bool");
+                    }
+                    _ => {}
+                }
+                if let Presence::Default(raw) = &field.presence
+                    && *ty == FieldType::String
+                    && self.default_value(ty, raw).is_some()
+                {
+                    needs.insert("copy_string");
+                }
+            }
+        }
+        Ok(needs)
+    }
+
+    fn write_enum_reader(&self, out: &mut String, name: &str) -> Result<(), GenError> {
+        let Some(CType::Enum { variants, .. }) = self.types.get(name) else {
+            return Ok(());
+        };
+        let (snake, ty) = (to_snake_case(name), self.type_name(name));
+        writeln!(
+            out,
+            "/* Read a variant, written as a tag (`@name`) or a bare scalar. */"
+        )?;
+        writeln!(out, "static bool read_{}(Cursor *c, {} *out) {{", snake, ty)?;
+        writeln!(out, "    StyxStr name = {{NULL, 0}};")?;
+        writeln!(out, "    if (c->ev.kind == STYX_EVENT_TAG_START) {{")?;
+        writeln!(out, "        name = c->ev.tag;")?;
+        writeln!(out, "    }} else if (c->ev.kind == STYX_EVENT_SCALAR) {{")?;
+        writeln!(out, "        name = c->ev.text;")?;
+        writeln!(out, "    }}")?;
+        writeln!(out, "    switch (lookup(&{}_keys, name)) {{", snake)?;
+        for (i, variant) in variants.iter().enumerate() {
+            writeln!(out, "    case {}:", i)?;
+            writeln!(
+                out,
+                "        *out = {};",
+                self.enum_constant(name, &variant.name)
+            )?;
+            writeln!(out, "        break;")?;
+        }
+        writeln!(out, "    default:")?;
+        writeln!(
+            out,
+            "        return fail(c, \"expected a variant of {}\");",
+            ty
+        )?;
+        writeln!(out, "    }}")?;
+        writeln!(out, "    return skip(c);")?;
+        writeln!(out, "}}")?;
+        writeln!(out)?;
+        Ok(())
+    }
+
+    fn write_struct_parser(&self, out: &mut String, name: &str) -> Result<(), GenError> {
+        let Some(CType::Struct { fields, .. }) = self.types.get(name) else {
+            return Ok(());
+        };
+        let (snake, ty) = (to_snake_case(name), self.type_name(name));
+        writeln!(
+            out,
+            "static bool parse_{}(Cursor *c, {} *out, {}Seen *seen) {{",
+            snake, ty, ty
+        )?;
+        if fields.is_empty() {
+            writeln!(out, "    (void)out;")?;
+        }
+        writeln!(out, "    if (c->ev.kind != STYX_EVENT_OBJECT_START) {{")?;
+        writeln!(out, "        return fail(c, \"expected an object\");")?;
+        writeln!(out, "    }}")?;
+        writeln!(out, "    for (;;) {{")?;
+        writeln!(out, "        int field;")?;
+        writeln!(
+            out,
+            "        /* ENTRY_START or OBJECT_END, then KEY and the value. */"
+        )?;
+        writeln!(out, "        if (!next(c)) {{")?;
+        writeln!(out, "            return false;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        if (c->ev.kind == STYX_EVENT_OBJECT_END) {{")?;
+        writeln!(out, "            return true;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        if (!next(c)) {{")?;
+        writeln!(out, "            return false;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        field = lookup(&{}_keys, c->ev.text);", snake)?;
+        writeln!(out, "        if (!next(c)) {{")?;
+        writeln!(out, "            return false;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        switch (field) {{")?;
+        for (i, field) in fields.iter().enumerate() {
+            writeln!(out, "        case {}:", i)?;
+            let target = format!("out->{}", field.c_name);
+            let seen = format!("&seen->{}", field.c_name);
+            self.write_read(out, "            ", &field.ty, &target, Some(&seen))?;
+            if field.presence == Presence::Optional
+                && !matches!(
+                    self.resolve(&field.ty)?,
+                    FieldType::Seq(_) | FieldType::Unit | FieldType::Unsupported(_)
+                )
+            {
+                writeln!(out, "            out->has_{} = true;", field.c_name)?;
+            }
+            writeln!(out, "            break;")?;
+        }
+        writeln!(out, "        default:")?;
+        writeln!(out, "            if (!skip(c)) {{")?;
+        writeln!(out, "                return false;")?;
+        writeln!(out, "            }}")?;
+        writeln!(out, "            break;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        if (field >= 0) {{")?;
+        writeln!(out, "            seen->fields[field] = true;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "        /* ENTRY_END */")?;
+        writeln!(out, "        if (!next(c)) {{")?;
+        writeln!(out, "            return false;")?;
+        writeln!(out, "        }}")?;
+        writeln!(out, "    }}")?;
+        writeln!(out, "}}")?;
+        writeln!(out)?;
+        Ok(())
+    }
+
+    /// Emit statements reading the value at the current event into the
+    /// lvalue `target`. Struct values record their fields in `seen`, or are
+    /// finished on the spot when there is none (sequence items).
+    fn write_read(
+        &self,
+        out: &mut String,
+        indent: &str,
+        ty: &FieldType,
+        target: &str,
+        seen: Option<&str>,
+    ) -> Result<(), GenError> {
+        let call = match self.resolve(ty)? {
+            FieldType::String => format!("read_string(c, &{})", target),
+            FieldType::Int => format!("read_i64(c, &{})", target),
+            FieldType::Float => format!("read_f64(c, &{})", target),
+            FieldType::Bool => format!("read_bool(c, &{})", target),
+            FieldType::Unsupported(_) => "skip(c)".to_string(),
+            FieldType::Unit => {
+                writeln!(out, "{}{} = true;", indent, target)?;
+                "skip(c)".to_string()
+            }
+            FieldType::Named(name) if self.is_struct(name) => {
+                let snake = to_snake_case(name);
+                match seen {
+                    Some(seen) => format!("parse_{}(c, &{}, {})", snake, target, seen),
+                    None => {
+                        writeln!(out, "{}{{", indent)?;
+                        writeln!(out, "{}    {}Seen item_seen;", indent, self.type_name(name))?;
+                        writeln!(
+                            out,
+                            "{}    memset(&item_seen, 0, sizeof item_seen);",
+                            indent
+                        )?;
+                        writeln!(
+                            out,
+                            "{}    if (!parse_{}(c, &{}, &item_seen) || !finish_{}(c, &{}, &item_seen)) {{",
+                            indent, snake, target, snake, target
+                        )?;
+                        writeln!(out, "{}        return false;", indent)?;
+                        writeln!(out, "{}    }}", indent)?;
+                        writeln!(out, "{}}}", indent)?;
+                        return Ok(());
+                    }
+                }
+            }
+            FieldType::Named(name) => format!("read_{}(c, &{})", to_snake_case(name), target),
+            FieldType::Seq(item) => {
+                let item_type = self.c_type(self.resolve(item)?);
+                let i = indent;
+                writeln!(out, "{i}{{")?;
+                writeln!(out, "{i}    size_t cap = {target}_len;")?;
+                writeln!(
+                    out,
+                    "{i}    if (c->ev.kind != STYX_EVENT_SEQUENCE_START) {{"
+                )?;
+                writeln!(out, "{i}        return fail(c, \"expected a sequence\");")?;
+                writeln!(out, "{i}    }}")?;
+                writeln!(out, "{i}    for (;;) {{")?;
+                writeln!(out, "{i}        if (!next(c)) {{")?;
+                writeln!(out, "{i}            return false;")?;
+                writeln!(out, "{i}        }}")?;
+                writeln!(
+                    out,
+                    "{i}        if (c->ev.kind == STYX_EVENT_SEQUENCE_END) {{"
+                )?;
+                writeln!(out, "{i}            break;")?;
+                writeln!(out, "{i}        }}")?;
+                writeln!(out, "{i}        if ({target}_len == cap) {{")?;
+                writeln!(
+                    out,
+                    "{i}            {};",
+                    declare(&pointer_to(&item_type), "items")
+                )?;
+                writeln!(out, "{i}            cap = cap ? cap * 2 : 4;")?;
+                writeln!(
+                    out,
+                    "{i}            items = ({})realloc({target}, cap * sizeof *items);",
+                    pointer_to(&item_type).trim_end()
+                )?;
+                writeln!(out, "{i}            if (!items) {{")?;
+                writeln!(out, "{i}                return fail(c, \"out of memory\");")?;
+                writeln!(out, "{i}            }}")?;
+                writeln!(out, "{i}            {target} = items;")?;
+                writeln!(out, "{i}        }}")?;
+                writeln!(
+                    out,
+                    "{i}        memset(&{target}[{target}_len], 0, sizeof *{target});"
+                )?;
+                writeln!(
+                    out,
+                    "{i}        /* Counted before reading so a partial item is freed too. */"
+                )?;
+                writeln!(out, "{i}        {target}_len++;")?;
+                let item_target = format!("{}[{}_len - 1]", target, target);
+                self.write_read(out, &format!("{i}        "), item, &item_target, None)?;
+                writeln!(out, "{i}    }}")?;
+                writeln!(out, "{i}}}")?;
+                return Ok(());
+            }
+        };
+        writeln!(out, "{}if (!{}) {{", indent, call)?;
+        writeln!(out, "{}    return false;", indent)?;
+        writeln!(out, "{}}}", indent)?;
+        Ok(())
+    }
+
+    fn write_struct_finisher(&self, out: &mut String, name: &str) -> Result<(), GenError> {
+        let Some(CType::Struct { fields, .. }) = self.types.get(name) else {
+            return Ok(());
+        };
+        let (snake, ty) = (to_snake_case(name), self.type_name(name));
+        writeln!(
+            out,
+            "/* Check required fields and fill in defaults once the document is read. */"
+        )?;
+        writeln!(
+            out,
+            "static bool finish_{}(Cursor *c, {} *out, const {}Seen *seen) {{",
+            snake, ty, ty
+        )?;
+        let mut body = String::new();
+        for (i, field) in fields.iter().enumerate() {
+            let resolved = self.resolve(&field.ty)?;
+            match &field.presence {
+                Presence::Required => {
+                    writeln!(body, "    if (!seen->fields[{}]) {{", i)?;
+                    writeln!(
+                        body,
+                        "        return fail(c, \"missing field `{}` in {}\");",
+                        c_escape(&field.styx_name),
+                        ty
+                    )?;
+                    writeln!(body, "    }}")?;
+                }
+                Presence::Default(raw) => {
+                    if let Some(value) = self.default_value(resolved, raw) {
+                        let target = format!("out->{}", field.c_name);
+                        writeln!(body, "    if (!seen->fields[{}]) {{", i)?;
+                        if *resolved == FieldType::String {
+                            writeln!(
+                                body,
+                                "        if (!copy_string(c, &{}, {}, {})) {{",
+                                target,
+                                value,
+                                raw_string(raw).map_or(0, str::len)
+                            )?;
+                            writeln!(body, "            return false;")?;
+                            writeln!(body, "        }}")?;
+                        } else {
+                            writeln!(body, "        {} = {};", target, value)?;
+                        }
+                        writeln!(body, "    }}")?;
+                    }
+                }
+                Presence::Optional => {}
+            }
+            if let FieldType::Named(inner) = resolved
+                && self.is_struct(inner)
+            {
+                writeln!(
+                    body,
+                    "    if (seen->fields[{}] && !finish_{}(c, &out->{}, &seen->{})) {{",
+                    i,
+                    to_snake_case(inner),
+                    field.c_name,
+                    field.c_name
+                )?;
+                writeln!(body, "        return false;")?;
+                writeln!(body, "    }}")?;
+            }
+        }
+        // Structs without required fields or defaults ignore some parameters
+        for (param, used) in [("c", "(c,"), ("out", "out->"), ("seen", "seen->")] {
+            if !body.contains(used) {
+                writeln!(out, "    (void){};", param)?;
+            }
+        }
+        out.push_str(&body);
+        writeln!(out, "    return true;")?;
+        writeln!(out, "}}")?;
+        writeln!(out)?;
+        Ok(())
+    }
+
+    /// C expression for a schema default, if it can be written as a
+    /// constant of the field's type.
+    fn default_value(&self, ty: &FieldType, raw: &str) -> Option<String> {
+        let raw = raw.trim();
+        match ty {
+            FieldType::Int => {
+                let value: i64 = raw.parse().ok()?;
+                Some(if value == i64::MIN {
+                    "INT64_MIN".to_string()
+                } else {
+                    format!("INT64_C({})", value)
+                })
+            }
+            FieldType::Float => {
+                let value: f64 = raw.parse().ok()?;
+                value.is_finite().then(|| format!("{:?}", value))
+            }
+            FieldType::Bool => match raw {
+                "true" | "false" => Some(raw.to_string()),
+                _ => None,
+            },
+            FieldType::String => raw_string(raw).map(|s| format!("\"{}\"", c_escape(s))),
+            FieldType::Named(name) => match self.types.get(name) {
+                Some(CType::Enum { variants, .. }) => {
+                    let variant = raw.strip_prefix('@').unwrap_or(raw);
+                    variants
+                        .iter()
+                        .find(|v| v.name == variant)
+                        .map(|v| self.enum_constant(name, &v.name))
+                }
+                _ => None,
+            },
+            _ => None,
+        }
+    }
+
+    fn write_free(&self, out: &mut String, name: &str) -> Result<(), GenError> {
+        let Some(CType::Struct { fields, .. }) = self.types.get(name) else {
+            return Ok(());
+        };
+        writeln!(
+            out,
+            "void {}_{}_free({} *value) {{",
+            self.prefix,
+            to_snake_case(name),
+            self.type_name(name)
+        )?;
+        writeln!(out, "    if (!value) {{")?;
+        writeln!(out, "        return;")?;
+        writeln!(out, "    }}")?;
+        for field in fields {
+            let member = format!("value->{}", field.c_name);
+            match self.resolve(&field.ty)? {
+                FieldType::String => writeln!(out, "    free({});", member)?,
+                FieldType::Named(inner) if self.is_struct(inner) => writeln!(
+                    out,
+                    "    {}_{}_free(&{});",
+                    self.prefix,
+                    to_snake_case(inner),
+                    member
+                )?,
+                FieldType::Seq(item) => {
+                    let item_free = match self.resolve(item)? {
+                        FieldType::String => Some(format!("free({}[i])", member)),
+                        FieldType::Named(inner) if self.is_struct(inner) => Some(format!(
+                            "{}_{}_free(&{}[i])",
+                            self.prefix,
+                            to_snake_case(inner),
+                            member
+                        )),
+                        _ => None,
+                    };
+                    if let Some(item_free) = item_free {
+                        writeln!(out, "    for (size_t i = 0; i < {}_len; i++) {{", member)?;
+                        writeln!(out, "        {};", item_free)?;
+                        writeln!(out, "    }}")?;
+                    }
+                    writeln!(out, "    free({});", member)?;
+                }
+                _ => {}
+            }
+        }
+        writeln!(out, "    memset(value, 0, sizeof *value);")?;
+        writeln!(out, "}}")?;
+        writeln!(out)?;
+        Ok(())
+    }
+
+    fn write_entry_points(&self, out: &mut String, root: &str) -> Result<(), GenError> {
+        let code = ENTRY_POINTS
+            .replace("PREFIX", self.prefix)
+            .replace("ROOT_TYPE", &self.type_name(root))
+            .replace("ROOT_SNAKE", &to_snake_case(root))
+            .replace("ERROR_TYPE", &self.type_name("Error"));
+        out.push_str(&code);
+        Ok(())
+    }
+}
+
+/// Emit the perfect hash table `<name>_keys` for `names`.
+fn write_table(out: &mut String, name: &str, names: &[&str]) -> Result<(), GenError> {
+    let table = PerfectHash::build(names);
+    writeln!(
+        out,
+        "static const uint32_t {}_buckets[{}] = {{",
+        name,
+        table.buckets.len()
+    )?;
+    for seed in &table.buckets {
+        writeln!(out, "    0x{:08x}u,", seed)?;
+    }
+    writeln!(out, "}};")?;
+    writeln!(
+        out,
+        "static const Slot {}_slots[{}] = {{",
+        name,
+        table.slots.len()
+    )?;
+    for slot in &table.slots {
+        match slot {
+            Some(index) => writeln!(
+                out,
+                "    {{\"{}\", {}, {}}},",
+                c_escape(names[*index]),
+                names[*index].len(),
+                index
+            )?,
+            None => writeln!(out, "    {{NULL, 0, -1}},")?,
+        }
+    }
+    writeln!(out, "}};")?;
+    writeln!(
+        out,
+        "static const Table {}_keys = {{{}_slots, {}_buckets, 0x{:08x}u, {}u, {}u}};",
+        name,
+        name,
+        name,
+        table.seed,
+        table.bucket_mask(),
+        table.slot_mask()
+    )?;
+    writeln!(out)?;
+    Ok(())
+}
+
+fn write_doc(out: &mut String, indent: &str, doc: Option<&str>) -> Result<(), GenError> {
+    if let Some(doc) = doc {
+        let doc = doc.replace("*/", "* /");
+        writeln!(out, "{}/** {} */", indent, doc.trim())?;
+    }
+    Ok(())
+}
+
+/// `T name` or `T *name`, depending on whether `ty` ends in a pointer.
+fn declare(ty: &str, name: &str) -> String {
+    if ty.ends_with('*') {
+        format!("{}{}", ty, name)
+    } else {
+        format!("{} {}", ty, name)
+    }
+}
+
+fn pointer_to(ty: &str) -> String {
+    if ty.ends_with('*') {
+        format!("{}*", ty)
+    } else {
+        format!("{} *", ty)
+    }
+}
+
+/// The text of a string default: bare, or quoted without escapes.
+fn raw_string(raw: &str) -> Option<&str> {
+    let raw = raw.trim();
+    match raw.strip_prefix('"').and_then(|s| s.strip_suffix('"')) {
+        Some(inner) if !inner.contains(['\\', '"']) => Some(inner),
+        Some(_) => None,
+        None if !raw.is_empty() && !raw.contains(char::is_whitespace) => Some(raw),
+        None => None,
+    }
+}
+
+/// Escape text for a C string literal. Non-ASCII bytes become octal escapes,
+/// which (unlike hex) cannot swallow the characters after them.
+fn c_escape(s: &str) -> String {
+    let mut out = String::new();
+    for b in s.bytes() {
+        match b {
+            b'"' => out.push_str("\\\""),
+            b'\\' => out.push_str("\\\\"),
+            b'?' => out.push_str("\\?"),
+            0x20..=0x7e => out.push(b as char),
+            _ => {
+                let _ = write!(out, "\\{:03o}", b);
+            }
+        }
+    }
+    out
+}
+
+fn to_snake_case(s: &str) -> String {
+    let mut out = String::new();
+    let mut prev_lower = false;
+    for c in s.chars() {
+        if c.is_ascii_uppercase() {
+            if prev_lower {
+                out.push('_');
+            }
+            out.push(c.to_ascii_lowercase());
+            prev_lower = false;
+        } else {
+            out.push(c);
+            prev_lower = c.is_ascii_lowercase() || c.is_ascii_digit();
+        }
+    }
+    c_identifier(&out)
+}
+
+/// Cursor, key lookup and event helpers shared by every parser.
+const RUNTIME: &str = r#"/* Position in the event stream. */
+typedef struct Cursor {
+    StyxEventReader *reader;
+    StyxEvent ev;
+    ERROR_TYPE *error;
+} Cursor;
+
+/* One slot of a perfect hash table: a name and its index. */
+typedef struct Slot {
+    const char *name;
+    size_t len;
+    int index;
+} Slot;
+
+/* Hash-and-displace table: `seed` picks a bucket, whose seed picks a slot. */
+typedef struct Table {
+    const Slot *slots;
+    const uint32_t *buckets;
+    uint32_t seed;
+    uint32_t bucket_mask;
+    uint32_t slot_mask;
+} Table;
+
+static bool fail(Cursor *c, const char *message) {
+    if (c->error) {
+        snprintf(c->error->message, sizeof c->error->message, "%s", message);
+        c->error->span_start = c->ev.span_start;
+        c->error->span_end = c->ev.span_end;
+    }
+    return false;
+}
+
+/* Report the parse error in the current ERROR event. */
+static bool parse_error(Cursor *c) {
+    if (c->error) {
+        snprintf(c->error->message, sizeof c->error->message, "%.*s", (int)c->ev.text.len,
+                 c->ev.text.ptr ? c->ev.text.ptr : "");
+        c->error->span_start = c->ev.span_start;
+        c->error->span_end = c->ev.span_end;
+    }
+    return false;
+}
+
+/* Advance to the next event, skipping comments. */
+static bool next(Cursor *c) {
+    while (styx_reader_next(c->reader, &c->ev)) {
+        switch (c->ev.kind) {
+        case STYX_EVENT_COMMENT:
+        case STYX_EVENT_DOC_COMMENT:
+            break;
+        case STYX_EVENT_ERROR:
+            return parse_error(c);
+        default:
+            return true;
+        }
+    }
+    return fail(c, "unexpected end of input");
+}
+
+/* Skip the value that starts at the current event. */
+static bool skip(Cursor *c) {
+    size_t depth = 0;
+    for (;;) {
+        switch (c->ev.kind) {
+        case STYX_EVENT_OBJECT_START:
+        case STYX_EVENT_SEQUENCE_START:
+        case STYX_EVENT_ENTRY_START:
+        case STYX_EVENT_TAG_START:
+            depth++;
+            break;
+        case STYX_EVENT_OBJECT_END:
+        case STYX_EVENT_SEQUENCE_END:
+        case STYX_EVENT_ENTRY_END:
+        case STYX_EVENT_TAG_END:
+            depth--;
+            break;
+        default:
+            break;
+        }
+        if (depth == 0) {
+            return true;
+        }
+        if (!next(c)) {
+            return false;
+        }
+    }
+}
+
+/* Read the remaining events, which may still report an error. */
+static bool drain(Cursor *c) {
+    while (styx_reader_next(c->reader, &c->ev)) {
+        if (c->ev.kind == STYX_EVENT_ERROR) {
+            return parse_error(c);
+        }
+    }
+    return true;
+}
+
+/* FNV-1a with a final mix; must match the generator. */
+static uint32_t hash(uint32_t seed, StyxStr key) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < key.len; i++) {
+        h = (h ^ (unsigned char)key.ptr[i]) * 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    return h ^ (h >> 15);
+}
+
+/* Index of `key` in the table, or -1. */
+static int lookup(const Table *table, StyxStr key) {
+    uint32_t bucket = hash(table->seed, key) & table->bucket_mask;
+    const Slot *slot = &table->slots[hash(table->buckets[bucket], key) & table->slot_mask];
+    if (slot->name && slot->len == key.len &&
+        (key.len == 0 || memcmp(slot->name, key.ptr, key.len) == 0)) {
+        return slot->index;
+    }
+    return -1;
+}
+
+"#;
+
+/// Scalar helpers, emitted only when some field needs them.
+const HELPERS: &[(&str, &str)] = &[
+    (
+        "copy_string",
+        r#"/* Replace `*out` with a null-terminated copy of `len` bytes. */
+static bool copy_string(Cursor *c, char **out, const char *text, size_t len) {
+    char *s = (char *)malloc(len + 1);
+    if (!s) {
+        return fail(c, "out of memory");
+    }
+    if (len) {
+        memcpy(s, text, len);
+    }
+    s[len] = '\0';
+    free(*out);
+    *out = s;
+    return true;
+}
+
+"#,
+    ),
+    (
+        "read_string",
+        r#"static bool read_string(Cursor *c, char **out) {
+    if (c->ev.kind != STYX_EVENT_SCALAR) {
+        return fail(c, "expected a string");
+    }
+    return copy_string(c, out, c->ev.text.ptr, c->ev.text.len);
+}
+
+"#,
+    ),
+    (
+        "scalar_text",
+        r#"/* Copy a numeric-looking scalar into `buf` for strtoll. */
+static bool scalar_text(Cursor *c, char *buf, size_t size) {
+    size_t len = c->ev.text.len;
+    if (c->ev.kind != STYX_EVENT_SCALAR || len == 0 || len >= size) {
+        return false;
+    }
+    memcpy(buf, c->ev.text.ptr, len);
+    buf[len] = '\0';
+    return buf[0] == '-' || buf[0] == '+' || buf[0] == '.' || (buf[0] >= '0' && buf[0] <= '9');
+}
+
+"#,
+    ),
+    (
+        "read_i64",
+        r#"static bool read_i64(Cursor *c, int64_t *out) {
+    char buf[32];
+    char *end;
+    long long value;
+    if (!scalar_text(c, buf, sizeof buf)) {
+        return fail(c, "expected an integer");
+    }
+    errno = 0;
+    value = strtoll(buf, &end, 10);
+    if (*end != '\0') {
+        return fail(c, "expected an integer");
+    }
+    if (errno == ERANGE) {
+        return fail(c, "integer out of range");
+    }
+    *out = (int64_t)value;
+    return true;
+}
+
+"#,
+    ),
+    (
+        "read_f64",
+        r#"/* styx_str_as_f64 rather than strtod, which follows the C locale. */
+static bool read_f64(Cursor *c, double *out) {
+    if (c->ev.kind != STYX_EVENT_SCALAR) {
+        return fail(c, "expected a number");
+    }
+    switch (styx_str_as_f64(c->ev.text, out)) {
+    case STYX_SCALAR_STATUS_OK:
+        return true;
+    case STYX_SCALAR_STATUS_OUT_OF_RANGE:
+        return fail(c, "number out of range");
+    default:
+        return fail(c, "expected a number");
+    }
+}
+
+"#,
+    ),
+    (
+        "read_bool",
+        r#"static bool read_bool(Cursor *c, bool *out) {
+    StyxStr text = c->ev.text;
+    if (c->ev.kind == STYX_EVENT_SCALAR && text.len == 4 && memcmp(text.ptr, "true", 4) == 0) {
+        *out = true;
+        return true;
+    }
+    if (c->ev.kind == STYX_EVENT_SCALAR && text.len == 5 && memcmp(text.ptr, "false", 5) == 0) {
+        *out = false;
+        return true;
+    }
+    return fail(c, "expected `true` or `false`");
+}
+
+"#,
+    ),
+];
+
+/// `<prefix>_parse` and `<prefix>_load_file`.
+const ENTRY_POINTS: &str = r#"bool PREFIX_parse(const char *source, size_t len, ROOT_TYPE *out, ERROR_TYPE *error) {
+    Cursor c;
+    ROOT_TYPESeen seen;
+    bool ok;
+
+    memset(&c, 0, sizeof c);
+    memset(&seen, 0, sizeof seen);
+    memset(out, 0, sizeof *out);
+    if (error) {
+        memset(error, 0, sizeof *error);
+    }
+    c.error = error;
+    c.reader = styx_reader_new(source, len, 0);
+    if (!c.reader) {
+        return fail(&c, "source is not valid UTF-8");
+    }
+    /* DOCUMENT_START, then the root OBJECT_START. */
+    ok = next(&c) && next(&c) && parse_ROOT_SNAKE(&c, out, &seen) &&
+         finish_ROOT_SNAKE(&c, out, &seen) && drain(&c);
+    styx_reader_free(c.reader);
+    if (!ok) {
+        PREFIX_ROOT_SNAKE_free(out);
+    }
+    return ok;
+}
+
+bool PREFIX_load_file(const char *path, ROOT_TYPE *out, ERROR_TYPE *error) {
+    FILE *file = fopen(path, "rb");
+    char *data = NULL;
+    long size = -1;
+    bool ok = false;
+
+    if (file && fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = (char *)malloc((size_t)size + 1);
+    }
+    if (data && fread(data, 1, (size_t)size, file) == (size_t)size) {
+        ok = PREFIX_parse(data, (size_t)size, out, error);
+    } else {
+        Cursor c;
+        memset(&c, 0, sizeof c);
+        memset(out, 0, sizeof *out);
+        c.error = error;
+        fail(&c, "cannot read file");
+    }
+    free(data);
+    if (file) {
+        fclose(file);
+    }
+    return ok;
+}
+"#;
+
+impl From<std::fmt::Error> for GenError {
+    fn from(_: std::fmt::Error) -> Self {
+        GenError::Format("formatting error".into())
+    }
+}
@@ -0,0 +1,151 @@
+//! Perfect hashing of field and variant names.
+//!
+//! Generated deserializers look keys up with hash-and-displace: a first hash
+//! picks a bucket, the bucket's seed rehashes the key into a slot, and the
+//! name stored in that slot is compared once. Seeds are searched for at
+//! generation time so that every name gets its own slot, and the table is
+//! at most about twice the number of names.
+
+/// A collision-free table for a fixed set of names.
+#[derive(Debug)]
+pub struct PerfectHash {
+    /// Seed of the bucket hash.
+    pub seed: u32,
+    /// For each bucket, the seed of the slot hash.
+    pub buckets: Vec<u32>,
+    /// For each slot, the index of the name stored there.
+    pub slots: Vec<Option<usize>>,
+}
+
+impl PerfectHash {
+    /// Find seeds that place every name in a distinct slot.
+    pub fn build(names: &[&str]) -> Self {
+        let n = names.len().max(1);
+        let size = (n + n / 2).next_power_of_two();
+        let bucket_count = n.div_ceil(4).next_power_of_two();
+        let mut attempt = 0u32;
+        loop {
+            let seed = derive_seed(attempt);
+            if let Some((buckets, slots)) = displace(names, seed, bucket_count, size) {
+                return PerfectHash {
+                    seed,
+                    buckets,
+                    slots,
+                };
+            }
+            attempt += 1;
+        }
+    }
+
+    /// Slot of `name` in the table (which may hold a different name).
+    #[cfg(test)]
+    pub fn slot(&self, name: &str) -> usize {
+        let bucket = hash(self.seed, name.as_bytes()) & self.bucket_mask();
+        (hash(self.buckets[bucket as usize], name.as_bytes()) & self.slot_mask()) as usize
+    }
+
+    /// The mask applied to the first hash to get a bucket.
+    pub fn bucket_mask(&self) -> u32 {
+        (self.buckets.len() - 1) as u32
+    }
+
+    /// The mask applied to the second hash to get a slot.
+    pub fn slot_mask(&self) -> u32 {
+        (self.slots.len() - 1) as u32
+    }
+}
+
+/// Displacements tried per bucket before picking a new first-level seed.
+const DISPLACEMENTS: u32 = 1 << 12;
+const FNV_OFFSET: u32 = 0x811c_9dc5;
+const FNV_PRIME: u32 = 0x0100_0193;
+
+fn derive_seed(i: u32) -> u32 {
+    FNV_OFFSET ^ i.wrapping_mul(0x9e37_79b9)
+}
+
+/// Place the biggest buckets first, giving each the first seed that sends
+/// all of its names to free slots.
+fn displace(
+    names: &[&str],
+    seed: u32,
+    bucket_count: usize,
+    size: usize,
+) -> Option<(Vec<u32>, Vec<Option<usize>>)> {
+    let mut members: Vec<Vec<usize>> = vec![Vec::new(); bucket_count];
+    for (index, name) in names.iter().enumerate() {
+        members[(hash(seed, name.as_bytes()) as usize) & (bucket_count - 1)].push(index);
+    }
+    let mut order: Vec<usize> = (0..bucket_count).collect();
+    order.sort_by_key(|&b| std::cmp::Reverse(members[b].len()));
+
+    let mut buckets = vec![derive_seed(0); bucket_count];
+    let mut slots = vec![None; size];
+    let mut taken = Vec::new();
+    for b in order {
+        if members[b].is_empty() {
+            break;
+        }
+        let placed = (0..DISPLACEMENTS).map(derive_seed).find(|&d| {
+            taken.clear();
+            members[b].iter().all(|&index| {
+                let slot = (hash(d, names[index].as_bytes()) as usize) & (size - 1);
+                if slots[slot].is_some() || taken.contains(&slot) {
+                    return false;
+                }
+                taken.push(slot);
+                true
+            })
+        })?;
+        buckets[b] = placed;
+        for (&index, &slot) in members[b].iter().zip(&taken) {
+            slots[slot] = Some(index);
+        }
+    }
+    Some((buckets, slots))
+}
+
+/// FNV-1a from `seed`, with a final mix so the low bits used for slots
+/// depend on every bit of the name. The generated C `hash` function must
+/// match it.
+pub fn hash(seed: u32, bytes: &[u8]) -> u32 {
+    let mut h = bytes
+        .iter()
+        .fold(seed, |h, &b| (h ^ b as u32).wrapping_mul(FNV_PRIME));
+    h ^= h >> 16;
+    h = h.wrapping_mul(0x7feb_352d);
+    h ^ (h >> 15)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn assert_perfect(names: &[&str]) -> PerfectHash {
+        let table = PerfectHash::build(names);
+        assert!(table.slots.len().is_power_of_two());
+        assert!(table.buckets.len().is_power_of_two());
+        for (index, name) in names.iter().enumerate() {
+            assert_eq!(table.slots[table.slot(name)], Some(index), "{name}");
+        }
+        table
+    }
+
+    #[test]
+    fn test_every_name_has_its_own_slot() {
+        assert_perfect(&[]);
+        assert_perfect(&["host"]);
+        assert_perfect(&["host", "port", "timeout", "tls", "tags"]);
+        assert_perfect(&["a", "b", "ab", "ba", "", "aa"]);
+    }
+
+    #[test]
+    fn test_tables_stay_small() {
+        for n in [10usize, 64, 200, 1000] {
+            let names: Vec<String> = (0..n).map(|i| format!("field_{i}")).collect();
+            let names: Vec<&str> = names.iter().map(String::as_str).collect();
+            let table = assert_perfect(&names);
+            assert!(table.slots.len() <= 2 * n.next_power_of_two(), "{n}");
+        }
+    }
+}
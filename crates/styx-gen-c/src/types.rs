@@ -0,0 +1,282 @@
+//! Type mapping from Styx schemas to C types.
+
+use crate::error::GenError;
+use facet_styx::{EnumSchema, ObjectSchema, Schema};
+use std::collections::BTreeMap;
+
+/// A named C type representation.
+#[derive(Debug, Clone)]
+pub enum CType {
+    /// A struct type
+    Struct {
+        fields: Vec<StructField>,
+        doc: Option<String>,
+    },
+    /// An enum type (matched against variant tags)
+    Enum {
+        variants: Vec<EnumVariant>,
+        doc: Option<String>,
+    },
+    /// Another name for a field type (e.g. `Port @int`)
+    Alias(FieldType),
+}
+
+/// The type of a struct field or sequence item.
+#[derive(Debug, Clone, PartialEq)]
+pub enum FieldType {
+    /// `char *`, heap-allocated and null-terminated
+    String,
+    /// `int64_t`
+    Int,
+    /// `double`
+    Float,
+    /// `bool`
+    Bool,
+    /// `bool`, set when the key is present
+    Unit,
+    /// A registered struct, enum or alias, by schema name
+    Named(String),
+    /// `T *` plus a `_len` count
+    Seq(Box<FieldType>),
+    /// Not representable; the value is skipped while parsing
+    Unsupported(&'static str),
+}
+
+/// What happens when a field's key is absent.
+#[derive(Debug, Clone, PartialEq)]
+pub enum Presence {
+    /// Parsing fails
+    Required,
+    /// The field's `has_` flag stays false
+    Optional,
+    /// The default from the schema, as Styx source text, is filled in
+    Default(String),
+}
+
+/// A field in a C struct.
+#[derive(Debug, Clone)]
+pub struct StructField {
+    /// C member name
+    pub c_name: String,
+    /// Styx field name (original)
+    pub styx_name: String,
+    /// Field type
+    pub ty: FieldType,
+    /// Behaviour when the key is missing
+    pub presence: Presence,
+    /// Field documentation
+    pub doc: Option<String>,
+}
+
+/// An enum variant.
+#[derive(Debug, Clone)]
+pub struct EnumVariant {
+    /// Variant name
+    pub name: String,
+    /// Variant documentation
+    pub doc: Option<String>,
+}
+
+/// Maps Styx schema types to C types.
+pub struct TypeMapper {
+    types: BTreeMap<String, CType>,
+}
+
+impl TypeMapper {
+    pub fn new() -> Self {
+        Self {
+            types: BTreeMap::new(),
+        }
+    }
+
+    /// Register a named type from the schema.
+    pub fn register_type(&mut self, name: &str, schema: &Schema) -> Result<(), GenError> {
+        let name = to_pascal_case(name);
+        let c_type = self.map_named(&name, schema)?;
+        self.types.insert(name, c_type);
+        Ok(())
+    }
+
+    /// Get all registered types, sorted by name.
+    pub fn types(&self) -> &BTreeMap<String, CType> {
+        &self.types
+    }
+
+    /// Map the schema of a named type.
+    fn map_named(&mut self, name: &str, schema: &Schema) -> Result<CType, GenError> {
+        match schema {
+            Schema::Object(obj_schema) => self.map_object(name, obj_schema),
+            Schema::Enum(enum_schema) => Ok(map_enum(enum_schema)),
+            Schema::Default(default_schema) => self.map_named(name, default_schema.0.1.value()),
+            Schema::Deprecated(depr_schema) => self.map_named(name, depr_schema.0.1.value()),
+            other => Ok(CType::Alias(self.field_type(name, other)?)),
+        }
+    }
+
+    /// Map an object schema to a struct. Fields are sorted by name so the
+    /// layout does not depend on map iteration order.
+    fn map_object(&mut self, name: &str, obj_schema: &ObjectSchema) -> Result<CType, GenError> {
+        let mut fields = Vec::new();
+        for (documented_key, field_schema) in &obj_schema.0 {
+            // Catch-all keys (`@` or `@string`) have no field to fill.
+            let key = documented_key.value();
+            if let Some(field_name) = &key.value {
+                let field_doc = documented_key.doc.as_ref().map(|lines| {
+                    lines
+                        .iter()
+                        .map(|line| line.strip_prefix(' ').unwrap_or(line))
+                        .collect::<Vec<_>>()
+                        .join(" ")
+                });
+                fields.push(self.map_field(name, field_name, field_schema, field_doc)?);
+            }
+        }
+        fields.sort_by(|a, b| a.styx_name.cmp(&b.styx_name));
+        Ok(CType::Struct { fields, doc: None })
+    }
+
+    /// Map a field to a struct field, registering nested types as needed.
+    fn map_field(
+        &mut self,
+        parent_name: &str,
+        field_name: &str,
+        schema: &Schema,
+        doc: Option<String>,
+    ) -> Result<StructField, GenError> {
+        // Unwrap Default, Optional and Deprecated wrappers to find the core type
+        let mut current = schema;
+        let mut presence = Presence::Required;
+
+        loop {
+            match current {
+                Schema::Default(default_schema) => {
+                    presence = Presence::Default(default_schema.0.0.as_str().to_string());
+                    current = default_schema.0.1.value();
+                }
+                Schema::Optional(opt_schema) => {
+                    if presence == Presence::Required {
+                        presence = Presence::Optional;
+                    }
+                    current = opt_schema.0.0.value();
+                }
+                Schema::Deprecated(depr_schema) => {
+                    current = depr_schema.0.1.value();
+                }
+                _ => break,
+            }
+        }
+
+        // Inline objects and enums become named types after their field
+        let nested_type_name = format!("{}{}", parent_name, to_pascal_case(field_name));
+        let ty = self.field_type(&nested_type_name, current)?;
+
+        Ok(StructField {
+            c_name: c_identifier(field_name),
+            styx_name: field_name.to_string(),
+            ty,
+            presence,
+            doc,
+        })
+    }
+
+    /// Map a schema to a field type. Inline objects and enums are registered
+    /// under `name`.
+    fn field_type(&mut self, name: &str, schema: &Schema) -> Result<FieldType, GenError> {
+        match schema {
+            Schema::String(_) | Schema::Literal(_) => Ok(FieldType::String),
+            Schema::Int(_) => Ok(FieldType::Int),
+            Schema::Float(_) => Ok(FieldType::Float),
+            Schema::Bool => Ok(FieldType::Bool),
+            Schema::Unit => Ok(FieldType::Unit),
+            Schema::Object(obj_schema) => {
+                if !self.types.contains_key(name) {
+                    let nested_type = self.map_object(name, obj_schema)?;
+                    self.types.insert(name.to_string(), nested_type);
+                }
+                Ok(FieldType::Named(name.to_string()))
+            }
+            Schema::Enum(enum_schema) => {
+                if !self.types.contains_key(name) {
+                    self.types.insert(name.to_string(), map_enum(enum_schema));
+                }
+                Ok(FieldType::Named(name.to_string()))
+            }
+            Schema::Seq(seq_schema) => {
+                let item_name = format!("{}Item", name);
+                match self.field_type(&item_name, seq_schema.0.0.value())? {
+                    FieldType::Seq(_) => Ok(FieldType::Unsupported("nested sequences")),
+                    FieldType::Unit => Ok(FieldType::Unsupported("sequences of units")),
+                    item => Ok(FieldType::Seq(Box::new(item))),
+                }
+            }
+            Schema::OneOf(one_of_schema) => self.field_type(name, one_of_schema.0.0.value()),
+            Schema::Default(default_schema) => self.field_type(name, default_schema.0.1.value()),
+            Schema::Deprecated(depr_schema) => self.field_type(name, depr_schema.0.1.value()),
+            Schema::Type { name: Some(n) } => Ok(FieldType::Named(to_pascal_case(n))),
+            Schema::Type { name: None } | Schema::Any => Ok(FieldType::Unsupported("@any values")),
+            Schema::Tuple(_) => Ok(FieldType::Unsupported("tuples")),
+            Schema::Map(_) => Ok(FieldType::Unsupported("maps")),
+            Schema::Union(_) => Ok(FieldType::Unsupported("unions")),
+            Schema::Flatten(_) => Ok(FieldType::Unsupported("flattened fields")),
+            Schema::Optional(_) => Ok(FieldType::Unsupported("nested optionals")),
+        }
+    }
+}
+
+fn map_enum(enum_schema: &EnumSchema) -> CType {
+    let mut variants: Vec<EnumVariant> = enum_schema
+        .0
+        .keys()
+        .map(|documented_name| EnumVariant {
+            name: documented_name.value().clone(),
+            doc: documented_name.doc().map(|lines| {
+                lines
+                    .iter()
+                    .map(|line| line.strip_prefix(' ').unwrap_or(line))
+                    .collect::<Vec<_>>()
+                    .join(" ")
+            }),
+        })
+        .collect();
+    variants.sort_by(|a, b| a.name.cmp(&b.name));
+    CType::Enum {
+        variants,
+        doc: None,
+    }
+}
+
+/// Turn a Styx name into a valid C identifier.
+pub fn c_identifier(name: &str) -> String {
+    let mut ident: String = name
+        .chars()
+        .map(|c| if c.is_ascii_alphanumeric() { c } else { '_' })
+        .collect();
+    if ident.is_empty() || ident.starts_with(|c: char| c.is_ascii_digit()) {
+        ident.insert(0, '_');
+    }
+    if C_KEYWORDS.contains(&ident.as_str()) {
+        ident.push('_');
+    }
+    ident
+}
+
+const C_KEYWORDS: &[&str] = &[
+    "auto", "bool", "break", "case", "char", "const", "continue", "default", "delete", "do",
+    "double", "else", "enum", "extern", "false", "float", "for", "goto", "if", "inline", "int",
+    "long", "new", "register", "restrict", "return", "short", "signed", "sizeof", "static",
+    "struct", "switch", "template", "this", "true", "typedef", "union", "unsigned", "void",
+    "volatile", "while",
+];
+
+pub fn to_pascal_case(s: &str) -> String {
+    s.split(['_', '-'])
+        .filter(|s| !s.is_empty())
+        .map(|word| {
+            let mut chars = word.chars();
+            match chars.next() {
+                None => String::new(),
+                Some(first) => first.to_uppercase().chain(chars).collect(),
+            }
+        })
+        .collect()
+}
@@ -0,0 +1,164 @@
+//! Generate C for a small schema, compile it with `-Wall -Wextra -Werror`
+//! against the styx-ffi library and run it on sample documents.
+//!
+//! Needs a C compiler (`$CC`, default `cc`) and `libstyx_ffi.a`, from
+//! `cargo build -p styx-ffi`. The library is looked up in
+//! `$STYX_FFI_LIB_DIR`, then in the workspace's `target/debug` and
+//! `target/release`. Without `STYX_FFI_LIB_DIR` the test is skipped when
+//! either is missing; with it, that is a failure.
+
+#![cfg(unix)]
+
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+const SCHEMA: &str = r#"meta {
+    id https://example.com/gen-c-test
+}
+schema {
+    @ @object{
+        name @string
+        port @default(8080 @int)
+        debug @default(false @bool)
+        level @optional(@enum{debug @unit, info @unit, warn @unit})
+        ratio @optional(@float)
+        server @object{
+            host @string
+            weights @optional(@seq(@float))
+        }
+        tags @optional(@seq(@string))
+    }
+}
+"#;
+
+/// Parses each sample with the generated code and prints what it read.
+const DRIVER: &str = r##"#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app.h"
+
+static const char *const levels[] = {"debug", "info", "warn"};
+
+static void run(const char *source) {
+    AppRoot root;
+    AppError error;
+    /* Floats must not follow a locale whose decimal separator is a comma. */
+    if (!setlocale(LC_NUMERIC, "de_DE.UTF-8")) {
+        setlocale(LC_NUMERIC, "fr_FR.UTF-8");
+    }
+    bool ok = app_parse(source, strlen(source), &root, &error);
+    setlocale(LC_NUMERIC, "C");
+    if (!ok) {
+        printf("error %u-%u: %s\n", error.span_start, error.span_end, error.message);
+        return;
+    }
+    printf("name=%s port=%lld debug=%d", root.name, (long long)root.port, root.debug);
+    printf(" level=%s", root.has_level ? levels[root.level] : "-");
+    if (root.has_ratio) {
+        printf(" ratio=%.17g", root.ratio);
+    } else {
+        printf(" ratio=-");
+    }
+    printf(" host=%s weights=", root.server.host);
+    for (size_t i = 0; i < root.server.weights_len; i++) {
+        printf("%s%.17g", i ? "," : "", root.server.weights[i]);
+    }
+    printf(" tags=");
+    for (size_t i = 0; i < root.tags_len; i++) {
+        printf("%s%s", i ? "," : "", root.tags[i]);
+    }
+    printf("\n");
+    app_root_free(&root);
+}
+
+int main(void) {
+    run("name api\nserver {host localhost}");
+    run("name \"my app\"\nport 9090\ndebug true\nlevel warn\nratio 0.25\n"
+        "server {host example.com, weights (0.5 1e300 -2.5e-3)}\ntags (a \"b c\" d)");
+    run("name x\nratio 5e-324\nserver.host h\nextra {ignored (1 2)}");
+    run("name x\nratio 1e400\nserver {host h}");
+    run("name x\nport 1.5\nserver {host h}");
+    run("name x\nlevel loud\nserver {host h}");
+    run("name x");
+    run("server {host h}\nname {nested 1}");
+    run("name x\nserver {host h");
+    return 0;
+}
+"##;
+
+const EXPECTED: &str = "\
+name=api port=8080 debug=0 level=- ratio=- host=localhost weights= tags=
+name=my app port=9090 debug=1 level=warn ratio=0.25 host=example.com weights=0.5,1.0000000000000001e+300,-0.0025000000000000001 tags=a,b c,d
+name=x port=8080 debug=0 level=- ratio=4.9406564584124654e-324 host=h weights= tags=
+error 13-18: number out of range
+error 12-15: expected an integer
+error 13-17: expected a variant of AppRootLevel
+error 0-0: missing field `server` in AppRoot
+error 21-31: expected a string
+error 14-15: unclosed object (missing `}`)
+";
+
+/// `libstyx_ffi.a`, or `None` if it has not been built and no directory
+/// was given.
+fn ffi_library() -> Option<PathBuf> {
+    if let Some(dir) = std::env::var_os("STYX_FFI_LIB_DIR") {
+        let lib = Path::new(&dir).join("libstyx_ffi.a");
+        assert!(lib.exists(), "{} not found", lib.display());
+        return Some(lib);
+    }
+    let target = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../target");
+    ["debug", "release"]
+        .iter()
+        .map(|profile| target.join(profile).join("libstyx_ffi.a"))
+        .find(|lib| lib.exists())
+}
+
+#[test]
+fn test_generated_c_compiles_and_parses() {
+    let Some(lib) = ffi_library() else {
+        eprintln!("skipped: build styx-ffi first or set STYX_FFI_LIB_DIR");
+        return;
+    };
+    let cc = std::env::var("CC").unwrap_or_else(|_| "cc".to_string());
+    if Command::new(&cc).arg("--version").output().is_err() {
+        assert!(
+            std::env::var_os("STYX_FFI_LIB_DIR").is_none(),
+            "no C compiler `{cc}`"
+        );
+        eprintln!("skipped: no C compiler `{cc}`");
+        return;
+    }
+
+    let dir = std::env::temp_dir().join(format!("styx-gen-c-test-{}", std::process::id()));
+    let _ = std::fs::remove_dir_all(&dir);
+    std::fs::create_dir_all(&dir).unwrap();
+    let schema: facet_styx::SchemaFile = facet_styx::from_str(SCHEMA).unwrap();
+    styx_gen_c::generate(&schema, "app", dir.to_str().unwrap()).unwrap();
+    std::fs::write(dir.join("main.c"), DRIVER).unwrap();
+
+    let include = Path::new(env!("CARGO_MANIFEST_DIR")).join("../styx-ffi/include");
+    let exe = dir.join("main");
+    let compiled = Command::new(&cc)
+        .args(["-std=c11", "-Wall", "-Wextra", "-Werror", "-I"])
+        .arg(&include)
+        .arg("-I")
+        .arg(&dir)
+        .arg(dir.join("main.c"))
+        .arg(dir.join("app.c"))
+        .arg(&lib)
+        .args(["-lpthread", "-ldl", "-lm", "-o"])
+        .arg(&exe)
+        .output()
+        .unwrap();
+    assert!(
+        compiled.status.success(),
+        "{}",
+        String::from_utf8_lossy(&compiled.stderr)
+    );
+
+    let run = Command::new(&exe).output().unwrap();
+    assert!(run.status.success());
+    assert_eq!(String::from_utf8_lossy(&run.stdout), EXPECTED);
+    std::fs::remove_dir_all(&dir).unwrap();
+}
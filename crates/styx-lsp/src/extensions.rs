@@ -373,7 +373,7 @@ impl StyxLspHost for StyxLspHostImpl {
         for key in &params.path {
             let obj = current.as_object()?;
             let entry = obj
-                .entries
+                .entries()
                 .iter()
                 .find(|e| e.key.as_str() == Some(key.as_str()))?;
             current = &entry.value;
@@ -134,7 +134,7 @@ pub struct ResolvedSchema {
 pub fn find_schema_declaration(value: &Value) -> Option<SchemaRef> {
     let obj = value.as_object()?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.is_schema_tag() {
             // @schema @ (explicit opt-out)
             if entry.value.is_unit() {
@@ -197,17 +197,17 @@ fn load_schema_file(path: &Path) -> Result<SchemaFile, String> {
 pub fn strip_schema_declaration(value: &Value) -> Value {
     if let Some(obj) = value.as_object() {
         let filtered_entries: Vec<_> = obj
-            .entries
+            .entries()
             .iter()
             .filter(|e| !e.key.is_schema_tag())
             .cloned()
             .collect();
         Value {
             tag: value.tag.clone(),
-            payload: Some(styx_tree::Payload::Object(styx_tree::Object {
-                entries: filtered_entries,
-                span: obj.span,
-            })),
+            payload: Some(styx_tree::Payload::Object(styx_tree::Object::new(
+                filtered_entries,
+                obj.span,
+            ))),
             span: value.span,
         }
     } else {
@@ -329,7 +329,7 @@ pub fn find_value_by_path<'a>(value: &'a Value, path: &str) -> Option<&'a Value>
     }
 
     // Find the entry with matching key
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if let Some(key_str) = entry.key.as_str()
             && key_str == segment
         {
@@ -470,7 +470,7 @@ pub fn load_document_schema(value: &Value, document_uri: &Url) -> Result<SchemaF
 pub fn get_document_fields(value: &Value) -> Vec<String> {
     let mut fields = Vec::new();
     if let Some(obj) = value.as_object() {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(name) = entry.key.as_str() {
                 fields.push(name.to_string());
             }
@@ -527,7 +527,7 @@ fn find_tagged_context_recursive(
 
     // Check payload for nested values
     if let Some(styx_tree::Payload::Object(obj)) = &value.payload {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(result) = find_tagged_context_recursive(&entry.value, offset, new_tagged) {
                 return Some(result);
             }
@@ -536,7 +536,7 @@ fn find_tagged_context_recursive(
 
     // Also check if the value itself is an object (for root objects without payload)
     if let Some(obj) = value.as_object() {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(result) = find_tagged_context_recursive(&entry.value, offset, new_tagged) {
                 return Some(result);
             }
@@ -569,7 +569,7 @@ fn find_object_at_offset_recursive(
         return None;
     }
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if let Some(val_span) = entry.value.span
             && offset >= val_span.start as usize
             && offset <= val_span.end as usize
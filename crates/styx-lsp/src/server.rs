@@ -997,7 +997,7 @@ impl LanguageServer for StyxLanguageServer {
             .as_ref()
             .map(|c| {
                 c.object
-                    .entries
+                    .entries()
                     .iter()
                     .filter_map(|e| e.key.as_str().map(|s| s.to_string()))
                     .collect()
@@ -1430,7 +1430,7 @@ impl LanguageServer for StyxLanguageServer {
                         let fields = get_schema_fields_at_path(&schema_file, &ctx.path);
                         let existing: Vec<String> = ctx
                             .object
-                            .entries
+                            .entries()
                             .iter()
                             .filter_map(|e| e.key.as_str().map(String::from))
                             .collect();
@@ -2052,7 +2052,7 @@ fn collect_document_symbols(value: &Value, content: &str) -> Vec<DocumentSymbol>
         return symbols;
     };
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         // Skip the @ (schema declaration)
         if entry.key.is_unit() {
             continue;
@@ -2132,7 +2132,7 @@ fn collect_document_symbols(value: &Value, content: &str) -> Vec<DocumentSymbol>
 fn find_schema_declaration_range(tree: &Value, content: &str) -> Option<Range> {
     let obj = tree.as_object()?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.is_schema_tag() {
             let span = entry.value.span?;
             return Some(Range {
@@ -2226,7 +2226,7 @@ fn find_path_segments_at_offset(tree: &Value, offset: usize) -> Option<Vec<PathS
 fn find_path_in_value(value: &Value, offset: usize) -> Option<Vec<PathSegment>> {
     // Check if we're in an object
     if let Some(obj) = value.as_object() {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             // Check if cursor is on the key
             if let Some(span) = entry.key.span {
                 let start = span.start as usize;
@@ -2290,7 +2290,7 @@ fn find_field_in_schema_source(schema_source: &str, field_name: &str) -> Option<
     // Navigate to schema.@ (the root schema definition)
     let obj = tree.as_object()?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.as_str() == Some("schema") {
             // Found schema block
             // Structure: schema { @ @object { name @string } }
@@ -2303,7 +2303,7 @@ fn find_field_in_schema_source(schema_source: &str, field_name: &str) -> Option<
                     // unit_value should be @object{...} - an object with @object key
                     if let Some(inner_obj) = unit_value.as_object() {
                         // This object has an @object entry
-                        for inner_entry in &inner_obj.entries {
+                        for inner_entry in inner_obj.entries() {
                             if inner_entry.key.tag_name() == Some("object") {
                                 // Found @object - its value is the fields object
                                 return find_field_in_object(
@@ -2342,7 +2342,7 @@ fn find_field_in_object(value: &Value, source: &str, field_name: &str) -> Option
         return None;
     };
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.as_str() == Some(field_name) {
             // Found the field!
             if let Some(span) = entry.key.span {
@@ -2381,7 +2381,7 @@ fn get_schema_meta(schema_source: &str) -> Option<SchemaMeta> {
     let tree = styx_tree::parse(schema_source).ok()?;
     let obj = tree.as_object()?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.as_str() == Some("meta") {
             let meta_obj = entry.value.as_object()?;
 
@@ -2424,7 +2424,7 @@ fn get_field_info_from_schema(schema_source: &str, field_path: &[&str]) -> Optio
 
     // Find the schema block
     let schema_value = obj
-        .entries
+        .entries()
         .iter()
         .find(|e| e.key.as_str() == Some("schema"))
         .map(|e| &e.value)?;
@@ -2439,7 +2439,7 @@ fn get_field_info_in_schema(schema_block: &Value, path: &[&str]) -> Option<Field
 
     // Find the root schema (@ entry)
     let root = schema_obj
-        .entries
+        .entries()
         .iter()
         .find(|e| e.key.is_unit())
         .map(|e| &e.value)?;
@@ -2508,7 +2508,7 @@ fn get_field_info_in_type(
     // inside variant types (like @Query) to find nested fields (like `from`)
     if let Some(enum_obj) = extract_enum_object(value) {
         // Search all enum variants for the field
-        for entry in &enum_obj.entries {
+        for entry in enum_obj.entries() {
             // Resolve the variant's value type and recurse
             let resolved = resolve_type_reference(&entry.value, schema_defs);
             if let Some(info) = get_field_info_in_type(resolved, path, schema_defs) {
@@ -2521,7 +2521,7 @@ fn get_field_info_in_type(
     // Try to get the object - handle various wrappings (also resolves type refs)
     let obj = extract_object_from_value_with_defs(value, schema_defs)?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.as_str() == Some(field_name) {
             if remaining_path.is_empty() {
                 // This is the target field
@@ -2559,7 +2559,7 @@ fn resolve_type_reference<'a>(value: &'a Value, schema_defs: &'a styx_tree::Obje
 
         if is_type_ref {
             // Look for a definition with this name in schema_defs
-            for entry in &schema_defs.entries {
+            for entry in schema_defs.entries() {
                 if entry.key.as_str() == Some(&tag.name) {
                     return &entry.value;
                 }
@@ -2645,8 +2645,8 @@ fn extract_object_catchall_value_type(value: &Value) -> Option<&Value> {
     let obj = value.as_object()?;
 
     // Catch-all pattern: exactly one entry with a tagged key (like @string)
-    if obj.entries.len() == 1 {
-        let entry = &obj.entries[0];
+    if obj.entries().len() == 1 {
+        let entry = &obj.entries()[0];
         // Key must be tagged (e.g., @string), not a scalar
         if entry.key.tag.is_some() && entry.key.payload.is_none() {
             return Some(&entry.value);
@@ -2744,7 +2744,7 @@ fn format_type_concise(value: &Value) -> String {
                 result.push_str("{...}");
             } else {
                 // Count fields for a hint
-                let field_count = obj.entries.len();
+                let field_count = obj.entries().len();
                 result.push_str(&format!("{{...}} ({} fields)", field_count));
             }
         }
@@ -2853,7 +2853,7 @@ fn get_schema_fields_from_source_at_path(
 
     // Find the "schema" entry
     let schema_entry = obj
-        .entries
+        .entries()
         .iter()
         .find(|e| e.key.as_str() == Some("schema"));
     let Some(schema_entry) = schema_entry else {
@@ -2888,7 +2888,7 @@ fn navigate_schema_path<'a>(value: &'a Value, path: &[String]) -> Option<&'a Val
     // Get the object (unwrapping @object{...} if needed)
     let obj = extract_object_from_value(value)?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         // Check named fields
         if entry.key.as_str() == Some(field_name.as_str()) {
             // Found the field - unwrap any wrappers like @optional to get to the inner type
@@ -2924,7 +2924,7 @@ fn unwrap_type_wrappers(value: &Value) -> &Value {
             // @optional @object{...} - the object is the payload directly
             Some(styx_tree::Payload::Object(obj)) => {
                 // Check for unit entry pattern
-                for entry in &obj.entries {
+                for entry in obj.entries() {
                     if entry.key.is_unit() {
                         return unwrap_type_wrappers(&entry.value);
                     }
@@ -2949,7 +2949,7 @@ fn collect_fields_from_object(value: &Value, source: &str, fields: &mut Vec<(Str
         return;
     };
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         // If it's a named field (not @), add it
         if let Some(name) = entry.key.as_str()
             && let Some(span) = entry.value.span
@@ -2970,7 +2970,7 @@ fn get_existing_fields(tree: &Value) -> Vec<String> {
     let mut fields = Vec::new();
 
     if let Some(obj) = tree.as_object() {
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(name) = entry.key.as_str() {
                 fields.push(name.to_string());
             }
@@ -3052,7 +3052,7 @@ fn convert_styx_value_to_json(value: &styx_tree::Value) -> serde_json::Value {
     // Check for object
     if let Some(styx_tree::Payload::Object(obj)) = &value.payload {
         let mut map = serde_json::Map::new();
-        for entry in &obj.entries {
+        for entry in obj.entries() {
             if let Some(key) = entry.key.as_str() {
                 map.insert(key.to_string(), convert_styx_value_to_json(&entry.value));
             }
@@ -3136,10 +3136,7 @@ fn json_to_styx_value(json: &serde_json::Value) -> styx_tree::Value {
 
             Value {
                 tag: None,
-                payload: Some(Payload::Object(Object {
-                    entries,
-                    span: None,
-                })),
+                payload: Some(Payload::Object(Object::new(entries, None))),
                 span: None,
             }
         }
@@ -3189,7 +3186,7 @@ fn is_schema_file(tree: &Value) -> bool {
     let mut has_schema = false;
     let mut has_meta = false;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         match entry.key.as_str() {
             Some("schema") => has_schema = true,
             Some("meta") => has_meta = true,
@@ -3204,7 +3201,7 @@ fn is_schema_file(tree: &Value) -> bool {
 fn find_field_in_doc(tree: &Value, field_name: &str, content: &str) -> Option<Range> {
     let obj = tree.as_object()?;
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         if entry.key.as_str() == Some(field_name)
             && let Some(span) = entry.key.span
         {
@@ -3297,7 +3294,7 @@ fn generate_reorder_edit(
 
     // Collect document entries with their positions
     let mut doc_entries: Vec<(Option<usize>, &styx_tree::Entry)> = obj
-        .entries
+        .entries()
         .iter()
         .map(|e| {
             let order = e
@@ -3868,14 +3865,18 @@ schema {
 
         // Find the schema entry
         let schema_entry = obj
-            .entries
+            .entries()
             .iter()
             .find(|e| e.key.as_str() == Some("schema"))
             .unwrap();
         let schema_obj = schema_entry.value.as_object().unwrap();
 
         // Find the @ entry (unit key)
-        let unit_entry = schema_obj.entries.iter().find(|e| e.key.is_unit()).unwrap();
+        let unit_entry = schema_obj
+            .entries()
+            .iter()
+            .find(|e| e.key.is_unit())
+            .unwrap();
 
         // The value is @object{...} - check if it's an object with entries
         println!("unit_entry.value tag: {:?}", unit_entry.value.tag);
@@ -3886,7 +3887,7 @@ schema {
 
         // Navigate into the @object
         if let Some(inner_obj) = unit_entry.value.as_object() {
-            for entry in &inner_obj.entries {
+            for entry in inner_obj.entries() {
                 println!(
                     "Inner entry: key={:?}, tag={:?}, doc={:?}",
                     entry.key.as_str(),
@@ -3945,7 +3946,7 @@ schema {
         let tree = styx_tree::parse(schema_source).unwrap();
         let obj = tree.as_object().unwrap();
         let schema_entry = obj
-            .entries
+            .entries()
             .iter()
             .find(|e| e.key.as_str() == Some("schema"))
             .unwrap();
@@ -3956,7 +3957,7 @@ schema {
 
         // Look for syntax_highlight in the schema
         if let Some(inner_obj) = extract_object_from_value(&schema_entry.value) {
-            for entry in &inner_obj.entries {
+            for entry in inner_obj.entries() {
                 tracing::debug!(
                     key = ?entry.key.as_str(),
                     tag = ?entry.key.tag_name(),
@@ -3968,7 +3969,7 @@ schema {
                 if entry.key.is_unit() {
                     tracing::debug!(tag = ?entry.value.tag_name(), "unit value");
                     if let Some(l2_obj) = extract_object_from_value(&entry.value) {
-                        for l2_entry in &l2_obj.entries {
+                        for l2_entry in l2_obj.entries() {
                             tracing::debug!(
                                 key = ?l2_entry.key.as_str(),
                                 tag = ?l2_entry.key.tag_name(),
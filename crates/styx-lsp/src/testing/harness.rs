@@ -542,7 +542,7 @@ fn find_path_at_offset(tree: &Value, offset: usize) -> Option<Vec<String>> {
         }
 
         if let Some(obj) = value.as_object() {
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(key) = entry.key.as_str() {
                     // Check if cursor is in the value position (after key, potentially empty value)
                     let key_end = entry.key.span.as_ref().map(|s| s.end as usize).unwrap_or(0);
@@ -569,7 +569,7 @@ fn find_path_at_offset(tree: &Value, offset: usize) -> Option<Vec<String>> {
             && let Some(styx_tree::Payload::Object(obj)) = &value.payload
         {
             path.push(format!("@{}", tag.name));
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(key) = entry.key.as_str() {
                     // Same logic for tagged objects
                     let key_end = entry.key.span.as_ref().map(|s| s.end as usize).unwrap_or(0);
@@ -614,7 +614,7 @@ fn find_context_at_offset(tree: &Value, offset: usize) -> Option<Value> {
         // For tagged objects (like @query{...}), check if we're inside
         if let Some(styx_tree::Payload::Object(obj)) = &value.payload {
             // Check if cursor is in any child first
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(nested) = find_obj(&entry.value, offset, Some(value)) {
                     return Some(nested);
                 }
@@ -639,7 +639,7 @@ fn find_context_at_offset(tree: &Value, offset: usize) -> Option<Value> {
 
         // For untagged objects
         if let Some(obj) = value.as_object() {
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(nested) = find_obj(&entry.value, offset, Some(value)) {
                     return Some(nested);
                 }
@@ -705,7 +705,7 @@ fn find_tagged_context_at_offset(tree: &Value, offset: usize) -> Option<Value> {
 
         // Check payload for nested values
         if let Some(styx_tree::Payload::Object(obj)) = &value.payload {
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(result) = find_tagged(&entry.value, offset, new_tagged) {
                     return Some(result);
                 }
@@ -714,7 +714,7 @@ fn find_tagged_context_at_offset(tree: &Value, offset: usize) -> Option<Value> {
 
         // Also check if the value itself is an object (for root objects without payload)
         if let Some(obj) = value.as_object() {
-            for entry in &obj.entries {
+            for entry in obj.entries() {
                 if let Some(result) = find_tagged(&entry.value, offset, new_tagged) {
                     return Some(result);
                 }
@@ -364,6 +364,26 @@ impl<'src> Lexer<'src> {
             },
         }
     }
+
+    /// Skip the rest of an object whose `{` was just returned as
+    /// [`Lexeme::ObjectStart`], returning the span of its closing `}`.
+    ///
+    /// Only braces are matched; strings, heredocs and comments are still
+    /// tokenized so braces inside them don't count, but no lexemes are built.
+    /// Returns `None` if the input ends first.
+    pub fn skip_block(&mut self) -> Option<Span> {
+        let mut depth = 0usize;
+        loop {
+            let tok = self.next_token();
+            match tok.kind {
+                TokenKind::LBrace => depth += 1,
+                TokenKind::RBrace if depth == 0 => return Some(tok.span),
+                TokenKind::RBrace => depth -= 1,
+                TokenKind::Eof => return None,
+                _ => {}
+            }
+        }
+    }
 }
 
 impl<'src> Iterator for Lexer<'src> {
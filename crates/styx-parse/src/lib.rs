@@ -9,4 +9,4 @@ mod lexer;
 pub use lexer::{Lexeme, Lexer};
 
 mod parser;
-pub use parser::Parser;
+pub use parser::{Parser, ParserBuffers};
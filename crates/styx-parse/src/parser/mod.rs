@@ -47,6 +47,65 @@ pub struct Parser<'src> {
     source: LexemeSource<'src>,
     state: ParserState,
     event_queue: VecDeque<Event<'src>>,
+    /// Objects nested at least this deep inside atoms are skipped (see
+    /// [`Parser::new_shallow`]).
+    skip_depth: Option<u32>,
+    /// Number of object atoms currently being parsed.
+    object_depth: u32,
+    /// Cleared allocations to reuse instead of allocating.
+    spare: ParserBuffers,
+}
+
+/// Allocations that one [`Parser`] can hand on to the next.
+///
+/// Parsing many small documents allocates the same event queue, duplicate-key
+/// sets and path stack over and over. Take them back with
+/// [`Parser::into_buffers`] and pass them to [`Parser::with_buffers`] to
+/// parse the next document with the capacity already in place.
+#[derive(Clone, Default)]
+pub struct ParserBuffers {
+    events: Vec<Event<'static>>,
+    key_sets: Vec<HashMap<KeyValue, Span>>,
+    segments: Vec<PathSegment>,
+}
+
+impl ParserBuffers {
+    /// Create an empty set of buffers.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    fn take_keys(&mut self) -> HashMap<KeyValue, Span> {
+        self.key_sets.pop().unwrap_or_default()
+    }
+
+    fn give_keys(&mut self, mut keys: HashMap<KeyValue, Span>) {
+        // Nested objects hand their sets back as they close, so the pool
+        // only grows with nesting depth.
+        if keys.capacity() > 0 {
+            keys.clear();
+            self.key_sets.push(keys);
+        }
+    }
+
+    fn give_segments(&mut self, mut segments: Vec<PathSegment>) {
+        if segments.capacity() > self.segments.capacity() {
+            segments.clear();
+            self.segments = segments;
+        }
+    }
+}
+
+/// Reuse the allocation of an event vector for events of another lifetime.
+fn recycle_events<'b>(mut events: Vec<Event<'_>>) -> Vec<Event<'b>> {
+    events.clear();
+    let mut events = std::mem::ManuallyDrop::new(events);
+    let (ptr, capacity) = (events.as_mut_ptr(), events.capacity());
+    // SAFETY: `Event<'_>` and `Event<'b>` differ only in lifetime, so they
+    // have the same size and alignment and the buffer was allocated for the
+    // new type too. The vector is empty, so no value is reinterpreted, and
+    // `ManuallyDrop` hands ownership of the buffer over without freeing it.
+    unsafe { Vec::from_raw_parts(ptr.cast::<Event<'b>>(), 0, capacity) }
 }
 
 /// Parser state machine states.
@@ -91,6 +150,64 @@ impl<'src> Parser<'src> {
             source: LexemeSource::new(source),
             state: ParserState::BeforeDocument,
             event_queue: VecDeque::new(),
+            skip_depth: None,
+            object_depth: 0,
+            spare: ParserBuffers::default(),
+        }
+    }
+
+    /// Create a parser that reuses the allocations in `buffers`.
+    pub fn with_buffers(source: &'src str, mut buffers: ParserBuffers) -> Self {
+        let events = std::mem::take(&mut buffers.events);
+        Self {
+            event_queue: VecDeque::from(recycle_events(events)),
+            spare: buffers,
+            ..Self::new(source)
+        }
+    }
+
+    /// Give up this parser's allocations for [`Parser::with_buffers`].
+    ///
+    /// The parser does not need to have reached the end of its input.
+    pub fn into_buffers(mut self) -> ParserBuffers {
+        let mut buffers = std::mem::take(&mut self.spare);
+        let mut state = std::mem::replace(&mut self.state, ParserState::AfterDocument);
+        loop {
+            match state {
+                ParserState::InObject {
+                    seen_keys, parent, ..
+                } => {
+                    buffers.give_keys(seen_keys);
+                    state = *parent;
+                }
+                ParserState::DocumentRoot {
+                    seen_keys,
+                    path_state,
+                    ..
+                } => {
+                    buffers.give_keys(seen_keys);
+                    buffers.give_segments(path_state.segments);
+                    break;
+                }
+                _ => break,
+            }
+        }
+        buffers.events = recycle_events(Vec::from(std::mem::take(&mut self.event_queue)));
+        buffers
+    }
+
+    /// Create a parser that skips over the contents of nested objects.
+    ///
+    /// Every object used as a value is reported as an `ObjectStart` /
+    /// `ObjectEnd` pair with no entries in between, spanning the whole
+    /// `{...}` block. The block is only brace-matched (strings, heredocs and
+    /// comments are still tokenized so their braces don't count), so errors
+    /// inside it are not reported. Parse a skipped block later with
+    /// [`Parser::new_shallow_expr`] on its span.
+    pub fn new_shallow(source: &'src str) -> Self {
+        Self {
+            skip_depth: Some(0),
+            ..Self::new(source)
         }
     }
 
@@ -104,6 +221,18 @@ impl<'src> Parser<'src> {
             source: LexemeSource::new(source),
             state: ParserState::BeforeExpression,
             event_queue: VecDeque::new(),
+            skip_depth: None,
+            object_depth: 0,
+            spare: ParserBuffers::default(),
+        }
+    }
+
+    /// Create an expression-mode parser that parses the outermost value but
+    /// skips objects nested inside it, as [`Parser::new_shallow`] does.
+    pub fn new_shallow_expr(source: &'src str) -> Self {
+        Self {
+            skip_depth: Some(1),
+            ..Self::new_expr(source)
         }
     }
 
@@ -139,9 +268,11 @@ impl<'src> Parser<'src> {
         match &self.state {
             ParserState::BeforeDocument => {
                 self.state = ParserState::DocumentRoot {
-                    seen_keys: HashMap::new(),
+                    seen_keys: self.spare.take_keys(),
                     pending_doc_comment: None,
-                    path_state: PathState::default(),
+                    path_state: PathState {
+                        segments: std::mem::take(&mut self.spare.segments),
+                    },
                     emitted_object_start: false,
                 };
                 Some(Event {
@@ -242,7 +373,16 @@ impl<'src> Parser<'src> {
                         span: Span::empty(self.input.len() as u32),
                         kind: EventKind::DocumentEnd,
                     });
-                    self.state = ParserState::AfterDocument;
+                    let root = std::mem::replace(&mut self.state, ParserState::AfterDocument);
+                    if let ParserState::DocumentRoot {
+                        seen_keys,
+                        path_state,
+                        ..
+                    } = root
+                    {
+                        self.spare.give_keys(seen_keys);
+                        self.spare.give_segments(path_state.segments);
+                    }
                     return self.event_queue.pop_front();
                 }
                 Lexeme::Newline { .. } | Lexeme::Comma { .. } => continue,
@@ -284,7 +424,7 @@ impl<'src> Parser<'src> {
                     // Explicit root object - after it closes, document is done
                     self.state = ParserState::InObject {
                         start_span: span,
-                        seen_keys: HashMap::new(),
+                        seen_keys: self.spare.take_keys(),
                         pending_doc_comment: None,
                         parent: Box::new(ParserState::AfterDocument),
                     };
@@ -444,7 +584,10 @@ impl<'src> Parser<'src> {
     /// Pop the current state and restore parent.
     fn pop_state(&mut self) {
         let parent = match &mut self.state {
-            ParserState::InObject { parent, .. } => {
+            ParserState::InObject {
+                parent, seen_keys, ..
+            } => {
+                self.spare.give_keys(std::mem::take(seen_keys));
                 std::mem::replace(parent.as_mut(), ParserState::AfterDocument)
             }
             _ => ParserState::AfterDocument,
@@ -765,7 +908,19 @@ impl<'src> Parser<'src> {
                     },
                 }
             }
-            Lexeme::ObjectStart { span } => self.parse_object_atom(span),
+            Lexeme::ObjectStart { span }
+                if self
+                    .skip_depth
+                    .is_some_and(|depth| self.object_depth >= depth) =>
+            {
+                self.skip_object_atom(span)
+            }
+            Lexeme::ObjectStart { span } => {
+                self.object_depth += 1;
+                let atom = self.parse_object_atom(span);
+                self.object_depth -= 1;
+                atom
+            }
             Lexeme::SeqStart { span } => self.parse_sequence_atom(span),
             Lexeme::AttrKey { key_span, key, .. } => self.parse_attributes(key_span, key),
             Lexeme::Error { span, message } => {
@@ -819,7 +974,7 @@ impl<'src> Parser<'src> {
     /// Parse an object atom.
     fn parse_object_atom(&mut self, start_span: Span) -> Atom<'src> {
         let mut entries: Vec<ObjectEntry<'src>> = Vec::new();
-        let mut seen_keys: HashMap<KeyValue, Span> = HashMap::new();
+        let mut seen_keys = self.spare.take_keys();
         let mut duplicate_key_spans: Vec<(Span, Span)> = Vec::new();
         let mut dangling_doc_comment_spans: Vec<Span> = Vec::new();
         let mut pending_doc_comments: Vec<(Span, &'src str)> = Vec::new();
@@ -904,6 +1059,7 @@ impl<'src> Parser<'src> {
                 }
             }
         }
+        self.spare.give_keys(seen_keys);
 
         Atom {
             span: Span::new(start_span.start, end_span.end),
@@ -916,6 +1072,23 @@ impl<'src> Parser<'src> {
         }
     }
 
+    /// Skip an object atom in shallow mode, keeping only its span.
+    fn skip_object_atom(&mut self, start_span: Span) -> Atom<'src> {
+        let (end, unclosed) = match self.source.lexer.skip_block() {
+            Some(span) => (span.end, false),
+            None => (self.input.len() as u32, true),
+        };
+        Atom {
+            span: Span::new(start_span.start, end),
+            content: AtomContent::Object {
+                entries: Vec::new(),
+                duplicate_key_spans: Vec::new(),
+                dangling_doc_comment_spans: Vec::new(),
+                unclosed,
+            },
+        }
+    }
+
     /// Parse a sequence atom.
     fn parse_sequence_atom(&mut self, start_span: Span) -> Atom<'src> {
         let mut elements: Vec<Atom<'src>> = Vec::new();
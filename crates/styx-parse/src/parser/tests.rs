@@ -1459,3 +1459,90 @@ fn test_implicit_object_has_object_start() {
         "
     );
 }
+
+#[test]
+fn test_shallow_skips_nested_objects() {
+    let input = "a {b {c 1}, s \"}\"}\nd 2";
+    let events = Parser::new_shallow(input).parse_to_vec();
+    assert_events_eq!(
+        input,
+        events,
+        "
+        DocumentStart
+        ObjectStart
+        EntryStart
+        Key(\"a\")
+        ObjectStart
+        ObjectEnd
+        EntryEnd
+        EntryStart
+        Key(\"d\")
+        Scalar(\"2\")
+        EntryEnd
+        ObjectEnd
+        DocumentEnd
+        "
+    );
+    // The skipped block parses on its own, one level deep.
+    let block = &input[2..18];
+    let events = Parser::new_shallow_expr(block).parse_to_vec();
+    assert_events_eq!(
+        block,
+        events,
+        "
+        ObjectStart
+        EntryStart
+        Key(\"b\")
+        ObjectStart
+        ObjectEnd
+        EntryEnd
+        EntryStart
+        Key(\"s\")
+        Scalar(\"}\", Quoted)
+        EntryEnd
+        ObjectEnd
+        "
+    );
+}
+
+#[test]
+fn test_reused_buffers_parse_identically() {
+    let inputs = [
+        "a 1\nb {c 2, d {e 3}}\nf (1 2 {g 4})",
+        "a.b.c 1\na.b.d 2\nx.y 3",
+        "a 1\na 2",
+        "{a {b 1, b 2}}",
+        "a {b 1",
+        "",
+        "/// doc\nkey @tag{x 1}",
+    ];
+    let mut buffers = ParserBuffers::new();
+    // Two rounds, so the second one reuses what every input left behind.
+    for _ in 0..2 {
+        for input in inputs {
+            let mut parser = Parser::with_buffers(input, buffers);
+            let mut events = Vec::new();
+            while let Some(event) = parser.next_event() {
+                events.push(event);
+            }
+            assert_eq!(events, parse(input), "{input:?}");
+            buffers = parser.into_buffers();
+        }
+    }
+    assert!(buffers.events.is_empty());
+    assert!(
+        buffers.events.capacity() > 0,
+        "event queue allocation was dropped"
+    );
+    assert!(buffers.key_sets.iter().all(HashMap::is_empty));
+    assert!(buffers.segments.is_empty());
+
+    // A parser dropped halfway still hands back clean buffers.
+    let mut parser = Parser::with_buffers("a {b {c 1}}\nd 2", buffers);
+    for _ in 0..4 {
+        parser.next_event();
+    }
+    let buffers = parser.into_buffers();
+    let events = Parser::with_buffers("z 1", buffers).parse_to_vec();
+    assert_eq!(events, parse("z 1"));
+}
@@ -2,6 +2,12 @@ use std::ops::Range;
 
 use ariadne::{CharSet, Color, Config, Label, Report, ReportKind, Source};
 
+mod corpus;
+pub use corpus::{
+    BenchInput, bench_corpus, deep_nesting, heredoc_heavy, huge_sequence, large_heredoc,
+    raw_string_heavy, small_config, wide_object,
+};
+
 #[derive(Debug, Clone)]
 pub struct ExpectedError {
     pub line: usize,
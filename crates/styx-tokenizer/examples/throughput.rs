@@ -0,0 +1,71 @@
+//! Tokenizer throughput in MB/s.
+//!
+//! Run with `cargo run --release -p styx-tokenizer --example throughput [FILE...]`.
+//! Without arguments, synthetic documents dominated by bare scalars, quoted
+//! strings, indentation and comments are generated.
+
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+use styx_tokenizer::Tokenizer;
+
+const TARGET_LEN: usize = 8 << 20;
+
+fn main() {
+    let files: Vec<String> = std::env::args().skip(1).collect();
+    if files.is_empty() {
+        for (name, source) in synthetic() {
+            report(name, &source);
+        }
+    } else {
+        for file in &files {
+            let source = std::fs::read_to_string(file).expect("failed to read input");
+            report(file, &source);
+        }
+    }
+}
+
+fn synthetic() -> Vec<(&'static str, String)> {
+    let repeat = |unit: &str| unit.repeat(TARGET_LEN / unit.len() + 1);
+    vec![
+        (
+            "bare scalars",
+            repeat("endpoint https://api.example.com/v1/resources/items/list?page=1\n"),
+        ),
+        (
+            "quoted strings",
+            repeat("message \"The quick brown fox jumps over the lazy dog, twice over\"\n"),
+        ),
+        (
+            "indentation",
+            repeat("server {\n                host localhost\n                port 8080\n}\n"),
+        ),
+        (
+            "comments",
+            repeat("// a line comment describing the configuration option below it\nkey value\n"),
+        ),
+    ]
+}
+
+fn report(name: &str, source: &str) {
+    // Warm up, then time enough iterations to fill about a second.
+    let mut tokens = tokenize(source);
+    let mut iterations = 0u32;
+    let mut elapsed = Duration::ZERO;
+    while elapsed < Duration::from_secs(1) {
+        let start = Instant::now();
+        tokens = tokenize(source);
+        elapsed += start.elapsed();
+        iterations += 1;
+    }
+    let bytes = source.len() as f64 * f64::from(iterations);
+    let mb_per_s = bytes / elapsed.as_secs_f64() / 1e6;
+    println!(
+        "{name:>16}: {mb_per_s:8.1} MB/s ({tokens} tokens, {} bytes)",
+        source.len()
+    );
+}
+
+fn tokenize(source: &str) -> usize {
+    Tokenizer::new(black_box(source)).map(black_box).count()
+}
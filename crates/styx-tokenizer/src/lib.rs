@@ -6,5 +6,6 @@ pub use span::Span;
 mod token;
 pub use token::{Token, TokenKind};
 
+mod scan;
 mod tokenizer;
 pub use tokenizer::Tokenizer;
@@ -0,0 +1,271 @@
+//! Vectorized byte scanning for the tokenizer's hot loops.
+//!
+//! Long bare scalars, quoted strings, comments and indentation make up most
+//! of a typical document. Instead of decoding one `char` at a time, these
+//! runs are skipped 16 bytes at a time with SSE2 (x86_64) or NEON (aarch64),
+//! both part of their architecture's baseline, finishing with a table-driven
+//! scalar loop. Every scan stops on an ASCII byte or at the end of input, so
+//! the returned length is always a char boundary.
+
+/// Bytes that continue an ASCII bare scalar (see `is_bare_scalar_char`).
+/// Non-ASCII bytes stop the scan so the caller can classify the whole char.
+pub(crate) const BARE: u8 = 1 << 0;
+/// Spaces and tabs.
+pub(crate) const SPACE: u8 = 1 << 1;
+/// Anything but `"` and `\` (quoted scalar content).
+pub(crate) const QUOTED: u8 = 1 << 2;
+/// Anything but `\n` and `\r` (rest of a line).
+pub(crate) const LINE: u8 = 1 << 3;
+
+/// For each byte, the set of classes it continues.
+static CONTINUES: [u8; 256] = build_table();
+
+const fn build_table() -> [u8; 256] {
+    let mut table = [0u8; 256];
+    let mut i = 0;
+    while i < 256 {
+        let b = i as u8;
+        let mut classes = 0;
+        if b < 0x80
+            && !matches!(
+                b,
+                b'{' | b'}' | b'(' | b')' | b',' | b'"' | b'>' | b' ' | b'\t'..=b'\r'
+            )
+        {
+            classes |= BARE;
+        }
+        if b == b' ' || b == b'\t' {
+            classes |= SPACE;
+        }
+        if b != b'"' && b != b'\\' {
+            classes |= QUOTED;
+        }
+        if b != b'\n' && b != b'\r' {
+            classes |= LINE;
+        }
+        table[i] = classes;
+        i += 1;
+    }
+    table
+}
+
+/// Length of the longest prefix of `bytes` made of `CLASS` bytes.
+#[inline]
+pub(crate) fn run_len<const CLASS: u8>(bytes: &[u8]) -> usize {
+    let mut i = simd::scan::<CLASS>(bytes);
+    while i < bytes.len() && CONTINUES[bytes[i] as usize] & CLASS != 0 {
+        i += 1;
+    }
+    i
+}
+
+#[cfg(target_arch = "x86_64")]
+mod simd {
+    use core::arch::x86_64::*;
+
+    use super::{BARE, LINE, QUOTED, SPACE};
+
+    /// Scan whole 16-byte blocks. Returns the index of the first byte that
+    /// ends the run, or the start of the unscanned tail.
+    #[inline]
+    pub(super) fn scan<const CLASS: u8>(bytes: &[u8]) -> usize {
+        let mut i = 0;
+        while i + 16 <= bytes.len() {
+            // SAFETY: `i + 16 <= bytes.len()`, and SSE2 is always available
+            // on x86_64.
+            let mask = unsafe {
+                let block = _mm_loadu_si128(bytes.as_ptr().add(i) as *const __m128i);
+                stop_mask::<CLASS>(block)
+            };
+            if mask != 0 {
+                return i + mask.trailing_zeros() as usize;
+            }
+            i += 16;
+        }
+        i
+    }
+
+    /// Bit `n` is set if byte `n` of `v` ends a `CLASS` run.
+    #[inline(always)]
+    unsafe fn stop_mask<const CLASS: u8>(v: __m128i) -> u32 {
+        unsafe {
+            let eq = |b: u8| _mm_cmpeq_epi8(v, _mm_set1_epi8(b as i8));
+            let mask = match CLASS {
+                BARE => {
+                    let mut m = _mm_or_si128(eq(b'{'), eq(b'}'));
+                    m = _mm_or_si128(m, _mm_or_si128(eq(b'('), eq(b')')));
+                    m = _mm_or_si128(m, _mm_or_si128(eq(b','), eq(b'"')));
+                    m = _mm_or_si128(m, _mm_or_si128(eq(b'>'), eq(b' ')));
+                    // `\t..=\r`: v - 9 <= 4, unsigned.
+                    let t = _mm_sub_epi8(v, _mm_set1_epi8(9));
+                    let ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+                    // Non-ASCII bytes have the high bit set.
+                    _mm_or_si128(m, _mm_or_si128(ctrl, v))
+                }
+                SPACE => _mm_xor_si128(_mm_or_si128(eq(b' '), eq(b'\t')), _mm_set1_epi8(-1)),
+                QUOTED => _mm_or_si128(eq(b'"'), eq(b'\\')),
+                LINE => _mm_or_si128(eq(b'\n'), eq(b'\r')),
+                _ => unreachable!(),
+            };
+            _mm_movemask_epi8(mask) as u32
+        }
+    }
+}
+
+#[cfg(target_arch = "aarch64")]
+mod simd {
+    use core::arch::aarch64::*;
+
+    use super::{BARE, LINE, QUOTED, SPACE};
+
+    /// Scan whole 16-byte blocks. Returns the index of the first byte that
+    /// ends the run, or the start of the unscanned tail.
+    #[inline]
+    pub(super) fn scan<const CLASS: u8>(bytes: &[u8]) -> usize {
+        let mut i = 0;
+        while i + 16 <= bytes.len() {
+            // SAFETY: `i + 16 <= bytes.len()`, and NEON is always available
+            // on aarch64.
+            let mask = unsafe {
+                let stops = stop_mask::<CLASS>(vld1q_u8(bytes.as_ptr().add(i)));
+                // Narrow each byte to a nibble: 4 mask bits per input byte.
+                let nibbles = vshrn_n_u16::<4>(vreinterpretq_u16_u8(stops));
+                vget_lane_u64::<0>(vreinterpret_u64_u8(nibbles))
+            };
+            if mask != 0 {
+                return i + (mask.trailing_zeros() / 4) as usize;
+            }
+            i += 16;
+        }
+        i
+    }
+
+    /// Byte `n` is `0xff` if byte `n` of `v` ends a `CLASS` run.
+    #[inline(always)]
+    unsafe fn stop_mask<const CLASS: u8>(v: uint8x16_t) -> uint8x16_t {
+        unsafe {
+            let eq = |b: u8| vceqq_u8(v, vdupq_n_u8(b));
+            match CLASS {
+                BARE => {
+                    let mut m = vorrq_u8(eq(b'{'), eq(b'}'));
+                    m = vorrq_u8(m, vorrq_u8(eq(b'('), eq(b')')));
+                    m = vorrq_u8(m, vorrq_u8(eq(b','), eq(b'"')));
+                    m = vorrq_u8(m, vorrq_u8(eq(b'>'), eq(b' ')));
+                    let ctrl = vcleq_u8(vsubq_u8(v, vdupq_n_u8(9)), vdupq_n_u8(4));
+                    let high = vcgeq_u8(v, vdupq_n_u8(0x80));
+                    vorrq_u8(m, vorrq_u8(ctrl, high))
+                }
+                SPACE => vmvnq_u8(vorrq_u8(eq(b' '), eq(b'\t'))),
+                QUOTED => vorrq_u8(eq(b'"'), eq(b'\\')),
+                LINE => vorrq_u8(eq(b'\n'), eq(b'\r')),
+                _ => unreachable!(),
+            }
+        }
+    }
+}
+
+#[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+mod simd {
+    /// No vector unit: leave everything to the scalar loop.
+    #[inline]
+    pub(super) fn scan<const CLASS: u8>(_bytes: &[u8]) -> usize {
+        0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::tokenizer::{is_bare_scalar_char, is_horizontal_space};
+    use crate::{Token, TokenKind, Tokenizer};
+
+    fn reference(bytes: &[u8], class: u8) -> usize {
+        bytes
+            .iter()
+            .position(|&b| CONTINUES[b as usize] & class == 0)
+            .unwrap_or(bytes.len())
+    }
+
+    fn check(bytes: &[u8]) {
+        assert_eq!(run_len::<BARE>(bytes), reference(bytes, BARE), "{bytes:?}");
+        assert_eq!(
+            run_len::<SPACE>(bytes),
+            reference(bytes, SPACE),
+            "{bytes:?}"
+        );
+        assert_eq!(
+            run_len::<QUOTED>(bytes),
+            reference(bytes, QUOTED),
+            "{bytes:?}"
+        );
+        assert_eq!(run_len::<LINE>(bytes), reference(bytes, LINE), "{bytes:?}");
+    }
+
+    /// The first token of `source` from the real tokenizer.
+    fn first_token(source: &str) -> Token<'_> {
+        Tokenizer::new(source).next().unwrap()
+    }
+
+    #[test]
+    fn test_table_matches_char_predicates() {
+        for b in 0u8..0x80 {
+            let c = b as char;
+            let classes = CONTINUES[b as usize];
+            assert_eq!(classes & BARE != 0, is_bare_scalar_char(c), "bare {c:?}");
+            assert_eq!(classes & SPACE != 0, is_horizontal_space(c), "space {c:?}");
+            // Lines end where the tokenizer starts a newline token.
+            assert_eq!(
+                classes & LINE != 0,
+                first_token(&format!("{c}\n")).kind != TokenKind::Newline,
+                "line {c:?}"
+            );
+            // In `"c""`, a quote closes the string at once and a backslash
+            // escapes the next quote; any other byte is plain content.
+            let plain = format!("\"{c}\"");
+            let quoted = match c {
+                '"' => "\"\"",
+                '\\' => "\"\\\"\"",
+                _ => &plain,
+            };
+            assert_eq!(first_token(&format!("\"{c}\"\"")).text, quoted, "{c:?}");
+            assert_eq!(classes & QUOTED != 0, quoted.len() == 3, "quoted {c:?}");
+        }
+        // Non-ASCII chars are classified by the tokenizer, not the table...
+        for b in 0x80..=0xffu8 {
+            assert_eq!(CONTINUES[b as usize] & (BARE | SPACE), 0);
+        }
+        // ...and can never end a string or a line.
+        for c in ['\u{85}', '\u{a0}', '\u{2028}', '\u{e9}', '\u{1f600}'] {
+            assert_eq!(
+                first_token(&format!("\"{c}\"\"")).text.len(),
+                c.len_utf8() + 2
+            );
+            assert_ne!(first_token(&format!("{c}\n")).kind, TokenKind::Newline);
+        }
+    }
+
+    #[test]
+    fn test_every_stop_byte_at_every_offset() {
+        for stop in 0..=255u8 {
+            for len in [1, 15, 16, 17, 31, 32, 33, 64] {
+                for at in 0..len {
+                    let mut bytes = vec![b'a'; len];
+                    bytes[at] = stop;
+                    check(&bytes);
+                    bytes.fill(b' ');
+                    bytes[at] = stop;
+                    check(&bytes);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_runs_on_text() {
+        check(b"");
+        check("https://example.com/a/very/long/path/that/keeps/going?x=1".as_bytes());
+        check("    \t  indented line with some words".as_bytes());
+        check("a quoted string with an \\\"escape\\\" and \u{e9}t\u{e9}\"".as_bytes());
+        check("// comment text that runs to the end of the line\r\nnext".as_bytes());
+    }
+}
@@ -1,5 +1,6 @@
 //! Tokenizer for the Styx configuration language.
 
+use crate::scan::{self, BARE, LINE, QUOTED, SPACE};
 use crate::{Span, Token, TokenKind};
 use tracing::trace;
 
@@ -86,6 +87,12 @@ impl<'src> Tokenizer<'src> {
         self.remaining = &self.remaining[n..];
     }
 
+    /// Advance past the run of `CLASS` bytes at the current position.
+    #[inline]
+    fn skip_run<const CLASS: u8>(&mut self) {
+        self.advance_by(scan::run_len::<CLASS>(self.remaining.as_bytes()));
+    }
+
     /// Check if the remaining text starts with the given prefix.
     #[inline]
     fn starts_with(&self, prefix: &str) -> bool {
@@ -171,7 +178,7 @@ impl<'src> Tokenizer<'src> {
             'r' if matches!(self.peek_nth(1), Some('#' | '"')) => self.tokenize_raw_string(),
 
             // Whitespace
-            ' ' | '\t' => self.tokenize_whitespace(),
+            c if is_horizontal_space(c) => self.tokenize_whitespace(),
 
             // Newline
             '\n' => {
@@ -198,24 +205,21 @@ impl<'src> Tokenizer<'src> {
     /// Tokenize horizontal whitespace (spaces and tabs).
     fn tokenize_whitespace(&mut self) -> Token<'src> {
         let start = self.pos;
-        while let Some(c) = self.peek() {
-            if c == ' ' || c == '\t' {
-                self.advance();
-            } else {
-                break;
-            }
-        }
+        self.skip_run::<SPACE>();
         self.token(TokenKind::Whitespace, start)
     }
 
     /// Tokenize a bare (unquoted) scalar.
     fn tokenize_bare_scalar(&mut self) -> Token<'src> {
         let start = self.pos;
-        while let Some(c) = self.peek() {
-            if is_bare_scalar_char(c) {
-                self.advance();
-            } else {
-                break;
+        loop {
+            self.skip_run::<BARE>();
+            // The fast path stops at non-ASCII chars; classify those here.
+            match self.peek() {
+                Some(c) if !c.is_ascii() && is_bare_scalar_char(c) => {
+                    self.advance();
+                }
+                _ => break,
             }
         }
         self.token(TokenKind::BareScalar, start)
@@ -262,6 +266,7 @@ impl<'src> Tokenizer<'src> {
         self.advance();
 
         loop {
+            self.skip_run::<QUOTED>();
             match self.peek() {
                 None => {
                     // Unterminated string - return error
@@ -297,12 +302,7 @@ impl<'src> Tokenizer<'src> {
         self.advance();
 
         // Consume until end of line
-        while let Some(c) = self.peek() {
-            if c == '\n' || c == '\r' {
-                break;
-            }
-            self.advance();
-        }
+        self.skip_run::<LINE>();
 
         self.token(TokenKind::LineComment, start)
     }
@@ -317,12 +317,7 @@ impl<'src> Tokenizer<'src> {
         self.advance();
 
         // Consume until end of line
-        while let Some(c) = self.peek() {
-            if c == '\n' || c == '\r' {
-                break;
-            }
-            self.advance();
-        }
+        self.skip_run::<LINE>();
 
         self.token(TokenKind::DocComment, start)
     }
@@ -427,7 +422,7 @@ impl<'src> Tokenizer<'src> {
         let indent_len = self
             .remaining
             .chars()
-            .take_while(|c| *c == ' ' || *c == '\t')
+            .take_while(|&c| is_horizontal_space(c))
             .count();
 
         // Check if delimiter follows the whitespace
@@ -461,16 +456,23 @@ impl<'src> Tokenizer<'src> {
         let mut closing_indent = 0usize;
         while !self.is_eof() {
             // Consume the current line
-            while let Some(c) = self.peek() {
-                if c == '\n' {
-                    self.advance();
-                    break;
-                } else if c == '\r' && self.peek_nth(1) == Some('\n') {
-                    self.advance();
-                    self.advance();
-                    break;
+            loop {
+                self.skip_run::<LINE>();
+                match self.peek() {
+                    Some('\n') => {
+                        self.advance();
+                        break;
+                    }
+                    Some('\r') if self.peek_nth(1) == Some('\n') => {
+                        self.advance();
+                        self.advance();
+                        break;
+                    }
+                    Some(_) => {
+                        self.advance();
+                    }
+                    None => break,
                 }
-                self.advance();
             }
 
             // Check if next line starts with delimiter (possibly indented)
@@ -589,6 +591,11 @@ impl<'src> Iterator for Tokenizer<'src> {
     }
 }
 
+/// Check if a character is horizontal whitespace (a space or a tab).
+pub(crate) fn is_horizontal_space(c: char) -> bool {
+    c == ' ' || c == '\t'
+}
+
 // parser[impl scalar.bare.chars]
 /// Check if a character can start a bare scalar.
 fn is_bare_scalar_start(c: char) -> bool {
@@ -599,7 +606,7 @@ fn is_bare_scalar_start(c: char) -> bool {
 
 // parser[impl scalar.bare.chars]
 /// Check if a character can continue a bare scalar.
-fn is_bare_scalar_char(c: char) -> bool {
+pub(crate) fn is_bare_scalar_char(c: char) -> bool {
     // Cannot be special chars or whitespace
     // `/`, `@`, and `=` are allowed after the first char
     // `>` is never allowed (attribute separator)
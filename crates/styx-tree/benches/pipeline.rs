@@ -0,0 +1,137 @@
+//! Throughput of each stage of the parse pipeline.
+//!
+//! Run with `cargo bench -p styx-tree`. Every stage is measured over the same
+//! corpus so the numbers can be compared stage by stage: tokenizing, lexing,
+//! the event parser, tree building from pre-collected events, and the full
+//! `Document::parse`. `lazy_parse` is `Document::parse_lazy` followed by a
+//! lookup of the first root key, the access pattern lazy parsing is for.
+
+use std::hint::black_box;
+
+use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use styx_parse::{Event, Lexer, Parser, Tokenizer};
+use styx_testhelpers::bench_corpus;
+use styx_tree::{Document, TreeBuilder};
+
+fn tokenizer(c: &mut Criterion) {
+    let mut group = c.benchmark_group("tokenizer");
+    for input in bench_corpus() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| b.iter(|| Tokenizer::new(black_box(source)).count()),
+        );
+    }
+    group.finish();
+}
+
+fn lexer(c: &mut Criterion) {
+    let mut group = c.benchmark_group("lexer");
+    for input in bench_corpus() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| b.iter(|| Lexer::new(black_box(source)).count()),
+        );
+    }
+    group.finish();
+}
+
+fn parser(c: &mut Criterion) {
+    let mut group = c.benchmark_group("parser");
+    for input in bench_corpus() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| {
+                b.iter(|| {
+                    let mut parser = Parser::new(black_box(source));
+                    let mut events = 0usize;
+                    while let Some(event) = parser.next_event() {
+                        black_box(&event);
+                        events += 1;
+                    }
+                    events
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+fn tree_builder(c: &mut Criterion) {
+    let mut group = c.benchmark_group("tree_builder");
+    for input in bench_corpus() {
+        let events: Vec<Event<'_>> = Parser::new(&input.source).parse_to_vec();
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &events,
+            |b, events| {
+                b.iter(|| {
+                    let mut builder = TreeBuilder::new();
+                    for event in events {
+                        builder.event(event.clone());
+                    }
+                    builder.finish()
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+fn document_parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("document_parse");
+    for input in bench_corpus() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| b.iter(|| Document::parse(black_box(source)).unwrap()),
+        );
+    }
+    group.finish();
+}
+
+fn lazy_parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("lazy_parse");
+    for input in bench_corpus() {
+        let first_key = Document::parse(&input.source)
+            .unwrap()
+            .root
+            .iter()
+            .find_map(|(key, _)| key.as_str().map(str::to_string))
+            .unwrap_or_default();
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| {
+                b.iter(|| {
+                    let doc = Document::parse_lazy(black_box(source)).unwrap();
+                    black_box(
+                        doc.get(&first_key)
+                            .and_then(|v| v.as_object())
+                            .map(|o| o.len()),
+                    );
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    tokenizer,
+    lexer,
+    parser,
+    tree_builder,
+    document_parse,
+    lazy_parse
+);
+criterion_main!(benches);
@@ -0,0 +1,1091 @@
+//! Arena-backed document representation.
+//!
+//! A [`Document`] is a tree of `Vec`s and `String`s: thousands of small
+//! allocations per document, each freed individually on drop. An
+//! [`ArenaDocument`] stores the same tree in a handful of flat vectors
+//! (nodes, entries, sequence items and one string pool) and borrows scalars
+//! and tag names from the source wherever no unescaping was needed. Dropping
+//! it frees those few blocks and nothing else, and traversal walks contiguous
+//! memory.
+//!
+//! Keys and tag names are interned: each distinct name is stored once and
+//! referred to by a [`Symbol`]. Tags hold only their symbol, and every entry
+//! records its key's symbol, so [`ArenaObject::get`] hashes the key once and
+//! then compares integers, and callers that look up the same key in many
+//! objects can resolve it with [`ArenaDocument::symbol`] up front.
+//!
+//! The tree is read through cheap `Copy` handles ([`ArenaValue`],
+//! [`ArenaObject`], [`ArenaSequence`]) that mirror the owned API, and can be
+//! converted to an owned [`Document`] with [`ArenaDocument::to_document`].
+
+use std::borrow::Cow;
+use std::collections::HashMap;
+use std::hash::{BuildHasherDefault, Hasher};
+
+use styx_parse::{Event, EventKind, ParseErrorKind, ScalarKind, Span};
+
+use crate::index::key_hash;
+use crate::value::split_path;
+use crate::{BuildError, Document, Entry, Object, Payload, Scalar, Sequence, Tag, Value};
+
+/// A parsed document stored in a few contiguous blocks.
+///
+/// Built with [`ArenaDocument::parse`] or an [`ArenaBuilder`]. Produces the
+/// same tree as [`Document::parse`].
+#[derive(Debug, Clone)]
+pub struct ArenaDocument<'src> {
+    source: &'src str,
+    /// Text that could not be borrowed from `source` (unescaped scalars,
+    /// joined doc comments).
+    strings: String,
+    nodes: Vec<Node>,
+    entries: Vec<EntryNode>,
+    items: Vec<usize>,
+    root: Run,
+    /// Text of each symbol, by id.
+    symbol_names: Vec<Str>,
+    /// Symbol ids by [`key_hash`] of their text. A hash taken by a different
+    /// name moves on to the next hash value.
+    symbol_ids: HashMap<u64, u32, BuildHasherDefault<PrehashedKey>>,
+}
+
+/// Passes a [`key_hash`] through unchanged; it is already well mixed.
+#[derive(Default)]
+struct PrehashedKey(u64);
+
+impl Hasher for PrehashedKey {
+    fn finish(&self) -> u64 {
+        self.0
+    }
+
+    fn write(&mut self, _: &[u8]) {
+        unreachable!("only u64 keys are hashed")
+    }
+
+    fn write_u64(&mut self, hash: u64) {
+        self.0 = hash;
+    }
+}
+
+/// An interned key or tag name in an [`ArenaDocument`].
+///
+/// Symbols are only meaningful for the document that produced them.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct Symbol(pub(crate) u32);
+
+/// Entry key symbol for keys that are not untagged scalars.
+const NO_SYMBOL: Symbol = Symbol(u32::MAX);
+
+/// A string stored either in the source or in the document's string pool.
+#[derive(Debug, Clone, Copy)]
+struct Str {
+    start: usize,
+    end: usize,
+    pooled: bool,
+}
+
+/// A `start..start + len` range into one of the document's vectors.
+#[derive(Debug, Clone, Copy)]
+struct Run {
+    start: usize,
+    len: usize,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct Node {
+    tag: Option<TagNode>,
+    payload: NodePayload,
+    /// Span of the value; payloads share it, as in the owned tree.
+    span: Option<Span>,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct TagNode {
+    name: Symbol,
+    span: Span,
+}
+
+#[derive(Debug, Clone, Copy)]
+enum NodePayload {
+    None,
+    Scalar { text: Str, kind: ScalarKind },
+    Sequence(Run),
+    Object(Run),
+}
+
+#[derive(Debug, Clone, Copy)]
+struct EntryNode {
+    key: usize,
+    /// Symbol of the key's text, if `key` is an untagged scalar.
+    key_symbol: Symbol,
+    value: usize,
+    doc_comment: Option<Str>,
+}
+
+impl<'src> ArenaDocument<'src> {
+    /// Parse a Styx document into an arena.
+    pub fn parse(source: &'src str) -> Result<Self, BuildError> {
+        let mut parser = styx_parse::Parser::new(source);
+        let mut builder = ArenaBuilder::new(source);
+        while let Some(event) = parser.next_event() {
+            builder.event(event);
+        }
+        builder.finish()
+    }
+
+    /// The source text this document borrows from.
+    pub fn source(&self) -> &'src str {
+        self.source
+    }
+
+    /// The root object.
+    pub fn root(&self) -> ArenaObject<'_> {
+        ArenaObject {
+            doc: self,
+            run: self.root,
+            span: None,
+        }
+    }
+
+    /// Get a value by path, like [`Document::get`].
+    pub fn get(&self, path: &str) -> Option<ArenaValue<'_>> {
+        if path.is_empty() {
+            return None;
+        }
+        let (segment, rest) = split_path(path);
+        let value = self.root().get(segment)?;
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Number of values stored in the arena (including keys).
+    pub fn node_count(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// The symbol for a key or tag name, if it occurs in the document.
+    ///
+    /// Resolving a key once and looking it up with [`ArenaObject::get_symbol`]
+    /// skips hashing it again for every object.
+    pub fn symbol(&self, name: &str) -> Option<Symbol> {
+        let mut hash = key_hash(name);
+        loop {
+            let &id = self.symbol_ids.get(&hash)?;
+            if self.str(self.symbol_names[id as usize]) == name {
+                return Some(Symbol(id));
+            }
+            hash = hash.wrapping_add(1);
+        }
+    }
+
+    /// The text of a symbol from this document.
+    pub fn symbol_name(&self, symbol: Symbol) -> &str {
+        self.str(self.symbol_names[symbol.0 as usize])
+    }
+
+    /// Number of distinct key and tag names.
+    pub fn symbol_count(&self) -> usize {
+        self.symbol_names.len()
+    }
+
+    /// The symbol table's `(hash, symbol id)` slots, in no particular order.
+    pub(crate) fn symbol_slots(&self) -> impl Iterator<Item = (u64, u32)> + '_ {
+        self.symbol_ids.iter().map(|(&hash, &id)| (hash, id))
+    }
+
+    /// Copy the tree into an owned [`Document`].
+    pub fn to_document(&self) -> Document {
+        Document::from_root(self.root().to_object())
+    }
+
+    fn str(&self, s: Str) -> &str {
+        if s.pooled {
+            &self.strings[s.start..s.end]
+        } else {
+            &self.source[s.start..s.end]
+        }
+    }
+
+    /// Store `text`, borrowing it from the source when it points into it.
+    fn intern(&mut self, text: &str) -> Str {
+        let base = self.source.as_ptr() as usize;
+        let start = (text.as_ptr() as usize).wrapping_sub(base);
+        if start <= self.source.len() && text.len() <= self.source.len() - start {
+            return Str {
+                start,
+                end: start + text.len(),
+                pooled: false,
+            };
+        }
+        let start = self.strings.len();
+        self.strings.push_str(text);
+        Str {
+            start,
+            end: self.strings.len(),
+            pooled: true,
+        }
+    }
+
+    fn text(&mut self, text: Cow<'src, str>) -> Str {
+        match text {
+            Cow::Borrowed(s) => self.intern(s),
+            Cow::Owned(s) => {
+                let start = self.strings.len();
+                self.strings.push_str(&s);
+                Str {
+                    start,
+                    end: self.strings.len(),
+                    pooled: true,
+                }
+            }
+        }
+    }
+
+    fn push_node(&mut self, node: Node) -> usize {
+        self.nodes.push(node);
+        self.nodes.len() - 1
+    }
+
+    /// Intern the name stored at `s`, reusing the first occurrence's storage.
+    fn symbol_for(&mut self, s: Str) -> Symbol {
+        let mut hash = key_hash(self.str(s));
+        while let Some(&id) = self.symbol_ids.get(&hash) {
+            if self.str(self.symbol_names[id as usize]) == self.str(s) {
+                return Symbol(id);
+            }
+            hash = hash.wrapping_add(1);
+        }
+        let id = self.symbol_names.len() as u32;
+        self.symbol_names.push(s);
+        self.symbol_ids.insert(hash, id);
+        Symbol(id)
+    }
+
+    /// The symbol an entry with key node `key` is found by.
+    fn key_symbol(&mut self, key: usize) -> Symbol {
+        match self.nodes[key] {
+            Node {
+                tag: None,
+                payload: NodePayload::Scalar { text, .. },
+                ..
+            } => self.symbol_for(text),
+            _ => NO_SYMBOL,
+        }
+    }
+}
+
+/// A value in an [`ArenaDocument`].
+#[derive(Clone, Copy)]
+pub struct ArenaValue<'a> {
+    doc: &'a ArenaDocument<'a>,
+    id: usize,
+}
+
+impl<'a> ArenaValue<'a> {
+    fn node(&self) -> &'a Node {
+        &self.doc.nodes[self.id]
+    }
+
+    /// Source span (None if synthesized, e.g. an implicit unit key).
+    pub fn span(&self) -> Option<Span> {
+        self.node().span
+    }
+
+    /// Check if this is unit (`@` - no tag, no payload).
+    pub fn is_unit(&self) -> bool {
+        let node = self.node();
+        node.tag.is_none() && matches!(node.payload, NodePayload::None)
+    }
+
+    /// Get the tag name if present.
+    pub fn tag_name(&self) -> Option<&'a str> {
+        self.node().tag.map(|t| self.doc.symbol_name(t.name))
+    }
+
+    /// Get the tag's interned name if present.
+    pub fn tag_symbol(&self) -> Option<Symbol> {
+        self.node().tag.map(|t| t.name)
+    }
+
+    /// Get the tag span if present.
+    pub fn tag_span(&self) -> Option<Span> {
+        self.node().tag.map(|t| t.span)
+    }
+
+    /// Get as string (for untagged scalars).
+    pub fn as_str(&self) -> Option<&'a str> {
+        if self.node().tag.is_some() {
+            return None;
+        }
+        self.scalar_text()
+    }
+
+    /// Get the scalar text regardless of tag.
+    pub fn scalar_text(&self) -> Option<&'a str> {
+        match self.node().payload {
+            NodePayload::Scalar { text, .. } => Some(self.doc.str(text)),
+            _ => None,
+        }
+    }
+
+    /// Get the scalar kind, if the payload is a scalar.
+    pub fn scalar_kind(&self) -> Option<ScalarKind> {
+        match self.node().payload {
+            NodePayload::Scalar { kind, .. } => Some(kind),
+            _ => None,
+        }
+    }
+
+    /// Get as object (payload only).
+    pub fn as_object(&self) -> Option<ArenaObject<'a>> {
+        match self.node().payload {
+            NodePayload::Object(run) => Some(ArenaObject {
+                doc: self.doc,
+                run,
+                span: self.span(),
+            }),
+            _ => None,
+        }
+    }
+
+    /// Get as sequence (payload only).
+    pub fn as_sequence(&self) -> Option<ArenaSequence<'a>> {
+        match self.node().payload {
+            NodePayload::Sequence(run) => Some(ArenaSequence {
+                doc: self.doc,
+                run,
+                span: self.span(),
+            }),
+            _ => None,
+        }
+    }
+
+    /// Get a value by path, like [`Value::get`].
+    pub fn get(&self, path: &str) -> Option<ArenaValue<'a>> {
+        if path.is_empty() {
+            return Some(*self);
+        }
+
+        let (segment, rest) = split_path(path);
+
+        let value = match self.node().payload {
+            NodePayload::Object(_) => self.as_object()?.get(segment)?,
+            NodePayload::Sequence(_) => {
+                let idx: usize = segment.strip_prefix('[')?.strip_suffix(']')?.parse().ok()?;
+                self.as_sequence()?.get(idx)?
+            }
+            _ => return None,
+        };
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Copy this value into an owned [`Value`].
+    pub fn to_value(&self) -> Value {
+        let node = self.node();
+        let payload = match node.payload {
+            NodePayload::None => None,
+            NodePayload::Scalar { text, kind } => Some(Payload::Scalar(Scalar {
+                text: self.doc.str(text).to_string(),
+                kind,
+                span: node.span,
+            })),
+            NodePayload::Sequence(_) => {
+                Some(Payload::Sequence(self.as_sequence().unwrap().to_sequence()))
+            }
+            NodePayload::Object(_) => Some(Payload::Object(self.as_object().unwrap().to_object())),
+        };
+        Value {
+            tag: node.tag.map(|t| Tag {
+                name: self.doc.symbol_name(t.name).to_string(),
+                span: Some(t.span),
+            }),
+            payload,
+            span: node.span,
+        }
+    }
+}
+
+impl std::fmt::Debug for ArenaValue<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        std::fmt::Debug::fmt(&self.to_value(), f)
+    }
+}
+
+/// An object in an [`ArenaDocument`].
+#[derive(Clone, Copy)]
+pub struct ArenaObject<'a> {
+    doc: &'a ArenaDocument<'a>,
+    run: Run,
+    span: Option<Span>,
+}
+
+impl<'a> ArenaObject<'a> {
+    fn entry_nodes(&self) -> &'a [EntryNode] {
+        &self.doc.entries[self.run.start..self.run.start + self.run.len]
+    }
+
+    /// Source span (None for the implicit root).
+    pub fn span(&self) -> Option<Span> {
+        self.span
+    }
+
+    /// Number of entries.
+    pub fn len(&self) -> usize {
+        self.run.len
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.run.len == 0
+    }
+
+    /// Get the entry at `index`.
+    pub fn entry(&self, index: usize) -> Option<ArenaEntry<'a>> {
+        self.entry_nodes().get(index).map(|e| self.wrap(e))
+    }
+
+    /// Get entry value by key (for untagged scalar keys).
+    pub fn get(&self, key: &str) -> Option<ArenaValue<'a>> {
+        self.get_symbol(self.doc.symbol(key)?)
+    }
+
+    /// Get entry value by interned key (see [`ArenaDocument::symbol`]).
+    pub fn get_symbol(&self, key: Symbol) -> Option<ArenaValue<'a>> {
+        self.entry_nodes()
+            .iter()
+            .find(|e| e.key_symbol == key)
+            .map(|e| self.wrap(e).value())
+    }
+
+    /// Iterate over entries.
+    pub fn iter(&self) -> impl Iterator<Item = ArenaEntry<'a>> + 'a {
+        let this = *self;
+        self.entry_nodes().iter().map(move |e| this.wrap(e))
+    }
+
+    /// Copy this object into an owned [`Object`].
+    pub fn to_object(&self) -> Object {
+        let entries = self
+            .iter()
+            .map(|e| Entry {
+                key: e.key().to_value(),
+                value: e.value().to_value(),
+                doc_comment: e.doc_comment().map(str::to_string),
+            })
+            .collect();
+        Object::new(entries, self.span)
+    }
+
+    fn wrap(&self, e: &EntryNode) -> ArenaEntry<'a> {
+        ArenaEntry {
+            doc: self.doc,
+            node: *e,
+        }
+    }
+}
+
+/// An entry (key-value pair) in an [`ArenaObject`].
+#[derive(Clone, Copy)]
+pub struct ArenaEntry<'a> {
+    doc: &'a ArenaDocument<'a>,
+    node: EntryNode,
+}
+
+impl<'a> ArenaEntry<'a> {
+    /// The key.
+    pub fn key(&self) -> ArenaValue<'a> {
+        ArenaValue {
+            doc: self.doc,
+            id: self.node.key,
+        }
+    }
+
+    /// The key's interned text, if the key is an untagged scalar.
+    pub fn key_symbol(&self) -> Option<Symbol> {
+        Some(self.node.key_symbol).filter(|&s| s != NO_SYMBOL)
+    }
+
+    /// The value.
+    pub fn value(&self) -> ArenaValue<'a> {
+        ArenaValue {
+            doc: self.doc,
+            id: self.node.value,
+        }
+    }
+
+    /// Doc comment attached to this entry.
+    pub fn doc_comment(&self) -> Option<&'a str> {
+        self.node.doc_comment.map(|s| self.doc.str(s))
+    }
+}
+
+/// A sequence in an [`ArenaDocument`].
+#[derive(Clone, Copy)]
+pub struct ArenaSequence<'a> {
+    doc: &'a ArenaDocument<'a>,
+    run: Run,
+    span: Option<Span>,
+}
+
+impl<'a> ArenaSequence<'a> {
+    fn ids(&self) -> &'a [usize] {
+        &self.doc.items[self.run.start..self.run.start + self.run.len]
+    }
+
+    /// Source span.
+    pub fn span(&self) -> Option<Span> {
+        self.span
+    }
+
+    /// Number of items.
+    pub fn len(&self) -> usize {
+        self.run.len
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.run.len == 0
+    }
+
+    /// Get item by index.
+    pub fn get(&self, index: usize) -> Option<ArenaValue<'a>> {
+        self.ids()
+            .get(index)
+            .map(|&id| ArenaValue { doc: self.doc, id })
+    }
+
+    /// Iterate over items.
+    pub fn iter(&self) -> impl Iterator<Item = ArenaValue<'a>> + 'a {
+        let doc = self.doc;
+        self.ids().iter().map(move |&id| ArenaValue { doc, id })
+    }
+
+    /// Copy this sequence into an owned [`Sequence`].
+    pub fn to_sequence(&self) -> Sequence {
+        Sequence {
+            items: self.iter().map(|v| v.to_value()).collect(),
+            span: self.span,
+        }
+    }
+}
+
+/// Builder that constructs an [`ArenaDocument`] from parse events.
+///
+/// Follows the same rules as [`TreeBuilder`](crate::TreeBuilder). Children
+/// are collected on shared scratch stacks and moved into the arena in one
+/// contiguous run when their container closes.
+pub struct ArenaBuilder<'src> {
+    doc: ArenaDocument<'src>,
+    stack: Vec<Frame>,
+    root_entries: Vec<EntryNode>,
+    pending_doc_comment: Option<Str>,
+    scratch_entries: Vec<EntryNode>,
+    scratch_items: Vec<usize>,
+    errors: Vec<(ParseErrorKind, Span)>,
+}
+
+enum Frame {
+    Object {
+        start: usize,
+        span: Span,
+        pending_doc_comment: Option<Str>,
+    },
+    Sequence {
+        start: usize,
+        span: Span,
+    },
+    Tag {
+        name: Symbol,
+        span: Span,
+    },
+    Entry {
+        key: Option<usize>,
+        doc_comment: Option<Str>,
+    },
+}
+
+const UNIT: Node = Node {
+    tag: None,
+    payload: NodePayload::None,
+    span: None,
+};
+
+impl<'src> ArenaBuilder<'src> {
+    /// Create a builder for events parsed from `source`.
+    pub fn new(source: &'src str) -> Self {
+        Self {
+            doc: ArenaDocument {
+                source,
+                strings: String::new(),
+                nodes: Vec::new(),
+                entries: Vec::new(),
+                items: Vec::new(),
+                root: Run { start: 0, len: 0 },
+                symbol_names: Vec::new(),
+                symbol_ids: HashMap::default(),
+            },
+            stack: Vec::new(),
+            root_entries: Vec::new(),
+            pending_doc_comment: None,
+            scratch_entries: Vec::new(),
+            scratch_items: Vec::new(),
+            errors: Vec::new(),
+        }
+    }
+
+    /// Finish building and return the document.
+    pub fn finish(mut self) -> Result<ArenaDocument<'src>, BuildError> {
+        if let Some((kind, span)) = self.errors.into_iter().next() {
+            return Err(BuildError::Parse(kind, span));
+        }
+
+        if !self.stack.is_empty() {
+            return Err(BuildError::UnclosedStructure);
+        }
+
+        self.doc.root = Run {
+            start: self.doc.entries.len(),
+            len: self.root_entries.len(),
+        };
+        self.doc.entries.append(&mut self.root_entries);
+        Ok(self.doc)
+    }
+
+    /// Process a parse event.
+    pub fn event(&mut self, event: Event<'src>) {
+        let span = event.span;
+        match event.kind {
+            EventKind::DocumentStart | EventKind::DocumentEnd => {}
+
+            EventKind::ObjectStart => {
+                self.stack.push(Frame::Object {
+                    start: self.scratch_entries.len(),
+                    span,
+                    pending_doc_comment: None,
+                });
+            }
+
+            EventKind::ObjectEnd => match self.stack.pop() {
+                Some(Frame::Object {
+                    start,
+                    span: start_span,
+                    ..
+                }) => {
+                    // If stack is now empty, this is the root object
+                    if self.stack.is_empty() {
+                        self.root_entries.clear();
+                        self.root_entries
+                            .extend(self.scratch_entries.drain(start..));
+                    } else {
+                        let run = Run {
+                            start: self.doc.entries.len(),
+                            len: self.scratch_entries.len() - start,
+                        };
+                        self.doc.entries.extend(self.scratch_entries.drain(start..));
+                        let id = self.doc.push_node(Node {
+                            tag: None,
+                            payload: NodePayload::Object(run),
+                            span: Some(Span {
+                                start: start_span.start,
+                                end: span.end,
+                            }),
+                        });
+                        self.push_value(id);
+                    }
+                }
+                Some(frame) => self.discard(frame),
+                None => {}
+            },
+
+            EventKind::SequenceStart => {
+                self.stack.push(Frame::Sequence {
+                    start: self.scratch_items.len(),
+                    span,
+                });
+            }
+
+            EventKind::SequenceEnd => match self.stack.pop() {
+                Some(Frame::Sequence {
+                    start,
+                    span: start_span,
+                }) => {
+                    let run = Run {
+                        start: self.doc.items.len(),
+                        len: self.scratch_items.len() - start,
+                    };
+                    self.doc.items.extend(self.scratch_items.drain(start..));
+                    let id = self.doc.push_node(Node {
+                        tag: None,
+                        payload: NodePayload::Sequence(run),
+                        span: Some(Span {
+                            start: start_span.start,
+                            end: span.end,
+                        }),
+                    });
+                    self.push_value(id);
+                }
+                Some(frame) => self.discard(frame),
+                None => {}
+            },
+
+            EventKind::EntryStart => {
+                let doc_comment = match self.stack.last_mut() {
+                    Some(Frame::Object {
+                        pending_doc_comment,
+                        ..
+                    }) => pending_doc_comment.take(),
+                    _ => self.pending_doc_comment.take(),
+                };
+                self.stack.push(Frame::Entry {
+                    key: None,
+                    doc_comment,
+                });
+            }
+
+            EventKind::EntryEnd => match self.stack.pop() {
+                Some(Frame::Entry {
+                    key: Some(key),
+                    doc_comment,
+                }) => {
+                    // We have a key but might not have a value yet
+                    let entries = match self.stack.last() {
+                        Some(Frame::Object { start, .. }) => &mut self.scratch_entries[*start..],
+                        _ => &mut self.root_entries[..],
+                    };
+                    // Check if last entry needs this key
+                    if let Some(last) = entries.last_mut()
+                        && self.doc.nodes[last.key].tag.is_none()
+                        && matches!(self.doc.nodes[last.key].payload, NodePayload::None)
+                        && last.doc_comment.is_none()
+                    {
+                        last.key = key;
+                        last.key_symbol = self.doc.key_symbol(key);
+                        last.doc_comment = doc_comment;
+                        return;
+                    }
+                    // Otherwise add as unit-valued entry
+                    let value = self.doc.push_node(UNIT);
+                    let key_symbol = self.doc.key_symbol(key);
+                    self.add_entry(EntryNode {
+                        key,
+                        key_symbol,
+                        value,
+                        doc_comment,
+                    });
+                }
+                Some(Frame::Entry { key: None, .. }) | None => {}
+                Some(frame) => self.discard(frame),
+            },
+
+            EventKind::Key { tag, payload, kind } => {
+                let tag = tag.map(|name| {
+                    let name = self.doc.intern(name);
+                    TagNode {
+                        name: self.doc.symbol_for(name),
+                        span,
+                    }
+                });
+                let payload = match payload {
+                    Some(text) => NodePayload::Scalar {
+                        text: self.doc.text(text),
+                        kind,
+                    },
+                    None => NodePayload::None,
+                };
+                let id = self.doc.push_node(Node {
+                    tag,
+                    payload,
+                    span: Some(span),
+                });
+                if let Some(Frame::Entry { key, .. }) = self.stack.last_mut() {
+                    *key = Some(id);
+                }
+            }
+
+            EventKind::Scalar { value, kind } => {
+                let text = self.doc.text(value);
+                let id = self.doc.push_node(Node {
+                    tag: None,
+                    payload: NodePayload::Scalar { text, kind },
+                    span: Some(span),
+                });
+                self.push_value(id);
+            }
+
+            EventKind::Unit => {
+                let id = self.doc.push_node(Node {
+                    span: Some(span),
+                    ..UNIT
+                });
+                self.push_value(id);
+            }
+
+            EventKind::TagStart { name } => {
+                let name = self.doc.intern(name);
+                let name = self.doc.symbol_for(name);
+                self.stack.push(Frame::Tag { name, span });
+            }
+
+            EventKind::TagEnd => {
+                // Only pop if the top frame is a Tag - otherwise the tag was already
+                // consumed when its payload was processed
+                if let Some(Frame::Tag { name, span }) = self.stack.last() {
+                    let node = Node {
+                        tag: Some(TagNode {
+                            name: *name,
+                            span: *span,
+                        }),
+                        payload: NodePayload::None,
+                        span: Some(*span),
+                    };
+                    self.stack.pop();
+                    let id = self.doc.push_node(node);
+                    self.push_value(id);
+                }
+            }
+
+            EventKind::DocComment { lines } => {
+                let target = match self.stack.last_mut() {
+                    Some(Frame::Object {
+                        pending_doc_comment,
+                        ..
+                    }) => pending_doc_comment,
+                    _ => &mut self.pending_doc_comment,
+                };
+                append_doc_comment(&mut self.doc.strings, target, &lines);
+            }
+
+            EventKind::Comment { .. } => {}
+
+            EventKind::Error { kind } => {
+                self.errors.push((kind, span));
+            }
+        }
+    }
+
+    /// Push a completed value to the current context.
+    fn push_value(&mut self, id: usize) {
+        match self.stack.last_mut() {
+            // The value becomes the tag's payload
+            Some(Frame::Tag { .. }) => {
+                if let Some(Frame::Tag { name, span }) = self.stack.pop() {
+                    self.doc.nodes[id].tag = Some(TagNode { name, span });
+                    self.push_value(id);
+                }
+            }
+            // The value completes an entry
+            Some(Frame::Entry {
+                key: key @ Some(_),
+                doc_comment,
+            }) => {
+                let key = key.take().unwrap();
+                let doc_comment = doc_comment.take();
+                let entry = EntryNode {
+                    key,
+                    key_symbol: self.doc.key_symbol(key),
+                    value: id,
+                    doc_comment,
+                };
+                self.stack.pop();
+                self.add_entry(entry);
+                // Re-push an empty entry frame for potential continuation
+                self.stack.push(Frame::Entry {
+                    key: None,
+                    doc_comment: None,
+                });
+            }
+            Some(Frame::Entry { key, .. }) => *key = Some(id),
+            Some(Frame::Object {
+                pending_doc_comment,
+                ..
+            }) => {
+                // Value for an entry without explicit key - use unit key
+                let doc_comment = pending_doc_comment.take();
+                let key = self.doc.push_node(UNIT);
+                self.scratch_entries.push(EntryNode {
+                    key,
+                    key_symbol: NO_SYMBOL,
+                    value: id,
+                    doc_comment,
+                });
+            }
+            Some(Frame::Sequence { .. }) => self.scratch_items.push(id),
+            None => {
+                let key = self.doc.push_node(UNIT);
+                self.root_entries.push(EntryNode {
+                    key,
+                    key_symbol: NO_SYMBOL,
+                    value: id,
+                    doc_comment: self.pending_doc_comment.take(),
+                });
+            }
+        }
+    }
+
+    /// Add a finished entry to the enclosing object (or the root).
+    fn add_entry(&mut self, entry: EntryNode) {
+        match self.stack.last() {
+            Some(Frame::Object { .. }) => self.scratch_entries.push(entry),
+            _ => self.root_entries.push(entry),
+        }
+    }
+
+    /// Drop a frame closed by a mismatched event, along with its children.
+    fn discard(&mut self, frame: Frame) {
+        match frame {
+            Frame::Object { start, .. } => self.scratch_entries.truncate(start),
+            Frame::Sequence { start, .. } => self.scratch_items.truncate(start),
+            Frame::Tag { .. } | Frame::Entry { .. } => {}
+        }
+    }
+}
+
+/// Append doc comment lines to `target` in the string pool, joining with newlines.
+fn append_doc_comment(strings: &mut String, target: &mut Option<Str>, lines: &[&str]) {
+    let start = match *target {
+        // Already at the end of the pool: extend in place
+        Some(s) if s.end == strings.len() => {
+            strings.push('\n');
+            s.start
+        }
+        Some(s) => {
+            let start = strings.len();
+            strings.extend_from_within(s.start..s.end);
+            strings.push('\n');
+            start
+        }
+        None => strings.len(),
+    };
+    for (i, line) in lines.iter().enumerate() {
+        if i > 0 {
+            strings.push('\n');
+        }
+        strings.push_str(line);
+    }
+    *target = Some(Str {
+        start,
+        end: strings.len(),
+        pooled: true,
+    });
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn assert_same_tree(source: &str) {
+        let owned = Document::parse(source);
+        let arena = ArenaDocument::parse(source);
+        match (owned, arena) {
+            (Ok(owned), Ok(arena)) => assert_eq!(arena.to_document(), owned, "{source:?}"),
+            (Err(a), Err(b)) => assert_eq!(a, b, "{source:?}"),
+            (a, b) => panic!(
+                "{source:?}: tree {a:?}, arena {:?}",
+                b.map(|d| d.to_document())
+            ),
+        }
+    }
+
+    #[test]
+    fn test_matches_tree_builder() {
+        for source in [
+            "",
+            "name Alice\nage 30",
+            "server {\n  host localhost\n  ports (8080 8443)\n}",
+            "/// Doc\n/// more\nkey value\n/// Second\nother @",
+            "obj {\n  /// inner\n  a 1\n  b \"quoted\\tvalue\"\n}",
+            "tagged @tag{a b}\nunit @\nbare @string\nseq @list(a (b c) {d e})",
+            "@ @object{\n  name @string\n}",
+            "{ explicit root }",
+            "a.b.c deep\na.b.d sibling",
+            "key \"unterminated",
+            "a {b c",
+            "dup 1\ndup 2",
+            "raw r#\"x \"y\"\"#\nheredoc <<EOF\n  text\n  EOF\n",
+        ] {
+            assert_same_tree(source);
+        }
+    }
+
+    #[test]
+    fn test_matches_tree_builder_on_corpus() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                if let Ok(source) = std::fs::read_to_string(file.path()) {
+                    assert_same_tree(&source);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_borrows_from_source() {
+        let source = "name Alice\nnote \"a\\nb\"\n/// doc\nk @tag";
+        let doc = ArenaDocument::parse(source).unwrap();
+
+        let name = doc.get("name").unwrap().as_str().unwrap();
+        assert_eq!(name, "Alice");
+        assert!(source.as_bytes().as_ptr_range().contains(&name.as_ptr()));
+
+        // Escapes and doc comments live in the pool
+        assert_eq!(doc.get("note").unwrap().as_str(), Some("a\nb"));
+        let entry = doc.root().iter().find(|e| e.key().as_str() == Some("k"));
+        assert_eq!(entry.unwrap().doc_comment(), Some("doc"));
+        assert_eq!(doc.get("k").unwrap().tag_name(), Some("tag"));
+    }
+
+    #[test]
+    fn test_navigation() {
+        let doc = ArenaDocument::parse("server {\n  hosts ({name a} {name b})\n}").unwrap();
+        assert_eq!(
+            doc.get("server.hosts[1].name").and_then(|v| v.as_str()),
+            Some("b")
+        );
+        assert!(doc.get("server.hosts[2]").is_none());
+        let hosts = doc.get("server.hosts").unwrap().as_sequence().unwrap();
+        assert_eq!(hosts.len(), 2);
+        let names: Vec<_> = hosts
+            .iter()
+            .map(|h| h.get("name").unwrap().as_str().unwrap())
+            .collect();
+        assert_eq!(names, ["a", "b"]);
+        assert_eq!(doc.root().len(), 1);
+    }
+
+    #[test]
+    fn test_symbols() {
+        let doc = ArenaDocument::parse(
+            "a {name x, port 1}\nb {name y, port 2, tag @name}\n\"name\" @port\n",
+        )
+        .unwrap();
+        // a, b, name, port, tag: keys, quoted keys and tag names share symbols
+        assert_eq!(doc.symbol_count(), 5);
+        let name = doc.symbol("name").unwrap();
+        assert_eq!(doc.symbol_name(name), "name");
+        assert!(doc.symbol("missing").is_none());
+
+        let b = doc.get("b").unwrap().as_object().unwrap();
+        assert_eq!(b.get_symbol(name).and_then(|v| v.as_str()), Some("y"));
+        assert_eq!(b.entry(0).unwrap().key_symbol(), Some(name));
+        assert_eq!(doc.get("b.tag").unwrap().tag_symbol(), doc.symbol("name"));
+        assert_eq!(doc.get("name").unwrap().tag_symbol(), doc.symbol("port"));
+        // Unit keys have no symbol
+        let unit = ArenaDocument::parse("@ x").unwrap();
+        assert_eq!(unit.root().entry(0).unwrap().key_symbol(), None);
+    }
+}
@@ -1,9 +1,11 @@
 //! Tree builder from parse events.
 
 use std::borrow::Cow;
+use std::sync::Arc;
 
 use styx_parse::{Event, ParseErrorKind, Span};
 
+use crate::pool::NodePool;
 use crate::value::{Entry, Object, Payload, Scalar, Sequence, Tag, Value};
 
 /// Error during tree building.
@@ -17,6 +19,8 @@ pub enum BuildError {
     EmptyDocument,
     /// Parse error from the lexer/parser.
     Parse(ParseErrorKind, Span),
+    /// The document is too large for a representation with 32-bit offsets.
+    TooLarge,
 }
 
 impl std::fmt::Display for BuildError {
@@ -25,6 +29,7 @@ impl std::fmt::Display for BuildError {
             BuildError::UnexpectedEvent(msg) => write!(f, "unexpected event: {}", msg),
             BuildError::UnclosedStructure => write!(f, "unclosed structure"),
             BuildError::EmptyDocument => write!(f, "empty document"),
+            BuildError::TooLarge => write!(f, "document is too large"),
             BuildError::Parse(kind, span) => {
                 write!(f, "parse error at {}-{}: {}", span.start, span.end, kind)
             }
@@ -52,6 +57,10 @@ pub struct TreeBuilder {
     root_entries: Vec<Entry>,
     pending_doc_comment: Option<String>,
     errors: Vec<(ParseErrorKind, Span)>,
+    /// Source for the deferred objects of a lazy parse.
+    lazy_source: Option<Arc<str>>,
+    /// Spare storage to build from (see [`DocumentParser`](crate::DocumentParser)).
+    pub(crate) pool: NodePool,
 }
 
 enum BuilderFrame {
@@ -82,27 +91,54 @@ impl TreeBuilder {
             root_entries: Vec::new(),
             pending_doc_comment: None,
             errors: Vec::new(),
+            lazy_source: None,
+            pool: NodePool::default(),
+        }
+    }
+
+    /// Create a builder for events from a shallow parser over `source`: empty
+    /// nested objects become deferred objects over their span.
+    pub(crate) fn lazy(source: Arc<str>) -> Self {
+        Self {
+            lazy_source: Some(source),
+            ..Self::new()
         }
     }
 
     /// Finish building and return the root value.
-    pub fn finish(self) -> Result<Value, BuildError> {
+    pub fn finish(mut self) -> Result<Value, BuildError> {
+        self.finish_in_place()
+    }
+
+    /// Finish building, leaving the builder empty for the next document but
+    /// keeping its buffers.
+    pub(crate) fn finish_in_place(&mut self) -> Result<Value, BuildError> {
+        let root_entries = std::mem::take(&mut self.root_entries);
+        self.pending_doc_comment = None;
+
         // Return the first error if any occurred during parsing
-        if let Some((kind, span)) = self.errors.into_iter().next() {
+        if !self.errors.is_empty() {
+            let (kind, span) = self.errors.swap_remove(0);
+            self.errors.clear();
+            self.stack.clear();
+            self.pool.recycle_entries(root_entries);
             return Err(BuildError::Parse(kind, span));
         }
 
         if !self.stack.is_empty() {
+            self.stack.clear();
+            self.pool.recycle_entries(root_entries);
             return Err(BuildError::UnclosedStructure);
         }
 
         // Root is always an implicit object (no tag)
+        let root = Object::new(root_entries, None);
+        if self.lazy_source.is_none() {
+            root.subtree_hash();
+        }
         Ok(Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: self.root_entries,
-                span: None,
-            })),
+            payload: Some(Payload::Object(root)),
             span: None,
         })
     }
@@ -213,7 +249,7 @@ impl TreeBuilder {
 
             styx_parse::EventKind::ObjectStart => {
                 self.stack.push(BuilderFrame::Object {
-                    entries: Vec::new(),
+                    entries: self.pool.entries(),
                     span,
                     pending_doc_comment: None,
                 });
@@ -230,15 +266,28 @@ impl TreeBuilder {
                     if self.stack.is_empty() {
                         self.root_entries = entries;
                     } else {
+                        let object_span = Span {
+                            start: start_span.start,
+                            end: span.end,
+                        };
+                        let object = match &self.lazy_source {
+                            // A shallow parser reports skipped blocks as
+                            // empty objects.
+                            Some(source) if entries.is_empty() => {
+                                Object::deferred(source.clone(), object_span)
+                            }
+                            Some(_) => Object::new(entries, Some(object_span)),
+                            None => {
+                                let object = Object::new(entries, Some(object_span));
+                                // Children are closed first, so this hashes
+                                // each node once.
+                                object.subtree_hash();
+                                object
+                            }
+                        };
                         let obj = Value {
                             tag: None,
-                            payload: Some(Payload::Object(Object {
-                                entries,
-                                span: Some(Span {
-                                    start: start_span.start,
-                                    end: span.end,
-                                }),
-                            })),
+                            payload: Some(Payload::Object(object)),
                             span: Some(Span {
                                 start: start_span.start,
                                 end: span.end,
@@ -251,7 +300,7 @@ impl TreeBuilder {
 
             styx_parse::EventKind::SequenceStart => {
                 self.stack.push(BuilderFrame::Sequence {
-                    items: Vec::new(),
+                    items: self.pool.items(),
                     span,
                 });
             }
@@ -340,12 +389,12 @@ impl TreeBuilder {
             styx_parse::EventKind::Key { tag, payload, kind } => {
                 let key_value = Value {
                     tag: tag.map(|name| Tag {
-                        name: name.to_string(),
+                        name: self.pool.string(Cow::Borrowed(name)),
                         span: Some(span),
                     }),
                     payload: payload.map(|text| {
                         Payload::Scalar(Scalar {
-                            text: cow_to_string(text),
+                            text: self.pool.string(text),
                             kind,
                             span: Some(span),
                         })
@@ -361,7 +410,7 @@ impl TreeBuilder {
                 let scalar = Value {
                     tag: None,
                     payload: Some(Payload::Scalar(Scalar {
-                        text: cow_to_string(value),
+                        text: self.pool.string(value),
                         kind,
                         span: Some(span),
                     })),
@@ -450,7 +499,7 @@ impl TreeBuilder {
 
             styx_parse::EventKind::TagStart { name } => {
                 self.stack.push(BuilderFrame::Tag {
-                    name: name.to_string(),
+                    name: self.pool.string(Cow::Borrowed(name)),
                     span,
                 });
             }
@@ -534,10 +583,6 @@ impl TreeBuilder {
     }
 }
 
-fn cow_to_string(cow: Cow<'_, str>) -> String {
-    cow.into_owned()
-}
-
 /// Append a doc comment line to an existing doc comment, joining with newline.
 fn append_doc_comment(target: &mut Option<String>, line: String) {
     match target {
@@ -618,11 +663,11 @@ mod tests {
         let value = parse("@ server.schema.styx");
         let obj = value.as_object().unwrap();
         // The unit key entry
-        let unit_entry = obj.entries.iter().find(|e| e.key.is_unit());
+        let unit_entry = obj.entries().iter().find(|e| e.key.is_unit());
         assert!(
             unit_entry.is_some(),
             "should have unit key entry, got: {:?}",
-            obj.entries
+            obj.entries()
                 .iter()
                 .map(|e| format!("key={:?}", e.key))
                 .collect::<Vec<_>>()
@@ -710,7 +755,7 @@ mod tests {
         let obj = value.as_object().unwrap();
         eprintln!(
             "Root entries: {:?}",
-            obj.entries
+            obj.entries()
                 .iter()
                 .map(|e| e.key.as_str())
                 .collect::<Vec<_>>()
@@ -732,7 +777,10 @@ mod tests {
 name @string"#;
         let value = parse(source);
         let obj = value.as_object().unwrap();
-        let entry = obj.entries.iter().find(|e| e.key.as_str() == Some("name"));
+        let entry = obj
+            .entries()
+            .iter()
+            .find(|e| e.key.as_str() == Some("name"));
         assert!(entry.is_some(), "should have 'name' entry");
         let entry = entry.unwrap();
         assert_eq!(
@@ -748,7 +796,10 @@ name @string"#;
 value 42"#;
         let value = parse(source);
         let obj = value.as_object().unwrap();
-        let entry = obj.entries.iter().find(|e| e.key.as_str() == Some("value"));
+        let entry = obj
+            .entries()
+            .iter()
+            .find(|e| e.key.as_str() == Some("value"));
         assert!(entry.is_some(), "should have 'value' entry");
         let entry = entry.unwrap();
         assert_eq!(entry.doc_comment, Some("Just one line".to_string()),);
@@ -768,7 +819,7 @@ value 42"#;
         let schema = obj.get("schema").expect("should have schema");
         let schema_obj = schema.as_object().expect("schema should be an object");
         let entry = schema_obj
-            .entries
+            .entries()
             .iter()
             .find(|e| e.key.as_str() == Some("field"));
         assert!(entry.is_some(), "should have 'field' entry");
@@ -0,0 +1,368 @@
+//! On-disk cache of parsed documents.
+//!
+//! Build steps tend to parse the same files on every run. A [`ParseCache`]
+//! stores each document it parses in the compiled binary format, in a file
+//! named after a 128-bit hash of the source text and the parser version, so
+//! a later parse of the same text loads the compiled image instead.
+//!
+//! Each entry starts with the hash of the source it was compiled from and a
+//! hash of the compiled image, and is only used when both match. The cache
+//! is only ever an optimization: sources that fail to parse are not stored,
+//! unreadable, misplaced or corrupt entries are parsed again and replaced,
+//! and the directory can be deleted at any time.
+
+use std::fs;
+use std::io;
+use std::path::{Path as FsPath, PathBuf};
+use std::sync::OnceLock;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use crate::compiled::COMPILED_VERSION;
+use crate::index::key_hash;
+use crate::{BuildError, Document};
+
+/// Environment variable naming the directory used by
+/// [`Document::parse_cached`].
+pub const PARSE_CACHE_ENV: &str = "STYX_PARSE_CACHE";
+
+/// Extension of cache entries.
+const EXTENSION: &str = "styxc";
+
+/// Length of the entry header: the source hash, then the payload hash.
+const ENTRY_HEADER_LEN: usize = 32;
+
+/// Sources below this many bytes are parsed directly, so that small
+/// messages do not fill the directory with entries.
+const DEFAULT_MIN_LEN: usize = 1024;
+
+/// A directory of compiled documents keyed by the hash of their source.
+///
+/// Safe to share between threads and processes: entries are written to a
+/// temporary file and renamed into place.
+///
+/// ```no_run
+/// use styx_tree::ParseCache;
+///
+/// let cache = ParseCache::new("target/styx-cache");
+/// let source = std::fs::read_to_string("config.styx").unwrap();
+/// // Parses and stores the first time, loads the compiled form afterwards.
+/// let doc = cache.parse(&source).unwrap();
+/// # drop(doc);
+/// ```
+#[derive(Debug, Clone)]
+pub struct ParseCache {
+    dir: PathBuf,
+    min_len: usize,
+}
+
+impl ParseCache {
+    /// Use `dir` for cache entries. It is created on the first store.
+    pub fn new(dir: impl Into<PathBuf>) -> Self {
+        ParseCache {
+            dir: dir.into(),
+            min_len: DEFAULT_MIN_LEN,
+        }
+    }
+
+    /// The cache named by the `STYX_PARSE_CACHE` environment variable, if it
+    /// is set and not empty.
+    pub fn from_env() -> Option<Self> {
+        let dir = std::env::var_os(PARSE_CACHE_ENV)?;
+        (!dir.is_empty()).then(|| ParseCache::new(dir))
+    }
+
+    /// Parse sources shorter than `len` bytes directly, without touching the
+    /// cache. Defaults to 1 KiB.
+    pub fn min_len(mut self, len: usize) -> Self {
+        self.min_len = len;
+        self
+    }
+
+    /// The cache directory.
+    pub fn dir(&self) -> &FsPath {
+        &self.dir
+    }
+
+    /// Parse `source`, loading the result from the cache when it is there
+    /// and storing it when it is not.
+    ///
+    /// Produces the same document or error as [`Document::parse`].
+    pub fn parse(&self, source: &str) -> Result<Document, BuildError> {
+        if source.len() < self.min_len {
+            return Document::parse(source);
+        }
+        let source_hash = content_hash(source.as_bytes());
+        let path = self.path_for(source_hash);
+        if let Some(doc) = load(&path, source_hash) {
+            return Ok(doc);
+        }
+        let doc = Document::parse(source)?;
+        // A failed store only costs the next run a parse.
+        if let Ok(payload) = doc.compile() {
+            let mut bytes = Vec::with_capacity(ENTRY_HEADER_LEN + payload.len());
+            bytes.extend_from_slice(&source_hash.to_le_bytes());
+            bytes.extend_from_slice(&content_hash(&payload).to_le_bytes());
+            bytes.extend_from_slice(&payload);
+            let _ = self.store(&path, &bytes);
+        }
+        Ok(doc)
+    }
+
+    /// Where the entry for `source` is stored.
+    pub fn entry_path(&self, source: &str) -> PathBuf {
+        self.path_for(content_hash(source.as_bytes()))
+    }
+
+    fn path_for(&self, source_hash: u128) -> PathBuf {
+        self.dir.join(format!("{source_hash:032x}.{EXTENSION}"))
+    }
+
+    fn store(&self, path: &FsPath, bytes: &[u8]) -> io::Result<()> {
+        static COUNTER: AtomicU64 = AtomicU64::new(0);
+        fs::create_dir_all(&self.dir)?;
+        let temp = path.with_extension(format!(
+            "{}.{}.tmp",
+            std::process::id(),
+            COUNTER.fetch_add(1, Ordering::Relaxed)
+        ));
+        fs::write(&temp, bytes)?;
+        fs::rename(&temp, path).inspect_err(|_| {
+            let _ = fs::remove_file(&temp);
+        })
+    }
+
+    /// Number of entries and their total size in bytes.
+    pub fn stats(&self) -> io::Result<(usize, u64)> {
+        self.walk(|_| Ok(()))
+    }
+
+    /// Delete every entry, returning how many there were and their total
+    /// size in bytes. Other files in the directory are left alone.
+    pub fn clear(&self) -> io::Result<(usize, u64)> {
+        self.walk(|path| fs::remove_file(path))
+    }
+
+    /// Call `f` on every entry (and leftover temporary file).
+    fn walk(&self, mut f: impl FnMut(&FsPath) -> io::Result<()>) -> io::Result<(usize, u64)> {
+        let entries = match fs::read_dir(&self.dir) {
+            Ok(entries) => entries,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok((0, 0)),
+            Err(e) => return Err(e),
+        };
+        let (mut count, mut size) = (0, 0);
+        for entry in entries {
+            let path = entry?.path();
+            let name = path.file_name().and_then(|n| n.to_str()).unwrap_or("");
+            if name.ends_with(&format!(".{EXTENSION}")) || name.ends_with(".tmp") {
+                size += fs::metadata(&path).map(|m| m.len()).unwrap_or(0);
+                f(&path)?;
+                count += 1;
+            }
+        }
+        Ok((count, size))
+    }
+}
+
+/// The document stored at `path`, if the entry is for the source with hash
+/// `source_hash` and its payload is intact.
+fn load(path: &FsPath, source_hash: u128) -> Option<Document> {
+    let bytes = fs::read(path).ok()?;
+    let (header, payload) = bytes.split_at_checked(ENTRY_HEADER_LEN)?;
+    let (stored_source, stored_payload) = header.split_at(16);
+    if u128::from_le_bytes(stored_source.try_into().unwrap()) != source_hash
+        || u128::from_le_bytes(stored_payload.try_into().unwrap()) != content_hash(payload)
+    {
+        return None;
+    }
+    Document::from_compiled(payload).ok()
+}
+
+impl Document {
+    /// Parse a Styx document through the cache named by the
+    /// `STYX_PARSE_CACHE` environment variable, or directly if it is unset.
+    ///
+    /// The variable is read once per process. See [`ParseCache`].
+    pub fn parse_cached(source: &str) -> Result<Self, BuildError> {
+        static CACHE: OnceLock<Option<ParseCache>> = OnceLock::new();
+        match CACHE.get_or_init(ParseCache::from_env) {
+            Some(cache) => cache.parse(source),
+            None => Document::parse(source),
+        }
+    }
+}
+
+/// MurmurHash3 (x64, 128-bit) of `bytes`, seeded with the parser version so
+/// that entries written by other versions are never read.
+fn content_hash(bytes: &[u8]) -> u128 {
+    const C1: u64 = 0x87c3_7b91_1142_53d5;
+    const C2: u64 = 0x4cf5_ad43_2745_937f;
+
+    fn mix_k1(k: u64) -> u64 {
+        k.wrapping_mul(C1).rotate_left(31).wrapping_mul(C2)
+    }
+    fn mix_k2(k: u64) -> u64 {
+        k.wrapping_mul(C2).rotate_left(33).wrapping_mul(C1)
+    }
+    fn fmix(mut k: u64) -> u64 {
+        k ^= k >> 33;
+        k = k.wrapping_mul(0xff51_afd7_ed55_8ccd);
+        k ^= k >> 33;
+        k = k.wrapping_mul(0xc4ce_b9fe_1a85_ec53);
+        k ^ (k >> 33)
+    }
+
+    let seed = key_hash(concat!("styx-tree ", env!("CARGO_PKG_VERSION"))) ^ COMPILED_VERSION as u64;
+    let (mut h1, mut h2) = (seed, seed);
+    let mut blocks = bytes.chunks_exact(16);
+    for block in &mut blocks {
+        let k1 = u64::from_le_bytes(block[..8].try_into().unwrap());
+        let k2 = u64::from_le_bytes(block[8..].try_into().unwrap());
+        h1 ^= mix_k1(k1);
+        h1 = h1
+            .rotate_left(27)
+            .wrapping_add(h2)
+            .wrapping_mul(5)
+            .wrapping_add(0x52dc_e729);
+        h2 ^= mix_k2(k2);
+        h2 = h2
+            .rotate_left(31)
+            .wrapping_add(h1)
+            .wrapping_mul(5)
+            .wrapping_add(0x3849_5ab5);
+    }
+
+    let tail = blocks.remainder();
+    let mut padded = [0u8; 16];
+    padded[..tail.len()].copy_from_slice(tail);
+    if tail.len() > 8 {
+        h2 ^= mix_k2(u64::from_le_bytes(padded[8..].try_into().unwrap()));
+    }
+    if !tail.is_empty() {
+        h1 ^= mix_k1(u64::from_le_bytes(padded[..8].try_into().unwrap()));
+    }
+
+    h1 ^= bytes.len() as u64;
+    h2 ^= bytes.len() as u64;
+    h1 = h1.wrapping_add(h2);
+    h2 = h2.wrapping_add(h1);
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 = h1.wrapping_add(h2);
+    h2 = h2.wrapping_add(h1);
+    (h1 as u128) << 64 | h2 as u128
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// A fresh cache directory under the system temp dir.
+    fn temp_cache() -> ParseCache {
+        static NEXT: AtomicU64 = AtomicU64::new(0);
+        let dir = std::env::temp_dir().join(format!(
+            "styx-parse-cache-{}-{}",
+            std::process::id(),
+            NEXT.fetch_add(1, Ordering::Relaxed)
+        ));
+        let _ = fs::remove_dir_all(&dir);
+        ParseCache::new(dir).min_len(0)
+    }
+
+    #[test]
+    fn test_store_then_load() {
+        let cache = temp_cache();
+        let source = "server {host localhost, port 8080}\ntags (a b \"c d\")";
+        let path = cache.entry_path(source);
+        assert!(!path.exists());
+
+        let first = cache.parse(source).unwrap();
+        assert_eq!(first, Document::parse(source).unwrap());
+        assert!(path.exists());
+        let hash = content_hash(source.as_bytes());
+        assert_eq!(load(&path, hash), Some(first.clone()));
+        assert_eq!(cache.parse(source).unwrap(), first);
+
+        // A corrupt entry is parsed again and replaced.
+        fs::write(&path, b"not compiled").unwrap();
+        assert_eq!(load(&path, hash), None);
+        assert_eq!(cache.parse(source).unwrap(), first);
+        assert_eq!(load(&path, hash), Some(first.clone()));
+
+        let (count, size) = cache.stats().unwrap();
+        assert_eq!((count, size), (1, fs::metadata(&path).unwrap().len()));
+        assert_eq!(cache.clear().unwrap(), (count, size));
+        assert_eq!(cache.stats().unwrap(), (0, 0));
+        fs::remove_dir_all(cache.dir()).unwrap();
+    }
+
+    #[test]
+    fn test_damaged_entries_are_misses() {
+        let cache = temp_cache();
+        let source = "server {host localhost, port 8080}";
+        let doc = cache.parse(source).unwrap();
+        let path = cache.entry_path(source);
+        let hash = content_hash(source.as_bytes());
+        let entry = fs::read(&path).unwrap();
+
+        // A flipped byte inside a string still decodes, to the wrong
+        // document; only the payload hash catches it.
+        let mut flipped = entry.clone();
+        let at = flipped.windows(9).rposition(|w| w == b"localhost").unwrap();
+        flipped[at] = b'L';
+        assert!(Document::from_compiled(&flipped[ENTRY_HEADER_LEN..]).is_ok());
+        fs::write(&path, &flipped).unwrap();
+        assert_eq!(load(&path, hash), None);
+        assert_eq!(cache.parse(source).unwrap(), doc);
+        assert_eq!(fs::read(&path).unwrap(), entry);
+
+        // Truncated entries and empty files.
+        for len in [0, 8, ENTRY_HEADER_LEN, entry.len() - 1] {
+            fs::write(&path, &entry[..len]).unwrap();
+            assert_eq!(load(&path, hash), None, "truncated to {len}");
+            assert_eq!(cache.parse(source).unwrap(), doc);
+        }
+
+        // An intact entry for another source, copied into this one's place.
+        let other = "marker 1";
+        cache.parse(other).unwrap();
+        fs::copy(cache.entry_path(other), &path).unwrap();
+        assert_eq!(load(&path, hash), None);
+        assert_eq!(cache.parse(source).unwrap(), doc);
+        fs::remove_dir_all(cache.dir()).unwrap();
+    }
+
+    #[test]
+    fn test_errors_and_short_sources_are_not_stored() {
+        let cache = temp_cache();
+        let broken = "a {b 1";
+        assert_eq!(
+            cache.parse(broken).map_err(|e| e.to_string()),
+            Document::parse(broken).map_err(|e| e.to_string())
+        );
+        assert!(!cache.entry_path(broken).exists());
+
+        let cache = cache.min_len(64);
+        cache.parse("short 1").unwrap();
+        assert!(!cache.dir().exists());
+        assert_eq!(cache.clear().unwrap(), (0, 0));
+    }
+
+    #[test]
+    fn test_entries_are_keyed_by_content() {
+        let cache = temp_cache();
+        let names: std::collections::HashSet<_> = [
+            "",
+            "a",
+            "a ",
+            "b",
+            &"x".repeat(15),
+            &"x".repeat(16),
+            &"x".repeat(17),
+        ]
+        .iter()
+        .map(|source| cache.entry_path(source))
+        .collect();
+        assert_eq!(names.len(), 7);
+        assert_eq!(cache.entry_path("a"), cache.entry_path("a"));
+    }
+}
@@ -0,0 +1,1026 @@
+//! Compact document representation for large data files.
+//!
+//! An owned [`Document`] is several times larger than its source: every
+//! [`Value`] carries an optional [`Tag`] with its own `String` and span, an
+//! optional payload and a span, and every [`Entry`] an optional doc comment.
+//! A [`CompactDocument`] stores the same tree in a few flat vectors and keeps
+//! the per-value cost to a 12-byte node:
+//!
+//! - scalars of up to 8 bytes are stored inside their node, longer ones in a
+//!   single string pool;
+//! - tags are stored in the node as the [`Symbol`] of their name;
+//! - untagged scalar keys take no node at all: the entry holds their symbol;
+//! - sequences of untagged scalars of one kind are stored as one packed run
+//!   of text, with no node per item;
+//! - doc comments are kept in a side table sorted by entry, so entries
+//!   without one pay nothing;
+//! - spans are kept in a side table that can be left out entirely with
+//!   [`CompactDocument::parse_without_spans`] or dropped later with
+//!   [`CompactDocument::strip_spans`].
+//!
+//! [`CompactDocument::heap_size`] reports what the tree occupies, for
+//! comparing against the source length. The tree is read through `Copy`
+//! handles that mirror [`ArenaDocument`]'s, and owns all of its text.
+//!
+//! Offsets are stored as `u32`, like [`Span`], so a document is limited to
+//! 4 GiB of text; building a larger one fails with
+//! [`BuildError::TooLarge`].
+
+use std::mem::size_of;
+
+use styx_parse::{ScalarKind, Span};
+
+use crate::arena::{ArenaDocument, ArenaObject, ArenaSequence, ArenaValue, Symbol};
+use crate::index::key_hash;
+use crate::value::split_path;
+use crate::{BuildError, Document, Entry, Object, Payload, Scalar, Sequence, Tag, Value};
+
+/// Scalars up to this many bytes are stored inside their node.
+const INLINE_LEN: usize = 8;
+
+// Node kinds, in the low bits of `Node::head`.
+const KIND_NONE: u32 = 0;
+const KIND_SCALAR: u32 = 1;
+const KIND_INLINE: u32 = 2;
+const KIND_SEQUENCE: u32 = 3;
+const KIND_PACKED: u32 = 4;
+const KIND_OBJECT: u32 = 5;
+const KIND_MASK: u32 = 0b111;
+
+// The rest of `Node::head`: scalar kind, inline length, then the tag.
+const SCALAR_KIND_SHIFT: u32 = 3;
+const INLINE_LEN_SHIFT: u32 = 5;
+const TAG_SHIFT: u32 = 9;
+
+/// Tag field of a node whose tag symbol is too large to fit in it; the
+/// symbol is in `CompactDocument::wide_tags`.
+const WIDE_TAG: u32 = u32::MAX >> TAG_SHIFT;
+
+/// Entry keys with this bit set are a key symbol, not a node id.
+const SYMBOL_KEY: u32 = 1 << 31;
+const KEY_KIND_SHIFT: u32 = 29;
+/// Symbols at or above this are stored as key nodes instead.
+const MAX_KEY_SYMBOL: u32 = 1 << KEY_KIND_SHIFT;
+
+/// Span table entry for values that have none.
+const NO_SPAN: Span = Span {
+    start: u32::MAX,
+    end: u32::MAX,
+};
+
+/// A parsed document stored in as little memory as possible.
+///
+/// Built with [`CompactDocument::parse`] or from an [`ArenaDocument`].
+/// Produces the same tree as [`Document::parse`], minus the spans if they
+/// were left out.
+#[derive(Debug, Clone)]
+pub struct CompactDocument {
+    /// Scalars too long to inline, symbol names, packed sequence text and
+    /// doc comments.
+    strings: String,
+    nodes: Vec<Node>,
+    entries: Vec<EntryNode>,
+    /// Node ids of sequence items, for sequences that are not packed.
+    items: Vec<u32>,
+    /// Text boundaries of packed sequence items in `strings`: a packed run
+    /// of `len` items starting at `start` uses `packed[start..=start + len]`.
+    packed: Vec<u32>,
+    root: Run,
+    /// Text of each symbol, by id (the same ids as the arena it came from).
+    symbol_names: Vec<Run>,
+    /// The arena's symbol table as `(hash, symbol id)` slots sorted by
+    /// hash, searched the same way.
+    symbol_slots: Vec<(u64, u32)>,
+    /// Doc comment text by entry index, sorted by entry.
+    doc_comments: Vec<(u32, Run)>,
+    /// Tag symbols of nodes marked [`WIDE_TAG`], sorted by node.
+    wide_tags: Vec<(u32, Symbol)>,
+    spans: Option<Spans>,
+}
+
+/// Source spans, kept apart from the tree so they can be left out.
+#[derive(Debug, Clone, Default)]
+struct Spans {
+    /// By node id, [`NO_SPAN`] if the value has none.
+    nodes: Vec<Span>,
+    /// By entry index, for keys stored as symbols.
+    keys: Vec<Span>,
+    /// Tag spans of tagged nodes, sorted by node.
+    tags: Vec<(u32, Span)>,
+    /// By packed item, parallel to `packed`.
+    packed: Vec<Span>,
+}
+
+/// A `start..start + len` range into one of the document's vectors.
+#[derive(Debug, Clone, Copy, Default)]
+struct Run {
+    start: u32,
+    len: u32,
+}
+
+impl Run {
+    fn range(self) -> std::ops::Range<usize> {
+        self.start as usize..(self.start + self.len) as usize
+    }
+}
+
+/// `kind | scalar_kind << 3 | inline_len << 5 | (tag + 1) << 9`, then eight
+/// bytes of inline text or a [`Run`] into the strings, items, packed text or
+/// entries.
+#[derive(Debug, Clone, Copy)]
+struct Node {
+    head: u32,
+    data: [u8; 8],
+}
+
+impl Node {
+    fn kind(&self) -> u32 {
+        self.head & KIND_MASK
+    }
+
+    fn scalar_kind(&self) -> ScalarKind {
+        scalar_kind((self.head >> SCALAR_KIND_SHIFT) & 0b11)
+    }
+
+    fn run(&self) -> Run {
+        Run {
+            start: u32::from_le_bytes(self.data[..4].try_into().unwrap()),
+            len: u32::from_le_bytes(self.data[4..].try_into().unwrap()),
+        }
+    }
+
+    fn with_run(head: u32, run: Run) -> Self {
+        let mut data = [0; 8];
+        data[..4].copy_from_slice(&run.start.to_le_bytes());
+        data[4..].copy_from_slice(&run.len.to_le_bytes());
+        Node { head, data }
+    }
+}
+
+#[derive(Debug, Clone, Copy, Default)]
+struct EntryNode {
+    /// A node id, or a key symbol tagged with [`SYMBOL_KEY`] and the key's
+    /// scalar kind.
+    key: u32,
+    value: u32,
+}
+
+fn scalar_kind(bits: u32) -> ScalarKind {
+    match bits {
+        0 => ScalarKind::Bare,
+        1 => ScalarKind::Quoted,
+        2 => ScalarKind::Raw,
+        _ => ScalarKind::Heredoc,
+    }
+}
+
+/// An offset or length as stored in the document.
+fn small(n: usize) -> Result<u32, BuildError> {
+    u32::try_from(n).map_err(|_| BuildError::TooLarge)
+}
+
+fn span_or_none(span: Span) -> Option<Span> {
+    Some(span).filter(|&s| s != NO_SPAN)
+}
+
+impl CompactDocument {
+    /// Parse a Styx document into a compact tree, keeping spans.
+    ///
+    /// The document is built through an [`ArenaDocument`], which is freed
+    /// before this returns.
+    pub fn parse(source: &str) -> Result<Self, BuildError> {
+        Self::from_arena(&ArenaDocument::parse(source)?, true)
+    }
+
+    /// Parse a Styx document into a compact tree with no spans.
+    pub fn parse_without_spans(source: &str) -> Result<Self, BuildError> {
+        Self::from_arena(&ArenaDocument::parse(source)?, false)
+    }
+
+    /// Copy an arena document, with or without its spans.
+    ///
+    /// Fails with [`BuildError::TooLarge`] if the tree's text or tables
+    /// outgrow 32-bit offsets.
+    pub fn from_arena(arena: &ArenaDocument<'_>, keep_spans: bool) -> Result<Self, BuildError> {
+        let mut doc = CompactDocument {
+            strings: String::new(),
+            nodes: Vec::new(),
+            entries: Vec::new(),
+            items: Vec::new(),
+            packed: Vec::new(),
+            root: Run::default(),
+            symbol_names: Vec::with_capacity(arena.symbol_count()),
+            symbol_slots: arena.symbol_slots().collect(),
+            doc_comments: Vec::new(),
+            wide_tags: Vec::new(),
+            spans: keep_spans.then(Spans::default),
+        };
+        doc.symbol_slots.sort_unstable();
+        for id in 0..arena.symbol_count() {
+            let name = doc.push_str(arena.symbol_name(Symbol(id as u32)))?;
+            doc.symbol_names.push(name);
+        }
+        doc.root = doc.object(arena.root())?;
+        doc.shrink_to_fit();
+        Ok(doc)
+    }
+
+    /// Drop the span table. Every span reads as `None` afterwards.
+    pub fn strip_spans(&mut self) {
+        self.spans = None;
+    }
+
+    /// Whether spans were kept.
+    pub fn has_spans(&self) -> bool {
+        self.spans.is_some()
+    }
+
+    /// The root object.
+    pub fn root(&self) -> CompactObject<'_> {
+        CompactObject {
+            doc: self,
+            run: self.root,
+            node: None,
+        }
+    }
+
+    /// Get a value by path, like [`Document::get`].
+    pub fn get(&self, path: &str) -> Option<CompactValue<'_>> {
+        if path.is_empty() {
+            return None;
+        }
+        let (segment, rest) = split_path(path);
+        let value = self.root().get(segment)?;
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Number of nodes stored. Keys stored as symbols and the items of
+    /// packed sequences take none.
+    pub fn node_count(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// The symbol for a key or tag name, if it occurs in the document.
+    pub fn symbol(&self, name: &str) -> Option<Symbol> {
+        let mut hash = key_hash(name);
+        loop {
+            let slots = &self.symbol_slots;
+            let id = slots[slots.binary_search_by_key(&hash, |&(h, _)| h).ok()?].1;
+            if self.symbol_name(Symbol(id)) == name {
+                return Some(Symbol(id));
+            }
+            hash = hash.wrapping_add(1);
+        }
+    }
+
+    /// The text of a symbol from this document.
+    pub fn symbol_name(&self, symbol: Symbol) -> &str {
+        self.text(self.symbol_names[symbol.0 as usize])
+    }
+
+    /// Number of distinct key and tag names.
+    pub fn symbol_count(&self) -> usize {
+        self.symbol_names.len()
+    }
+
+    /// Bytes of heap memory the document occupies, spans included.
+    ///
+    /// Counts the capacity of every block the document owns.
+    pub fn heap_size(&self) -> usize {
+        fn bytes<T>(v: &Vec<T>) -> usize {
+            v.capacity() * size_of::<T>()
+        }
+        let spans = self.spans.as_ref().map_or(0, |s| {
+            bytes(&s.nodes) + bytes(&s.keys) + bytes(&s.tags) + bytes(&s.packed)
+        });
+        self.strings.capacity()
+            + bytes(&self.nodes)
+            + bytes(&self.entries)
+            + bytes(&self.items)
+            + bytes(&self.packed)
+            + bytes(&self.symbol_names)
+            + bytes(&self.symbol_slots)
+            + bytes(&self.doc_comments)
+            + bytes(&self.wide_tags)
+            + spans
+    }
+
+    /// Copy the tree into an owned [`Document`].
+    pub fn to_document(&self) -> Document {
+        Document::from_root(self.root().to_object())
+    }
+
+    fn text(&self, run: Run) -> &str {
+        &self.strings[run.range()]
+    }
+
+    fn push_str(&mut self, text: &str) -> Result<Run, BuildError> {
+        let start = small(self.strings.len())?;
+        let len = small(text.len())?;
+        self.strings.push_str(text);
+        Ok(Run { start, len })
+    }
+
+    fn shrink_to_fit(&mut self) {
+        self.strings.shrink_to_fit();
+        self.nodes.shrink_to_fit();
+        self.entries.shrink_to_fit();
+        self.items.shrink_to_fit();
+        self.packed.shrink_to_fit();
+        self.doc_comments.shrink_to_fit();
+        self.wide_tags.shrink_to_fit();
+        if let Some(spans) = &mut self.spans {
+            spans.nodes.shrink_to_fit();
+            spans.keys.shrink_to_fit();
+            spans.tags.shrink_to_fit();
+            spans.packed.shrink_to_fit();
+        }
+    }
+
+    /// Copy an object's entries into one run. Doc comments are recorded
+    /// before descending, so the doc comment table stays sorted.
+    fn object(&mut self, object: ArenaObject<'_>) -> Result<Run, BuildError> {
+        let start = self.entries.len();
+        let run = Run {
+            start: small(start)?,
+            len: small(object.len())?,
+        };
+        self.entries
+            .resize(start + object.len(), EntryNode::default());
+        if let Some(spans) = &mut self.spans {
+            spans.keys.resize(start + object.len(), NO_SPAN);
+        }
+        for (i, entry) in object.iter().enumerate() {
+            if let Some(comment) = entry.doc_comment() {
+                let text = self.push_str(comment)?;
+                self.doc_comments.push((small(start + i)?, text));
+            }
+        }
+        for (i, entry) in object.iter().enumerate() {
+            let key = self.key(start + i, entry.key(), entry.key_symbol())?;
+            let value = self.value(entry.value())?;
+            self.entries[start + i] = EntryNode { key, value };
+        }
+        Ok(run)
+    }
+
+    fn key(
+        &mut self,
+        index: usize,
+        key: ArenaValue<'_>,
+        symbol: Option<Symbol>,
+    ) -> Result<u32, BuildError> {
+        match (symbol, key.scalar_kind()) {
+            (Some(symbol), Some(kind)) if symbol.0 < MAX_KEY_SYMBOL => {
+                if let (Some(spans), Some(span)) = (&mut self.spans, key.span()) {
+                    spans.keys[index] = span;
+                }
+                Ok(SYMBOL_KEY | (kind as u32) << KEY_KIND_SHIFT | symbol.0)
+            }
+            _ => self.value(key),
+        }
+    }
+
+    /// Copy a value and its children, returning its node id. Children are
+    /// pushed first, so node ids grow in the order the tables need.
+    fn value(&mut self, value: ArenaValue<'_>) -> Result<u32, BuildError> {
+        let node = if let Some(text) = value.scalar_text() {
+            let kind = value.scalar_kind().unwrap() as u32;
+            let head = kind << SCALAR_KIND_SHIFT;
+            if text.len() <= INLINE_LEN {
+                let mut data = [0; 8];
+                data[..text.len()].copy_from_slice(text.as_bytes());
+                Node {
+                    head: KIND_INLINE | head | (text.len() as u32) << INLINE_LEN_SHIFT,
+                    data,
+                }
+            } else {
+                let run = self.push_str(text)?;
+                Node::with_run(KIND_SCALAR | head, run)
+            }
+        } else if let Some(sequence) = value.as_sequence() {
+            match packed_kind(sequence) {
+                Some(kind) => {
+                    let start = self.packed.len();
+                    self.packed.push(small(self.strings.len())?);
+                    for item in sequence.iter() {
+                        self.strings.push_str(item.scalar_text().unwrap());
+                        self.packed.push(small(self.strings.len())?);
+                        if let Some(spans) = &mut self.spans {
+                            spans.packed.push(item.span().unwrap_or(NO_SPAN));
+                        }
+                    }
+                    if let Some(spans) = &mut self.spans {
+                        spans.packed.push(NO_SPAN);
+                    }
+                    let run = Run {
+                        start: small(start)?,
+                        len: small(sequence.len())?,
+                    };
+                    Node::with_run(KIND_PACKED | (kind as u32) << SCALAR_KIND_SHIFT, run)
+                }
+                None => {
+                    let start = self.items.len();
+                    self.items.resize(start + sequence.len(), 0);
+                    for (i, item) in sequence.iter().enumerate() {
+                        self.items[start + i] = self.value(item)?;
+                    }
+                    let run = Run {
+                        start: small(start)?,
+                        len: small(sequence.len())?,
+                    };
+                    Node::with_run(KIND_SEQUENCE, run)
+                }
+            }
+        } else if let Some(object) = value.as_object() {
+            let run = self.object(object)?;
+            Node::with_run(KIND_OBJECT, run)
+        } else {
+            Node {
+                head: KIND_NONE,
+                data: [0; 8],
+            }
+        };
+
+        let id = small(self.nodes.len())?;
+        let mut head = node.head;
+        if let Some(tag) = value.tag_symbol() {
+            if tag.0 < WIDE_TAG - 1 {
+                head |= (tag.0 + 1) << TAG_SHIFT;
+            } else {
+                head |= WIDE_TAG << TAG_SHIFT;
+                self.wide_tags.push((id, tag));
+            }
+            if let (Some(spans), Some(span)) = (&mut self.spans, value.tag_span()) {
+                spans.tags.push((id, span));
+            }
+        }
+        self.nodes.push(Node { head, ..node });
+        if let Some(spans) = &mut self.spans {
+            spans.nodes.push(value.span().unwrap_or(NO_SPAN));
+        }
+        Ok(id)
+    }
+}
+
+/// The scalar kind shared by the items of `sequence`, if there are at least
+/// two and they are all untagged scalars of that kind.
+fn packed_kind(sequence: ArenaSequence<'_>) -> Option<ScalarKind> {
+    let first = sequence.get(0)?;
+    let kind = first.as_str().and(first.scalar_kind())?;
+    (sequence.len() >= 2
+        && sequence
+            .iter()
+            .all(|item| item.as_str().is_some() && item.scalar_kind() == Some(kind)))
+    .then_some(kind)
+}
+
+/// Where a value lives in a [`CompactDocument`].
+#[derive(Clone, Copy)]
+enum At {
+    Node(u32),
+    /// A key stored as a symbol, by entry index.
+    Key(u32),
+    /// An item of a packed sequence, by index into `packed`.
+    Packed(u32, ScalarKind),
+}
+
+/// A value in a [`CompactDocument`].
+#[derive(Clone, Copy)]
+pub struct CompactValue<'a> {
+    doc: &'a CompactDocument,
+    at: At,
+}
+
+impl<'a> CompactValue<'a> {
+    fn node(&self) -> Option<(u32, &'a Node)> {
+        match self.at {
+            At::Node(id) => Some((id, &self.doc.nodes[id as usize])),
+            _ => None,
+        }
+    }
+
+    /// Source span (None if synthesized, or if spans were not kept).
+    pub fn span(&self) -> Option<Span> {
+        let spans = self.doc.spans.as_ref()?;
+        span_or_none(match self.at {
+            At::Node(id) => spans.nodes[id as usize],
+            At::Key(index) => spans.keys[index as usize],
+            At::Packed(index, _) => spans.packed[index as usize],
+        })
+    }
+
+    /// Check if this is unit (`@` - no tag, no payload).
+    pub fn is_unit(&self) -> bool {
+        self.node()
+            .is_some_and(|(_, node)| node.head >> TAG_SHIFT == 0 && node.kind() == KIND_NONE)
+    }
+
+    /// Get the tag name if present.
+    pub fn tag_name(&self) -> Option<&'a str> {
+        self.tag_symbol().map(|t| self.doc.symbol_name(t))
+    }
+
+    /// Get the tag's interned name if present.
+    pub fn tag_symbol(&self) -> Option<Symbol> {
+        let (id, node) = self.node()?;
+        match node.head >> TAG_SHIFT {
+            0 => None,
+            WIDE_TAG => {
+                let tags = &self.doc.wide_tags;
+                let at = tags.binary_search_by_key(&id, |&(node, _)| node).ok()?;
+                Some(tags[at].1)
+            }
+            tag => Some(Symbol(tag - 1)),
+        }
+    }
+
+    /// Get the tag span if present.
+    pub fn tag_span(&self) -> Option<Span> {
+        self.tag_symbol()?;
+        let (id, _) = self.node()?;
+        let tags = &self.doc.spans.as_ref()?.tags;
+        let at = tags.binary_search_by_key(&id, |&(node, _)| node).ok()?;
+        Some(tags[at].1)
+    }
+
+    /// Get as string (for untagged scalars).
+    pub fn as_str(&self) -> Option<&'a str> {
+        if self.tag_symbol().is_some() {
+            return None;
+        }
+        self.scalar_text()
+    }
+
+    /// Get the scalar text regardless of tag.
+    pub fn scalar_text(&self) -> Option<&'a str> {
+        let doc = self.doc;
+        match self.at {
+            At::Node(id) => {
+                let node = &doc.nodes[id as usize];
+                match node.kind() {
+                    KIND_INLINE => {
+                        let len = (node.head >> INLINE_LEN_SHIFT) as usize & 0b1111;
+                        Some(
+                            std::str::from_utf8(&node.data[..len])
+                                .expect("inline scalars are copied from whole strings"),
+                        )
+                    }
+                    KIND_SCALAR => Some(doc.text(node.run())),
+                    _ => None,
+                }
+            }
+            At::Key(index) => {
+                let key = doc.entries[index as usize].key;
+                Some(doc.symbol_name(Symbol(key & (MAX_KEY_SYMBOL - 1))))
+            }
+            At::Packed(index, _) => {
+                let index = index as usize;
+                let (start, end) = (doc.packed[index], doc.packed[index + 1]);
+                Some(&doc.strings[start as usize..end as usize])
+            }
+        }
+    }
+
+    /// Get the scalar kind, if the payload is a scalar.
+    pub fn scalar_kind(&self) -> Option<ScalarKind> {
+        match self.at {
+            At::Node(id) => {
+                let node = &self.doc.nodes[id as usize];
+                matches!(node.kind(), KIND_INLINE | KIND_SCALAR).then(|| node.scalar_kind())
+            }
+            At::Key(index) => {
+                let key = self.doc.entries[index as usize].key;
+                Some(scalar_kind((key >> KEY_KIND_SHIFT) & 0b11))
+            }
+            At::Packed(_, kind) => Some(kind),
+        }
+    }
+
+    /// Get as object (payload only).
+    pub fn as_object(&self) -> Option<CompactObject<'a>> {
+        let (id, node) = self.node()?;
+        (node.kind() == KIND_OBJECT).then(|| CompactObject {
+            doc: self.doc,
+            run: node.run(),
+            node: Some(id),
+        })
+    }
+
+    /// Get as sequence (payload only).
+    pub fn as_sequence(&self) -> Option<CompactSequence<'a>> {
+        let (id, node) = self.node()?;
+        let packed = match node.kind() {
+            KIND_SEQUENCE => None,
+            KIND_PACKED => Some(node.scalar_kind()),
+            _ => return None,
+        };
+        Some(CompactSequence {
+            doc: self.doc,
+            node: id,
+            run: node.run(),
+            packed,
+        })
+    }
+
+    /// Get a value by path, like [`Value::get`].
+    pub fn get(&self, path: &str) -> Option<CompactValue<'a>> {
+        if path.is_empty() {
+            return Some(*self);
+        }
+
+        let (segment, rest) = split_path(path);
+
+        let value = if let Some(object) = self.as_object() {
+            object.get(segment)?
+        } else {
+            let idx: usize = segment.strip_prefix('[')?.strip_suffix(']')?.parse().ok()?;
+            self.as_sequence()?.get(idx)?
+        };
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Copy this value into an owned [`Value`].
+    pub fn to_value(&self) -> Value {
+        let span = self.span();
+        let payload = if let Some(text) = self.scalar_text() {
+            Some(Payload::Scalar(Scalar {
+                text: text.to_string(),
+                kind: self.scalar_kind().unwrap(),
+                span,
+            }))
+        } else if let Some(sequence) = self.as_sequence() {
+            Some(Payload::Sequence(sequence.to_sequence()))
+        } else {
+            self.as_object()
+                .map(|object| Payload::Object(object.to_object()))
+        };
+        Value {
+            tag: self.tag_name().map(|name| Tag {
+                name: name.to_string(),
+                span: self.tag_span(),
+            }),
+            payload,
+            span,
+        }
+    }
+}
+
+impl std::fmt::Debug for CompactValue<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        std::fmt::Debug::fmt(&self.to_value(), f)
+    }
+}
+
+/// An object in a [`CompactDocument`].
+#[derive(Clone, Copy)]
+pub struct CompactObject<'a> {
+    doc: &'a CompactDocument,
+    run: Run,
+    /// The object's node (None for the root).
+    node: Option<u32>,
+}
+
+impl<'a> CompactObject<'a> {
+    /// Source span (None for the implicit root, or if spans were not kept).
+    pub fn span(&self) -> Option<Span> {
+        let spans = self.doc.spans.as_ref()?;
+        span_or_none(spans.nodes[self.node? as usize])
+    }
+
+    /// Number of entries.
+    pub fn len(&self) -> usize {
+        self.run.len as usize
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.run.len == 0
+    }
+
+    /// Get the entry at `index`.
+    pub fn entry(&self, index: usize) -> Option<CompactEntry<'a>> {
+        (index < self.len()).then(|| CompactEntry {
+            doc: self.doc,
+            index: self.run.start + index as u32,
+        })
+    }
+
+    /// Get entry value by key (for untagged scalar keys).
+    pub fn get(&self, key: &str) -> Option<CompactValue<'a>> {
+        self.get_symbol(self.doc.symbol(key)?)
+    }
+
+    /// Get entry value by interned key (see [`CompactDocument::symbol`]).
+    pub fn get_symbol(&self, key: Symbol) -> Option<CompactValue<'a>> {
+        if key.0 >= MAX_KEY_SYMBOL {
+            return self
+                .iter()
+                .find(|e| e.key_symbol() == Some(key))
+                .map(|e| e.value());
+        }
+        let want = SYMBOL_KEY | key.0;
+        let entries = &self.doc.entries[self.run.range()];
+        let at = entries
+            .iter()
+            .position(|e| e.key & !(0b11 << KEY_KIND_SHIFT) == want)?;
+        Some(CompactValue {
+            doc: self.doc,
+            at: At::Node(entries[at].value),
+        })
+    }
+
+    /// Iterate over entries.
+    pub fn iter(&self) -> impl Iterator<Item = CompactEntry<'a>> + 'a {
+        let doc = self.doc;
+        self.run.range().map(move |index| CompactEntry {
+            doc,
+            index: index as u32,
+        })
+    }
+
+    /// Copy this object into an owned [`Object`].
+    pub fn to_object(&self) -> Object {
+        let entries = self
+            .iter()
+            .map(|e| Entry {
+                key: e.key().to_value(),
+                value: e.value().to_value(),
+                doc_comment: e.doc_comment().map(str::to_string),
+            })
+            .collect();
+        Object::new(entries, self.span())
+    }
+}
+
+/// An entry (key-value pair) in a [`CompactObject`].
+#[derive(Clone, Copy)]
+pub struct CompactEntry<'a> {
+    doc: &'a CompactDocument,
+    index: u32,
+}
+
+impl<'a> CompactEntry<'a> {
+    fn node(&self) -> EntryNode {
+        self.doc.entries[self.index as usize]
+    }
+
+    /// The key.
+    pub fn key(&self) -> CompactValue<'a> {
+        let key = self.node().key;
+        let at = if key & SYMBOL_KEY != 0 {
+            At::Key(self.index)
+        } else {
+            At::Node(key)
+        };
+        CompactValue { doc: self.doc, at }
+    }
+
+    /// The key's interned text, if the key is an untagged scalar.
+    pub fn key_symbol(&self) -> Option<Symbol> {
+        let key = self.node().key;
+        if key & SYMBOL_KEY != 0 {
+            return Some(Symbol(key & (MAX_KEY_SYMBOL - 1)));
+        }
+        self.doc.symbol(self.key().as_str()?)
+    }
+
+    /// The value.
+    pub fn value(&self) -> CompactValue<'a> {
+        CompactValue {
+            doc: self.doc,
+            at: At::Node(self.node().value),
+        }
+    }
+
+    /// Doc comment attached to this entry.
+    pub fn doc_comment(&self) -> Option<&'a str> {
+        let comments = &self.doc.doc_comments;
+        let at = comments
+            .binary_search_by_key(&self.index, |&(entry, _)| entry)
+            .ok()?;
+        Some(self.doc.text(comments[at].1))
+    }
+}
+
+/// A sequence in a [`CompactDocument`].
+#[derive(Clone, Copy)]
+pub struct CompactSequence<'a> {
+    doc: &'a CompactDocument,
+    node: u32,
+    run: Run,
+    /// The items' scalar kind, if they are packed.
+    packed: Option<ScalarKind>,
+}
+
+impl<'a> CompactSequence<'a> {
+    /// Source span (None if spans were not kept).
+    pub fn span(&self) -> Option<Span> {
+        let spans = self.doc.spans.as_ref()?;
+        span_or_none(spans.nodes[self.node as usize])
+    }
+
+    /// Number of items.
+    pub fn len(&self) -> usize {
+        self.run.len as usize
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.run.len == 0
+    }
+
+    /// Whether the items are stored as one packed run of text.
+    pub fn is_packed(&self) -> bool {
+        self.packed.is_some()
+    }
+
+    /// Get item by index.
+    pub fn get(&self, index: usize) -> Option<CompactValue<'a>> {
+        (index < self.len()).then(|| self.item(self.run.start + index as u32))
+    }
+
+    /// Iterate over items.
+    pub fn iter(&self) -> impl Iterator<Item = CompactValue<'a>> + 'a {
+        let this = *self;
+        self.run.range().map(move |index| this.item(index as u32))
+    }
+
+    /// Copy this sequence into an owned [`Sequence`].
+    pub fn to_sequence(&self) -> Sequence {
+        Sequence {
+            items: self.iter().map(|v| v.to_value()).collect(),
+            span: self.span(),
+        }
+    }
+
+    fn item(&self, index: u32) -> CompactValue<'a> {
+        let at = match self.packed {
+            Some(kind) => At::Packed(index, kind),
+            None => At::Node(self.doc.items[index as usize]),
+        };
+        CompactValue { doc: self.doc, at }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Remove every span from `value`, as a compact tree without spans
+    /// would produce it.
+    fn strip_value(value: &mut Value) {
+        value.span = None;
+        if let Some(tag) = &mut value.tag {
+            tag.span = None;
+        }
+        match &mut value.payload {
+            Some(Payload::Scalar(scalar)) => scalar.span = None,
+            Some(Payload::Sequence(sequence)) => {
+                sequence.span = None;
+                sequence.items.iter_mut().for_each(strip_value);
+            }
+            Some(Payload::Object(object)) => strip_object(object),
+            None => {}
+        }
+    }
+
+    fn strip_object(object: &mut Object) {
+        object.span = None;
+        for entry in object.entries_mut() {
+            strip_value(&mut entry.key);
+            strip_value(&mut entry.value);
+        }
+    }
+
+    fn assert_same_tree(source: &str) {
+        match (Document::parse(source), CompactDocument::parse(source)) {
+            (Ok(mut owned), Ok(mut compact)) => {
+                assert_eq!(compact.to_document(), owned, "{source:?}");
+                compact.strip_spans();
+                strip_object(&mut owned.root);
+                assert_eq!(compact.to_document(), owned, "{source:?}");
+                let bare = CompactDocument::parse_without_spans(source).unwrap();
+                assert_eq!(bare.to_document(), owned, "{source:?}");
+            }
+            (Err(a), Err(b)) => assert_eq!(a, b, "{source:?}"),
+            (a, b) => panic!(
+                "{source:?}: tree {a:?}, compact {:?}",
+                b.map(|d| d.to_document())
+            ),
+        }
+    }
+
+    #[test]
+    fn test_matches_tree_builder() {
+        for source in [
+            "",
+            "name Alice\nage 30",
+            "server {\n  host localhost\n  ports (8080 8443)\n}",
+            "/// Doc\n/// more\nkey value\n/// Second\nother @",
+            "obj {\n  /// inner\n  a 1\n  b \"quoted\\tvalue\"\n}",
+            "tagged @tag{a b}\nunit @\nbare @string\nseq @list(a (b c) {d e})",
+            "@ @object{\n  name @string\n}",
+            "{ explicit root }",
+            "a.b.c deep\na.b.d sibling",
+            "key \"unterminated",
+            "a {b c",
+            "dup 1\ndup 2",
+            "raw r#\"x \"y\"\"#\nheredoc <<EOF\n  text\n  EOF\n",
+            "mixed (a \"b\" c)\nsame (\"a\" \"b\")\none (x)\nnone ()\n\"quoted key\" 1",
+            "exactly8 12345678\nnine____ 123456789\nutf8 \"é✓\"",
+        ] {
+            assert_same_tree(source);
+        }
+    }
+
+    #[test]
+    fn test_matches_tree_builder_on_corpus() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                if let Ok(source) = std::fs::read_to_string(file.path()) {
+                    assert_same_tree(&source);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_layout() {
+        assert_eq!(size_of::<Node>(), 12);
+        assert_eq!(size_of::<EntryNode>(), 8);
+
+        let source = "id 42\nname \"a longer name\"\ntags (red green blue)\nmix (a @b)";
+        let doc = CompactDocument::parse(source).unwrap();
+        // `42`, the long name, the packed `tags`, and `mix` with its two
+        // items: keys and packed items take no nodes.
+        assert_eq!(doc.node_count(), 6);
+
+        let tags = doc.get("tags").unwrap().as_sequence().unwrap();
+        assert!(tags.is_packed());
+        let names: Vec<_> = tags.iter().map(|t| t.as_str().unwrap()).collect();
+        assert_eq!(names, ["red", "green", "blue"]);
+        assert_eq!(doc.get("tags[1]").unwrap().span(), Some(Span::new(37, 42)));
+        assert!(!doc.get("mix").unwrap().as_sequence().unwrap().is_packed());
+        assert_eq!(doc.get("mix[1]").unwrap().tag_name(), Some("b"));
+
+        let entry = doc.root().entry(1).unwrap();
+        assert_eq!(entry.key().as_str(), Some("name"));
+        assert_eq!(entry.key().span(), Some(Span::new(6, 10)));
+        assert_eq!(entry.key_symbol(), doc.symbol("name"));
+        assert_eq!(entry.value().as_str(), Some("a longer name"));
+
+        let bare = CompactDocument::parse_without_spans(source).unwrap();
+        assert!(!bare.has_spans() && doc.has_spans());
+        assert_eq!(bare.get("tags[1]").unwrap().span(), None);
+        assert!(bare.heap_size() < doc.heap_size());
+    }
+
+    #[test]
+    fn test_bytes_per_source_byte() {
+        let mut source = String::from("users (\n");
+        for i in 0..2000 {
+            source.push_str(&format!(
+                "  {{id {i}, name \"User number {i}\", score 0.{i}, tags (a b c), active true}}\n"
+            ));
+        }
+        source.push_str(")\n");
+        let (owned, stats) = Document::parse_with_stats(&source);
+        owned.unwrap();
+        let compact = CompactDocument::parse(&source).unwrap();
+        let bare = CompactDocument::parse_without_spans(&source).unwrap();
+        let ratio = |bytes: usize| bytes as f64 / source.len() as f64;
+        assert!(
+            ratio(compact.heap_size()) < 4.0 && ratio(bare.heap_size()) < 2.5,
+            "compact {:.2}, without spans {:.2} bytes per source byte",
+            ratio(compact.heap_size()),
+            ratio(bare.heap_size())
+        );
+        // The owned tree takes around 50.
+        assert!(compact.heap_size() * 10 < stats.allocated_bytes);
+    }
+
+    #[test]
+    fn test_offsets_past_u32_are_an_error() {
+        assert_eq!(small(u32::MAX as usize), Ok(u32::MAX));
+        if let Some(past) = (u32::MAX as usize).checked_add(1) {
+            assert_eq!(small(past), Err(BuildError::TooLarge));
+        }
+    }
+}
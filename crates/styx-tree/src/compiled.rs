@@ -0,0 +1,930 @@
+//! Compiled binary document format.
+//!
+//! A compiled document is a flat, little-endian image of a [`Document`] that
+//! can be read in place (e.g. from a memory-mapped file) without tokenizing,
+//! parsing or unescaping anything:
+//!
+//! ```text
+//! header   magic "STYXDOC\0", then u32 words: version, flags, root node,
+//!          node count, entry count, item count, index slot count, string bytes
+//! nodes    NODE_WORDS u32 words each (see below)
+//! entries  key node, value node, doc comment offset, doc comment length
+//! items    one u32 node id per sequence item
+//! index    u32 open-addressing slots (local entry index, or u32::MAX)
+//! strings  UTF-8 string table, each distinct string stored once
+//! ```
+//!
+//! A node is `kind | scalar_kind << 8 | flags << 16`, tag offset, tag length,
+//! tag span, value span, two payload words (string offset/length, or the
+//! start/length of the node's run of entries or items) and the start/length
+//! of the object's key index. Objects with at least
+//! [`INDEX_THRESHOLD`](crate::INDEX_THRESHOLD) entries get an index keyed by
+//! [`key_hash`], so lookups on wide objects stay O(1).
+//!
+//! [`CompiledDocument::from_bytes`] validates every offset up front, and
+//! checks that every node is the child of at most one node with a smaller
+//! id, so the nodes form a tree. Accessors never read out of bounds and
+//! walks always terminate, even on corrupt input.
+
+use std::collections::HashMap;
+
+use styx_parse::{ScalarKind, Span};
+
+use crate::index::{INDEX_THRESHOLD, capacity_for, key_hash};
+use crate::value::split_path;
+use crate::{Document, Entry, Object, Payload, Scalar, Sequence, Tag, Value};
+
+/// Magic bytes at the start of every compiled document.
+pub const COMPILED_MAGIC: [u8; 8] = *b"STYXDOC\0";
+
+/// Version of the compiled format produced by [`Document::compile`].
+pub const COMPILED_VERSION: u32 = 1;
+
+const HEADER_WORDS: usize = 8;
+const HEADER_LEN: usize = COMPILED_MAGIC.len() + HEADER_WORDS * 4;
+const NODE_WORDS: usize = 11;
+const ENTRY_WORDS: usize = 4;
+
+const KIND_NONE: u32 = 0;
+const KIND_SCALAR: u32 = 1;
+const KIND_SEQUENCE: u32 = 2;
+const KIND_OBJECT: u32 = 3;
+
+const FLAG_TAG: u32 = 1 << 0;
+const FLAG_SPAN: u32 = 1 << 1;
+const FLAG_TAG_SPAN: u32 = 1 << 2;
+
+/// Marks an absent doc comment and an empty index slot.
+const NONE: u32 = u32::MAX;
+
+/// Error loading a compiled document.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum CompiledError {
+    /// The data does not start with [`COMPILED_MAGIC`].
+    BadMagic,
+    /// The format version is not supported by this build.
+    UnsupportedVersion(u32),
+    /// The data is shorter than its header claims.
+    Truncated,
+    /// An offset, length or string in the data is invalid.
+    Corrupt(&'static str),
+    /// The document is too large for the format's 32-bit offsets.
+    TooLarge,
+}
+
+impl std::fmt::Display for CompiledError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            CompiledError::BadMagic => write!(f, "not a compiled styx document"),
+            CompiledError::UnsupportedVersion(v) => {
+                write!(f, "unsupported compiled document version {v}")
+            }
+            CompiledError::Truncated => write!(f, "compiled document is truncated"),
+            CompiledError::Corrupt(what) => write!(f, "corrupt compiled document: {what}"),
+            CompiledError::TooLarge => write!(f, "document is too large to compile"),
+        }
+    }
+}
+
+impl std::error::Error for CompiledError {}
+
+impl Document {
+    /// Serialize this document to the compiled binary format.
+    ///
+    /// The root is always stored without a span, as in a parsed document.
+    /// Payload spans are not stored separately: they are restored from the
+    /// value span, which is what the parser produces.
+    ///
+    /// Fails with [`CompiledError::TooLarge`] if a table or the string data
+    /// would not fit the format's 32-bit offsets.
+    pub fn compile(&self) -> Result<Vec<u8>, CompiledError> {
+        let mut writer = Writer::default();
+        let root = writer.reserve_node()?;
+        let mut node = [0; NODE_WORDS];
+        writer.object(&self.root, &mut node)?;
+        node[0] = KIND_OBJECT;
+        writer.nodes[root as usize] = node;
+        writer.finish(root)
+    }
+
+    /// Load a document from the compiled binary format.
+    pub fn from_compiled(bytes: &[u8]) -> Result<Document, CompiledError> {
+        Ok(CompiledDocument::from_bytes(bytes)?.to_document())
+    }
+}
+
+#[derive(Default)]
+struct Writer<'d> {
+    nodes: Vec<[u32; NODE_WORDS]>,
+    entries: Vec<[u32; ENTRY_WORDS]>,
+    items: Vec<u32>,
+    index: Vec<u32>,
+    strings: Vec<u8>,
+    interned: HashMap<&'d str, u32>,
+}
+
+/// Convert a length or offset to a format word.
+fn to_word(n: usize) -> Result<u32, CompiledError> {
+    u32::try_from(n).map_err(|_| CompiledError::TooLarge)
+}
+
+impl<'d> Writer<'d> {
+    fn reserve_node(&mut self) -> Result<u32, CompiledError> {
+        let id = to_word(self.nodes.len())?;
+        self.nodes.push([0; NODE_WORDS]);
+        Ok(id)
+    }
+
+    fn string(&mut self, s: &'d str) -> Result<[u32; 2], CompiledError> {
+        let len = to_word(s.len())?;
+        if let Some(&offset) = self.interned.get(s) {
+            return Ok([offset, len]);
+        }
+        let offset = to_word(self.strings.len())?;
+        // Keep every string end addressable, too.
+        to_word(self.strings.len() + s.len())?;
+        self.strings.extend_from_slice(s.as_bytes());
+        self.interned.insert(s, offset);
+        Ok([offset, len])
+    }
+
+    fn value(&mut self, value: &'d Value) -> Result<u32, CompiledError> {
+        let id = self.reserve_node()?;
+        let mut node = [0; NODE_WORDS];
+        let mut flags = 0;
+        if let Some(tag) = &value.tag {
+            flags |= FLAG_TAG;
+            [node[1], node[2]] = self.string(&tag.name)?;
+            if let Some(span) = tag.span {
+                flags |= FLAG_TAG_SPAN;
+                [node[3], node[4]] = [span.start, span.end];
+            }
+        }
+        if let Some(span) = value.span {
+            flags |= FLAG_SPAN;
+            [node[5], node[6]] = [span.start, span.end];
+        }
+        let kind = match &value.payload {
+            None => KIND_NONE,
+            Some(Payload::Scalar(scalar)) => {
+                [node[7], node[8]] = self.string(&scalar.text)?;
+                KIND_SCALAR | (scalar.kind as u32) << 8
+            }
+            Some(Payload::Sequence(seq)) => {
+                let start = self.items.len();
+                self.items.resize(start + seq.len(), 0);
+                for (i, item) in seq.iter().enumerate() {
+                    self.items[start + i] = self.value(item)?;
+                }
+                [node[7], node[8]] = [to_word(start)?, to_word(seq.len())?];
+                KIND_SEQUENCE
+            }
+            Some(Payload::Object(obj)) => {
+                self.object(obj, &mut node)?;
+                KIND_OBJECT
+            }
+        };
+        node[0] = kind | flags << 16;
+        self.nodes[id as usize] = node;
+        Ok(id)
+    }
+
+    /// Write an object's entries and key index into `node`'s payload words.
+    fn object(
+        &mut self,
+        obj: &'d Object,
+        node: &mut [u32; NODE_WORDS],
+    ) -> Result<(), CompiledError> {
+        let start = self.entries.len();
+        self.entries.resize(start + obj.len(), [0; ENTRY_WORDS]);
+        for (i, entry) in obj.entries().iter().enumerate() {
+            let key = self.value(&entry.key)?;
+            let value = self.value(&entry.value)?;
+            let [doc_offset, doc_len] = match &entry.doc_comment {
+                Some(doc) => self.string(doc)?,
+                None => [NONE, 0],
+            };
+            self.entries[start + i] = [key, value, doc_offset, doc_len];
+        }
+        [node[7], node[8]] = [to_word(start)?, to_word(obj.len())?];
+
+        if obj.len() >= INDEX_THRESHOLD {
+            let capacity = capacity_for(obj.len());
+            let index_start = self.index.len();
+            self.index.resize(index_start + capacity, NONE);
+            let slots = &mut self.index[index_start..];
+            let mask = capacity - 1;
+            for (i, entry) in obj.entries().iter().enumerate() {
+                let Some(key) = entry.key.as_str() else {
+                    continue;
+                };
+                let mut slot = key_hash(key) as usize & mask;
+                // Keep the first occurrence of duplicate keys.
+                while slots[slot] != NONE {
+                    if obj.entries()[slots[slot] as usize].key.as_str() == Some(key) {
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                if slots[slot] == NONE {
+                    slots[slot] = to_word(i)?;
+                }
+            }
+            [node[9], node[10]] = [to_word(index_start)?, to_word(capacity)?];
+        }
+        Ok(())
+    }
+
+    fn finish(self, root: u32) -> Result<Vec<u8>, CompiledError> {
+        let words = HEADER_WORDS
+            + self.nodes.len() * NODE_WORDS
+            + self.entries.len() * ENTRY_WORDS
+            + self.items.len()
+            + self.index.len();
+        let mut out = Vec::with_capacity(COMPILED_MAGIC.len() + words * 4 + self.strings.len());
+        out.extend_from_slice(&COMPILED_MAGIC);
+        let header = [
+            COMPILED_VERSION,
+            0,
+            root,
+            to_word(self.nodes.len())?,
+            to_word(self.entries.len())?,
+            to_word(self.items.len())?,
+            to_word(self.index.len())?,
+            to_word(self.strings.len())?,
+        ];
+        let body = self
+            .nodes
+            .iter()
+            .flatten()
+            .chain(self.entries.iter().flatten())
+            .chain(&self.items)
+            .chain(&self.index);
+        for word in header.iter().chain(body) {
+            out.extend_from_slice(&word.to_le_bytes());
+        }
+        out.extend_from_slice(&self.strings);
+        Ok(out)
+    }
+}
+
+/// A compiled document read in place from a byte buffer.
+///
+/// Created with [`CompiledDocument::from_bytes`]; reads go through `Copy`
+/// handles that mirror the owned API.
+#[derive(Debug, Clone, Copy)]
+pub struct CompiledDocument<'a> {
+    nodes: &'a [u8],
+    entries: &'a [u8],
+    items: &'a [u8],
+    index: &'a [u8],
+    strings: &'a str,
+    root: u32,
+}
+
+#[inline]
+fn word(bytes: &[u8], i: usize) -> u32 {
+    u32::from_le_bytes(bytes[i * 4..i * 4 + 4].try_into().unwrap())
+}
+
+impl<'a> CompiledDocument<'a> {
+    /// Validate `bytes` and wrap them for reading.
+    ///
+    /// Validation is a single linear pass over the tables; nothing is copied.
+    pub fn from_bytes(bytes: &'a [u8]) -> Result<Self, CompiledError> {
+        if bytes.len() < COMPILED_MAGIC.len() || bytes[..COMPILED_MAGIC.len()] != COMPILED_MAGIC {
+            return Err(CompiledError::BadMagic);
+        }
+        if bytes.len() < HEADER_LEN {
+            return Err(CompiledError::Truncated);
+        }
+        let header = &bytes[COMPILED_MAGIC.len()..HEADER_LEN];
+        let version = word(header, 0);
+        if version != COMPILED_VERSION {
+            return Err(CompiledError::UnsupportedVersion(version));
+        }
+        let root = word(header, 2);
+        // A table too large to address cannot be in `bytes` either.
+        let table_len = |i, width: usize| {
+            (word(header, i) as usize)
+                .checked_mul(width)
+                .ok_or(CompiledError::Truncated)
+        };
+        let counts = [
+            table_len(3, NODE_WORDS * 4)?,
+            table_len(4, ENTRY_WORDS * 4)?,
+            table_len(5, 4)?,
+            table_len(6, 4)?,
+            table_len(7, 1)?,
+        ];
+        let mut rest = &bytes[HEADER_LEN..];
+        let mut sections = [&[][..]; 5];
+        for (section, len) in sections.iter_mut().zip(counts) {
+            if rest.len() < len {
+                return Err(CompiledError::Truncated);
+            }
+            (*section, rest) = rest.split_at(len);
+        }
+        let [nodes, entries, items, index, strings] = sections;
+        let strings = std::str::from_utf8(strings)
+            .map_err(|_| CompiledError::Corrupt("string table is not UTF-8"))?;
+
+        let doc = CompiledDocument {
+            nodes,
+            entries,
+            items,
+            index,
+            strings,
+            root,
+        };
+        doc.validate()?;
+        Ok(doc)
+    }
+
+    fn validate(&self) -> Result<(), CompiledError> {
+        let node_count = self.nodes.len() / (NODE_WORDS * 4);
+        let entry_count = self.entries.len() / (ENTRY_WORDS * 4);
+        let item_count = self.items.len() / 4;
+        let index_count = self.index.len() / 4;
+        let in_range = |start: u32, len: u32, count: usize| {
+            (start as usize)
+                .checked_add(len as usize)
+                .is_some_and(|end| end <= count)
+        };
+        let valid_str = |offset: u32, len: u32| {
+            in_range(offset, len, self.strings.len())
+                && self.strings.is_char_boundary(offset as usize)
+                && self.strings.is_char_boundary((offset + len) as usize)
+        };
+
+        if self.root as usize >= node_count || self.node_word(self.root, 0) & 0xff != KIND_OBJECT {
+            return Err(CompiledError::Corrupt("root is not an object"));
+        }
+        // Every child must have a larger id than its parent and only one
+        // parent, as the writer emits them. That makes the reachable nodes a
+        // tree: no cycles, and no shared subtrees to blow up a walk.
+        let mut parented = vec![false; node_count];
+        let mut adopt = |parent: u32, child: u32| {
+            let ok = child > parent && !std::mem::replace(&mut parented[child as usize], true);
+            if ok {
+                Ok(())
+            } else {
+                Err(CompiledError::Corrupt("node is not part of a tree"))
+            }
+        };
+        for id in 0..node_count as u32 {
+            let w = |i| self.node_word(id, i);
+            if (w(0) >> 16) & FLAG_TAG != 0 && !valid_str(w(1), w(2)) {
+                return Err(CompiledError::Corrupt("tag name out of range"));
+            }
+            let ok = match w(0) & 0xff {
+                KIND_NONE => true,
+                KIND_SCALAR => valid_str(w(7), w(8)) && (w(0) >> 8 & 0xff) <= 3,
+                KIND_SEQUENCE => in_range(w(7), w(8), item_count),
+                KIND_OBJECT => {
+                    in_range(w(7), w(8), entry_count)
+                        && in_range(w(9), w(10), index_count)
+                        && (w(10) == 0 || (w(10).is_power_of_two() && w(10) > w(8)))
+                }
+                _ => false,
+            };
+            if !ok {
+                return Err(CompiledError::Corrupt("node payload out of range"));
+            }
+            match w(0) & 0xff {
+                KIND_SEQUENCE => {
+                    for i in w(7)..w(7) + w(8) {
+                        let item = word(self.items, i as usize);
+                        if item as usize >= node_count {
+                            return Err(CompiledError::Corrupt("item node out of range"));
+                        }
+                        adopt(id, item)?;
+                    }
+                }
+                KIND_OBJECT => {
+                    for i in w(7)..w(7) + w(8) {
+                        let at = i as usize * ENTRY_WORDS;
+                        for child in [word(self.entries, at), word(self.entries, at + 1)] {
+                            if child as usize >= node_count {
+                                return Err(CompiledError::Corrupt("entry node out of range"));
+                            }
+                            adopt(id, child)?;
+                        }
+                    }
+                }
+                _ => {}
+            }
+        }
+        for i in 0..entry_count {
+            let [key, value, doc_offset, doc_len] =
+                std::array::from_fn(|w| word(self.entries, i * ENTRY_WORDS + w));
+            if key as usize >= node_count || value as usize >= node_count {
+                return Err(CompiledError::Corrupt("entry node out of range"));
+            }
+            if doc_offset != NONE && !valid_str(doc_offset, doc_len) {
+                return Err(CompiledError::Corrupt("doc comment out of range"));
+            }
+        }
+        for i in 0..item_count {
+            if word(self.items, i) as usize >= node_count {
+                return Err(CompiledError::Corrupt("item node out of range"));
+            }
+        }
+        // Index slots are checked against their object's entry count on use.
+        Ok(())
+    }
+
+    #[inline]
+    fn node_word(&self, id: u32, i: usize) -> u32 {
+        word(self.nodes, id as usize * NODE_WORDS + i)
+    }
+
+    #[inline]
+    fn str(&self, offset: u32, len: u32) -> &'a str {
+        &self.strings[offset as usize..(offset + len) as usize]
+    }
+
+    /// The root object.
+    pub fn root(&self) -> CompiledObject<'a> {
+        CompiledValue {
+            doc: *self,
+            id: self.root,
+        }
+        .as_object()
+        .unwrap()
+    }
+
+    /// Get a value by path, like [`Document::get`].
+    pub fn get(&self, path: &str) -> Option<CompiledValue<'a>> {
+        if path.is_empty() {
+            return None;
+        }
+        let (segment, rest) = split_path(path);
+        let value = self.root().get(segment)?;
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Copy the tree into an owned [`Document`].
+    pub fn to_document(&self) -> Document {
+        let mut root = self.root().to_object();
+        root.span = None;
+        Document::from_root(root)
+    }
+}
+
+/// A value in a [`CompiledDocument`].
+#[derive(Clone, Copy)]
+pub struct CompiledValue<'a> {
+    doc: CompiledDocument<'a>,
+    id: u32,
+}
+
+impl<'a> CompiledValue<'a> {
+    #[inline]
+    fn word(&self, i: usize) -> u32 {
+        self.doc.node_word(self.id, i)
+    }
+
+    fn kind(&self) -> u32 {
+        self.word(0) & 0xff
+    }
+
+    fn flags(&self) -> u32 {
+        self.word(0) >> 16
+    }
+
+    /// Source span (None if the value had none).
+    pub fn span(&self) -> Option<Span> {
+        (self.flags() & FLAG_SPAN != 0).then(|| Span::new(self.word(5), self.word(6)))
+    }
+
+    /// Check if this is unit (`@` - no tag, no payload).
+    pub fn is_unit(&self) -> bool {
+        self.flags() & FLAG_TAG == 0 && self.kind() == KIND_NONE
+    }
+
+    /// Get the tag name if present.
+    pub fn tag_name(&self) -> Option<&'a str> {
+        (self.flags() & FLAG_TAG != 0).then(|| self.doc.str(self.word(1), self.word(2)))
+    }
+
+    /// Get as string (for untagged scalars).
+    pub fn as_str(&self) -> Option<&'a str> {
+        if self.flags() & FLAG_TAG != 0 {
+            return None;
+        }
+        self.scalar_text()
+    }
+
+    /// Get the scalar text regardless of tag.
+    pub fn scalar_text(&self) -> Option<&'a str> {
+        (self.kind() == KIND_SCALAR).then(|| self.doc.str(self.word(7), self.word(8)))
+    }
+
+    /// Get the scalar kind, if the payload is a scalar.
+    pub fn scalar_kind(&self) -> Option<ScalarKind> {
+        if self.kind() != KIND_SCALAR {
+            return None;
+        }
+        Some(match self.word(0) >> 8 & 0xff {
+            0 => ScalarKind::Bare,
+            1 => ScalarKind::Quoted,
+            2 => ScalarKind::Raw,
+            _ => ScalarKind::Heredoc,
+        })
+    }
+
+    /// Get as object (payload only).
+    pub fn as_object(&self) -> Option<CompiledObject<'a>> {
+        (self.kind() == KIND_OBJECT).then_some(CompiledObject { value: *self })
+    }
+
+    /// Get as sequence (payload only).
+    pub fn as_sequence(&self) -> Option<CompiledSequence<'a>> {
+        (self.kind() == KIND_SEQUENCE).then_some(CompiledSequence { value: *self })
+    }
+
+    /// Get a value by path, like [`Value::get`].
+    pub fn get(&self, path: &str) -> Option<CompiledValue<'a>> {
+        if path.is_empty() {
+            return Some(*self);
+        }
+
+        let (segment, rest) = split_path(path);
+
+        let value = match self.kind() {
+            KIND_OBJECT => self.as_object()?.get(segment)?,
+            KIND_SEQUENCE => {
+                let idx: usize = segment.strip_prefix('[')?.strip_suffix(']')?.parse().ok()?;
+                self.as_sequence()?.get(idx)?
+            }
+            _ => return None,
+        };
+        if rest.is_empty() {
+            Some(value)
+        } else {
+            value.get(rest)
+        }
+    }
+
+    /// Copy this value into an owned [`Value`].
+    pub fn to_value(&self) -> Value {
+        let span = self.span();
+        let payload = match self.kind() {
+            KIND_SCALAR => Some(Payload::Scalar(Scalar {
+                text: self.scalar_text().unwrap().to_string(),
+                kind: self.scalar_kind().unwrap(),
+                span,
+            })),
+            KIND_SEQUENCE => Some(Payload::Sequence(self.as_sequence().unwrap().to_sequence())),
+            KIND_OBJECT => Some(Payload::Object(self.as_object().unwrap().to_object())),
+            _ => None,
+        };
+        Value {
+            tag: self.tag_name().map(|name| Tag {
+                name: name.to_string(),
+                span: (self.flags() & FLAG_TAG_SPAN != 0)
+                    .then(|| Span::new(self.word(3), self.word(4))),
+            }),
+            payload,
+            span,
+        }
+    }
+}
+
+impl std::fmt::Debug for CompiledValue<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        std::fmt::Debug::fmt(&self.to_value(), f)
+    }
+}
+
+/// An object in a [`CompiledDocument`].
+#[derive(Clone, Copy)]
+pub struct CompiledObject<'a> {
+    value: CompiledValue<'a>,
+}
+
+impl<'a> CompiledObject<'a> {
+    /// Source span (None for the root).
+    pub fn span(&self) -> Option<Span> {
+        self.value.span()
+    }
+
+    /// Number of entries.
+    pub fn len(&self) -> usize {
+        self.value.word(8) as usize
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Get the entry at `index`.
+    pub fn entry(&self, index: usize) -> Option<CompiledEntry<'a>> {
+        (index < self.len()).then(|| CompiledEntry {
+            doc: self.value.doc,
+            index: self.value.word(7) as usize + index,
+        })
+    }
+
+    /// Get entry value by key (for untagged scalar keys).
+    pub fn get(&self, key: &str) -> Option<CompiledValue<'a>> {
+        let capacity = self.value.word(10) as usize;
+        if capacity == 0 {
+            return self
+                .iter()
+                .find(|e| e.key().as_str() == Some(key))
+                .map(|e| e.value());
+        }
+        let slots = self.value.word(9) as usize;
+        let mask = capacity - 1;
+        let mut slot = key_hash(key) as usize & mask;
+        // Capacity is always larger than the entry count, so probing ends.
+        for _ in 0..capacity {
+            let local = word(self.value.doc.index, slots + slot);
+            if local == NONE {
+                return None;
+            }
+            let entry = self.entry(local as usize)?;
+            if entry.key().as_str() == Some(key) {
+                return Some(entry.value());
+            }
+            slot = (slot + 1) & mask;
+        }
+        None
+    }
+
+    /// Iterate over entries.
+    pub fn iter(&self) -> impl Iterator<Item = CompiledEntry<'a>> + 'a {
+        let this = *self;
+        (0..self.len()).map(move |i| this.entry(i).unwrap())
+    }
+
+    /// Copy this object into an owned [`Object`].
+    pub fn to_object(&self) -> Object {
+        let entries = self
+            .iter()
+            .map(|e| Entry {
+                key: e.key().to_value(),
+                value: e.value().to_value(),
+                doc_comment: e.doc_comment().map(str::to_string),
+            })
+            .collect();
+        Object::new(entries, self.span())
+    }
+}
+
+/// An entry (key-value pair) in a [`CompiledObject`].
+#[derive(Clone, Copy)]
+pub struct CompiledEntry<'a> {
+    doc: CompiledDocument<'a>,
+    index: usize,
+}
+
+impl<'a> CompiledEntry<'a> {
+    fn word(&self, i: usize) -> u32 {
+        word(self.doc.entries, self.index * ENTRY_WORDS + i)
+    }
+
+    /// The key.
+    pub fn key(&self) -> CompiledValue<'a> {
+        CompiledValue {
+            doc: self.doc,
+            id: self.word(0),
+        }
+    }
+
+    /// The value.
+    pub fn value(&self) -> CompiledValue<'a> {
+        CompiledValue {
+            doc: self.doc,
+            id: self.word(1),
+        }
+    }
+
+    /// Doc comment attached to this entry.
+    pub fn doc_comment(&self) -> Option<&'a str> {
+        let offset = self.word(2);
+        (offset != NONE).then(|| self.doc.str(offset, self.word(3)))
+    }
+}
+
+/// A sequence in a [`CompiledDocument`].
+#[derive(Clone, Copy)]
+pub struct CompiledSequence<'a> {
+    value: CompiledValue<'a>,
+}
+
+impl<'a> CompiledSequence<'a> {
+    /// Source span.
+    pub fn span(&self) -> Option<Span> {
+        self.value.span()
+    }
+
+    /// Number of items.
+    pub fn len(&self) -> usize {
+        self.value.word(8) as usize
+    }
+
+    /// Check if empty.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Get item by index.
+    pub fn get(&self, index: usize) -> Option<CompiledValue<'a>> {
+        (index < self.len()).then(|| CompiledValue {
+            doc: self.value.doc,
+            id: word(self.value.doc.items, self.value.word(7) as usize + index),
+        })
+    }
+
+    /// Iterate over items.
+    pub fn iter(&self) -> impl Iterator<Item = CompiledValue<'a>> + 'a {
+        let this = *self;
+        (0..self.len()).map(move |i| this.get(i).unwrap())
+    }
+
+    /// Copy this sequence into an owned [`Sequence`].
+    pub fn to_sequence(&self) -> Sequence {
+        Sequence {
+            items: self.iter().map(|v| v.to_value()).collect(),
+            span: self.span(),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SOURCE: &str = r#"/// The server
+server {
+    host localhost
+    ports (8080 8443)
+    tls @tls{cert "/etc/cert.pem"}
+}
+name "quoted \"app\""
+empty @
+schema @object{x @string}
+"#;
+
+    #[test]
+    fn test_round_trip() {
+        let doc = Document::parse(SOURCE).unwrap();
+        let bytes = doc.compile().unwrap();
+        assert_eq!(Document::from_compiled(&bytes).unwrap(), doc);
+    }
+
+    #[test]
+    fn test_round_trip_corpus() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                let Ok(source) = std::fs::read_to_string(file.path()) else {
+                    continue;
+                };
+                if let Ok(doc) = Document::parse(&source) {
+                    let back = Document::from_compiled(&doc.compile().unwrap()).unwrap();
+                    assert_eq!(back, doc, "{}", file.path().display());
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_read_in_place() {
+        let doc = Document::parse(SOURCE).unwrap();
+        let bytes = doc.compile().unwrap();
+        let compiled = CompiledDocument::from_bytes(&bytes).unwrap();
+
+        assert_eq!(
+            compiled.get("server.ports[1]").and_then(|v| v.as_str()),
+            Some("8443")
+        );
+        assert_eq!(
+            compiled.get("server.tls.cert").and_then(|v| v.as_str()),
+            Some("/etc/cert.pem")
+        );
+        assert_eq!(
+            compiled.get("server.tls").and_then(|v| v.tag_name()),
+            Some("tls")
+        );
+        assert_eq!(
+            compiled.get("name").and_then(|v| v.as_str()),
+            Some("quoted \"app\"")
+        );
+        assert!(compiled.get("empty").unwrap().is_unit());
+        assert_eq!(
+            compiled.root().entry(0).unwrap().doc_comment(),
+            Some("The server")
+        );
+    }
+
+    #[test]
+    fn test_wide_object_index() {
+        let mut source = String::new();
+        for i in 0..200 {
+            source.push_str(&format!("key{i} value{i}\n"));
+        }
+        let doc = Document::parse(&source).unwrap();
+        let bytes = doc.compile().unwrap();
+        let compiled = CompiledDocument::from_bytes(&bytes).unwrap();
+        for i in 0..200 {
+            let expected = format!("value{i}");
+            assert_eq!(
+                compiled.get(&format!("key{i}")).and_then(|v| v.as_str()),
+                Some(expected.as_str())
+            );
+        }
+        assert!(compiled.get("key200").is_none());
+    }
+
+    #[test]
+    fn test_strings_are_interned() {
+        let doc = Document::parse("a same\nb same\nc same").unwrap();
+        let bytes = doc.compile().unwrap();
+        // "same" is stored once, after the keys.
+        assert!(bytes.ends_with(b"asamebc"));
+    }
+
+    #[test]
+    fn test_rejects_bad_input() {
+        let bytes = Document::parse("a b").unwrap().compile().unwrap();
+        assert_eq!(
+            CompiledDocument::from_bytes(b"nope").err(),
+            Some(CompiledError::BadMagic)
+        );
+        assert_eq!(
+            CompiledDocument::from_bytes(&bytes[..bytes.len() - 1]).err(),
+            Some(CompiledError::Truncated)
+        );
+
+        let mut bad_version = bytes.clone();
+        bad_version[8] = 99;
+        assert_eq!(
+            CompiledDocument::from_bytes(&bad_version).err(),
+            Some(CompiledError::UnsupportedVersion(99))
+        );
+
+        // Claim the largest node table the header can describe.
+        let mut huge = bytes.clone();
+        let nodes = COMPILED_MAGIC.len() + 3 * 4;
+        huge[nodes..nodes + 4].copy_from_slice(&u32::MAX.to_le_bytes());
+        assert_eq!(
+            CompiledDocument::from_bytes(&huge).err(),
+            Some(CompiledError::Truncated)
+        );
+
+        // Point the root's entry run past the end of the entry table.
+        let mut corrupt = bytes.clone();
+        let root_len = HEADER_LEN + 8 * 4;
+        corrupt[root_len..root_len + 4].copy_from_slice(&100u32.to_le_bytes());
+        assert!(matches!(
+            CompiledDocument::from_bytes(&corrupt),
+            Err(CompiledError::Corrupt(_))
+        ));
+    }
+
+    /// Point entry `entry`'s value at node `node`.
+    fn set_entry_value(bytes: &mut [u8], entry: usize, node: u32) {
+        let nodes = word(&bytes[COMPILED_MAGIC.len()..], 3) as usize;
+        let at = HEADER_LEN + (nodes * NODE_WORDS + entry * ENTRY_WORDS + 1) * 4;
+        bytes[at..at + 4].copy_from_slice(&node.to_le_bytes());
+    }
+
+    #[test]
+    fn test_rejects_cycles_and_shared_nodes() {
+        // Nodes: root 0, `a` 1, `{b c}` 2, `b` 3, `c` 4. Entry 1 is `b c`.
+        let bytes = Document::parse("a {b c}").unwrap().compile().unwrap();
+        for target in [0, 2] {
+            let mut cyclic = bytes.clone();
+            set_entry_value(&mut cyclic, 1, target);
+            assert_eq!(
+                CompiledDocument::from_bytes(&cyclic).err(),
+                Some(CompiledError::Corrupt("node is not part of a tree")),
+                "b -> node {target}"
+            );
+        }
+
+        // Entries 0 and 1 both holding node 2 would share it.
+        let mut shared = Document::parse("a 1\nb 2").unwrap().compile().unwrap();
+        set_entry_value(&mut shared, 1, 2);
+        assert_eq!(
+            CompiledDocument::from_bytes(&shared).err(),
+            Some(CompiledError::Corrupt("node is not part of a tree"))
+        );
+    }
+}
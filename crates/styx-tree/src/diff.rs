@@ -0,0 +1,303 @@
+//! Path-level comparison of document trees.
+//!
+//! Spans and doc comments are ignored: two values are the same if they have
+//! the same tag and the same payload, wherever they sit in the source.
+//! Objects whose [subtree hashes](crate::Object::subtree_hash) differ are
+//! known to differ without being walked. Equal hashes are confirmed by
+//! comparing the subtrees, since distinct subtrees can share a 64-bit hash;
+//! that walk is a plain comparison, with no paths built.
+
+use std::collections::{HashMap, VecDeque};
+
+use crate::{Document, Entry, Object, Payload, Value};
+
+impl Document {
+    /// List the paths whose values differ between `self` (old) and `other`
+    /// (new).
+    pub fn diff(&self, other: &Document) -> Vec<Change> {
+        let mut changes = Vec::new();
+        if !objects_unchanged(&self.root, &other.root) {
+            diff_entries(self.root.entries(), other.root.entries(), "", &mut changes);
+        }
+        changes
+    }
+}
+
+/// How the value at a path differs between two documents.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ChangeKind {
+    /// The path exists only in the new document.
+    Added,
+    /// The path exists only in the old document.
+    Removed,
+    /// The path exists in both, with different values.
+    Changed,
+}
+
+/// A single difference between two documents.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Change {
+    /// What happened at `path`.
+    pub kind: ChangeKind,
+    /// Path to the value, in [`Document::get`](crate::Document::get) syntax.
+    pub path: String,
+}
+
+/// Compare two entry lists, appending differences under `prefix` to `out`.
+///
+/// Entries are matched by key. Repeated keys (such as root entries split by
+/// other keys) are matched in order of occurrence.
+pub(crate) fn diff_entries(old: &[Entry], new: &[Entry], prefix: &str, out: &mut Vec<Change>) {
+    // Usual case: same keys in the same order.
+    if old.len() == new.len() && old.iter().zip(new).all(|(a, b)| unchanged(&a.key, &b.key)) {
+        for (a, b) in old.iter().zip(new) {
+            if !unchanged(&a.value, &b.value) {
+                diff_value(&a.value, &b.value, join(prefix, &key_segment(&b.key)), out);
+            }
+        }
+        return;
+    }
+
+    let mut positions: HashMap<String, VecDeque<usize>> = HashMap::new();
+    for (i, entry) in old.iter().enumerate() {
+        positions
+            .entry(key_segment(&entry.key))
+            .or_default()
+            .push_back(i);
+    }
+    let mut matched = vec![false; old.len()];
+    for entry in new {
+        let key = key_segment(&entry.key);
+        match positions.get_mut(&key).and_then(VecDeque::pop_front) {
+            Some(i) => {
+                matched[i] = true;
+                if !unchanged(&old[i].value, &entry.value) {
+                    diff_value(&old[i].value, &entry.value, join(prefix, &key), out);
+                }
+            }
+            None => out.push(Change {
+                kind: ChangeKind::Added,
+                path: join(prefix, &key),
+            }),
+        }
+    }
+    for (entry, _) in old.iter().zip(&matched).filter(|(_, m)| !**m) {
+        out.push(Change {
+            kind: ChangeKind::Removed,
+            path: join(prefix, &key_segment(&entry.key)),
+        });
+    }
+}
+
+/// Record how `old` and `new`, known to differ, differ at `path`.
+fn diff_value(old: &Value, new: &Value, path: String, out: &mut Vec<Change>) {
+    if same_tag(old, new) {
+        match (&old.payload, &new.payload) {
+            (Some(Payload::Object(a)), Some(Payload::Object(b))) => {
+                return diff_entries(a.entries(), b.entries(), &path, out);
+            }
+            (Some(Payload::Sequence(a)), Some(Payload::Sequence(b)))
+                if a.items.len() == b.items.len() =>
+            {
+                for (i, (a, b)) in a.items.iter().zip(&b.items).enumerate() {
+                    if !unchanged(a, b) {
+                        diff_value(a, b, format!("{path}[{i}]"), out);
+                    }
+                }
+                return;
+            }
+            _ => {}
+        }
+    }
+    out.push(Change {
+        kind: ChangeKind::Changed,
+        path,
+    });
+}
+
+/// Whether two values are structurally equal.
+fn unchanged(a: &Value, b: &Value) -> bool {
+    same_tag(a, b)
+        && match (&a.payload, &b.payload) {
+            (None, None) => true,
+            (Some(Payload::Scalar(x)), Some(Payload::Scalar(y))) => {
+                x.text == y.text && x.kind == y.kind
+            }
+            (Some(Payload::Object(x)), Some(Payload::Object(y))) => objects_unchanged(x, y),
+            (Some(Payload::Sequence(x)), Some(Payload::Sequence(y))) => {
+                x.items.len() == y.items.len()
+                    && x.items.iter().zip(&y.items).all(|(a, b)| unchanged(a, b))
+            }
+            _ => false,
+        }
+}
+
+/// Whether two objects are structurally equal. Differing cached hashes
+/// answer at once; equal ones only make equality likely, so the entries are
+/// compared too.
+fn objects_unchanged(a: &Object, b: &Object) -> bool {
+    if std::ptr::eq(a, b) {
+        return true;
+    }
+    if a.subtree_hash() != b.subtree_hash() {
+        return false;
+    }
+    let (a, b) = (a.entries(), b.entries());
+    a.len() == b.len()
+        && a.iter()
+            .zip(b)
+            .all(|(a, b)| unchanged(&a.key, &b.key) && unchanged(&a.value, &b.value))
+}
+
+fn same_tag(a: &Value, b: &Value) -> bool {
+    a.tag_name() == b.tag_name()
+}
+
+/// A key as a path segment: its scalar text, or `@` for the unit key.
+fn key_segment(key: &Value) -> String {
+    match (key.tag_name(), key.scalar_text()) {
+        (None, Some(text)) => text.to_string(),
+        (Some(tag), _) => format!("@{tag}"),
+        (None, None) => "@".to_string(),
+    }
+}
+
+fn join(prefix: &str, key: &str) -> String {
+    if prefix.is_empty() {
+        key.to_string()
+    } else {
+        format!("{prefix}.{key}")
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn diff(old: &str, new: &str) -> Vec<(ChangeKind, String)> {
+        let old = Document::parse(old).unwrap();
+        let new = Document::parse(new).unwrap();
+        old.diff(&new)
+            .into_iter()
+            .map(|c| (c.kind, c.path))
+            .collect()
+    }
+
+    #[test]
+    fn test_identical_documents() {
+        let source = "a 1\nb {c (x y), d @tag{e f}}\n";
+        assert!(diff(source, source).is_empty());
+        // Layout and doc comments are not changes.
+        assert!(
+            diff(
+                source,
+                "/// doc\na   1\n\nb {\n  c (x y)\n  d @tag{e f}\n}\n"
+            )
+            .is_empty()
+        );
+    }
+
+    #[test]
+    fn test_path_level_changes() {
+        use ChangeKind::*;
+        assert_eq!(
+            diff(
+                "a 1\nb {c 2, d {e 3, f 4}}\ns (1 2 3)\nold x\n",
+                "a 1\nb {c 2, d {e 3, f 5}, g 6}\ns (1 9 3)\nnew y\n",
+            ),
+            [
+                (Changed, "b.d.f".to_string()),
+                (Added, "b.g".to_string()),
+                (Changed, "s[1]".to_string()),
+                (Added, "new".to_string()),
+                (Removed, "old".to_string()),
+            ]
+        );
+        // Kind, tag and shape changes replace the whole value.
+        assert_eq!(
+            diff("a 1\nb (1 2)\nc @x\n", "a \"1\"\nb (1 2 3)\nc @y\n"),
+            [
+                (Changed, "a".to_string()),
+                (Changed, "b".to_string()),
+                (Changed, "c".to_string()),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_reordered_keys() {
+        use ChangeKind::*;
+        assert!(diff("a 1\nb 2\n", "b 2\na 1\n").is_empty());
+        assert_eq!(
+            diff("a 1\nb 2\n", "b 3\na 1\n"),
+            [(Changed, "b".to_string())]
+        );
+    }
+
+    #[test]
+    fn test_subtree_hash() {
+        let a = Document::parse("x {y 1, z (a b)}\n").unwrap();
+        let b = Document::parse("/// moved\n\nx {\n  y 1\n  z (a b)\n}\n").unwrap();
+        let c = Document::parse("x {y 1, z (a c)}\n").unwrap();
+        assert_eq!(a.root.subtree_hash(), b.root.subtree_hash());
+        assert_ne!(a.root.subtree_hash(), c.root.subtree_hash());
+    }
+
+    #[test]
+    fn test_mutation_updates_hash() {
+        let mut doc = Document::parse("x {y 1}\n").unwrap();
+        let before = doc.root.subtree_hash();
+
+        doc.root
+            .get_mut("x")
+            .and_then(Value::as_object_mut)
+            .unwrap()
+            .insert("y", Value::scalar("2"));
+        assert_ne!(doc.root.subtree_hash(), before);
+
+        let mut pushed = Document::parse("x {y 1}\n").unwrap();
+        pushed.root.push(Entry {
+            key: Value::scalar("z"),
+            value: Value::unit(),
+            doc_comment: None,
+        });
+        assert_ne!(pushed.root.subtree_hash(), before);
+    }
+
+    #[test]
+    fn test_diff_sees_edits_after_hashing() {
+        use ChangeKind::*;
+        let old = Document::parse("a 1\nb 2\nc {d {e 4}}\n").unwrap();
+        old.root.subtree_hash();
+
+        // Through the root's entries, on a copy carrying the cached hashes.
+        let mut new = old.clone();
+        new.root.entries_mut()[1].value = Value::scalar("3");
+        assert_eq!(
+            old.diff(&new),
+            [Change {
+                kind: Changed,
+                path: "b".into()
+            }]
+        );
+
+        // Two levels down, through nested objects.
+        let mut new = old.clone();
+        new.root
+            .get_mut("c")
+            .and_then(Value::as_object_mut)
+            .and_then(|c| c.get_mut("d"))
+            .and_then(Value::as_object_mut)
+            .unwrap()
+            .entries_mut()[0]
+            .value = Value::scalar("5");
+        assert_ne!(new.root.subtree_hash(), old.root.subtree_hash());
+        assert_eq!(
+            old.diff(&new),
+            [Change {
+                kind: Changed,
+                path: "c.d.e".into()
+            }]
+        );
+    }
+}
@@ -0,0 +1,68 @@
+//! Structural hashes of subtrees.
+//!
+//! Every object caches a hash of its contents, computed by the
+//! [`TreeBuilder`](crate::TreeBuilder) as the object is closed (children
+//! first, so each node is hashed once). Diffing two documents then rejects
+//! differing subtrees in O(1); equal hashes still need confirming, as
+//! distinct subtrees can collide. Like
+//! [`Document::diff`](crate::Document::diff), hashes ignore spans and doc
+//! comments.
+
+use std::sync::OnceLock;
+
+use crate::index::key_hash;
+use crate::{Object, Payload, Value};
+
+/// Lazily computed hash of an [`Object`]'s entries.
+///
+/// The owning object resets it on every mutable access to its entries, so a
+/// cached hash is never stale.
+#[derive(Default, Clone)]
+pub(crate) struct SubtreeHash {
+    cell: OnceLock<u64>,
+}
+
+impl SubtreeHash {
+    pub(crate) fn get(&self, obj: &Object) -> u64 {
+        *self.cell.get_or_init(|| object_hash(obj))
+    }
+}
+
+fn object_hash(obj: &Object) -> u64 {
+    let entries = obj.entries();
+    entries
+        .iter()
+        .fold(mix(0x6f62, entries.len() as u64), |hash, entry| {
+            mix(mix(hash, value_hash(&entry.key)), value_hash(&entry.value))
+        })
+}
+
+/// Structural hash of a value: its tag and payload, not its spans.
+pub(crate) fn value_hash(value: &Value) -> u64 {
+    let hash = value
+        .tag
+        .as_ref()
+        .map_or(0, |tag| mix(1, key_hash(&tag.name)));
+    match &value.payload {
+        None => mix(hash, 1),
+        Some(Payload::Scalar(scalar)) => {
+            mix(mix(hash, 2 + scalar.kind as u64), key_hash(&scalar.text))
+        }
+        Some(Payload::Sequence(seq)) => seq
+            .items
+            .iter()
+            .fold(mix(mix(hash, 6), seq.items.len() as u64), |hash, item| {
+                mix(hash, value_hash(item))
+            }),
+        Some(Payload::Object(obj)) => mix(mix(hash, 7), obj.subtree_hash()),
+    }
+}
+
+/// Order-dependent combination of two hashes (splitmix64 finalizer).
+#[inline]
+fn mix(hash: u64, value: u64) -> u64 {
+    let mut z = hash.rotate_left(23) ^ value.wrapping_add(0x9e37_79b9_7f4a_7c15);
+    z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    z ^ (z >> 31)
+}
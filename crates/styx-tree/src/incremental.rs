@@ -0,0 +1,348 @@
+//! Incremental reparsing after a text edit.
+//!
+//! Only the root entries around the edited range are re-tokenized and
+//! rebuilt. The reparsed chunk is chosen with the cut rules used by
+//! [`parse_parallel`](crate::parse_parallel): it starts at an unchanged root
+//! entry where the serial parser carries no state, and ends at the first
+//! entry past the edit where the old and new parses line up again. Entries
+//! outside the chunk are kept as they are, with spans after the edit shifted
+//! by the change in length. The result is identical to a full
+//! [`Document::parse`] of the new source.
+
+use std::ops::Range;
+
+use styx_parse::{ScalarKind, Span, TokenKind, Tokenizer};
+
+use crate::diff::{Change, diff_entries};
+use crate::parallel::{Cuts, parse_chunk};
+use crate::{BuildError, Document, Entry, Payload, Value};
+
+/// A text edit: `range` of the old source was replaced by `new_len` bytes.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Edit {
+    /// Byte range replaced in the old source.
+    pub range: Range<usize>,
+    /// Length in bytes of the replacement text.
+    pub new_len: usize,
+}
+
+impl Document {
+    /// Update the document after `edit` turned its source into `new_source`,
+    /// reparsing only the root entries the edit touches.
+    ///
+    /// `self` must have been parsed from the source before the edit. Returns
+    /// the paths whose values were added, removed or changed. On error the
+    /// document is left as it was.
+    pub fn reparse(&mut self, new_source: &str, edit: &Edit) -> Result<Vec<Change>, BuildError> {
+        let mut changes = Vec::new();
+        let Some(plan) = plan(self.root.entries(), new_source, edit) else {
+            let new = Document::parse(new_source)?;
+            diff_entries(self.root.entries(), new.root.entries(), "", &mut changes);
+            *self = new;
+            return Ok(changes);
+        };
+
+        let chunk = parse_chunk(new_source, (plan.source.start, plan.source.end))?;
+        diff_entries(
+            &self.root.entries()[plan.entries.clone()],
+            &chunk,
+            "",
+            &mut changes,
+        );
+        let delta = edit.new_len as i64 - edit.range.len() as i64;
+        if delta != 0 {
+            for entry in &mut self.root.entries_mut()[plan.entries.end..] {
+                shift_value(&mut entry.key, delta);
+                shift_value(&mut entry.value, delta);
+            }
+        }
+        self.root.entries_mut().splice(plan.entries, chunk);
+        Ok(changes)
+    }
+}
+
+/// What to reparse: old root `entries` are replaced by the entries parsed
+/// from `source` (a range of the new source).
+#[derive(Debug, PartialEq)]
+struct Plan {
+    entries: Range<usize>,
+    source: Range<usize>,
+}
+
+/// Work out the smallest chunk to reparse, or `None` to reparse everything.
+fn plan(entries: &[Entry], source: &str, edit: &Edit) -> Option<Plan> {
+    let range = &edit.range;
+    let new_end = range.start.checked_add(edit.new_len)?;
+    if range.start > range.end || new_end > source.len() || explicit_root(source) {
+        return None;
+    }
+    let delta = new_end as i64 - range.end as i64;
+    let starts: Vec<usize> = entries
+        .iter()
+        .map(|e| e.key.span.map(|s| s.start as usize))
+        .collect::<Option<_>>()?;
+
+    // Old source bytes, where they survive the edit.
+    let bytes = source.as_bytes();
+    let old_byte = |pos: usize| {
+        if pos < range.start {
+            Some(bytes[pos])
+        } else if pos >= range.end {
+            bytes.get((pos as i64 + delta) as usize).copied()
+        } else {
+            None
+        }
+    };
+    // Start of the (old) line holding the key at `key`, if only indentation
+    // precedes it.
+    let line_start = |key: usize| {
+        let mut pos = key;
+        while pos > 0 {
+            match old_byte(pos - 1)? {
+                b' ' | b'\t' => pos -= 1,
+                b'\n' => return Some(pos),
+                _ => return None,
+            }
+        }
+        Some(0)
+    };
+
+    // Start at the last entry before the edit where a chunk may begin, both
+    // in the old source and in the new one.
+    let before = starts.partition_point(|&s| s <= range.start);
+    let (first, start) = (1..=before.min(entries.len().saturating_sub(1)))
+        .rev()
+        .find_map(|i| {
+            let at = line_start(starts[i]).filter(|&at| at <= range.start)?;
+            let prev = old_cut(entries, i)?;
+            (Cuts::resume(source, at, Some(prev)).until(at).next() == Some(at)).then_some((i, at))
+        })
+        .unwrap_or((0, 0));
+
+    // End at the first cut past the edit that lands on an old entry which
+    // itself started with a clean parser state.
+    let prev = first.checked_sub(1).and_then(|i| bare_key(&entries[i].key));
+    for cut in Cuts::resume(source, start, prev) {
+        if cut <= new_end {
+            continue;
+        }
+        let old = (cut as i64 - delta) as usize;
+        let last = starts.partition_point(|&s| s < old);
+        if last == entries.len() {
+            break;
+        }
+        if line_start(starts[last]) == Some(old) && old_cut(entries, last).is_some() {
+            return Some(Plan {
+                entries: first..last,
+                source: start..cut,
+            });
+        }
+    }
+    Some(Plan {
+        entries: first..entries.len(),
+        source: start..source.len(),
+    })
+}
+
+/// Whether the parser starts fresh before root entry `i`: returns the
+/// previous entry's key if both keys are bare, with different first path
+/// segments, and no doc comment precedes entry `i`.
+fn old_cut(entries: &[Entry], i: usize) -> Option<&str> {
+    let entry = entries.get(i)?;
+    let key = bare_key(&entry.key)?;
+    let prev = bare_key(&entries.get(i.checked_sub(1)?)?.key)?;
+    (entry.doc_comment.is_none() && key != prev).then_some(prev)
+}
+
+fn bare_key(key: &Value) -> Option<&str> {
+    match (&key.tag, &key.payload) {
+        (None, Some(Payload::Scalar(scalar))) if scalar.kind == ScalarKind::Bare => {
+            Some(&scalar.text)
+        }
+        _ => None,
+    }
+}
+
+/// Whether the document is wrapped in an explicit root object.
+fn explicit_root(source: &str) -> bool {
+    Tokenizer::new(source)
+        .find(|t| {
+            !matches!(
+                t.kind,
+                TokenKind::Whitespace
+                    | TokenKind::Newline
+                    | TokenKind::LineComment
+                    | TokenKind::DocComment
+            )
+        })
+        .is_some_and(|t| t.kind == TokenKind::LBrace)
+}
+
+fn shift_value(value: &mut Value, delta: i64) {
+    shift_span(&mut value.span, delta);
+    if let Some(tag) = &mut value.tag {
+        shift_span(&mut tag.span, delta);
+    }
+    match &mut value.payload {
+        Some(Payload::Scalar(scalar)) => shift_span(&mut scalar.span, delta),
+        Some(Payload::Sequence(seq)) => {
+            shift_span(&mut seq.span, delta);
+            for item in &mut seq.items {
+                shift_value(item, delta);
+            }
+        }
+        Some(Payload::Object(obj)) => {
+            // Deferred spans point into the old source, so this parses
+            // lazy objects first.
+            shift_span(&mut obj.span, delta);
+            for entry in obj.entries_mut() {
+                shift_value(&mut entry.key, delta);
+                shift_value(&mut entry.value, delta);
+            }
+        }
+        None => {}
+    }
+}
+
+fn shift_span(span: &mut Option<Span>, delta: i64) {
+    if let Some(span) = span {
+        span.start = (span.start as i64 + delta) as u32;
+        span.end = (span.end as i64 + delta) as u32;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ChangeKind;
+
+    /// Apply `range -> text` to `old`, reparse incrementally, and check the
+    /// result against a full parse.
+    fn edit(old: &str, range: Range<usize>, text: &str) -> (Document, Vec<Change>) {
+        let mut new = old.to_string();
+        new.replace_range(range.clone(), text);
+        let edit = Edit {
+            range,
+            new_len: text.len(),
+        };
+        let mut doc = Document::parse(old).unwrap();
+        let changes = doc.reparse(&new, &edit).unwrap();
+        assert_eq!(Ok(&doc), Document::parse(&new).as_ref(), "{new:?}");
+        (doc, changes)
+    }
+
+    fn plan_for(old: &str, range: Range<usize>, text: &str) -> Option<Plan> {
+        let mut new = old.to_string();
+        new.replace_range(range.clone(), text);
+        let doc = Document::parse(old).unwrap();
+        let edit = Edit {
+            range,
+            new_len: text.len(),
+        };
+        plan(doc.root.entries(), &new, &edit)
+    }
+
+    fn paths(changes: &[Change], kind: ChangeKind) -> Vec<&str> {
+        changes
+            .iter()
+            .filter(|c| c.kind == kind)
+            .map(|c| c.path.as_str())
+            .collect()
+    }
+
+    const SOURCE: &str =
+        "name app\nserver {\n  host localhost\n  port 8080\n}\nlog.level info\nfeatures (a b c)\n";
+
+    #[test]
+    fn test_value_edit_reparses_one_entry() {
+        let at = SOURCE.find("8080").unwrap();
+        assert_eq!(
+            plan_for(SOURCE, at..at + 4, "9090"),
+            Some(Plan {
+                entries: 1..2,
+                source: 9..SOURCE.find("log").unwrap(),
+            })
+        );
+        let (doc, changes) = edit(SOURCE, at..at + 4, "9090");
+        assert_eq!(paths(&changes, ChangeKind::Changed), ["server.port"]);
+        assert_eq!(doc.get("server.port").unwrap().as_str(), Some("9090"));
+    }
+
+    #[test]
+    fn test_length_change_shifts_later_spans() {
+        let at = SOURCE.find("localhost").unwrap();
+        let (doc, changes) = edit(SOURCE, at..at + 9, "example.internal");
+        assert_eq!(paths(&changes, ChangeKind::Changed), ["server.host"]);
+        assert!(doc.get("features").unwrap().span.unwrap().start > SOURCE.len() as u32 - 18);
+    }
+
+    #[test]
+    fn test_insert_and_remove_entries() {
+        let at = SOURCE.find("log").unwrap();
+        let (_, changes) = edit(SOURCE, at..at, "timeout 30s\n");
+        assert_eq!(paths(&changes, ChangeKind::Added), ["timeout"]);
+        assert!(paths(&changes, ChangeKind::Changed).is_empty());
+
+        let (_, changes) = edit(SOURCE, 0..9, "");
+        assert_eq!(paths(&changes, ChangeKind::Removed), ["name"]);
+    }
+
+    #[test]
+    fn test_sequence_item_change() {
+        let at = SOURCE.find("b c").unwrap();
+        let (_, changes) = edit(SOURCE, at..at + 1, "x");
+        assert_eq!(paths(&changes, ChangeKind::Changed), ["features[1]"]);
+    }
+
+    #[test]
+    fn test_edits_that_reshape_the_document() {
+        // A new multi-line entry.
+        let at = SOURCE.find("log").unwrap();
+        edit(SOURCE, at..at, "extra {\n  nested 1\n}\n");
+        // Dotted keys sharing a first segment across the edit.
+        let source = "a.x 1\nb 2\nc 3\n";
+        edit(source, 6..9, "a.y 2");
+        // Doc comments attach to the entry after them.
+        edit(SOURCE, 9..9, "/// The server.\n");
+        edit("/// doc\na 1\nb 2\nc 3\n", 8..12, "");
+        // Explicit root object.
+        edit("{\na 1\nb 2\nc 3\n}\n", 8..9, "5");
+    }
+
+    #[test]
+    fn test_error_leaves_document_unchanged() {
+        let mut doc = Document::parse(SOURCE).unwrap();
+        let before = doc.clone();
+        let at = SOURCE.find("}").unwrap();
+        let mut new = SOURCE.to_string();
+        new.replace_range(at..at + 1, "");
+        let edit = Edit {
+            range: at..at + 1,
+            new_len: 0,
+        };
+        assert!(doc.reparse(&new, &edit).is_err());
+        assert_eq!(doc, before);
+    }
+
+    #[test]
+    fn test_every_single_byte_edit() {
+        let source =
+            "a 1\nb {x 1, y (p q)}\n/// c\nc \"s\"\nd.e 4\nd.f 5\ng <<EOT\n  text\n  EOT\nh 8\n";
+        for at in 0..source.len() {
+            for text in ["", "z", "\n", " ", "{", "}", ".", "/"] {
+                let mut new = source.to_string();
+                new.replace_range(at..at + 1, text);
+                let edit = Edit {
+                    range: at..at + 1,
+                    new_len: text.len(),
+                };
+                let mut doc = Document::parse(source).unwrap();
+                match (doc.reparse(&new, &edit), Document::parse(&new)) {
+                    (Ok(_), Ok(full)) => assert_eq!(doc, full, "{new:?}"),
+                    (Err(a), Err(b)) => assert_eq!(a, b, "{new:?}"),
+                    (a, b) => panic!("{new:?}: incremental {a:?}, full {b:?}"),
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,281 @@
+//! Hashed key index for wide objects.
+//!
+//! `Object::get` is a linear scan, which is the right call for the handful of
+//! entries most objects have. Wide objects (routing tables, generated maps)
+//! get a lazily built open-addressing table of entry indices instead, so
+//! lookups stay O(1) while `entries` keeps insertion order.
+
+use std::sync::OnceLock;
+
+use crate::value::Entry;
+
+/// Objects with at least this many entries build their index on first lookup.
+pub const INDEX_THRESHOLD: usize = 16;
+
+const EMPTY: u64 = u64::MAX;
+
+/// Hash a key the same way the object index does.
+///
+/// Exposed so callers that look up the same keys repeatedly (e.g. compiled
+/// paths) can compute the hash once and use `Object::get_hashed`.
+#[inline]
+pub fn key_hash(key: &str) -> u64 {
+    // FxHash-style multiply/rotate over 8-byte words: keys are short and we
+    // don't need DoS resistance for an in-memory config tree.
+    const K: u64 = 0x517c_c1b7_2722_0a95;
+    let mut hash = key.len() as u64;
+    let mut bytes = key.as_bytes();
+    while bytes.len() >= 8 {
+        let word = u64::from_le_bytes(bytes[..8].try_into().unwrap());
+        hash = (hash.rotate_left(5) ^ word).wrapping_mul(K);
+        bytes = &bytes[8..];
+    }
+    if !bytes.is_empty() {
+        let mut tail = [0u8; 8];
+        tail[..bytes.len()].copy_from_slice(bytes);
+        hash = (hash.rotate_left(5) ^ u64::from_le_bytes(tail)).wrapping_mul(K);
+    }
+    // Fold the high bits down so both the slot (low bits) and the stored
+    // tag (high bits) are well mixed.
+    hash ^ (hash >> 29)
+}
+
+/// Lazily built key index for an [`Object`](crate::Object).
+///
+/// Only untagged scalar keys are indexed, matching `Object::get`. When a key
+/// appears more than once, the first entry wins, as with the linear scan.
+/// The owning object drops the index on every mutable access to its entries
+/// except appends, which update it, so a built index is never stale.
+#[derive(Default, Clone)]
+pub(crate) struct KeyIndex {
+    table: OnceLock<Table>,
+}
+
+#[derive(Clone)]
+struct Table {
+    /// Each slot is `(hash_hi32 << 32) | entry_index`, or `EMPTY`.
+    slots: Box<[u64]>,
+    /// Number of entries in the table.
+    len: usize,
+    /// Some key appears in more than one entry.
+    duplicates: bool,
+}
+
+impl KeyIndex {
+    /// Look up `key` (with precomputed `hash`) in `entries`.
+    ///
+    /// Returns `None` if the object is too small to be indexed; callers then
+    /// fall back to a linear scan.
+    #[inline]
+    pub(crate) fn lookup(&self, entries: &[Entry], key: &str, hash: u64) -> Option<Option<usize>> {
+        let table = match self.table.get() {
+            Some(table) => table,
+            None if entries.len() >= INDEX_THRESHOLD => {
+                self.table.get_or_init(|| Table::build(entries))
+            }
+            None => return None,
+        };
+        debug_assert_eq!(table.len, entries.len(), "stale key index");
+        Some(table.find(entries, key, hash))
+    }
+
+    /// Build the index now, regardless of object size.
+    pub(crate) fn build(&self, entries: &[Entry]) {
+        self.table.get_or_init(|| Table::build(entries));
+    }
+
+    /// Keep the index current after an entry was pushed onto `entries`.
+    pub(crate) fn pushed(&mut self, entries: &[Entry]) {
+        let Some(table) = self.table.get_mut() else {
+            return;
+        };
+        if capacity_for(entries.len()) > table.slots.len() {
+            *table = Table::build(entries);
+        } else {
+            table.insert(entries, entries.len() - 1);
+        }
+    }
+
+    /// Whether the index has been built.
+    pub(crate) fn is_built(&self) -> bool {
+        self.table.get().is_some()
+    }
+
+    /// Whether the index is built and saw every indexed key only once.
+    pub(crate) fn keys_are_unique(&self) -> bool {
+        self.table.get().is_some_and(|table| !table.duplicates)
+    }
+}
+
+impl Table {
+    fn build(entries: &[Entry]) -> Self {
+        let mut table = Table {
+            slots: vec![EMPTY; capacity_for(entries.len())].into_boxed_slice(),
+            len: 0,
+            duplicates: false,
+        };
+        for i in 0..entries.len() {
+            table.insert(entries, i);
+        }
+        table
+    }
+
+    /// Add `entries[i]` to the table. Entries must be added in order.
+    fn insert(&mut self, entries: &[Entry], i: usize) {
+        self.len = i + 1;
+        let Some(key) = entries[i].key.as_str() else {
+            return;
+        };
+        let hash = key_hash(key);
+        let mask = self.slots.len() - 1;
+        let mut slot = hash as usize & mask;
+        loop {
+            let cur = self.slots[slot];
+            if cur == EMPTY {
+                self.slots[slot] = tag(hash) | i as u64;
+                return;
+            }
+            // Keep the first occurrence of duplicate keys.
+            if cur & !0xffff_ffff == tag(hash)
+                && entries[(cur & 0xffff_ffff) as usize].key.as_str() == Some(key)
+            {
+                self.duplicates = true;
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    #[inline]
+    fn find(&self, entries: &[Entry], key: &str, hash: u64) -> Option<usize> {
+        let mask = self.slots.len() - 1;
+        let mut slot = hash as usize & mask;
+        loop {
+            let cur = self.slots[slot];
+            if cur == EMPTY {
+                return None;
+            }
+            if cur & !0xffff_ffff == tag(hash) {
+                let i = (cur & 0xffff_ffff) as usize;
+                if entries[i].key.as_str() == Some(key) {
+                    return Some(i);
+                }
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+}
+
+/// Table size for `n` entries, keeping the load factor at or below 1/2.
+pub(crate) fn capacity_for(n: usize) -> usize {
+    (n * 2).next_power_of_two().max(8)
+}
+
+#[inline]
+fn tag(hash: u64) -> u64 {
+    hash & !0xffff_ffff
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Object, Value};
+
+    fn wide_object(n: usize) -> Object {
+        let mut obj = Object::default();
+        for i in 0..n {
+            obj.insert(format!("key{i}"), Value::scalar(i.to_string()));
+        }
+        obj
+    }
+
+    #[test]
+    fn test_small_object_is_not_indexed() {
+        let obj = wide_object(INDEX_THRESHOLD - 1);
+        assert_eq!(obj.get("key3").and_then(|v| v.as_str()), Some("3"));
+        assert!(!obj.has_index());
+    }
+
+    #[test]
+    fn test_wide_object_lookup() {
+        let obj = wide_object(1000);
+        for i in 0..1000 {
+            let expected = i.to_string();
+            assert_eq!(
+                obj.get(&format!("key{i}")).and_then(|v| v.as_str()),
+                Some(expected.as_str())
+            );
+        }
+        assert!(obj.has_index());
+        assert_eq!(obj.get("missing"), None);
+        assert!(obj.contains_key("key999"));
+    }
+
+    #[test]
+    fn test_index_keeps_first_duplicate() {
+        let mut obj = wide_object(INDEX_THRESHOLD);
+        obj.build_index();
+        assert!(obj.keys_are_unique());
+        obj.push(crate::Entry {
+            key: Value::scalar("key0"),
+            value: Value::scalar("second"),
+            doc_comment: None,
+        });
+        assert!(!obj.keys_are_unique());
+        obj.invalidate_index();
+        obj.build_index();
+        assert!(!obj.keys_are_unique());
+        assert_eq!(obj.get("key0").and_then(|v| v.as_str()), Some("0"));
+    }
+
+    #[test]
+    fn test_index_follows_pushes() {
+        let mut obj = wide_object(INDEX_THRESHOLD);
+        obj.build_index();
+        obj.push(crate::Entry {
+            key: Value::scalar("late"),
+            value: Value::scalar("yes"),
+            doc_comment: None,
+        });
+        assert_eq!(obj.get("late").and_then(|v| v.as_str()), Some("yes"));
+        assert!(obj.has_index());
+
+        obj.insert("later", Value::scalar("also"));
+        assert_eq!(obj.get("later").and_then(|v| v.as_str()), Some("also"));
+        assert_eq!(obj.get("key5").and_then(|v| v.as_str()), Some("5"));
+    }
+
+    #[test]
+    fn test_index_follows_same_length_edits() {
+        let mut obj = wide_object(INDEX_THRESHOLD);
+        obj.build_index();
+        obj.entries_mut().swap(0, 1);
+        assert_eq!(obj.get("key0").and_then(|v| v.as_str()), Some("0"));
+        assert_eq!(obj.position("key0"), Some(1));
+
+        obj.build_index();
+        obj.entries_mut()[2].key = Value::scalar("renamed");
+        assert_eq!(obj.get("renamed").and_then(|v| v.as_str()), Some("2"));
+        assert_eq!(obj.get("key2"), None);
+
+        obj.build_index();
+        obj.entries_mut()
+            .sort_by(|a, b| b.key.as_str().cmp(&a.key.as_str()));
+        for i in 3..INDEX_THRESHOLD {
+            let expected = i.to_string();
+            assert_eq!(
+                obj.get(&format!("key{i}")).and_then(|v| v.as_str()),
+                Some(expected.as_str())
+            );
+        }
+    }
+
+    #[test]
+    fn test_iteration_order_preserved() {
+        let obj = wide_object(64);
+        obj.build_index();
+        let keys: Vec<_> = obj.iter().map(|(k, _)| k.as_str().unwrap()).collect();
+        let expected: Vec<_> = (0..64).map(|i| format!("key{i}")).collect();
+        assert_eq!(keys, expected);
+    }
+}
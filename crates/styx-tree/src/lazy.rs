@@ -0,0 +1,179 @@
+//! Lazily materialized documents.
+//!
+//! [`Document::parse_lazy`] runs the parser in shallow mode: every nested
+//! object is brace-matched and skipped, and the tree gets a deferred
+//! [`Object`] holding the block's span into a shared copy of the source. The
+//! first read through the object's methods parses that block, one level deep
+//! again, so parse time follows what is read rather than the document size.
+
+use std::sync::{Arc, OnceLock};
+
+use styx_parse::{Parser, Span};
+
+use crate::parallel::shift_event;
+use crate::{BuildError, Document, Entry, Payload, TreeBuilder};
+
+/// The source of a not yet built object, and its entries once built.
+pub(crate) struct Deferred {
+    source: Arc<str>,
+    span: Span,
+    entries: OnceLock<Result<Vec<Entry>, BuildError>>,
+}
+
+impl Deferred {
+    pub(crate) fn new(source: Arc<str>, span: Span) -> Self {
+        Deferred {
+            source,
+            span,
+            entries: OnceLock::new(),
+        }
+    }
+
+    /// The object's entries, parsing the block on first use.
+    pub(crate) fn entries(&self) -> Result<&[Entry], &BuildError> {
+        self.entries
+            .get_or_init(|| parse_block(&self.source, self.span))
+            .as_deref()
+    }
+
+    pub(crate) fn is_built(&self) -> bool {
+        self.entries.get().is_some()
+    }
+
+    /// Take the entries out, parsing the block if needed. Errors leave the
+    /// object empty.
+    pub(crate) fn into_entries(self: Arc<Self>) -> Vec<Entry> {
+        match Arc::try_unwrap(self) {
+            Ok(deferred) => match deferred.entries.into_inner() {
+                Some(entries) => entries.unwrap_or_default(),
+                None => parse_block(&deferred.source, deferred.span).unwrap_or_default(),
+            },
+            Err(shared) => shared.entries().map(<[Entry]>::to_vec).unwrap_or_default(),
+        }
+    }
+}
+
+/// Parse the `{...}` block at `span`, deferring any objects nested in it.
+fn parse_block(source: &Arc<str>, span: Span) -> Result<Vec<Entry>, BuildError> {
+    let mut parser = Parser::new_shallow_expr(&source[span.start as usize..span.end as usize]);
+    let mut builder = TreeBuilder::lazy(source.clone());
+    while let Some(event) = parser.next_event() {
+        builder.event(shift_event(event, span.start));
+    }
+    match builder.finish()?.payload {
+        Some(Payload::Object(obj)) => Ok(obj.into_entries()),
+        _ => Ok(Vec::new()),
+    }
+}
+
+impl Document {
+    /// Parse a Styx document, deferring the contents of nested objects until
+    /// they are first read.
+    ///
+    /// The source is copied once and shared by the deferred objects. Only the
+    /// root level is fully parsed up front; nested blocks are brace-matched
+    /// (respecting strings, heredocs and comments) but not checked, so an
+    /// error inside one surfaces only when it is read: the object then
+    /// appears empty and [`Object::try_entries`](crate::Object::try_entries)
+    /// returns the error. Subtree hashes are computed on demand too.
+    pub fn parse_lazy(source: &str) -> Result<Self, BuildError> {
+        let shared: Arc<str> = Arc::from(source);
+        let mut parser = Parser::new_shallow(&shared);
+        let mut builder = TreeBuilder::lazy(shared.clone());
+        while let Some(event) = parser.next_event() {
+            builder.event(event);
+        }
+        Document::from_root_value(builder.finish()?)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Object, Value};
+
+    /// Fully materialize a lazy document and compare it with an eager parse.
+    fn assert_same(source: &str) {
+        let Ok(eager) = Document::parse(source) else {
+            return;
+        };
+        let lazy = Document::parse_lazy(source).expect(source);
+        assert_eq!(lazy, eager, "{source:?}");
+    }
+
+    #[test]
+    fn test_nested_objects_are_deferred() {
+        let doc = Document::parse_lazy("a 1\nb {c {d 2}, e (x {y 3})}\n").unwrap();
+        let b = doc.root.get("b").and_then(Value::as_object).unwrap();
+        assert!(b.is_deferred());
+        let c = b.get("c").and_then(Value::as_object).unwrap();
+        assert!(!b.is_deferred());
+        assert!(c.is_deferred());
+        assert_eq!(doc.get("b.c.d").and_then(Value::as_str), Some("2"));
+        assert_eq!(doc.get("b.e[1].y").and_then(Value::as_str), Some("3"));
+    }
+
+    #[test]
+    fn test_matches_eager_parse() {
+        for source in [
+            "a {b 1, c {d 2}}\n",
+            "server @tagged{host localhost, port 8080}\n",
+            "a.b.c {x 1}\na.b.d 2\n",
+            "s ({a 1} {b {c 2}})\n",
+            "h {text <<EOT\n  a } brace\n  EOT\n}\n",
+            "r {raw r#\"}\"#, q \"}\\\"{\", // } comment\n}\n",
+            "/// doc\nk {\n  /// inner doc\n  x 1\n}\n",
+            "{\n  a {b 1}\n}\n",
+            "a>x b>{c 1}\n",
+            "empty {}\n",
+        ] {
+            assert_same(source);
+        }
+    }
+
+    #[test]
+    fn test_matches_eager_on_corpus() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                if let Ok(source) = std::fs::read_to_string(file.path()) {
+                    assert_same(&source);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_errors_inside_blocks_surface_on_read() {
+        // Unbalanced braces are still caught up front.
+        assert!(Document::parse_lazy("a {b 1\n").is_err());
+        // Other errors wait until the block is read.
+        let doc = Document::parse_lazy("a {b 1, b 2}\nc 3\n").unwrap();
+        assert_eq!(doc.get("c").and_then(Value::as_str), Some("3"));
+        let a = doc.root.get("a").and_then(Value::as_object).unwrap();
+        assert!(a.try_entries().is_err());
+        assert!(a.is_empty());
+    }
+
+    #[test]
+    fn test_mutation_materializes() {
+        let mut doc = Document::parse_lazy("a {b 1, c {d 2}}\n").unwrap();
+        let a: &mut Object = doc
+            .root
+            .get_mut("a")
+            .and_then(Value::as_object_mut)
+            .unwrap();
+        assert!(!a.is_deferred());
+        assert_eq!(a.entries().len(), 2);
+        a.insert("e", Value::scalar("3"));
+        assert_eq!(doc.get("a.c.d").and_then(Value::as_str), Some("2"));
+        assert_eq!(doc.get("a.e").and_then(Value::as_str), Some("3"));
+    }
+}
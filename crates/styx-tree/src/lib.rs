@@ -4,12 +4,47 @@
 //! This crate provides a high-level API for working with Styx documents,
 //! including parsing, accessing values by path, and serialization.
 
+mod arena;
 mod builder;
+mod cache;
+mod compact;
+mod compiled;
 mod diagnostic;
+mod diff;
+mod hash;
+mod incremental;
+mod index;
+mod lazy;
+mod parallel;
+mod path;
+mod pool;
+mod schema;
+mod schema_stream;
+mod select;
+mod stats;
 mod value;
 
+pub use arena::{
+    ArenaBuilder, ArenaDocument, ArenaEntry, ArenaObject, ArenaSequence, ArenaValue, Symbol,
+};
 pub use builder::{BuildError, TreeBuilder};
+pub use cache::{PARSE_CACHE_ENV, ParseCache};
+pub use compact::{CompactDocument, CompactEntry, CompactObject, CompactSequence, CompactValue};
+pub use compiled::{
+    COMPILED_MAGIC, COMPILED_VERSION, CompiledDocument, CompiledEntry, CompiledError,
+    CompiledObject, CompiledSequence, CompiledValue,
+};
 pub use diagnostic::ParseError;
+pub use diff::{Change, ChangeKind};
+pub use incremental::Edit;
+pub use index::{INDEX_THRESHOLD, key_hash};
+pub use parallel::parse_parallel;
+pub use path::Path;
+pub use pool::DocumentParser;
+pub use schema::{CompiledSchema, SchemaError, SchemaViolation};
+pub use schema_stream::{EventValidator, ValidateError};
+pub use select::{EventSelector, Selector, SelectorError};
+pub use stats::ParseStats;
 pub use styx_parse::{ParseErrorKind, ScalarKind, Span};
 pub use value::{Entry, Object, Payload, Scalar, Sequence, Tag, Value};
 
@@ -33,20 +68,66 @@ pub struct Document {
 }
 
 impl Document {
-    /// Parse a Styx document.
-    pub fn parse(source: &str) -> Result<Self, BuildError> {
-        let value = parse(source)?;
+    /// A document with `root` as its root object.
+    pub(crate) fn from_root(root: Object) -> Self {
+        Document {
+            root,
+            leading_comments: Vec::new(),
+        }
+    }
+
+    /// A document from the value a [`TreeBuilder`] finished with, which must
+    /// be an object.
+    pub(crate) fn from_root_value(value: Value) -> Result<Self, BuildError> {
         match value.payload {
-            Some(Payload::Object(root)) => Ok(Document {
-                root,
-                leading_comments: Vec::new(),
-            }),
+            Some(Payload::Object(root)) => Ok(Document::from_root(root)),
             _ => Err(BuildError::UnexpectedEvent(
                 "expected object at root".to_string(),
             )),
         }
     }
 
+    /// Parse a Styx document.
+    pub fn parse(source: &str) -> Result<Self, BuildError> {
+        Document::from_root_value(parse(source)?)
+    }
+
+    /// Parse a Styx document using up to `threads` threads.
+    ///
+    /// See [`parse_parallel`]; the result is identical to [`Document::parse`].
+    pub fn parse_parallel(source: &str, threads: usize) -> Result<Self, BuildError> {
+        Document::from_root_value(parse_parallel(source, threads)?)
+    }
+
+    /// Build the key index of every object in the document with at least
+    /// [`INDEX_THRESHOLD`] entries.
+    ///
+    /// Indexes are otherwise built lazily on first lookup; doing it up front
+    /// keeps that cost off readers when the document is shared. Objects from
+    /// [`Document::parse_lazy`] that have not been read yet are left alone,
+    /// so this never parses them; they index themselves when first read.
+    pub fn build_indexes(&self) {
+        fn walk_object(obj: &Object) {
+            if obj.is_deferred() {
+                return;
+            }
+            if obj.len() >= INDEX_THRESHOLD {
+                obj.build_index();
+            }
+            for entry in obj.entries() {
+                walk_value(&entry.value);
+            }
+        }
+        fn walk_value(value: &Value) {
+            match &value.payload {
+                Some(Payload::Object(obj)) => walk_object(obj),
+                Some(Payload::Sequence(seq)) => seq.iter().for_each(walk_value),
+                _ => {}
+            }
+        }
+        walk_object(&self.root);
+    }
+
     /// Get a value by path.
     pub fn get(&self, path: &str) -> Option<&Value> {
         if path.is_empty() {
@@ -0,0 +1,460 @@
+//! Parallel parsing of large documents.
+//!
+//! The root of a document is a flat list of entries, so a large file can be
+//! cut between top-level entries and each piece parsed on its own thread. A
+//! token pre-scan picks cut points where the serial parser would carry no
+//! state across the boundary; the per-chunk trees are then concatenated, with
+//! spans shifted back to whole-document offsets. The result is identical to
+//! [`parse`](crate::parse), errors included.
+//!
+//! Many independent documents are parsed with [`Document::parse_batch`]
+//! instead: each worker thread claims a few inputs at a time from a shared
+//! cursor, so threads that draw small documents go back for more, and parses
+//! them with its own [`DocumentParser`].
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+
+use styx_parse::{Event, EventKind, ParseErrorKind, Parser, Span, TokenKind, Tokenizer};
+
+use crate::{BuildError, Document, DocumentParser, Entry, Object, Payload, TreeBuilder, Value};
+
+/// Chunks smaller than this are not worth a thread of their own.
+const MIN_CHUNK_LEN: usize = 64 * 1024;
+
+/// Most inputs a batch worker claims at once.
+const MAX_BATCH_CLAIM: usize = 64;
+
+/// Resolve a requested thread count, where 0 means one per core.
+fn thread_count(threads: usize) -> usize {
+    match threads {
+        0 => thread::available_parallelism().map_or(1, |n| n.get()),
+        n => n,
+    }
+}
+
+/// Parse a Styx document into a tree, using up to `threads` threads.
+///
+/// `threads == 0` uses [`thread::available_parallelism`]. Small documents,
+/// and documents with no safe cut points, are parsed on the calling thread.
+pub fn parse_parallel(source: &str, threads: usize) -> Result<Value, BuildError> {
+    let chunks = thread_count(threads)
+        .min(source.len() / MIN_CHUNK_LEN)
+        .max(1);
+    parse_chunks(source, &split_points(source, chunks))
+}
+
+impl Document {
+    /// Parse many independent documents using up to `threads` threads.
+    ///
+    /// Returns one result per source, in order, each the same as
+    /// [`Document::parse`] would give. `threads == 0` uses
+    /// [`thread::available_parallelism`]; the calling thread does its share
+    /// of the work. Each thread reuses one [`DocumentParser`] for all the
+    /// documents it parses.
+    pub fn parse_batch<S>(sources: &[S], threads: usize) -> Vec<Result<Self, BuildError>>
+    where
+        S: AsRef<str> + Sync,
+    {
+        let threads = thread_count(threads).min(sources.len()).max(1);
+        if threads == 1 {
+            let mut parser = DocumentParser::new();
+            return sources.iter().map(|s| parser.parse(s.as_ref())).collect();
+        }
+
+        // Claims shrink with the batch so every thread gets several, which
+        // evens out batches whose documents differ widely in size.
+        let claim = (sources.len() / (threads * 8)).clamp(1, MAX_BATCH_CLAIM);
+        let next = AtomicUsize::new(0);
+        let work = || {
+            let mut parser = DocumentParser::new();
+            let mut parsed = Vec::new();
+            loop {
+                let start = next.fetch_add(claim, Ordering::Relaxed);
+                if start >= sources.len() {
+                    return parsed;
+                }
+                let end = (start + claim).min(sources.len());
+                for (index, source) in (start..end).zip(&sources[start..end]) {
+                    parsed.push((index, parser.parse(source.as_ref())));
+                }
+            }
+        };
+
+        let mut results: Vec<Option<Result<Self, BuildError>>> = std::iter::repeat_with(|| None)
+            .take(sources.len())
+            .collect();
+        thread::scope(|scope| {
+            let handles: Vec<_> = (1..threads).map(|_| scope.spawn(work)).collect();
+            let mut place = |parsed: Vec<(usize, Result<Self, BuildError>)>| {
+                for (index, result) in parsed {
+                    results[index] = Some(result);
+                }
+            };
+            place(work());
+            for handle in handles {
+                place(
+                    handle
+                        .join()
+                        .unwrap_or_else(|panic| std::panic::resume_unwind(panic)),
+                );
+            }
+        });
+        results
+            .into_iter()
+            .map(|result| result.expect("every source is claimed once"))
+            .collect()
+    }
+}
+
+/// Parse `source` cut at `points` (sorted byte offsets), one thread per chunk.
+fn parse_chunks(source: &str, points: &[usize]) -> Result<Value, BuildError> {
+    if points.is_empty() {
+        return crate::parse(source);
+    }
+
+    let starts = std::iter::once(0).chain(points.iter().copied());
+    let ends = points.iter().copied().chain(std::iter::once(source.len()));
+    let ranges: Vec<(usize, usize)> = starts.zip(ends).collect();
+
+    let results: Vec<Result<Vec<Entry>, BuildError>> = thread::scope(|scope| {
+        let handles: Vec<_> = ranges[1..]
+            .iter()
+            .map(|&range| scope.spawn(move || parse_chunk(source, range)))
+            .collect();
+        let first = parse_chunk(source, ranges[0]);
+        std::iter::once(first)
+            .chain(handles.into_iter().map(|handle| {
+                handle
+                    .join()
+                    .unwrap_or_else(|panic| std::panic::resume_unwind(panic))
+            }))
+            .collect()
+    });
+
+    // The first failing chunk holds the error the serial parse reports first.
+    let mut entries = Vec::new();
+    for result in results {
+        entries.extend(result?);
+    }
+    Ok(Value {
+        tag: None,
+        payload: Some(Payload::Object(Object::new(entries, None))),
+        span: None,
+    })
+}
+
+/// Parse `source[start..end]` and return its root entries.
+pub(crate) fn parse_chunk(
+    source: &str,
+    (start, end): (usize, usize),
+) -> Result<Vec<Entry>, BuildError> {
+    let offset = start as u32;
+    let mut parser = Parser::new(&source[start..end]);
+    let mut builder = TreeBuilder::new();
+    while let Some(event) = parser.next_event() {
+        builder.event(shift_event(event, offset));
+    }
+    match builder.finish()?.payload {
+        Some(Payload::Object(root)) => Ok(root.into_entries()),
+        _ => Ok(Vec::new()),
+    }
+}
+
+pub(crate) fn shift_event(mut event: Event<'_>, offset: u32) -> Event<'_> {
+    event.span = shift(event.span, offset);
+    if let EventKind::Error {
+        kind: ParseErrorKind::DuplicateKey { original },
+    } = &mut event.kind
+    {
+        *original = shift(*original, offset);
+    }
+    event
+}
+
+fn shift(span: Span, offset: u32) -> Span {
+    Span {
+        start: span.start + offset,
+        end: span.end + offset,
+    }
+}
+
+/// Find up to `chunks - 1` cut points splitting `source` into roughly equal
+/// chunks.
+fn split_points(source: &str, chunks: usize) -> Vec<usize> {
+    let mut points = Vec::new();
+    if chunks <= 1 {
+        return points;
+    }
+
+    let step = source.len() / chunks;
+    let mut target = step;
+    for point in Cuts::new(source) {
+        if point < target {
+            continue;
+        }
+        points.push(point);
+        if points.len() == chunks - 1 {
+            break;
+        }
+        target = point + step;
+    }
+    points
+}
+
+/// Iterator over the offsets where `source` can be cut between root entries.
+///
+/// A cut is only made at the start of a line at nesting depth zero where:
+///
+/// - the line starts with a bare key (followed by whitespace or a newline),
+/// - the previous root entry also had a bare key, with a different first
+///   path segment, so path-state tracking starts over either way,
+/// - no doc comment is waiting to attach to the next entry.
+///
+/// Scanning stops at anything that changes root parser state for the rest of
+/// the document: an explicit root object or an unbalanced closing bracket.
+pub(crate) struct Cuts<'a> {
+    tokens: std::iter::Peekable<Tokenizer<'a>>,
+    offset: usize,
+    limit: usize,
+    depth: usize,
+    entry_start: bool,
+    line_start: Option<usize>,
+    pending_doc: bool,
+    prev_key: Option<&'a str>,
+}
+
+impl<'a> Cuts<'a> {
+    /// Scan a whole document.
+    pub(crate) fn new(source: &'a str) -> Self {
+        Self::resume(source, 0, None)
+    }
+
+    /// Scan `source` from `start`, a line start at depth zero just after a
+    /// root entry whose key had first path segment `prev_key`. `start` itself
+    /// is yielded if a cut can be made there.
+    pub(crate) fn resume(source: &'a str, start: usize, prev_key: Option<&'a str>) -> Self {
+        Cuts {
+            tokens: Tokenizer::new(&source[start..]).peekable(),
+            offset: start,
+            limit: usize::MAX,
+            depth: 0,
+            entry_start: true,
+            line_start: (start > 0).then_some(start),
+            pending_doc: false,
+            prev_key,
+        }
+    }
+
+    /// Stop once the next candidate cut would lie past `limit`.
+    pub(crate) fn until(mut self, limit: usize) -> Self {
+        self.limit = limit;
+        self
+    }
+}
+
+impl Iterator for Cuts<'_> {
+    type Item = usize;
+
+    fn next(&mut self) -> Option<usize> {
+        while let Some(token) = self.tokens.next() {
+            match token.kind {
+                TokenKind::Whitespace | TokenKind::LineComment => continue,
+                TokenKind::Newline => {
+                    if self.depth == 0 {
+                        self.entry_start = true;
+                        self.line_start = Some(self.offset + token.span.end as usize);
+                    }
+                    continue;
+                }
+                TokenKind::DocComment => {
+                    self.pending_doc |= self.depth == 0;
+                    continue;
+                }
+                _ => {}
+            }
+
+            let mut cut = None;
+            if self.depth == 0 && self.entry_start {
+                if token.kind == TokenKind::LBrace
+                    || self.line_start.is_some_and(|start| start > self.limit)
+                {
+                    break;
+                }
+                let key = match (token.kind, self.tokens.peek().map(|t| t.kind)) {
+                    (
+                        TokenKind::BareScalar,
+                        None | Some(TokenKind::Whitespace | TokenKind::Newline),
+                    ) => first_segment(token.text),
+                    _ => None,
+                };
+                if let (Some(start), Some(key), Some(prev)) = (self.line_start, key, self.prev_key)
+                    && !self.pending_doc
+                    && key != prev
+                {
+                    cut = Some(start);
+                }
+                self.entry_start = false;
+                self.line_start = None;
+                self.pending_doc = false;
+                self.prev_key = key;
+            }
+
+            match token.kind {
+                TokenKind::LBrace | TokenKind::LParen => self.depth += 1,
+                TokenKind::RBrace | TokenKind::RParen => match self.depth.checked_sub(1) {
+                    Some(d) => self.depth = d,
+                    None => break,
+                },
+                TokenKind::Comma if self.depth == 0 => self.entry_start = true,
+                _ => {}
+            }
+            if cut.is_some() {
+                return cut;
+            }
+        }
+        // Exhausted, or hit a point past which no cut is safe.
+        self.tokens = Tokenizer::new("").peekable();
+        None
+    }
+}
+
+/// First segment of a bare key's dotted path, or `None` if the key is not a
+/// valid path (and so leaves path state untouched).
+pub(crate) fn first_segment(key: &str) -> Option<&str> {
+    let mut segments = key.split('.');
+    let first = segments.next()?;
+    if first.is_empty() || segments.any(str::is_empty) {
+        return None;
+    }
+    Some(first)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn assert_same(source: &str) {
+        let serial = crate::parse(source);
+        for chunks in 2..=8 {
+            let points = split_points(source, chunks);
+            assert_eq!(
+                parse_chunks(source, &points),
+                serial,
+                "chunks {chunks}, points {points:?}, source {source:?}"
+            );
+        }
+    }
+
+    fn large_source(entries: usize) -> String {
+        let mut source = String::new();
+        for i in 0..entries {
+            source.push_str(&format!(
+                "/// Entry {i}\nentry{i} {{\n  name \"item {i}\"\n  tags (a b c)\n}}\nflag{i} true\n"
+            ));
+        }
+        source
+    }
+
+    #[test]
+    fn test_split_points_balanced() {
+        let source = large_source(200);
+        let points = split_points(&source, 4);
+        assert_eq!(points.len(), 3);
+        for point in &points {
+            assert!(source[*point..].starts_with("entry") || source[*point..].starts_with("flag"));
+        }
+        assert_same(&source);
+    }
+
+    #[test]
+    fn test_no_split_without_safe_boundary() {
+        // Shared first segments keep path state alive across lines.
+        assert!(split_points("a.b 1\na.c 2\na.d 3\na.e 4\n", 4).is_empty());
+        // Explicit root object.
+        assert!(split_points("{\na 1\nb 2\n}\nc 3\nd 4\n", 4).is_empty());
+        // Non-bare keys.
+        assert!(split_points("\"a\" 1\n\"b\" 2\n\"c\" 3\n", 4).is_empty());
+    }
+
+    #[test]
+    fn test_doc_comment_stays_with_entry() {
+        let source = "a 1\n/// doc\n\nb 2\nc 3\n/// more\nd 4\n";
+        for point in split_points(source, 8) {
+            assert!(!source[..point].trim_end().ends_with("doc"));
+            assert!(!source[..point].trim_end().ends_with("more"));
+        }
+        assert_same(source);
+    }
+
+    #[test]
+    fn test_errors_match_serial() {
+        for source in [
+            "a 1\nb 2\nc 3\nb 4\nd 5\n",
+            "a.x 1\nb 2\na.y 3\n",
+            "a {x 1}\nb 2\nc {y 2\nd 4\n",
+            "a 1\nb 2\n}\nc 3\nd 4\n",
+            "a 1\nb 2\nc 3\nd 4\n/// dangling\n",
+            "a 1\nb 2\na.b.c 3\nd ..x\ne 5\n",
+            "a 1\n@ x\nfoo\nb 2\nc 3\n",
+        ] {
+            assert_same(source);
+        }
+    }
+
+    #[test]
+    fn test_spans_shifted() {
+        let source = "a 1\nb 2\nc 3\nd 4\n";
+        let points = split_points(source, 4);
+        assert!(!points.is_empty());
+        let value = parse_chunks(source, &points).unwrap();
+        let obj = value.as_object().unwrap();
+        let d = obj.get("d").unwrap();
+        assert_eq!(d.span, Some(Span { start: 14, end: 15 }));
+    }
+
+    #[test]
+    fn test_parse_parallel_small_document() {
+        let source = "name app\nport 8080\n";
+        assert_eq!(parse_parallel(source, 4), crate::parse(source));
+        assert_eq!(parse_parallel(source, 0), crate::parse(source));
+    }
+
+    #[test]
+    fn test_parse_batch_matches_serial() {
+        let mut sources: Vec<String> = (0..500)
+            .map(|i| format!("id {i}\nname \"item {i}\"\ntags (a b c)\n"))
+            .collect();
+        sources[17] = "a {b 1".to_string();
+        sources[250] = "a 1\na 2\n".to_string();
+        sources.push(large_source(400));
+        let serial: Vec<_> = sources.iter().map(|s| Document::parse(s)).collect();
+        for threads in [0, 1, 3, 8] {
+            assert_eq!(
+                Document::parse_batch(&sources, threads),
+                serial,
+                "threads {threads}"
+            );
+        }
+        assert!(Document::parse_batch::<&str>(&[], 4).is_empty());
+    }
+
+    #[test]
+    fn test_matches_serial_on_corpus() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                if let Ok(source) = std::fs::read_to_string(file.path()) {
+                    assert_same(&source);
+                }
+            }
+        }
+    }
+}
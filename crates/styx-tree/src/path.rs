@@ -0,0 +1,146 @@
+//! Pre-compiled paths.
+//!
+//! [`Value::get`] splits the path string and parses `[n]` indices on every
+//! call. A [`Path`] does that work once: segments are split, indices parsed
+//! and key hashes computed up front, so evaluating the same path against many
+//! documents only walks the tree.
+
+use crate::index::key_hash;
+use crate::value::split_path;
+use crate::{Document, Object, Payload, Value};
+
+/// A path compiled for repeated lookups.
+///
+/// Uses the same syntax and semantics as [`Value::get`]: `.` separates
+/// object keys and `[n]` indexes sequences.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Path {
+    segments: Box<[Segment]>,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+struct Segment {
+    /// Raw segment text, used as the key for object lookups.
+    key: Box<str>,
+    /// Precomputed [`key_hash`] of `key`.
+    hash: u64,
+    /// Parsed `[n]` index, used for sequence lookups.
+    index: Option<usize>,
+}
+
+impl Path {
+    /// Compile a path string.
+    pub fn compile(path: &str) -> Self {
+        let mut segments = Vec::new();
+        let mut rest = path;
+        while !rest.is_empty() {
+            let (segment, next) = split_path(rest);
+            let index = segment
+                .strip_prefix('[')
+                .and_then(|s| s.strip_suffix(']'))
+                .and_then(|s| s.parse().ok());
+            segments.push(Segment {
+                key: segment.into(),
+                hash: key_hash(segment),
+                index,
+            });
+            rest = next;
+        }
+        Path {
+            segments: segments.into_boxed_slice(),
+        }
+    }
+
+    /// Number of segments in the path.
+    pub fn len(&self) -> usize {
+        self.segments.len()
+    }
+
+    /// Whether the path has no segments.
+    pub fn is_empty(&self) -> bool {
+        self.segments.is_empty()
+    }
+
+    /// Resolve this path starting at `value`, like [`Value::get`].
+    pub fn eval<'a>(&self, value: &'a Value) -> Option<&'a Value> {
+        eval_segments(value, &self.segments)
+    }
+
+    /// Resolve this path against a document, like [`Document::get`].
+    pub fn eval_document<'a>(&self, doc: &'a Document) -> Option<&'a Value> {
+        let (first, rest) = self.segments.split_first()?;
+        let value = get_key(&doc.root, first)?;
+        eval_segments(value, rest)
+    }
+}
+
+fn eval_segments<'a>(mut value: &'a Value, segments: &[Segment]) -> Option<&'a Value> {
+    for segment in segments {
+        value = match &value.payload {
+            Some(Payload::Object(obj)) => get_key(obj, segment)?,
+            Some(Payload::Sequence(seq)) => seq.get(segment.index?)?,
+            _ => return None,
+        };
+    }
+    Some(value)
+}
+
+#[inline]
+fn get_key<'a>(obj: &'a Object, segment: &Segment) -> Option<&'a Value> {
+    obj.get_hashed(&segment.key, segment.hash)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SOURCE: &str = "server {
+    host localhost
+    ports (8080 8443)
+    routes ({path /a} {path /b})
+}
+name app
+";
+
+    #[test]
+    fn test_compiled_matches_get() {
+        let doc = Document::parse(SOURCE).unwrap();
+        for path in [
+            "server.host",
+            "server.ports[1]",
+            "server.ports[2]",
+            "server.routes[1].path",
+            "server.routes.path",
+            "server.missing",
+            "name",
+            "name.deeper",
+            "[0]",
+            "",
+        ] {
+            assert_eq!(
+                Path::compile(path).eval_document(&doc),
+                doc.get(path),
+                "path {path:?}"
+            );
+        }
+    }
+
+    #[test]
+    fn test_compiled_on_value() {
+        let doc = Document::parse(SOURCE).unwrap();
+        let server = doc.get("server").unwrap();
+        let path = Path::compile("routes[0].path");
+        assert_eq!(path.len(), 3);
+        assert_eq!(path.eval(server).and_then(|v| v.as_str()), Some("/a"));
+        assert_eq!(Path::compile("").eval(server), Some(server));
+    }
+
+    #[test]
+    fn test_compiled_reused_across_documents() {
+        let path = Path::compile("server.host");
+        let a = Document::parse("server {host a}").unwrap();
+        let b = Document::parse("server {host b}").unwrap();
+        assert_eq!(path.eval_document(&a).and_then(|v| v.as_str()), Some("a"));
+        assert_eq!(path.eval_document(&b).and_then(|v| v.as_str()), Some("b"));
+    }
+}
@@ -0,0 +1,223 @@
+//! Reusing allocations across many small documents.
+//!
+//! Parsing a tiny document spends most of its time allocating: parser and
+//! builder state, plus one buffer per object, sequence and scalar in the
+//! tree. A [`DocumentParser`] keeps the parser and builder state between
+//! calls, and documents handed back with [`DocumentParser::recycle`] are
+//! broken up into spare entry lists, item lists and strings that later
+//! parses build from.
+
+use std::borrow::Cow;
+
+use styx_parse::{Parser, ParserBuffers};
+
+use crate::{BuildError, Document, Entry, Payload, TreeBuilder, Value};
+
+/// Spare buffers kept per kind; the rest of a recycled document is freed.
+const MAX_SPARE: usize = 4096;
+
+/// Buffers that grew beyond this many elements (or bytes) are freed rather
+/// than kept, so one large document does not pin its memory.
+const MAX_SPARE_CAPACITY: usize = 1024;
+
+/// Spare tree storage taken from recycled documents.
+#[derive(Default)]
+pub(crate) struct NodePool {
+    entries: Vec<Vec<Entry>>,
+    items: Vec<Vec<Value>>,
+    strings: Vec<String>,
+}
+
+impl NodePool {
+    /// An empty entry list, reusing a spare one if there is any.
+    pub(crate) fn entries(&mut self) -> Vec<Entry> {
+        self.entries.pop().unwrap_or_default()
+    }
+
+    /// An empty item list, reusing a spare one if there is any.
+    pub(crate) fn items(&mut self) -> Vec<Value> {
+        self.items.pop().unwrap_or_default()
+    }
+
+    /// An owned copy of `text`, reusing a spare string if it must be copied.
+    pub(crate) fn string(&mut self, text: Cow<'_, str>) -> String {
+        match text {
+            Cow::Owned(text) => text,
+            Cow::Borrowed("") => String::new(),
+            Cow::Borrowed(text) => match self.strings.pop() {
+                Some(mut spare) => {
+                    spare.push_str(text);
+                    spare
+                }
+                None => text.to_string(),
+            },
+        }
+    }
+
+    /// Take apart `entries` and everything under them.
+    pub(crate) fn recycle_entries(&mut self, mut entries: Vec<Entry>) {
+        for entry in entries.drain(..) {
+            self.recycle_value(entry.key);
+            self.recycle_value(entry.value);
+            if let Some(doc) = entry.doc_comment {
+                self.recycle_string(doc);
+            }
+        }
+        if keep(entries.capacity(), &self.entries) {
+            self.entries.push(entries);
+        }
+    }
+
+    fn recycle_value(&mut self, value: Value) {
+        if let Some(tag) = value.tag {
+            self.recycle_string(tag.name);
+        }
+        match value.payload {
+            Some(Payload::Scalar(scalar)) => self.recycle_string(scalar.text),
+            Some(Payload::Sequence(sequence)) => {
+                let mut items = sequence.items;
+                for item in items.drain(..) {
+                    self.recycle_value(item);
+                }
+                if keep(items.capacity(), &self.items) {
+                    self.items.push(items);
+                }
+            }
+            Some(Payload::Object(object)) => self.recycle_entries(object.into_entries()),
+            None => {}
+        }
+    }
+
+    fn recycle_string(&mut self, mut text: String) {
+        if keep(text.capacity(), &self.strings) {
+            text.clear();
+            self.strings.push(text);
+        }
+    }
+
+    /// Number of spare buffers of each kind, for tests.
+    #[cfg(test)]
+    fn spare_counts(&self) -> (usize, usize, usize) {
+        (self.entries.len(), self.items.len(), self.strings.len())
+    }
+}
+
+/// Whether a buffer with `capacity` is worth adding to `spares`.
+fn keep<S>(capacity: usize, spares: &[S]) -> bool {
+    capacity > 0 && capacity <= MAX_SPARE_CAPACITY && spares.len() < MAX_SPARE
+}
+
+/// A parser for many small documents that reuses its allocations.
+///
+/// Produces the same documents and errors as [`Document::parse`]. Not shared
+/// between threads; use one per thread.
+///
+/// ```
+/// use styx_tree::DocumentParser;
+///
+/// let mut parser = DocumentParser::new();
+/// for message in ["id 1\nkind ping", "id 2\nkind pong"] {
+///     let doc = parser.parse(message).unwrap();
+///     assert!(doc.get("kind").is_some());
+///     // Hand the storage back for the next message.
+///     parser.recycle(doc);
+/// }
+/// ```
+#[derive(Default)]
+pub struct DocumentParser {
+    buffers: ParserBuffers,
+    builder: TreeBuilder,
+}
+
+impl DocumentParser {
+    /// Create a parser with nothing retained yet.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Parse a Styx document.
+    pub fn parse(&mut self, source: &str) -> Result<Document, BuildError> {
+        let mut parser = Parser::with_buffers(source, std::mem::take(&mut self.buffers));
+        while let Some(event) = parser.next_event() {
+            self.builder.event(event);
+        }
+        self.buffers = parser.into_buffers();
+        Document::from_root_value(self.builder.finish_in_place()?)
+    }
+
+    /// Give a document's storage to later parses. The document may come from
+    /// anywhere, not just this parser.
+    pub fn recycle(&mut self, document: Document) {
+        let pool = &mut self.builder.pool;
+        pool.recycle_entries(document.root.into_entries());
+        for comment in document.leading_comments {
+            pool.recycle_string(comment);
+        }
+    }
+
+    /// Free everything retained so far.
+    pub fn reset(&mut self) {
+        *self = Self::new();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const INPUTS: &[&str] = &[
+        "name hello\nport 8080\ntags (a b c)",
+        "server {host localhost, tls {cert \"a.pem\"}}\n/// doc\nflag",
+        "a.b.c 1\na.b.d @tag{x 1}\nlist ({k v} {k w})",
+        "text <<EOF\nline\nEOF\nraw r#\"x\"#",
+        "a 1\na 2",
+        "a {b 1",
+        "",
+    ];
+
+    #[test]
+    fn test_matches_document_parse() {
+        let mut parser = DocumentParser::new();
+        for round in 0..3 {
+            for input in INPUTS {
+                let expected = Document::parse(input);
+                let actual = parser.parse(input);
+                assert_eq!(
+                    actual.as_ref().map_err(|e| e.to_string()),
+                    expected.as_ref().map_err(|e| e.to_string()),
+                    "round {round}: {input:?}"
+                );
+                if let Ok(doc) = actual {
+                    parser.recycle(doc);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_recycled_storage_is_reused() {
+        let mut parser = DocumentParser::new();
+        let doc = parser.parse(INPUTS[0]).unwrap();
+        parser.recycle(doc);
+        // The root's entries, the `tags` items and eight scalars.
+        assert_eq!(parser.builder.pool.spare_counts(), (1, 1, 8));
+
+        // Parsing the same shape again uses them all up.
+        let doc = parser.parse(INPUTS[0]).unwrap();
+        assert_eq!(parser.builder.pool.spare_counts(), (0, 0, 0));
+        parser.recycle(doc);
+
+        parser.reset();
+        assert_eq!(parser.builder.pool.spare_counts(), (0, 0, 0));
+    }
+
+    #[test]
+    fn test_large_buffers_are_not_kept() {
+        let mut parser = DocumentParser::new();
+        let long = format!("text \"{}\"", "x".repeat(MAX_SPARE_CAPACITY * 2));
+        let doc = parser.parse(&long).unwrap();
+        parser.recycle(doc);
+        // The key is kept; the long string is not.
+        assert_eq!(parser.builder.pool.spare_counts().2, 1);
+    }
+}
@@ -0,0 +1,1248 @@
+//! Compiled schemas.
+//!
+//! Interpreting a schema tree on every validation means re-reading tags,
+//! parsing constraint text and looking up type names by string for every
+//! value checked. [`CompiledSchema`] does that once: the `schema` block of a
+//! schema file is lowered into a flat table of nodes in which type
+//! references are resolved to node ids, `min`/`max` constraints are parsed,
+//! and each object type gets a key table sorted by [`key_hash`]. Validation
+//! then walks the document and the node table together.
+//!
+//! The semantics follow `facet-styx`'s schema validator. Regex `pattern`
+//! constraints are accepted but not enforced (as there), and deprecation is
+//! not reported since only violations are.
+//!
+//! A compiled schema is immutable, so one instance can validate documents
+//! on any number of threads at once.
+
+use crate::index::key_hash;
+use crate::{Document, Entry, Object, Payload, Sequence, Span, Value};
+
+/// Index of a node in [`CompiledSchema::nodes`].
+pub(crate) type NodeId = u32;
+
+/// The node every unit enum variant shares.
+const UNIT: NodeId = 0;
+
+/// A schema lowered for repeated validation.
+#[derive(Debug, Clone)]
+pub struct CompiledSchema {
+    pub(crate) nodes: Vec<Node>,
+    /// The `@` type, checked against document roots.
+    pub(crate) root: Option<NodeId>,
+    /// Named types, sorted by name.
+    types: Box<[(Box<str>, NodeId)]>,
+}
+
+#[derive(Debug, Clone)]
+pub(crate) enum Node {
+    Any,
+    Unit,
+    Bool,
+    String {
+        min_len: usize,
+        max_len: usize,
+    },
+    Int {
+        min: i128,
+        max: i128,
+    },
+    Float {
+        min: f64,
+        max: f64,
+    },
+    Literal(Box<str>),
+    Object(ObjectTable),
+    Seq(NodeId),
+    Tuple(Box<[NodeId]>),
+    Map {
+        key: Option<NodeId>,
+        value: NodeId,
+    },
+    Union(Box<[NodeId]>),
+    Optional(NodeId),
+    Enum(EnumTable),
+    OneOf {
+        base: NodeId,
+        allowed: Box<[Box<str>]>,
+    },
+    /// A type reference; only present while compiling.
+    Alias(NodeId),
+}
+
+#[derive(Debug, Clone)]
+pub(crate) struct ObjectTable {
+    /// Named fields in declaration order.
+    pub(crate) fields: Box<[Field]>,
+    /// `(key_hash(name), index into fields)`, sorted.
+    by_hash: Box<[(u64, u32)]>,
+    /// Schema for keys that are not named fields (`@` or `@string` keys).
+    pub(crate) catch_all: Option<NodeId>,
+}
+
+#[derive(Debug, Clone)]
+pub(crate) struct Field {
+    pub(crate) name: Box<str>,
+    pub(crate) node: NodeId,
+    /// False for `@optional` and `@default` fields.
+    pub(crate) required: bool,
+}
+
+#[derive(Debug, Clone)]
+pub(crate) struct EnumTable {
+    /// `(key_hash(name), name, payload schema)` in declaration order.
+    pub(crate) variants: Box<[(u64, Box<str>, NodeId)]>,
+    /// Scalar variants that untagged scalars fall back to, in order.
+    fallbacks: Box<[NodeId]>,
+}
+
+/// Error compiling a schema.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct SchemaError {
+    /// What is wrong with the schema.
+    pub message: String,
+    /// Where in the schema source, if known.
+    pub span: Option<Span>,
+}
+
+impl std::fmt::Display for SchemaError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(f, "invalid schema: {}", self.message)
+    }
+}
+
+impl std::error::Error for SchemaError {}
+
+/// A place where a document does not match its schema.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct SchemaViolation {
+    /// Path to the offending value, in [`Document::get`] syntax (empty for
+    /// the root).
+    pub path: String,
+    /// What is wrong with it.
+    pub message: String,
+    /// Where in the document source, if known.
+    pub span: Option<Span>,
+}
+
+impl std::fmt::Display for SchemaViolation {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        if self.path.is_empty() {
+            write!(f, "{}", self.message)
+        } else {
+            write!(f, "{}: {}", self.path, self.message)
+        }
+    }
+}
+
+impl std::error::Error for SchemaViolation {}
+
+impl CompiledSchema {
+    /// Parse and compile a schema file.
+    pub fn parse(source: &str) -> Result<Self, SchemaError> {
+        let doc = Document::parse(source).map_err(|e| SchemaError {
+            message: e.to_string(),
+            span: None,
+        })?;
+        Self::compile(&doc)
+    }
+
+    /// Compile the `schema` block of a parsed schema file.
+    ///
+    /// Every type reference must name a built-in type or a type defined in
+    /// the block; unknown names are reported here rather than during
+    /// validation.
+    pub fn compile(schema_file: &Document) -> Result<Self, SchemaError> {
+        let block = schema_file
+            .root
+            .get("schema")
+            .ok_or_else(|| error("missing `schema` block", None))?;
+        let block = block
+            .as_object()
+            .ok_or_else(|| error("`schema` must be an object", block.span))?;
+        Compiler::default().run(block)
+    }
+
+    /// Whether the schema defines a root (`@`) type.
+    pub fn has_root(&self) -> bool {
+        self.root.is_some()
+    }
+
+    /// Validate a document against the root type, reporting every violation.
+    pub fn validate(&self, doc: &Document) -> Result<(), Vec<SchemaViolation>> {
+        let mut violations = Vec::new();
+        self.check_root(doc, &mut Some(&mut violations));
+        if violations.is_empty() {
+            Ok(())
+        } else {
+            Err(violations)
+        }
+    }
+
+    /// Whether a document matches the root type.
+    ///
+    /// Stops at the first violation and builds no messages, so it is the
+    /// cheaper call when only the verdict matters.
+    pub fn is_valid(&self, doc: &Document) -> bool {
+        self.check_root(doc, &mut None)
+    }
+
+    /// Validate a value against a named type, reporting every violation.
+    pub fn validate_as(&self, value: &Value, type_name: &str) -> Result<(), Vec<SchemaViolation>> {
+        let Some(node) = self.type_node(type_name) else {
+            return Err(vec![SchemaViolation {
+                path: String::new(),
+                message: format!("unknown type '{type_name}'"),
+                span: value.span,
+            }]);
+        };
+        let mut violations = Vec::new();
+        self.check(
+            node,
+            Subject::of(value),
+            &Trail::ROOT,
+            &mut Some(&mut violations),
+        );
+        if violations.is_empty() {
+            Ok(())
+        } else {
+            Err(violations)
+        }
+    }
+
+    fn type_node(&self, name: &str) -> Option<NodeId> {
+        let i = self.types.binary_search_by(|(n, _)| (**n).cmp(name)).ok()?;
+        Some(self.types[i].1)
+    }
+
+    fn check_root(&self, doc: &Document, out: &mut Sink) -> bool {
+        let subject = Subject {
+            tag: None,
+            shape: Shape::Object(&doc.root),
+            span: doc.root.span,
+        };
+        match self.root {
+            Some(node) => self.check(node, subject, &Trail::DOCUMENT, out),
+            None => fail(out, &Trail::DOCUMENT, None, || {
+                "schema has no root type definition".to_string()
+            }),
+        }
+    }
+
+    /// Check `subject` against `node`, stopping at the first violation.
+    ///
+    /// `path` renders the subject's path and is only called on failure;
+    /// `document` marks a document root, whose `@schema` entry is skipped.
+    pub(crate) fn first_violation(
+        &self,
+        node: NodeId,
+        subject: Subject,
+        document: bool,
+        path: impl FnOnce() -> String,
+    ) -> Result<(), SchemaViolation> {
+        let unnamed = match document {
+            true => Trail::DOCUMENT,
+            false => Trail::ROOT,
+        };
+        if self.check(node, subject, &unnamed, &mut None) {
+            return Ok(());
+        }
+        let prefix = path();
+        let at = Trail {
+            parent: None,
+            segment: match document {
+                true => Segment::Document,
+                false => Segment::Key(&prefix),
+            },
+        };
+        let mut violations = Vec::new();
+        self.check(node, subject, &at, &mut Some(&mut violations));
+        Err(violations.swap_remove(0))
+    }
+
+    /// Check `subject` against `node`. With a sink, every violation is
+    /// recorded; without one, the walk stops at the first.
+    fn check(&self, node: NodeId, subject: Subject, at: &Trail, out: &mut Sink) -> bool {
+        match &self.nodes[node as usize] {
+            Node::Any => true,
+            Node::Unit => {
+                subject.is_unit() || fail(out, at, subject.span, || "expected unit value".into())
+            }
+            Node::Bool => match subject.shape {
+                Shape::Scalar("true" | "false") => true,
+                Shape::Scalar(text) => fail(out, at, subject.span, || {
+                    format!("'{text}' is not a valid boolean (expected true/false)")
+                }),
+                _ => expected(out, at, subject, "boolean"),
+            },
+            &Node::String { min_len, max_len } => {
+                let Shape::Scalar(text) = subject.shape else {
+                    return expected(out, at, subject, "string");
+                };
+                if text.len() < min_len {
+                    fail(out, at, subject.span, || {
+                        format!("string too short (min length: {min_len})")
+                    })
+                } else if text.len() > max_len {
+                    fail(out, at, subject.span, || {
+                        format!("string too long (max length: {max_len})")
+                    })
+                } else {
+                    true
+                }
+            }
+            &Node::Int { min, max } => {
+                let Shape::Scalar(text) = subject.shape else {
+                    return expected(out, at, subject, "integer");
+                };
+                match text.parse::<i128>() {
+                    Ok(n) if n < min => fail(out, at, subject.span, || {
+                        format!("value too small (min: {min})")
+                    }),
+                    Ok(n) if n > max => fail(out, at, subject.span, || {
+                        format!("value too large (max: {max})")
+                    }),
+                    Ok(_) => true,
+                    Err(_) => fail(out, at, subject.span, || {
+                        format!("'{text}' is not a valid integer")
+                    }),
+                }
+            }
+            &Node::Float { min, max } => {
+                let Shape::Scalar(text) = subject.shape else {
+                    return expected(out, at, subject, "number");
+                };
+                match text.parse::<f64>() {
+                    Ok(n) if n < min => fail(out, at, subject.span, || {
+                        format!("value too small (min: {min})")
+                    }),
+                    Ok(n) if n > max => fail(out, at, subject.span, || {
+                        format!("value too large (max: {max})")
+                    }),
+                    Ok(_) => true,
+                    Err(_) => fail(out, at, subject.span, || {
+                        format!("'{text}' is not a valid number")
+                    }),
+                }
+            }
+            Node::Literal(literal) => match subject.shape {
+                Shape::Scalar(text) if text == &**literal => true,
+                Shape::Scalar(text) => fail(out, at, subject.span, || {
+                    format!("expected '{literal}', got '{text}'")
+                }),
+                _ => fail(out, at, subject.span, || {
+                    format!("expected literal '{literal}', got non-scalar")
+                }),
+            },
+            Node::Object(table) => match subject.shape {
+                Shape::Object(obj) => self.check_object(table, obj, subject.span, at, out),
+                _ => expected(out, at, subject, "object"),
+            },
+            &Node::Seq(item) => match subject.shape {
+                Shape::Sequence(seq) => {
+                    let mut valid = true;
+                    for (i, value) in seq.items.iter().enumerate() {
+                        if !self.check(item, Subject::of(value), &at.index(i), out) {
+                            if out.is_none() {
+                                return false;
+                            }
+                            valid = false;
+                        }
+                    }
+                    valid
+                }
+                _ => expected(out, at, subject, "sequence"),
+            },
+            Node::Tuple(elements) => {
+                let Shape::Sequence(seq) = subject.shape else {
+                    return expected(out, at, subject, "tuple (sequence)");
+                };
+                let mut valid = seq.items.len() == elements.len()
+                    || fail(out, at, subject.span, || {
+                        format!(
+                            "tuple has wrong number of elements: expected {}, got {}",
+                            elements.len(),
+                            seq.items.len()
+                        )
+                    });
+                for (i, (value, &element)) in seq.items.iter().zip(elements.iter()).enumerate() {
+                    if !valid && out.is_none() {
+                        return false;
+                    }
+                    valid &= self.check(element, Subject::of(value), &at.index(i), out);
+                }
+                valid
+            }
+            &Node::Map { key, value } => {
+                let Shape::Object(obj) = subject.shape else {
+                    return expected(out, at, subject, "map (object)");
+                };
+                let mut valid = true;
+                for entry in obj.entries() {
+                    if !valid && out.is_none() {
+                        return false;
+                    }
+                    let Some(name) = key_name(&entry.key) else {
+                        valid &= fail(out, at, entry.key.span, || "invalid map key".into());
+                        continue;
+                    };
+                    if let Some(key) = key {
+                        valid &= self.check(key, Subject::of(&entry.key), at, out);
+                    }
+                    valid &= self.check(value, Subject::of(&entry.value), &at.key(name), out);
+                }
+                valid
+            }
+            Node::Union(variants) => {
+                variants
+                    .iter()
+                    .any(|&variant| self.check(variant, subject, at, &mut None))
+                    || fail(out, at, subject.span, || {
+                        let tried: Vec<_> = variants.iter().map(|&v| self.kind_name(v)).collect();
+                        format!(
+                            "value doesn't match any union variant (tried: {})",
+                            tried.join(", ")
+                        )
+                    })
+            }
+            &Node::Optional(inner) => subject.is_unit() || self.check(inner, subject, at, out),
+            Node::Enum(table) => self.check_enum(table, subject, at, out),
+            Node::OneOf { base, allowed } => {
+                if !self.check(*base, subject, at, out) {
+                    return false;
+                }
+                let Shape::Scalar(text) = subject.shape else {
+                    return allowed.is_empty()
+                        || expected(out, at, subject, "scalar value for one-of constraint");
+                };
+                allowed.is_empty()
+                    || allowed.iter().any(|a| **a == *text)
+                    || fail(out, at, subject.span, || {
+                        format!("'{text}' is not one of: {}", allowed.join(", "))
+                    })
+            }
+            Node::Alias(_) => unreachable!("aliases are resolved at compile time"),
+        }
+    }
+
+    fn check_object(
+        &self,
+        table: &ObjectTable,
+        obj: &Object,
+        span: Option<Span>,
+        at: &Trail,
+        out: &mut Sink,
+    ) -> bool {
+        let mut seen = Seen::new(table.fields.len());
+        let mut valid = true;
+        for entry in obj.entries() {
+            if !valid && out.is_none() {
+                return false;
+            }
+            valid &= self.check_entry(table, entry, &mut seen, at, out);
+        }
+        if !valid && out.is_none() {
+            return false;
+        }
+        for (i, field) in table.fields.iter().enumerate() {
+            if field.required && !seen.contains(i) {
+                let name = &*field.name;
+                valid &= fail(out, &at.key(name), span, || {
+                    format!("missing required field '{name}'")
+                });
+                if out.is_none() {
+                    return false;
+                }
+            }
+        }
+        valid
+    }
+
+    fn check_entry(
+        &self,
+        table: &ObjectTable,
+        entry: &Entry,
+        seen: &mut Seen,
+        at: &Trail,
+        out: &mut Sink,
+    ) -> bool {
+        let Some(name) = key_name(&entry.key) else {
+            // A document's own `@schema` declaration is not part of its data.
+            if matches!(at.segment, Segment::Document) && entry.key.is_schema_tag() {
+                return true;
+            }
+            return fail(out, at, entry.key.span, || "invalid object key".into());
+        };
+        let field = match entry.key.payload {
+            Some(_) => table.field(name),
+            None => None,
+        };
+        let node = match field {
+            Some(i) => {
+                seen.insert(i);
+                table.fields[i].node
+            }
+            None => match table.catch_all {
+                Some(node) => node,
+                None => {
+                    return fail(out, &at.key(name), entry.key.span, || {
+                        format!("unknown field '{name}'")
+                    });
+                }
+            },
+        };
+        self.check(node, Subject::of(&entry.value), &at.key(name), out)
+    }
+
+    fn check_enum(&self, table: &EnumTable, subject: Subject, at: &Trail, out: &mut Sink) -> bool {
+        let Some(tag) = subject.tag else {
+            if let Shape::Scalar(text) = subject.shape
+                && let Some(fallback) = self.enum_fallback(table, text)
+            {
+                return self.check(fallback, subject, at, out);
+            }
+            return fail(out, at, subject.span, || {
+                format!(
+                    "expected tagged value for enum, got {}",
+                    subject.type_name()
+                )
+            });
+        };
+        let Some(node) = table.variant(tag) else {
+            return fail(out, at, subject.span, || {
+                let expected: Vec<_> = table.variants.iter().map(|(_, n, _)| &**n).collect();
+                format!(
+                    "unknown enum variant '{tag}' (expected one of: {})",
+                    expected.join(", ")
+                )
+            });
+        };
+        let payload = subject.payload();
+        match (payload.shape, &self.nodes[node as usize]) {
+            (Shape::Unit, Node::Unit) => true,
+            (Shape::Unit, _) => fail(out, at, subject.span, || {
+                format!("variant '{tag}' requires a payload")
+            }),
+            _ => self.check(node, payload, &at.key(tag), out),
+        }
+    }
+
+    /// The first scalar variant of an enum that accepts untagged `text`.
+    fn enum_fallback(&self, table: &EnumTable, text: &str) -> Option<NodeId> {
+        table
+            .fallbacks
+            .iter()
+            .copied()
+            .find(|&node| match self.nodes[node as usize] {
+                Node::String { .. } => true,
+                Node::Int { .. } => text.parse::<i64>().is_ok(),
+                Node::Float { .. } => text.parse::<f64>().is_ok(),
+                Node::Bool => text == "true" || text == "false",
+                _ => false,
+            })
+    }
+
+    fn kind_name(&self, node: NodeId) -> &'static str {
+        match &self.nodes[node as usize] {
+            Node::Any => "any",
+            Node::Unit => "unit",
+            Node::Bool => "bool",
+            Node::String { .. } => "string",
+            Node::Int { .. } => "int",
+            Node::Float { .. } => "float",
+            Node::Literal(_) => "literal",
+            Node::Object(_) => "object",
+            Node::Seq(_) => "seq",
+            Node::Tuple(_) => "tuple",
+            Node::Map { .. } => "map",
+            Node::Union(_) => "union",
+            Node::Optional(_) => "optional",
+            Node::Enum(_) => "enum",
+            Node::OneOf { .. } => "one-of",
+            Node::Alias(_) => "alias",
+        }
+    }
+}
+
+impl ObjectTable {
+    #[inline]
+    pub(crate) fn field(&self, name: &str) -> Option<usize> {
+        let hash = key_hash(name);
+        let start = self.by_hash.partition_point(|&(h, _)| h < hash);
+        self.by_hash[start..]
+            .iter()
+            .take_while(|&&(h, _)| h == hash)
+            .map(|&(_, i)| i as usize)
+            .find(|&i| *self.fields[i].name == *name)
+    }
+}
+
+impl EnumTable {
+    /// The payload schema of the variant named `name`.
+    #[inline]
+    pub(crate) fn variant(&self, name: &str) -> Option<NodeId> {
+        let hash = key_hash(name);
+        self.variants
+            .iter()
+            .find(|(h, n, _)| *h == hash && **n == *name)
+            .map(|&(_, _, node)| node)
+    }
+}
+
+/// A key as a path segment: its text, or `@` for the unit key. Tagged keys
+/// have no name.
+fn key_name(key: &Value) -> Option<&str> {
+    match (&key.tag, &key.payload) {
+        (None, None) => Some("@"),
+        (None, Some(Payload::Scalar(s))) => Some(&s.text),
+        _ => None,
+    }
+}
+
+/// Where violations go; `None` means stop at the first one.
+type Sink<'a> = Option<&'a mut Vec<SchemaViolation>>;
+
+/// Record a violation at `at`, returning false so callers can `&&`/`||` it.
+#[cold]
+fn fail(out: &mut Sink, at: &Trail, span: Option<Span>, message: impl FnOnce() -> String) -> bool {
+    if let Some(violations) = out {
+        violations.push(SchemaViolation {
+            path: at.render(),
+            message: message(),
+            span,
+        });
+    }
+    false
+}
+
+fn expected(out: &mut Sink, at: &Trail, subject: Subject, what: &str) -> bool {
+    fail(out, at, subject.span, || {
+        format!("expected {what}, got {}", subject.type_name())
+    })
+}
+
+/// The part of a value that validation looks at. Unlike `&Value` this can
+/// also describe a document root or a tag's payload without copying.
+#[derive(Clone, Copy)]
+pub(crate) struct Subject<'a> {
+    pub(crate) tag: Option<&'a str>,
+    pub(crate) shape: Shape<'a>,
+    pub(crate) span: Option<Span>,
+}
+
+#[derive(Clone, Copy)]
+pub(crate) enum Shape<'a> {
+    Unit,
+    Scalar(&'a str),
+    Sequence(&'a Sequence),
+    Object(&'a Object),
+}
+
+impl<'a> Subject<'a> {
+    pub(crate) fn of(value: &'a Value) -> Self {
+        Subject {
+            tag: value.tag_name(),
+            shape: match &value.payload {
+                None => Shape::Unit,
+                Some(Payload::Scalar(s)) => Shape::Scalar(&s.text),
+                Some(Payload::Sequence(s)) => Shape::Sequence(s),
+                Some(Payload::Object(o)) => Shape::Object(o),
+            },
+            span: value.span,
+        }
+    }
+
+    fn is_unit(&self) -> bool {
+        self.tag.is_none() && matches!(self.shape, Shape::Unit)
+    }
+
+    /// The payload of a tagged value, as an untagged subject.
+    fn payload(&self) -> Subject<'a> {
+        Subject { tag: None, ..*self }
+    }
+
+    fn type_name(&self) -> &'static str {
+        match self.shape {
+            _ if self.is_unit() => "unit",
+            _ if self.tag.is_some() => "tagged",
+            Shape::Unit => "unit",
+            Shape::Scalar(_) => "scalar",
+            Shape::Sequence(_) => "sequence",
+            Shape::Object(_) => "object",
+        }
+    }
+}
+
+/// Path to the value being checked, kept on the stack and only rendered
+/// into a string when a violation is recorded.
+struct Trail<'a> {
+    parent: Option<&'a Trail<'a>>,
+    segment: Segment<'a>,
+}
+
+#[derive(Clone, Copy)]
+enum Segment<'a> {
+    Root,
+    /// The root of a document, which may carry a `@schema` declaration.
+    Document,
+    Key(&'a str),
+    Index(usize),
+}
+
+impl<'a> Trail<'a> {
+    const ROOT: Trail<'static> = Trail {
+        parent: None,
+        segment: Segment::Root,
+    };
+
+    const DOCUMENT: Trail<'static> = Trail {
+        parent: None,
+        segment: Segment::Document,
+    };
+
+    fn key<'b>(&'b self, key: &'b str) -> Trail<'b> {
+        Trail {
+            parent: Some(self),
+            segment: Segment::Key(key),
+        }
+    }
+
+    fn index(&self, index: usize) -> Trail<'_> {
+        Trail {
+            parent: Some(self),
+            segment: Segment::Index(index),
+        }
+    }
+
+    fn render(&self) -> String {
+        let mut segments = Vec::new();
+        let mut trail = Some(self);
+        while let Some(t) = trail {
+            segments.push(t.segment);
+            trail = t.parent;
+        }
+        let mut path = String::new();
+        for segment in segments.into_iter().rev() {
+            match segment {
+                Segment::Root | Segment::Document => {}
+                Segment::Key(key) => {
+                    if !path.is_empty() {
+                        path.push('.');
+                    }
+                    path.push_str(key);
+                }
+                Segment::Index(i) => path.push_str(&format!("[{i}]")),
+            }
+        }
+        path
+    }
+}
+
+/// Which named fields of an object have been seen.
+pub(crate) enum Seen {
+    Small(u64),
+    Large(Vec<bool>),
+}
+
+impl Seen {
+    pub(crate) fn new(fields: usize) -> Self {
+        if fields <= 64 {
+            Seen::Small(0)
+        } else {
+            Seen::Large(vec![false; fields])
+        }
+    }
+
+    pub(crate) fn insert(&mut self, i: usize) {
+        match self {
+            Seen::Small(bits) => *bits |= 1 << i,
+            Seen::Large(seen) => seen[i] = true,
+        }
+    }
+
+    pub(crate) fn contains(&self, i: usize) -> bool {
+        match self {
+            Seen::Small(bits) => bits & (1 << i) != 0,
+            Seen::Large(seen) => seen[i],
+        }
+    }
+}
+
+fn error(message: impl Into<String>, span: Option<Span>) -> SchemaError {
+    SchemaError {
+        message: message.into(),
+        span,
+    }
+}
+
+#[derive(Default)]
+struct Compiler<'s> {
+    nodes: Vec<Node>,
+    /// Named types and their reserved node slots.
+    types: Vec<(&'s str, NodeId)>,
+}
+
+impl<'s> Compiler<'s> {
+    fn run(mut self, block: &'s Object) -> Result<CompiledSchema, SchemaError> {
+        self.nodes.push(Node::Unit);
+
+        // Reserve a slot per named type first so references can be
+        // resolved regardless of definition order, including recursion.
+        let mut bodies = Vec::new();
+        let mut root = None;
+        for entry in block.entries() {
+            if entry.key.is_unit() {
+                let slot = self.push(Node::Any);
+                root = Some(slot);
+                bodies.push((slot, &entry.value));
+            } else if let Some(name) = entry.key.as_str() {
+                let slot = self.push(Node::Any);
+                self.types.push((name, slot));
+                bodies.push((slot, &entry.value));
+            } else {
+                return Err(error("type names must be scalars or `@`", entry.key.span));
+            }
+        }
+        self.types.sort_unstable_by_key(|&(name, _)| name);
+        for (slot, body) in bodies {
+            self.nodes[slot as usize] = self.lower(body)?;
+        }
+
+        self.resolve_aliases(block)?;
+        let root = root.map(|r| self.target(r));
+        let types = self
+            .types
+            .iter()
+            .map(|&(name, slot)| (name.into(), self.target(slot)))
+            .collect();
+        self.compute_fallbacks();
+        Ok(CompiledSchema {
+            nodes: self.nodes,
+            root,
+            types,
+        })
+    }
+
+    fn push(&mut self, node: Node) -> NodeId {
+        self.nodes.push(node);
+        (self.nodes.len() - 1) as NodeId
+    }
+
+    /// Compile a schema expression to a node id, reusing the target's id
+    /// for type references.
+    fn compile(&mut self, value: &'s Value) -> Result<NodeId, SchemaError> {
+        match self.lower(value)? {
+            Node::Alias(id) => Ok(id),
+            node => Ok(self.push(node)),
+        }
+    }
+
+    fn lower(&mut self, value: &'s Value) -> Result<Node, SchemaError> {
+        let Some(tag) = value.tag_name() else {
+            return match &value.payload {
+                None => Ok(Node::Unit),
+                Some(Payload::Scalar(s)) => Ok(Node::Literal(s.text.as_str().into())),
+                Some(_) => Err(error("expected a type", value.span)),
+            };
+        };
+        let payload = value.payload.as_ref();
+        let node = match (tag, payload) {
+            ("string", None) => Node::String {
+                min_len: 0,
+                max_len: usize::MAX,
+            },
+            ("string", Some(Payload::Object(c))) => Node::String {
+                min_len: constraint(c, "minLen")?.unwrap_or(0),
+                max_len: constraint(c, "maxLen")?.unwrap_or(usize::MAX),
+            },
+            ("int", None) => Node::Int {
+                min: i128::MIN,
+                max: i128::MAX,
+            },
+            ("int", Some(Payload::Object(c))) => Node::Int {
+                min: constraint(c, "min")?.unwrap_or(i128::MIN),
+                max: constraint(c, "max")?.unwrap_or(i128::MAX),
+            },
+            ("float", None) => Node::Float {
+                min: f64::NEG_INFINITY,
+                max: f64::INFINITY,
+            },
+            ("float", Some(Payload::Object(c))) => Node::Float {
+                min: constraint(c, "min")?.unwrap_or(f64::NEG_INFINITY),
+                max: constraint(c, "max")?.unwrap_or(f64::INFINITY),
+            },
+            ("bool", None) => Node::Bool,
+            ("unit", None) => Node::Unit,
+            ("any", None) => Node::Any,
+            ("object", Some(Payload::Object(fields))) => Node::Object(self.object(fields)?),
+            ("seq", Some(Payload::Sequence(s))) => Node::Seq(self.compile(single(s, value)?)?),
+            ("tuple", Some(Payload::Sequence(s))) => Node::Tuple(self.compile_all(s)?),
+            ("map", Some(Payload::Sequence(s))) => match s.items.as_slice() {
+                [v] => Node::Map {
+                    key: None,
+                    value: self.compile(v)?,
+                },
+                [k, v] => Node::Map {
+                    key: Some(self.compile(k)?),
+                    value: self.compile(v)?,
+                },
+                _ => return Err(error("@map takes one or two types", value.span)),
+            },
+            ("union", Some(Payload::Sequence(s))) if !s.items.is_empty() => {
+                Node::Union(self.compile_all(s)?)
+            }
+            ("optional", Some(Payload::Sequence(s))) => {
+                Node::Optional(self.compile(single(s, value)?)?)
+            }
+            ("enum", Some(Payload::Object(variants))) => Node::Enum(self.enumeration(variants)?),
+            ("one-of", Some(Payload::Sequence(s))) => match s.items.as_slice() {
+                [base, values] => Node::OneOf {
+                    base: self.compile(base)?,
+                    allowed: match values.as_sequence() {
+                        Some(values) => values
+                            .items
+                            .iter()
+                            .map(|v| {
+                                v.scalar_text()
+                                    .map(Into::into)
+                                    .ok_or_else(|| error("@one-of values must be scalars", v.span))
+                            })
+                            .collect::<Result<_, _>>()?,
+                        None => return Err(error("expected a sequence of values", values.span)),
+                    },
+                },
+                _ => return Err(error("@one-of takes a type and a sequence", value.span)),
+            },
+            // Wrappers that only matter when deserializing.
+            ("flatten", Some(Payload::Sequence(s))) => self.lower(single(s, value)?)?,
+            ("default" | "deprecated", Some(Payload::Sequence(s))) => match s.items.as_slice() {
+                [_, inner] => self.lower(inner)?,
+                _ => return Err(error(format!("@{tag} takes two arguments"), value.span)),
+            },
+            (name, None) => match self.types.binary_search_by_key(&name, |&(n, _)| n) {
+                Ok(i) => Node::Alias(self.types[i].1),
+                Err(_) => return Err(error(format!("unknown type '{name}'"), value.span)),
+            },
+            (name, Some(_)) => {
+                return Err(error(format!("invalid payload for @{name}"), value.span));
+            }
+        };
+        Ok(node)
+    }
+
+    fn compile_all(&mut self, seq: &'s Sequence) -> Result<Box<[NodeId]>, SchemaError> {
+        seq.items.iter().map(|v| self.compile(v)).collect()
+    }
+
+    fn object(&mut self, obj: &'s Object) -> Result<ObjectTable, SchemaError> {
+        let mut fields = Vec::new();
+        let mut catch_all = None;
+        for entry in obj.entries() {
+            let node = self.compile(&entry.value)?;
+            match entry.key.as_str() {
+                Some(name) => fields.push(Field {
+                    name: name.into(),
+                    node,
+                    required: !matches!(entry.value.tag_name(), Some("optional" | "default")),
+                }),
+                None => catch_all = Some(node),
+            }
+        }
+        let mut by_hash: Vec<_> = fields
+            .iter()
+            .enumerate()
+            .map(|(i, f)| (key_hash(&f.name), i as u32))
+            .collect();
+        by_hash.sort_unstable();
+        Ok(ObjectTable {
+            fields: fields.into_boxed_slice(),
+            by_hash: by_hash.into_boxed_slice(),
+            catch_all,
+        })
+    }
+
+    fn enumeration(&mut self, obj: &'s Object) -> Result<EnumTable, SchemaError> {
+        let mut variants = Vec::new();
+        for entry in obj.entries() {
+            let Some(name) = entry.key.as_str() else {
+                return Err(error("enum variants must be named", entry.key.span));
+            };
+            let node = match entry.value.is_unit() {
+                true => UNIT,
+                false => self.compile(&entry.value)?,
+            };
+            variants.push((key_hash(name), name.into(), node));
+        }
+        Ok(EnumTable {
+            variants: variants.into_boxed_slice(),
+            fallbacks: Box::new([]),
+        })
+    }
+
+    /// Follow a chain of aliases to the node it names.
+    fn target(&self, mut id: NodeId) -> NodeId {
+        while let Node::Alias(next) = self.nodes[id as usize] {
+            id = next;
+        }
+        id
+    }
+
+    /// Point every reference straight at its target so validation never
+    /// sees an alias.
+    fn resolve_aliases(&mut self, block: &Object) -> Result<(), SchemaError> {
+        for start in 0..self.nodes.len() {
+            let mut id = start as NodeId;
+            for _ in 0..=self.nodes.len() {
+                match self.nodes[id as usize] {
+                    Node::Alias(next) => id = next,
+                    _ => break,
+                }
+            }
+            if matches!(self.nodes[id as usize], Node::Alias(_)) {
+                return Err(error("type is defined as itself", block.span));
+            }
+        }
+        for i in 0..self.nodes.len() {
+            let mut node = std::mem::replace(&mut self.nodes[i], Node::Any);
+            node.for_each_child(|child| *child = self.target(*child));
+            self.nodes[i] = node;
+        }
+        Ok(())
+    }
+
+    fn compute_fallbacks(&mut self) {
+        for i in 0..self.nodes.len() {
+            let Node::Enum(table) = &self.nodes[i] else {
+                continue;
+            };
+            let fallbacks = table
+                .variants
+                .iter()
+                .map(|&(_, _, node)| node)
+                .filter(|&node| {
+                    matches!(
+                        self.nodes[node as usize],
+                        Node::String { .. } | Node::Int { .. } | Node::Float { .. } | Node::Bool
+                    )
+                })
+                .collect();
+            if let Node::Enum(table) = &mut self.nodes[i] {
+                table.fallbacks = fallbacks;
+            }
+        }
+    }
+}
+
+impl Node {
+    fn for_each_child(&mut self, mut f: impl FnMut(&mut NodeId)) {
+        match self {
+            Node::Object(table) => {
+                table.fields.iter_mut().for_each(|field| f(&mut field.node));
+                table.catch_all.iter_mut().for_each(f);
+            }
+            Node::Seq(id) | Node::Optional(id) | Node::OneOf { base: id, .. } => f(id),
+            Node::Tuple(ids) | Node::Union(ids) => ids.iter_mut().for_each(f),
+            Node::Map { key, value } => {
+                key.iter_mut().for_each(&mut f);
+                f(value);
+            }
+            Node::Enum(table) => table.variants.iter_mut().for_each(|(_, _, id)| f(id)),
+            _ => {}
+        }
+    }
+}
+
+/// The single type argument of `@seq(...)`, `@optional(...)` and the like.
+fn single<'s>(seq: &'s Sequence, owner: &Value) -> Result<&'s Value, SchemaError> {
+    match seq.items.as_slice() {
+        [item] => Ok(item),
+        _ => Err(error(
+            format!("@{} takes one type", owner.tag_name().unwrap_or_default()),
+            owner.span,
+        )),
+    }
+}
+
+/// Parse an optional numeric constraint such as `min` or `maxLen`.
+fn constraint<T: std::str::FromStr>(obj: &Object, name: &str) -> Result<Option<T>, SchemaError> {
+    let Some(value) = obj.get(name) else {
+        return Ok(None);
+    };
+    value
+        .as_str()
+        .and_then(|s| s.parse().ok())
+        .map(Some)
+        .ok_or_else(|| error(format!("invalid `{name}` constraint"), value.span))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SCHEMA: &str = r#"meta {id test}
+schema {
+    @ @object{
+        name @string{minLen 1}
+        port @int{min 1, max 65535}
+        ratio @optional(@float{max 1})
+        enabled @default(true @bool)
+        tags @optional(@seq(@string))
+        pair @optional(@tuple(@int @string))
+        env @optional(@map(@string))
+        level @optional(@one-of(@string (debug info warn)))
+        mode @optional(@Mode)
+        tree @optional(@Node)
+        kind @optional(@literal)
+    }
+    Mode @enum{
+        off
+        fixed @int
+        named @object{id @string}
+    }
+    Node @object{
+        label @string
+        children @optional(@seq(@Node))
+    }
+    literal v1
+}
+"#;
+
+    fn violations(source: &str) -> Vec<String> {
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        let doc = Document::parse(source).unwrap();
+        let result = schema.validate(&doc);
+        assert_eq!(schema.is_valid(&doc), result.is_ok(), "{source:?}");
+        match result {
+            Ok(()) => Vec::new(),
+            Err(v) => v.iter().map(ToString::to_string).collect(),
+        }
+    }
+
+    #[test]
+    fn test_valid_documents() {
+        for source in [
+            "name a\nport 80\n",
+            "name a\nport 80\nratio 0.5\nenabled false\ntags (x y)\n",
+            "name a\nport 80\npair (1 one)\nenv {HOME /root, PATH /bin}\n",
+            "name a\nport 80\nlevel info\nmode @off\n",
+            "name a\nport 80\nmode @fixed\"3\"\nkind v1\n",
+            "name a\nport 80\nmode 3\n",
+            "name a\nport 80\nmode @named{id x}\n",
+            "name a\nport 80\ntree {label a, children ({label b} {label c, children ()})}\n",
+        ] {
+            assert_eq!(violations(source), Vec::<String>::new(), "{source:?}");
+        }
+    }
+
+    #[test]
+    fn test_violations() {
+        assert_eq!(
+            violations("port 80\n"),
+            ["name: missing required field 'name'"]
+        );
+        assert_eq!(
+            violations("name \"\"\nport 0\nextra 1\n"),
+            [
+                "name: string too short (min length: 1)",
+                "port: value too small (min: 1)",
+                "extra: unknown field 'extra'",
+            ]
+        );
+        assert_eq!(
+            violations("name a\nport x\nratio 2\ntags (a {b c})\n"),
+            [
+                "port: 'x' is not a valid integer",
+                "ratio: value too large (max: 1)",
+                "tags[1]: expected string, got object",
+            ]
+        );
+        assert_eq!(
+            violations("name a\nport 80\npair (1)\nlevel trace\nkind v2\n"),
+            [
+                "pair: tuple has wrong number of elements: expected 2, got 1",
+                "level: 'trace' is not one of: debug, info, warn",
+                "kind: expected 'v1', got 'v2'",
+            ]
+        );
+        assert_eq!(
+            violations("name a\nport 80\nmode @on\n"),
+            ["mode: unknown enum variant 'on' (expected one of: off, fixed, named)"]
+        );
+        assert_eq!(
+            violations("name a\nport 80\nmode @fixed\n"),
+            ["mode: variant 'fixed' requires a payload"]
+        );
+        assert_eq!(
+            violations("name a\nport 80\ntree {label a, children ({label b} {})}\n"),
+            ["tree.children[1].label: missing required field 'label'"]
+        );
+    }
+
+    #[test]
+    fn test_repo_examples() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../examples");
+        let read = |name: &str| std::fs::read_to_string(dir.join(name));
+        let Ok(schema) = read("server.schema.styx") else {
+            return;
+        };
+        let schema = CompiledSchema::parse(&schema).unwrap();
+        let valid = Document::parse(&read("server-valid.styx").unwrap()).unwrap();
+        assert_eq!(schema.validate(&valid), Ok(()));
+        let invalid = Document::parse(&read("server-invalid.styx").unwrap()).unwrap();
+        let paths: Vec<_> = schema
+            .validate(&invalid)
+            .unwrap_err()
+            .into_iter()
+            .map(|v| v.path)
+            .collect();
+        assert_eq!(
+            paths,
+            ["prot", "enbled", "unknown_field", "tls.key", "port"]
+        );
+    }
+
+    #[test]
+    fn test_compile_errors() {
+        for (source, message) in [
+            ("meta {id x}\n", "missing `schema` block"),
+            ("schema {@ @object{a @Missing}}\n", "unknown type 'Missing'"),
+            ("schema {@ @seq(@string @int)}\n", "@seq takes one type"),
+            ("schema {@ @int{min low}}\n", "invalid `min` constraint"),
+            ("schema {A @B, B @A}\n", "type is defined as itself"),
+        ] {
+            let err = CompiledSchema::parse(source).unwrap_err();
+            assert_eq!(err.message, message, "{source:?}");
+        }
+    }
+
+    #[test]
+    fn test_aliases_and_named_types() {
+        let schema =
+            CompiledSchema::parse("schema {@ @Config, Config @Inner, Inner @object{x @int}}\n")
+                .unwrap();
+        let root = schema.root.unwrap() as usize;
+        assert!(matches!(schema.nodes[root], Node::Object(_)));
+        let doc = Document::parse("x 1\n").unwrap();
+        assert!(schema.is_valid(&doc));
+        assert!(!schema.is_valid(&Document::parse("x y\n").unwrap()));
+        assert!(schema.validate_as(&Value::scalar("3"), "Inner").is_err());
+        assert!(schema.validate_as(&Value::scalar("3"), "Nope").is_err());
+    }
+
+    #[test]
+    fn test_shared_across_threads() {
+        fn assert_send_sync<T: Send + Sync>() {}
+        assert_send_sync::<CompiledSchema>();
+
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        std::thread::scope(|s| {
+            for i in 0..4 {
+                let schema = &schema;
+                s.spawn(move || {
+                    let doc = Document::parse(&format!("name n{i}\nport {}\n", i + 1)).unwrap();
+                    assert!(schema.is_valid(&doc));
+                });
+            }
+        });
+    }
+}
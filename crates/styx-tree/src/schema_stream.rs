@@ -0,0 +1,883 @@
+//! Schema validation over the parser's event stream.
+//!
+//! [`CompiledSchema::validate`] needs a built [`Document`], so a document
+//! that fails on its first entry still pays for the whole tree. An
+//! [`EventValidator`] instead follows the events from
+//! [`Parser::next_event`](styx_parse::Parser::next_event) with a stack of
+//! expected schema nodes and stops at the first violation, without
+//! building values. Scalars are checked as they arrive; only union,
+//! one-of and tuple values, whose verdict depends on the whole value, are
+//! buffered into a subtree and checked when it closes.
+//!
+//! The verdict and the first violation are those of
+//! [`CompiledSchema::is_valid`] on the parsed document, except that parse
+//! errors and violations are reported in source order, whichever comes
+//! first.
+
+use std::borrow::Cow;
+use std::fmt::Write;
+
+use styx_parse::{Event, EventKind, Parser, ScalarKind};
+
+use crate::schema::{Node, NodeId, ObjectTable, Seen, Shape, Subject};
+use crate::{
+    BuildError, CompiledSchema, Document, Object, Payload, SchemaViolation, Sequence, Span,
+    TreeBuilder,
+};
+
+/// Why a source was rejected by [`CompiledSchema::check_source`].
+#[derive(Debug, Clone, PartialEq)]
+pub enum ValidateError {
+    /// The source is not a well-formed document.
+    Parse(BuildError),
+    /// The document does not match the schema.
+    Schema(SchemaViolation),
+}
+
+impl std::fmt::Display for ValidateError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            ValidateError::Parse(e) => write!(f, "{e}"),
+            ValidateError::Schema(v) => write!(f, "{v}"),
+        }
+    }
+}
+
+impl std::error::Error for ValidateError {}
+
+impl CompiledSchema {
+    /// Parse `source` and check it against the schema without building a
+    /// tree, stopping at the first parse error or violation.
+    pub fn check_source(&self, source: &str) -> Result<(), ValidateError> {
+        let mut parser = Parser::new(source);
+        let mut validator = EventValidator::new(self);
+        while let Some(event) = parser.next_event() {
+            validator.event(&event)?;
+        }
+        validator.finish()
+    }
+
+    /// Parse `source` into a document that matches the schema.
+    ///
+    /// Validation runs on the events as they are parsed, so an invalid
+    /// document is abandoned at its first violation and the partial tree
+    /// discarded; a valid one is returned without a second pass over it.
+    pub fn parse_validated(&self, source: &str) -> Result<Document, ValidateError> {
+        let mut parser = Parser::new(source);
+        let mut validator = EventValidator::new(self);
+        let mut builder = TreeBuilder::new();
+        while let Some(event) = parser.next_event() {
+            validator.event(&event)?;
+            builder.event(event);
+        }
+        validator.finish()?;
+        builder
+            .finish()
+            .and_then(Document::from_root_value)
+            .map_err(ValidateError::Parse)
+    }
+}
+
+/// Checks a document against a [`CompiledSchema`] one parse event at a time.
+///
+/// Feed it every event of one document with [`event`](Self::event), then
+/// call [`finish`](Self::finish). After the first error, later events are
+/// ignored and the error is returned again.
+pub struct EventValidator<'s, 'src> {
+    schema: &'s CompiledSchema,
+    stack: Vec<Frame<'s, 'src>>,
+    rooted: bool,
+    error: Option<ValidateError>,
+}
+
+enum Frame<'s, 'src> {
+    Object {
+        table: &'s ObjectTable,
+        seen: Seen,
+        /// Span of the opening brace; `None` for the document root.
+        start: Option<Span>,
+        document: bool,
+    },
+    Map {
+        key: Option<NodeId>,
+        value: NodeId,
+    },
+    Entry {
+        key: Option<Cow<'src, str>>,
+        expect: Expect,
+    },
+    Seq {
+        item: NodeId,
+        /// Number of items started so far.
+        next: usize,
+    },
+    /// A tagged value checked against `node`. For enums, `variant` is the
+    /// schema of the payload, which is checked untagged.
+    Tag {
+        name: &'src str,
+        node: NodeId,
+        variant: Option<NodeId>,
+        span: Span,
+        payload: bool,
+        /// Tags directly inside this one, which the tree drops.
+        nested: u32,
+    },
+    /// A value the schema accepts whatever it contains.
+    Skip {
+        depth: u32,
+    },
+    /// A value only checkable as a whole, built into a tree first.
+    Buffer {
+        builder: Box<TreeBuilder>,
+        node: NodeId,
+        depth: u32,
+        document: bool,
+    },
+}
+
+#[derive(Clone, Copy)]
+enum Expect {
+    Key,
+    /// The schema for the entry's value; `None` accepts anything.
+    Value(Option<NodeId>),
+    Done,
+}
+
+impl<'s, 'src> EventValidator<'s, 'src> {
+    /// Create a validator for one document.
+    pub fn new(schema: &'s CompiledSchema) -> Self {
+        EventValidator {
+            schema,
+            stack: Vec::new(),
+            rooted: false,
+            error: None,
+        }
+    }
+
+    /// Process the next event, failing at the first parse error or
+    /// violation.
+    pub fn event(&mut self, event: &Event<'src>) -> Result<(), ValidateError> {
+        if let Some(error) = &self.error {
+            return Err(error.clone());
+        }
+        let result = self.step(event);
+        if let Err(error) = &result {
+            self.error = Some(error.clone());
+        }
+        result
+    }
+
+    /// Finish the document: the first error, if any, or an error for
+    /// structures still open.
+    pub fn finish(mut self) -> Result<(), ValidateError> {
+        if !self.rooted {
+            let span = Span { start: 0, end: 0 };
+            self.event(&Event {
+                span,
+                kind: EventKind::ObjectStart,
+            })?;
+            self.event(&Event {
+                span,
+                kind: EventKind::ObjectEnd,
+            })?;
+        }
+        if let Some(error) = self.error {
+            return Err(error);
+        }
+        if !self.stack.is_empty() {
+            return Err(ValidateError::Parse(BuildError::UnclosedStructure));
+        }
+        Ok(())
+    }
+
+    fn step(&mut self, event: &Event<'src>) -> Result<(), ValidateError> {
+        let span = event.span;
+        match &event.kind {
+            EventKind::Error { kind } => {
+                return Err(ValidateError::Parse(BuildError::Parse(kind.clone(), span)));
+            }
+            EventKind::DocumentStart
+            | EventKind::DocumentEnd
+            | EventKind::Comment { .. }
+            | EventKind::DocComment { .. } => return Ok(()),
+            _ => {}
+        }
+        let Some(top) = self.stack.last_mut() else {
+            if matches!(event.kind, EventKind::ObjectStart) && !self.rooted {
+                self.rooted = true;
+                return self.root(event);
+            }
+            return Ok(());
+        };
+        match top {
+            Frame::Skip { depth } => {
+                *depth = depth.wrapping_add_signed(nesting(&event.kind));
+                if *depth == 0 {
+                    self.stack.pop();
+                }
+                Ok(())
+            }
+            Frame::Buffer { builder, depth, .. } => {
+                builder.event(event.clone());
+                *depth = depth.wrapping_add_signed(nesting(&event.kind));
+                match *depth {
+                    0 => self.close_buffer(),
+                    _ => Ok(()),
+                }
+            }
+            Frame::Object { .. } | Frame::Map { .. } => match event.kind {
+                EventKind::EntryStart => {
+                    self.stack.push(Frame::Entry {
+                        key: None,
+                        expect: Expect::Key,
+                    });
+                    Ok(())
+                }
+                EventKind::ObjectEnd => self.close_object(span),
+                _ => self.value(None, None, event),
+            },
+            Frame::Entry { expect, .. } => match &event.kind {
+                EventKind::Key { tag, payload, .. } => self.key(*tag, payload.as_ref(), span),
+                EventKind::EntryEnd => {
+                    self.stack.pop();
+                    Ok(())
+                }
+                _ => {
+                    let node = match std::mem::replace(expect, Expect::Done) {
+                        Expect::Value(node) => node,
+                        Expect::Key | Expect::Done => None,
+                    };
+                    self.value(node, None, event)
+                }
+            },
+            Frame::Seq { item, next } => match event.kind {
+                EventKind::SequenceEnd => {
+                    self.stack.pop();
+                    Ok(())
+                }
+                _ => {
+                    *next += 1;
+                    let item = *item;
+                    self.value(Some(item), None, event)
+                }
+            },
+            Frame::Tag {
+                name,
+                node,
+                variant,
+                span: tag_span,
+                payload,
+                nested,
+            } => match event.kind {
+                EventKind::TagStart { .. } if !*payload => {
+                    *nested += 1;
+                    Ok(())
+                }
+                EventKind::TagEnd if *nested > 0 => {
+                    *nested -= 1;
+                    Ok(())
+                }
+                EventKind::TagEnd => {
+                    let (name, node, tag_span, payload) = (*name, *node, *tag_span, *payload);
+                    self.stack.pop();
+                    match payload {
+                        true => Ok(()),
+                        false => self.leaf(
+                            node,
+                            Subject {
+                                tag: Some(name),
+                                shape: Shape::Unit,
+                                span: Some(tag_span),
+                            },
+                        ),
+                    }
+                }
+                // The tree treats `@tag @` as a bare tag.
+                EventKind::Unit => Ok(()),
+                _ => {
+                    *payload = true;
+                    let (node, tag) = match *variant {
+                        Some(variant) => (variant, None),
+                        None => (*node, Some(*name)),
+                    };
+                    self.value(Some(node), tag, event)
+                }
+            },
+        }
+    }
+
+    fn root(&mut self, event: &Event<'src>) -> Result<(), ValidateError> {
+        match self.schema.root {
+            Some(mut node) => {
+                while let Node::Optional(inner) = self.schema.nodes[node as usize] {
+                    node = inner;
+                }
+                self.container(node, None, event, true)
+            }
+            None => Err(ValidateError::Schema(SchemaViolation {
+                path: String::new(),
+                message: "schema has no root type definition".to_string(),
+                span: None,
+            })),
+        }
+    }
+
+    /// Start a value checked against `expect` (anything, if `None`), tagged
+    /// `tag` when it is the payload of a tag.
+    fn value(
+        &mut self,
+        expect: Option<NodeId>,
+        tag: Option<&'src str>,
+        event: &Event<'src>,
+    ) -> Result<(), ValidateError> {
+        let Some(mut node) = expect else {
+            if nesting(&event.kind) > 0 {
+                self.stack.push(Frame::Skip { depth: 1 });
+            }
+            return Ok(());
+        };
+        while let Node::Optional(inner) = self.schema.nodes[node as usize] {
+            if tag.is_none() && matches!(event.kind, EventKind::Unit) {
+                return Ok(());
+            }
+            node = inner;
+        }
+        let span = Some(event.span);
+        match &event.kind {
+            EventKind::Scalar { value, .. } => self.leaf(
+                node,
+                Subject {
+                    tag,
+                    shape: Shape::Scalar(value),
+                    span,
+                },
+            ),
+            EventKind::Unit => self.leaf(
+                node,
+                Subject {
+                    tag,
+                    shape: Shape::Unit,
+                    span,
+                },
+            ),
+            EventKind::TagStart { name } => self.tag(node, name, event),
+            EventKind::ObjectStart | EventKind::SequenceStart => {
+                self.container(node, tag, event, false)
+            }
+            _ => Ok(()),
+        }
+    }
+
+    fn tag(
+        &mut self,
+        node: NodeId,
+        name: &'src str,
+        event: &Event<'src>,
+    ) -> Result<(), ValidateError> {
+        let variant = match &self.schema.nodes[node as usize] {
+            Node::Any => {
+                self.stack.push(Frame::Skip { depth: 1 });
+                return Ok(());
+            }
+            Node::Union(_) | Node::OneOf { .. } | Node::Tuple(_) => {
+                return self.buffer(node, event, false);
+            }
+            Node::Enum(table) => match table.variant(name) {
+                Some(variant) => Some(variant),
+                None => {
+                    // Reports the unknown variant.
+                    let subject = Subject {
+                        tag: Some(name),
+                        shape: Shape::Unit,
+                        span: Some(event.span),
+                    };
+                    return self.leaf(node, subject);
+                }
+            },
+            _ => None,
+        };
+        self.stack.push(Frame::Tag {
+            name,
+            node,
+            variant,
+            span: event.span,
+            payload: false,
+            nested: 0,
+        });
+        Ok(())
+    }
+
+    fn container(
+        &mut self,
+        node: NodeId,
+        tag: Option<&'src str>,
+        event: &Event<'src>,
+        document: bool,
+    ) -> Result<(), ValidateError> {
+        let schema = self.schema;
+        let object = matches!(event.kind, EventKind::ObjectStart);
+        let frame = match &schema.nodes[node as usize] {
+            Node::Any => Frame::Skip { depth: 1 },
+            Node::Union(_) | Node::OneOf { .. } | Node::Tuple(_) => {
+                return self.buffer(node, event, document);
+            }
+            Node::Object(table) if object => Frame::Object {
+                table,
+                seen: Seen::new(table.fields.len()),
+                start: (!document).then_some(event.span),
+                document,
+            },
+            &Node::Map { key, value } if object => Frame::Map { key, value },
+            &Node::Seq(item) if !object => Frame::Seq { item, next: 0 },
+            _ => {
+                // The contents cannot matter: check an empty stand-in to
+                // report the mismatch.
+                let (empty_object, empty_sequence);
+                let shape = if object {
+                    empty_object = Object::new(Vec::new(), None);
+                    Shape::Object(&empty_object)
+                } else {
+                    empty_sequence = Sequence {
+                        items: Vec::new(),
+                        span: None,
+                    };
+                    Shape::Sequence(&empty_sequence)
+                };
+                let subject = Subject {
+                    tag,
+                    shape,
+                    span: (!document).then_some(event.span),
+                };
+                self.first_violation(node, subject, document)?;
+                return self.buffer(node, event, document);
+            }
+        };
+        self.stack.push(frame);
+        Ok(())
+    }
+
+    fn key(
+        &mut self,
+        tag: Option<&'src str>,
+        payload: Option<&Cow<'src, str>>,
+        span: Span,
+    ) -> Result<(), ValidateError> {
+        let name = match (tag, payload) {
+            (None, None) => Some(Cow::Borrowed("@")),
+            (None, Some(text)) => Some(text.clone()),
+            _ => None,
+        };
+        let [.., parent, Frame::Entry { key, expect }] = &mut self.stack[..] else {
+            return Ok(());
+        };
+        match parent {
+            Frame::Object {
+                table,
+                seen,
+                document,
+                ..
+            } => {
+                let Some(name) = name else {
+                    // A document's own `@schema` declaration is not part of
+                    // its data.
+                    if *document && tag == Some("schema") {
+                        *expect = Expect::Value(None);
+                        return Ok(());
+                    }
+                    return Err(self.violation(String::new(), span, "invalid object key".into()));
+                };
+                let field = match payload {
+                    Some(_) => table.field(&name),
+                    None => None,
+                };
+                let node = match field {
+                    Some(i) => {
+                        seen.insert(i);
+                        Some(table.fields[i].node)
+                    }
+                    None => table.catch_all,
+                };
+                *expect = Expect::Value(node);
+                let message = node.is_none().then(|| format!("unknown field '{name}'"));
+                *key = Some(name);
+                match message {
+                    Some(message) => Err(self.violation(String::new(), span, message)),
+                    None => Ok(()),
+                }
+            }
+            &mut Frame::Map {
+                key: key_node,
+                value,
+            } => {
+                let Some(name) = name else {
+                    return Err(self.violation(String::new(), span, "invalid map key".into()));
+                };
+                *expect = Expect::Value(Some(value));
+                if let Some(key_node) = key_node {
+                    let shape = match payload {
+                        Some(_) => Shape::Scalar(&name),
+                        None => Shape::Unit,
+                    };
+                    let subject = Subject {
+                        tag: None,
+                        shape,
+                        span: Some(span),
+                    };
+                    // Checked at the map's path, before the key is pushed.
+                    self.first_violation(key_node, subject, false)?;
+                }
+                if let Some(Frame::Entry { key, .. }) = self.stack.last_mut() {
+                    *key = Some(name);
+                }
+                Ok(())
+            }
+            _ => Ok(()),
+        }
+    }
+
+    fn close_object(&mut self, end: Span) -> Result<(), ValidateError> {
+        let Some(Frame::Object {
+            table, seen, start, ..
+        }) = self.stack.pop()
+        else {
+            return Ok(());
+        };
+        match table
+            .fields
+            .iter()
+            .enumerate()
+            .find(|&(i, field)| field.required && !seen.contains(i))
+        {
+            Some((_, field)) => {
+                let span = start.map(|start| Span {
+                    start: start.start,
+                    end: end.end,
+                });
+                let message = format!("missing required field '{}'", field.name);
+                Err(self.violation(field.name.to_string(), span, message))
+            }
+            None => Ok(()),
+        }
+    }
+
+    fn buffer(
+        &mut self,
+        node: NodeId,
+        event: &Event<'src>,
+        document: bool,
+    ) -> Result<(), ValidateError> {
+        // Build the value as the sole entry of a synthetic root, so it gets
+        // the same shape and spans as in a full parse.
+        let mut builder = Box::new(TreeBuilder::new());
+        let span = Span { start: 0, end: 0 };
+        for kind in [
+            EventKind::ObjectStart,
+            EventKind::EntryStart,
+            EventKind::Key {
+                tag: None,
+                payload: None,
+                kind: ScalarKind::Bare,
+            },
+        ] {
+            builder.event(Event { span, kind });
+        }
+        builder.event(event.clone());
+        self.stack.push(Frame::Buffer {
+            builder,
+            node,
+            depth: 1,
+            document,
+        });
+        Ok(())
+    }
+
+    fn close_buffer(&mut self) -> Result<(), ValidateError> {
+        let Some(Frame::Buffer {
+            mut builder,
+            node,
+            document,
+            ..
+        }) = self.stack.pop()
+        else {
+            return Ok(());
+        };
+        let span = Span { start: 0, end: 0 };
+        for kind in [EventKind::EntryEnd, EventKind::ObjectEnd] {
+            builder.event(Event { span, kind });
+        }
+        let root = builder.finish().map_err(ValidateError::Parse)?;
+        let Some(Payload::Object(root)) = &root.payload else {
+            return Ok(());
+        };
+        match root.entries().first() {
+            Some(entry) => self.first_violation(node, Subject::of(&entry.value), document),
+            None => Ok(()),
+        }
+    }
+
+    fn leaf(&self, node: NodeId, subject: Subject) -> Result<(), ValidateError> {
+        self.first_violation(node, subject, false)
+    }
+
+    fn first_violation(
+        &self,
+        node: NodeId,
+        subject: Subject,
+        document: bool,
+    ) -> Result<(), ValidateError> {
+        self.schema
+            .first_violation(node, subject, document, || self.path())
+            .map_err(ValidateError::Schema)
+    }
+
+    /// A violation at `key` (if not empty) under the current value.
+    #[cold]
+    fn violation(
+        &self,
+        key: String,
+        span: impl Into<Option<Span>>,
+        message: String,
+    ) -> ValidateError {
+        let mut path = self.path();
+        if !key.is_empty() {
+            if !path.is_empty() {
+                path.push('.');
+            }
+            path.push_str(&key);
+        }
+        ValidateError::Schema(SchemaViolation {
+            path,
+            message,
+            span: span.into(),
+        })
+    }
+
+    /// The path of the value being checked, in [`Document::get`] syntax.
+    fn path(&self) -> String {
+        let mut path = String::new();
+        for frame in &self.stack {
+            let key = match frame {
+                Frame::Entry { key: Some(key), .. } => &**key,
+                Frame::Tag {
+                    name,
+                    variant: Some(_),
+                    ..
+                } => name,
+                &Frame::Seq { next, .. } if next > 0 => {
+                    let _ = write!(path, "[{}]", next - 1);
+                    continue;
+                }
+                _ => continue,
+            };
+            if !path.is_empty() {
+                path.push('.');
+            }
+            path.push_str(key);
+        }
+        path
+    }
+}
+
+/// How an event changes the nesting depth of values.
+fn nesting(kind: &EventKind) -> i32 {
+    match kind {
+        EventKind::ObjectStart | EventKind::SequenceStart | EventKind::TagStart { .. } => 1,
+        EventKind::ObjectEnd | EventKind::SequenceEnd | EventKind::TagEnd => -1,
+        _ => 0,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SCHEMA: &str = r#"schema {
+    @ @object{
+        name @string{minLen 1}
+        port @optional(@int{min 1, max 65535})
+        tags @optional(@seq(@string))
+        pair @optional(@tuple(@int @bool))
+        env @optional(@map(@string))
+        ids @optional(@map(@int @string))
+        either @optional(@union(@int @bool))
+        level @optional(@one-of(@string (low high)))
+        mode @optional(@Mode)
+        inner @optional(@Inner)
+        extra @optional(@any)
+        exact @optional(v1)
+    }
+    Mode @enum{
+        off
+        fixed @int
+        named @object{id @string}
+        list @seq(@Inner)
+    }
+    Inner @object{
+        id @int
+        @ @string
+    }
+}
+"#;
+
+    /// The first violation the tree validator reports, as `path: message`.
+    fn tree_verdict(schema: &CompiledSchema, source: &str) -> Option<String> {
+        let doc = Document::parse(source).unwrap();
+        let verdict = match schema.validate(&doc) {
+            Ok(()) => None,
+            Err(violations) => Some(violations[0].to_string()),
+        };
+        assert_eq!(schema.is_valid(&doc), verdict.is_none(), "{source:?}");
+        verdict
+    }
+
+    fn stream_verdict(schema: &CompiledSchema, source: &str) -> Option<String> {
+        match schema.check_source(source) {
+            Ok(()) => None,
+            Err(ValidateError::Schema(violation)) => Some(violation.to_string()),
+            Err(ValidateError::Parse(e)) => panic!("{source:?}: {e}"),
+        }
+    }
+
+    #[test]
+    fn test_matches_tree_validation() {
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        for source in [
+            "name a\n",
+            "@schema schema.styx\nname a\n",
+            "name a\nport 80\ntags (x y)\npair (1 true)\n",
+            "name a\nenv {HOME /root, @ x}\nids {1 one, 2 two}\n",
+            "name a\neither 3\nlevel low\nexact v1\n",
+            "name a\neither @x\"true\"\nmode @off\n",
+            "name a\nmode 3\nextra {anything (goes @here)}\n",
+            "name a\nmode @named{id x}\ninner {id 1, note hi}\n",
+            "name a\nmode @list({id 1} {id 2, b c})\n",
+            "name a\nmode @fixed\"3\"\n",
+            "// comment\n/// doc\nname a\n",
+            "",
+            "port 80\n",
+            "name \"\"\n",
+            "name a\nport 0\n",
+            "name a\nport x\n",
+            "name a\nport @\n",
+            "name a\nbogus 1\n",
+            "name a\n@tagged key\n",
+            "name a\n@ 1\n",
+            "name a\ntags (a {b c})\n",
+            "name a\ntags x\n",
+            "name a\ntags {x y}\n",
+            "name a\npair (1)\n",
+            "name a\npair (x true y)\n",
+            "name a\npair (1 nope)\n",
+            "name a\nenv {a {b c}}\n",
+            "name a\nids {x one}\n",
+            "name a\nids {1 (two)}\n",
+            "name a\neither x\n",
+            "name a\neither (1)\n",
+            "name a\nlevel mid\n",
+            "name a\nlevel {x y}\n",
+            "name a\nmode @on\n",
+            "name a\nmode @on{x 1}\n",
+            "name a\nmode @fixed\n",
+            "name a\nmode @fixed\"x\"\n",
+            "name a\nmode @off\"1\"\n",
+            "name a\nmode @named{}\n",
+            "name a\nmode @named\n",
+            "name a\nmode @list({id 1} {b c})\n",
+            "name a\nmode {off 1}\n",
+            "name a\nmode (off)\n",
+            "name a\ninner {}\n",
+            "name a\ninner {id 1, note (x)}\n",
+            "name a\ninner @tag{id x}\n",
+            "name a\ninner x\n",
+            "name a\nexact v2\n",
+            "name a\nexact {v1 1}\n",
+            "name {}\n",
+            "name @x\nport 1\n",
+            "a.b.c 1\n",
+            "name a\ninner.id x\n",
+        ] {
+            assert_eq!(
+                stream_verdict(&schema, source),
+                tree_verdict(&schema, source),
+                "{source:?}"
+            );
+        }
+    }
+
+    #[test]
+    fn test_stops_at_first_violation() {
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        let mut parser = Parser::new("name a\nport 0\ntags (x y z)\n");
+        let mut validator = EventValidator::new(&schema);
+        let mut rejected = None;
+        for (i, event) in std::iter::from_fn(|| parser.next_event()).enumerate() {
+            if let Err(e) = validator.event(&event) {
+                rejected = Some((i, e));
+                break;
+            }
+        }
+        let (at, error) = rejected.unwrap();
+        assert!(at < 16, "rejected at event {at}");
+        let ValidateError::Schema(violation) = error else {
+            panic!("{error}");
+        };
+        assert_eq!(violation.path, "port");
+        assert_eq!(violation.span, Some(Span { start: 12, end: 13 }));
+        assert_eq!(
+            validator.finish().unwrap_err().to_string(),
+            "port: value too small (min: 1)"
+        );
+    }
+
+    #[test]
+    fn test_parse_errors() {
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        for source in ["name a\nname b\n", "name a\ninner {id 1\n"] {
+            assert!(
+                matches!(
+                    schema.check_source(source),
+                    Err(ValidateError::Parse(BuildError::Parse(..)))
+                ),
+                "{source:?}"
+            );
+            assert!(schema.parse_validated(source).is_err());
+        }
+    }
+
+    #[test]
+    fn test_parse_validated() {
+        let schema = CompiledSchema::parse(SCHEMA).unwrap();
+        let source = "name a\nmode @named{id x}\ntags (x y)\n";
+        assert_eq!(
+            schema.parse_validated(source),
+            Ok(Document::parse(source).unwrap())
+        );
+        assert_eq!(
+            schema
+                .parse_validated("name a\nmode @fixed\n")
+                .unwrap_err()
+                .to_string(),
+            "mode: variant 'fixed' requires a payload"
+        );
+        let unrooted = CompiledSchema::parse("schema {Inner @object{id @int}}\n").unwrap();
+        assert!(unrooted.check_source("id 1\n").is_err());
+    }
+
+    #[test]
+    fn test_repo_examples() {
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../examples");
+        let read = |name: &str| std::fs::read_to_string(dir.join(name));
+        let Ok(schema) = read("server.schema.styx") else {
+            return;
+        };
+        let schema = CompiledSchema::parse(&schema).unwrap();
+        for name in ["server-valid.styx", "server-invalid.styx"] {
+            let source = read(name).unwrap();
+            assert_eq!(
+                stream_verdict(&schema, &source),
+                tree_verdict(&schema, &source),
+                "{name}"
+            );
+        }
+    }
+}
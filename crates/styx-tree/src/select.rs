@@ -0,0 +1,975 @@
+//! Selectors: paths with wildcards, recursive descent and filters.
+//!
+//! A [`Path`](crate::Path) names one value. A [`Selector`] names any number
+//! of them and returns them all from one walk over the tree:
+//!
+//! ```text
+//! name  .name       entry `name` (the first step needs no dot)
+//! "a.b"             entry with a quoted name
+//! [n]               sequence item n
+//! .*  [*]           every entry value or sequence item
+//! ..name  ..*       entry `name`, or any value, at any depth below
+//! [@name]           keep values tagged `@name` (also `[@tag=name]`)
+//! [key=value]       keep objects whose `key` entry is the scalar `value`
+//! ```
+//!
+//! so `hosts[*].port` is the port of every host, `..port` every `port`
+//! entry in the document, and `..[@tag=duration]` every `@duration` value.
+//!
+//! A compiled selector is a small automaton: the positions it may have
+//! reached are a bitmask, advanced once per value, so recursive descent
+//! never visits a value twice and results come out in document order.
+//!
+//! [`EventSelector`] runs the same automaton over parse events, so a large
+//! file can be queried without building its tree. Only matched values, and
+//! objects whose `[key=value]` filters are still undecided, are built.
+
+use std::borrow::Cow;
+
+use styx_parse::{Event, EventKind, Parser, ScalarKind, Span};
+
+use crate::index::key_hash;
+use crate::{BuildError, Document, Object, Payload, TreeBuilder, Value};
+
+/// Steps a selector may have; one more bit marks a match.
+const MAX_STEPS: usize = 63;
+
+/// A compiled selector (see the [module docs](self) for the syntax).
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Selector {
+    steps: Box<[Step]>,
+    /// Bit of the state past the last step.
+    accept: u64,
+    /// Bits of filter steps.
+    filters: u64,
+    /// Bits of recursive descent steps, which stay active in children.
+    descend: u64,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+enum Step {
+    /// A direct child.
+    Child(Name),
+    /// A child at any depth.
+    Descendant(Name),
+    /// The value is tagged with this name.
+    Tag(Box<str>),
+    /// The value is an object whose `key` entry is the untagged scalar
+    /// `value`.
+    Field {
+        key: Box<str>,
+        hash: u64,
+        value: Box<str>,
+    },
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+enum Name {
+    Key { key: Box<str>, hash: u64 },
+    Index(usize),
+    Any,
+}
+
+/// Error compiling a selector.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct SelectorError {
+    /// What is wrong with the selector.
+    pub message: String,
+    /// Byte offset in the selector text.
+    pub offset: usize,
+}
+
+impl std::fmt::Display for SelectorError {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(f, "invalid selector at {}: {}", self.offset, self.message)
+    }
+}
+
+impl std::error::Error for SelectorError {}
+
+/// What is known about a value's payload when its filters are checked.
+#[derive(Clone, Copy)]
+enum Content<'a> {
+    /// Not seen yet: a `[key=value]` filter cannot be decided.
+    Unknown,
+    Object(&'a Object),
+    /// Anything but an object.
+    Other,
+}
+
+impl Selector {
+    /// Compile a selector.
+    pub fn compile(selector: &str) -> Result<Self, SelectorError> {
+        Compiler {
+            text: selector,
+            pos: 0,
+            steps: Vec::new(),
+        }
+        .run()
+    }
+
+    /// Number of steps, counting filters.
+    pub fn len(&self) -> usize {
+        self.steps.len()
+    }
+
+    /// Whether the selector has no steps.
+    pub fn is_empty(&self) -> bool {
+        self.steps.is_empty()
+    }
+
+    /// Every value in `doc` the selector matches, in document order.
+    ///
+    /// Steps start at the root object, which is never a result itself.
+    pub fn select<'a>(&self, doc: &'a Document) -> Vec<&'a Value> {
+        let mut out = Vec::new();
+        self.visit_root(&doc.root, 1, &mut out);
+        out
+    }
+
+    /// Every value under (and including) `value` the selector matches, with
+    /// steps starting at `value`.
+    pub fn select_value<'a>(&self, value: &'a Value) -> Vec<&'a Value> {
+        let mut out = Vec::new();
+        self.visit(value, 1, &mut out);
+        out
+    }
+
+    /// Parse `source` and return the values [`select`](Self::select) would,
+    /// without building the document (see [`EventSelector`]).
+    pub fn select_source(&self, source: &str) -> Result<Vec<Value>, BuildError> {
+        let mut parser = Parser::new(source);
+        let mut selector = EventSelector::new(self);
+        while let Some(event) = parser.next_event() {
+            selector.event(&event);
+        }
+        selector.finish()
+    }
+
+    /// Apply the filters active in `states` to a value, returning the
+    /// states that survive, or `None` if that needs content not seen yet.
+    fn settle(&self, mut states: u64, tag: Option<&str>, content: Content<'_>) -> Option<u64> {
+        let mut pending = states & self.filters;
+        while pending != 0 {
+            let i = pending.trailing_zeros() as usize;
+            states &= !(1 << i);
+            let pass = match &self.steps[i] {
+                Step::Tag(name) => tag == Some(&**name),
+                Step::Field { key, hash, value } => match content {
+                    Content::Unknown => return None,
+                    Content::Object(obj) => {
+                        obj.get_hashed(key, *hash).and_then(Value::as_str) == Some(&**value)
+                    }
+                    Content::Other => false,
+                },
+                Step::Child(_) | Step::Descendant(_) => unreachable!("not a filter"),
+            };
+            if pass {
+                states |= 1 << (i + 1);
+            }
+            // Later filters only: a passed filter may enable the next one.
+            pending = states & self.filters & !((2 << i) - 1);
+        }
+        Some(states)
+    }
+
+    /// The states of a child reached from `states` through a step that
+    /// `matches` accepts.
+    fn children(&self, states: u64, matches: impl Fn(&Name) -> bool) -> u64 {
+        let mut next = states & self.descend;
+        let mut bits = states & !self.accept;
+        while bits != 0 {
+            let i = bits.trailing_zeros() as usize;
+            bits &= bits - 1;
+            if let Step::Child(name) | Step::Descendant(name) = &self.steps[i]
+                && matches(name)
+            {
+                next |= 1 << (i + 1);
+            }
+        }
+        next
+    }
+
+    /// The states of the value of an entry keyed `key` (None unless the key
+    /// is an untagged scalar).
+    fn entry_states(&self, states: u64, key: Option<&str>) -> u64 {
+        self.children(states, |name| match name {
+            Name::Key { key: want, .. } => key == Some(&**want),
+            Name::Index(_) => false,
+            Name::Any => true,
+        })
+    }
+
+    /// The states of sequence item `index`.
+    fn item_states(&self, states: u64, index: usize) -> u64 {
+        self.children(states, |name| match name {
+            Name::Key { .. } => false,
+            Name::Index(want) => index == *want,
+            Name::Any => true,
+        })
+    }
+
+    /// The single direct-child step active in `states`, if that is all.
+    fn only_child(&self, states: u64) -> Option<(usize, &Name)> {
+        if states.count_ones() != 1 {
+            return None;
+        }
+        let i = states.trailing_zeros() as usize;
+        match &self.steps[i] {
+            Step::Child(name) => Some((i, name)),
+            _ => None,
+        }
+    }
+
+    fn visit_root<'a>(&self, root: &'a Object, raw: u64, out: &mut Vec<&'a Value>) {
+        let states = self.settle(raw, None, Content::Object(root)).unwrap();
+        self.visit_object(root, states & !self.accept, out);
+    }
+
+    fn visit<'a>(&self, value: &'a Value, raw: u64, out: &mut Vec<&'a Value>) {
+        let content = match &value.payload {
+            Some(Payload::Object(obj)) => Content::Object(obj),
+            _ => Content::Other,
+        };
+        let states = self.settle(raw, value.tag_name(), content).unwrap();
+        if states & self.accept != 0 {
+            out.push(value);
+        }
+        let states = states & !self.accept;
+        if states == 0 {
+            return;
+        }
+        match &value.payload {
+            Some(Payload::Object(obj)) => self.visit_object(obj, states, out),
+            Some(Payload::Sequence(seq)) => {
+                if let Some((i, &Name::Index(index))) = self.only_child(states) {
+                    if let Some(item) = seq.get(index) {
+                        self.visit(item, 1 << (i + 1), out);
+                    }
+                    return;
+                }
+                for (index, item) in seq.items.iter().enumerate() {
+                    let next = self.item_states(states, index);
+                    if next != 0 {
+                        self.visit(item, next, out);
+                    }
+                }
+            }
+            _ => {}
+        }
+    }
+
+    fn visit_object<'a>(&self, obj: &'a Object, states: u64, out: &mut Vec<&'a Value>) {
+        if states == 0 {
+            return;
+        }
+        // A plain key step is a lookup, which uses the object's index. Like
+        // the scan below and the streamed path, it visits every entry with
+        // the key, so later duplicates are collected unless the index (built
+        // by the lookup for wide objects) shows there are none.
+        if let Some((i, Name::Key { key, hash })) = self.only_child(states) {
+            let Some(first) = obj.position_hashed(key, *hash) else {
+                return;
+            };
+            let entries = obj.entries();
+            if obj.keys_are_unique() {
+                self.visit(&entries[first].value, 1 << (i + 1), out);
+                return;
+            }
+            for entry in &entries[first..] {
+                if entry.key.as_str() == Some(&**key) {
+                    self.visit(&entry.value, 1 << (i + 1), out);
+                }
+            }
+            return;
+        }
+        for entry in obj.entries() {
+            let next = self.entry_states(states, entry.key.as_str());
+            if next != 0 {
+                self.visit(&entry.value, next, out);
+            }
+        }
+    }
+}
+
+struct Compiler<'a> {
+    text: &'a str,
+    pos: usize,
+    steps: Vec<Step>,
+}
+
+impl<'a> Compiler<'a> {
+    fn run(mut self) -> Result<Selector, SelectorError> {
+        if !self.text.is_empty() && !self.at(".") && !self.at("[") {
+            self.segment(false)?;
+        }
+        while self.pos < self.text.len() {
+            if self.eat("..") {
+                self.segment(true)?;
+            } else if self.eat(".") {
+                self.segment(false)?;
+            } else if self.at("[") {
+                self.bracket(false)?;
+            } else {
+                return Err(self.error("expected `.`, `..` or `[`"));
+            }
+        }
+        if self.steps.len() > MAX_STEPS {
+            return Err(SelectorError {
+                message: format!("more than {MAX_STEPS} steps"),
+                offset: 0,
+            });
+        }
+
+        let mut filters = 0;
+        let mut descend = 0;
+        for (i, step) in self.steps.iter().enumerate() {
+            match step {
+                Step::Tag(_) | Step::Field { .. } => filters |= 1 << i,
+                Step::Descendant(_) => descend |= 1 << i,
+                Step::Child(_) => {}
+            }
+        }
+        Ok(Selector {
+            accept: 1 << self.steps.len(),
+            steps: self.steps.into_boxed_slice(),
+            filters,
+            descend,
+        })
+    }
+
+    /// A step after `.` (or `..` if `descend`), or at the start.
+    fn segment(&mut self, descend: bool) -> Result<(), SelectorError> {
+        if self.at("[") {
+            if !descend {
+                return Err(self.error("expected a name or `*`"));
+            }
+            return self.bracket(true);
+        }
+        let name = if self.eat("*") {
+            Name::Any
+        } else {
+            let key = self.name()?;
+            Name::Key {
+                hash: key_hash(&key),
+                key: key.into(),
+            }
+        };
+        self.push(descend, name);
+        Ok(())
+    }
+
+    /// A bracketed index, wildcard or filter, after `..` if `descend`.
+    fn bracket(&mut self, descend: bool) -> Result<(), SelectorError> {
+        self.eat("[");
+        let digits = self.text[self.pos..]
+            .bytes()
+            .take_while(u8::is_ascii_digit)
+            .count();
+        if self.eat("*") {
+            self.push(descend, Name::Any);
+        } else if digits > 0 {
+            let index = self.text[self.pos..self.pos + digits]
+                .parse()
+                .map_err(|_| self.error("index out of range"))?;
+            self.pos += digits;
+            self.push(descend, Name::Index(index));
+        } else {
+            // A filter after `..` applies to every descendant.
+            if descend {
+                self.push(true, Name::Any);
+            }
+            if self.eat("@") {
+                let mut name = self.name()?;
+                if name == "tag" && self.eat("=") {
+                    name = self.name()?;
+                }
+                self.steps.push(Step::Tag(name.into()));
+            } else {
+                let key = self.name()?;
+                if !self.eat("=") {
+                    return Err(self.error("expected `=`"));
+                }
+                let value = self.name()?;
+                self.steps.push(Step::Field {
+                    hash: key_hash(&key),
+                    key: key.into(),
+                    value: value.into(),
+                });
+            }
+        }
+        if !self.eat("]") {
+            return Err(self.error("expected `]`"));
+        }
+        Ok(())
+    }
+
+    /// A bare or quoted name.
+    fn name(&mut self) -> Result<Cow<'a, str>, SelectorError> {
+        let text = self.text;
+        let rest = &text[self.pos..];
+        if let Some(quoted) = rest.strip_prefix('"') {
+            let mut name = String::new();
+            let mut chars = quoted.char_indices();
+            while let Some((i, c)) = chars.next() {
+                match c {
+                    '"' => {
+                        self.pos += i + 2;
+                        return Ok(Cow::Owned(name));
+                    }
+                    '\\' => match chars.next() {
+                        Some((_, c)) => name.push(c),
+                        None => break,
+                    },
+                    c => name.push(c),
+                }
+            }
+            return Err(self.error("unterminated quoted name"));
+        }
+        let len = rest
+            .find(|c: char| c.is_whitespace() || ".[]*=\"@".contains(c))
+            .unwrap_or(rest.len());
+        if len == 0 {
+            return Err(self.error("expected a name"));
+        }
+        self.pos += len;
+        Ok(Cow::Borrowed(&text[self.pos - len..self.pos]))
+    }
+
+    fn push(&mut self, descend: bool, name: Name) {
+        self.steps.push(match descend {
+            true => Step::Descendant(name),
+            false => Step::Child(name),
+        });
+    }
+
+    fn at(&self, s: &str) -> bool {
+        self.text[self.pos..].starts_with(s)
+    }
+
+    fn eat(&mut self, s: &str) -> bool {
+        let found = self.at(s);
+        if found {
+            self.pos += s.len();
+        }
+        found
+    }
+
+    fn error(&self, message: &str) -> SelectorError {
+        SelectorError {
+            message: message.to_string(),
+            offset: self.pos,
+        }
+    }
+}
+
+/// Runs a [`Selector`] over the parse events of one document.
+///
+/// Feed it every event with [`event`](Self::event), then call
+/// [`finish`](Self::finish) for the matched values, in document order.
+/// Values are only built when they match (or hold a match and are needed
+/// for a `[key=value]` filter), so memory stays proportional to the
+/// results rather than the document.
+///
+/// Returns the same values as [`Selector::select`] on the parsed document.
+pub struct EventSelector<'s> {
+    selector: &'s Selector,
+    stack: Vec<Frame>,
+    rooted: bool,
+    error: Option<BuildError>,
+    matches: Vec<Value>,
+}
+
+enum Frame {
+    /// An object whose entries are reached from `states`.
+    Object {
+        states: u64,
+    },
+    Entry {
+        /// States of the enclosing object.
+        states: u64,
+        /// States of the entry's value, once the key is known.
+        child: Option<u64>,
+        value: bool,
+    },
+    Sequence {
+        states: u64,
+        next: usize,
+    },
+    /// A tag whose payload has `states`.
+    Tag {
+        states: u64,
+        payload: bool,
+        /// Tags directly inside this one, which the tree drops.
+        nested: u32,
+    },
+    /// A value nothing below can match.
+    Skip {
+        depth: u32,
+    },
+    /// A value being built, to be matched from `states` when it closes.
+    Buffer {
+        builder: Box<TreeBuilder>,
+        states: u64,
+        depth: u32,
+        root: bool,
+    },
+}
+
+impl<'s> EventSelector<'s> {
+    /// Create an event selector for one document.
+    pub fn new(selector: &'s Selector) -> Self {
+        EventSelector {
+            selector,
+            stack: Vec::new(),
+            rooted: false,
+            error: None,
+            matches: Vec::new(),
+        }
+    }
+
+    /// Process the next event. After a parse error, later events are
+    /// ignored.
+    pub fn event(&mut self, event: &Event<'_>) {
+        if self.error.is_some() {
+            return;
+        }
+        let span = event.span;
+        if let EventKind::Error { kind } = &event.kind {
+            self.error = Some(BuildError::Parse(kind.clone(), span));
+            return;
+        }
+        if let Some(Frame::Buffer { builder, depth, .. }) = self.stack.last_mut() {
+            builder.event(event.clone());
+            *depth = depth.wrapping_add_signed(nesting(&event.kind));
+            if *depth == 0 {
+                self.close_buffer();
+            }
+            return;
+        }
+        if let EventKind::DocumentStart
+        | EventKind::DocumentEnd
+        | EventKind::Comment { .. }
+        | EventKind::DocComment { .. } = event.kind
+        {
+            return;
+        }
+
+        let selector = self.selector;
+        let Some(top) = self.stack.last_mut() else {
+            if matches!(event.kind, EventKind::ObjectStart) && !self.rooted {
+                self.rooted = true;
+                match selector.settle(1, None, Content::Unknown) {
+                    Some(states) => self.stack.push(Frame::Object {
+                        states: states & !selector.accept,
+                    }),
+                    None => self.buffer(1, event, true),
+                }
+            }
+            return;
+        };
+        match top {
+            Frame::Skip { depth } => {
+                *depth = depth.wrapping_add_signed(nesting(&event.kind));
+                if *depth == 0 {
+                    self.stack.pop();
+                }
+            }
+            Frame::Buffer { .. } => unreachable!("handled above"),
+            &mut Frame::Object { states } => match event.kind {
+                EventKind::EntryStart => self.stack.push(Frame::Entry {
+                    states,
+                    child: None,
+                    value: false,
+                }),
+                EventKind::ObjectEnd => {
+                    self.stack.pop();
+                }
+                _ => {
+                    let child = selector.entry_states(states, None);
+                    self.value(child, event);
+                }
+            },
+            Frame::Entry {
+                states,
+                child,
+                value,
+            } => match &event.kind {
+                EventKind::Key { tag, payload, .. } => {
+                    let key = if tag.is_none() {
+                        payload.as_deref()
+                    } else {
+                        None
+                    };
+                    *child = Some(selector.entry_states(*states, key));
+                }
+                EventKind::EntryEnd => {
+                    let (child, value) = (*child, *value);
+                    self.stack.pop();
+                    // A key with no value has a unit value.
+                    if let Some(child) = child
+                        && !value
+                        && selector
+                            .settle(child, None, Content::Other)
+                            .is_some_and(|s| s & selector.accept != 0)
+                    {
+                        self.matches.push(Value::unit());
+                    }
+                }
+                _ => {
+                    let states = child.unwrap_or_else(|| selector.entry_states(*states, None));
+                    *value = true;
+                    self.value(states, event);
+                }
+            },
+            Frame::Sequence { states, next } => match event.kind {
+                EventKind::SequenceEnd => {
+                    self.stack.pop();
+                }
+                _ => {
+                    let states = selector.item_states(*states, *next);
+                    *next += 1;
+                    self.value(states, event);
+                }
+            },
+            Frame::Tag {
+                states,
+                payload,
+                nested,
+            } => match event.kind {
+                EventKind::TagStart { .. } if !*payload => *nested += 1,
+                EventKind::TagEnd if *nested > 0 => *nested -= 1,
+                EventKind::TagEnd => {
+                    self.stack.pop();
+                }
+                // The tree treats `@tag @` as a bare tag.
+                EventKind::Unit => {}
+                _ => {
+                    *payload = true;
+                    let states = *states;
+                    self.settled(states, event);
+                }
+            },
+        }
+    }
+
+    /// Finish the document: the matched values, or the first parse error.
+    pub fn finish(self) -> Result<Vec<Value>, BuildError> {
+        if let Some(error) = self.error {
+            return Err(error);
+        }
+        if !self.stack.is_empty() {
+            return Err(BuildError::UnclosedStructure);
+        }
+        Ok(self.matches)
+    }
+
+    /// Start a value reached with `states`, before its filters.
+    fn value(&mut self, states: u64, event: &Event<'_>) {
+        if states == 0 {
+            return self.settled(0, event);
+        }
+        let (tag, content) = match &event.kind {
+            EventKind::TagStart { name } => (Some(&**name), Content::Unknown),
+            EventKind::ObjectStart => (None, Content::Unknown),
+            _ => (None, Content::Other),
+        };
+        match self.selector.settle(states, tag, content) {
+            Some(settled) if settled & self.selector.accept == 0 => self.settled(settled, event),
+            _ => self.buffer(states, event, false),
+        }
+    }
+
+    /// Start a value that has passed its filters and is not a match.
+    fn settled(&mut self, states: u64, event: &Event<'_>) {
+        let frame = match event.kind {
+            _ if states == 0 => match nesting(&event.kind) {
+                1 => Frame::Skip { depth: 1 },
+                _ => return,
+            },
+            EventKind::ObjectStart => Frame::Object { states },
+            EventKind::SequenceStart => Frame::Sequence { states, next: 0 },
+            EventKind::TagStart { .. } => Frame::Tag {
+                states,
+                payload: false,
+                nested: 0,
+            },
+            _ => return,
+        };
+        self.stack.push(frame);
+    }
+
+    /// Build the value starting at `event`, then match it from `states`.
+    fn buffer(&mut self, states: u64, event: &Event<'_>, root: bool) {
+        // Build the value as the sole entry of a synthetic root, so it gets
+        // the same shape and spans as in a full parse.
+        let mut builder = Box::new(TreeBuilder::new());
+        if !root {
+            let span = Span { start: 0, end: 0 };
+            for kind in [
+                EventKind::ObjectStart,
+                EventKind::EntryStart,
+                EventKind::Key {
+                    tag: None,
+                    payload: None,
+                    kind: ScalarKind::Bare,
+                },
+            ] {
+                builder.event(Event { span, kind });
+            }
+        }
+        builder.event(event.clone());
+        self.stack.push(Frame::Buffer {
+            builder,
+            states,
+            depth: 1,
+            root,
+        });
+        if nesting(&event.kind) == 0 {
+            self.close_buffer();
+        }
+    }
+
+    fn close_buffer(&mut self) {
+        let Some(Frame::Buffer {
+            mut builder,
+            states,
+            root,
+            ..
+        }) = self.stack.pop()
+        else {
+            return;
+        };
+        if !root {
+            let span = Span { start: 0, end: 0 };
+            for kind in [EventKind::EntryEnd, EventKind::ObjectEnd] {
+                builder.event(Event { span, kind });
+            }
+        }
+        let built = match builder.finish() {
+            Ok(value) => value,
+            Err(error) => {
+                self.error = Some(error);
+                return;
+            }
+        };
+        let Some(Payload::Object(mut obj)) = built.payload else {
+            return;
+        };
+        let mut found = Vec::new();
+        if root {
+            self.selector.visit_root(&obj, states, &mut found);
+        } else if let Some(entry) = obj.entries().first() {
+            self.selector.visit(&entry.value, states, &mut found);
+            // Usually the value itself is the one match: move it out.
+            if let [only] = found[..]
+                && std::ptr::eq(only, &entry.value)
+            {
+                self.matches.push(obj.entries_mut().swap_remove(0).value);
+                return;
+            }
+        }
+        self.matches.extend(found.into_iter().cloned());
+    }
+}
+
+/// How an event changes the nesting depth of values.
+fn nesting(kind: &EventKind) -> i32 {
+    match kind {
+        EventKind::ObjectStart | EventKind::SequenceStart | EventKind::TagStart { .. } => 1,
+        EventKind::ObjectEnd | EventKind::SequenceEnd | EventKind::TagEnd => -1,
+        _ => 0,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const SOURCE: &str = r#"name app
+hosts (
+  {name web, port 80, timeout @duration"5s"}
+  {name db, port 5432, timeout @duration"30s", tags (a b)}
+  {name cache, port 6379, retry {timeout @duration"1s"}}
+)
+limits {port 1024, "odd.key" 1}
+flag
+"#;
+
+    fn texts(values: &[&Value]) -> Vec<String> {
+        values
+            .iter()
+            .map(|v| match v.scalar_text() {
+                Some(text) => text.to_string(),
+                None => format!("{v:?}"),
+            })
+            .collect()
+    }
+
+    fn select(selector: &str) -> Vec<String> {
+        let doc = Document::parse(SOURCE).unwrap();
+        let selector = Selector::compile(selector).unwrap();
+        let found = selector.select(&doc);
+        let streamed = selector.select_source(SOURCE).unwrap();
+        assert_eq!(
+            streamed.iter().collect::<Vec<_>>(),
+            found,
+            "streamed {selector:?}"
+        );
+        texts(&found)
+    }
+
+    #[test]
+    fn test_paths_and_wildcards() {
+        assert_eq!(select("name"), ["app"]);
+        assert_eq!(select("hosts[1].port"), ["5432"]);
+        assert_eq!(select("hosts[*].port"), ["80", "5432", "6379"]);
+        assert_eq!(select("hosts.*.name"), ["web", "db", "cache"]);
+        assert_eq!(select("hosts[*].tags[*]"), ["a", "b"]);
+        assert_eq!(select("limits.\"odd.key\""), ["1"]);
+        assert_eq!(select("*.port"), ["1024"]);
+        assert_eq!(select("hosts[3]"), Vec::<String>::new());
+        let doc = Document::parse(SOURCE).unwrap();
+        let flag = Selector::compile("flag").unwrap().select(&doc);
+        assert!(flag.len() == 1 && flag[0].is_unit());
+        assert_eq!(select("flag").len(), 1);
+    }
+
+    #[test]
+    fn test_duplicate_keys_match_every_entry() {
+        // Parsing rejects duplicate keys, so build them by pushing entries
+        // and stream the source with its error events skipped.
+        let check = |source: &str, extra: &[(&str, &str)], selector: &str, expected: &[&str]| {
+            let mut doc = Document::parse(source).unwrap();
+            let mut text = source.to_string();
+            for (key, value) in extra {
+                doc.root.push(crate::Entry {
+                    key: Value::scalar(*key),
+                    value: Value::scalar(*value),
+                    doc_comment: None,
+                });
+                text.push_str(&format!("\n{key} {value}"));
+            }
+            let selector = Selector::compile(selector).unwrap();
+            let found = selector.select(&doc);
+            assert_eq!(texts(&found), expected, "{selector:?}");
+
+            let mut parser = Parser::new(&text);
+            let mut events = EventSelector::new(&selector);
+            while let Some(event) = parser.next_event() {
+                if !matches!(event.kind, EventKind::Error { .. }) {
+                    events.event(&event);
+                }
+            }
+            let streamed = events.finish().unwrap();
+            let streamed: Vec<_> = streamed.iter().collect();
+            assert_eq!(texts(&streamed), expected, "streamed {selector:?}");
+        };
+        check("a 1\nb 2", &[("a", "3")], "a", &["1", "3"]);
+        check("a 1\nb 2", &[("b", "3"), ("b", "4")], "b", &["2", "3", "4"]);
+
+        // Wide objects go through the index, with and without duplicates.
+        let wide: String = (0..40).map(|i| format!("k{i} {i}\n")).collect();
+        check(&wide, &[], "k7", &["7"]);
+        check(&wide, &[("k7", "again")], "k7", &["7", "again"]);
+    }
+
+    #[test]
+    fn test_recursive_descent() {
+        assert_eq!(select("..port"), ["80", "5432", "6379", "1024"]);
+        assert_eq!(select("hosts..timeout"), ["5s", "30s", "1s"]);
+        assert_eq!(select("..retry..timeout"), ["1s"]);
+        // Overlapping descents still report each value once.
+        assert_eq!(select("..hosts..port"), ["80", "5432", "6379"]);
+        // `hosts[1]`, then the `b` inside it.
+        let second = select("..[1]");
+        assert_eq!(second.len(), 2);
+        assert_eq!(second[1], "b");
+    }
+
+    #[test]
+    fn test_filters() {
+        assert_eq!(select("..[@tag=duration]"), ["5s", "30s", "1s"]);
+        assert_eq!(select("hosts[*].timeout[@duration]"), ["5s", "30s"]);
+        assert_eq!(select("hosts[*].timeout[@other]"), Vec::<String>::new());
+        assert_eq!(select("hosts[*][name=db].port"), ["5432"]);
+        assert_eq!(select("hosts[*][name=db][port=5432].tags[0]"), ["a"]);
+        assert_eq!(select("hosts[*][name=nope]"), Vec::<String>::new());
+        // Root filters see the whole document.
+        assert_eq!(select("[name=app].limits.port"), ["1024"]);
+        assert_eq!(select("[name=other].limits.port"), Vec::<String>::new());
+    }
+
+    #[test]
+    fn test_select_value() {
+        let doc = Document::parse(SOURCE).unwrap();
+        let hosts = doc.get("hosts").unwrap();
+        let found = Selector::compile("[*].name").unwrap().select_value(hosts);
+        assert_eq!(texts(&found), ["web", "db", "cache"]);
+        assert_eq!(Selector::compile("").unwrap().select_value(hosts), [hosts]);
+        assert!(Selector::compile("").unwrap().select(&doc).is_empty());
+    }
+
+    #[test]
+    fn test_stream_matches_tree_on_corpus() {
+        let selectors = ["..*", "..[@tag=string]", "*", "..name", "*[*]..*"]
+            .map(|s| Selector::compile(s).unwrap());
+        let dir = std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../../compliance/corpus");
+        let Ok(groups) = std::fs::read_dir(&dir) else {
+            return;
+        };
+        for group in groups.flatten() {
+            for file in std::fs::read_dir(group.path())
+                .into_iter()
+                .flatten()
+                .flatten()
+            {
+                let Ok(source) = std::fs::read_to_string(file.path()) else {
+                    continue;
+                };
+                for selector in &selectors {
+                    match (Document::parse(&source), selector.select_source(&source)) {
+                        (Ok(doc), Ok(streamed)) => assert_eq!(
+                            streamed.iter().collect::<Vec<_>>(),
+                            selector.select(&doc),
+                            "{:?} on {:?}",
+                            selector,
+                            file.path()
+                        ),
+                        (Err(a), Err(b)) => assert_eq!(a, b, "{:?}", file.path()),
+                        (a, b) => panic!("{:?}: tree {a:?}, stream {b:?}", file.path()),
+                    }
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn test_errors() {
+        for (selector, offset) in [
+            ("a..", 3),
+            ("a.[0]", 2),
+            ("a[", 2),
+            ("a[0", 3),
+            ("a[k]", 3),
+            ("a[@]", 3),
+            ("a b", 1),
+            ("\"open", 0),
+        ] {
+            let error = Selector::compile(selector).unwrap_err();
+            assert_eq!(error.offset, offset, "{selector:?}: {error}");
+        }
+        let long = format!("{}a", "a.".repeat(MAX_STEPS));
+        assert!(
+            Selector::compile(&long)
+                .unwrap_err()
+                .message
+                .contains("steps")
+        );
+        let broken = "a {b";
+        assert_eq!(
+            Selector::compile("a").unwrap().select_source(broken),
+            Err(Document::parse(broken).unwrap_err())
+        );
+    }
+}
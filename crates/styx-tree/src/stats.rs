@@ -0,0 +1,206 @@
+//! Per-phase counters and timings for a parse.
+//!
+//! [`Document::parse`] interleaves its phases: the builder pulls events from
+//! the parser, which pulls lexemes from the lexer, which pulls tokens from
+//! the tokenizer. [`Document::parse_with_stats`] instead runs them as
+//! separate passes over the source, so each phase can be timed on its own
+//! without putting clocks or counters in the hot loops. The normal parse
+//! paths are untouched, and cost nothing extra.
+//!
+//! The numbers are estimates, not a profile. Each pass repeats the ones
+//! before it, so a phase's time is the difference between two passes, and
+//! the passes run without the interleaving (and cache effects) of a real
+//! parse. Allocation counts are taken by walking the finished document: they
+//! are the heap blocks it retains, not every call the parse made to the
+//! allocator, so scratch buffers and blocks that were grown and freed along
+//! the way are not included.
+
+use std::time::{Duration, Instant};
+
+use styx_parse::{Lexer, Parser, Tokenizer};
+use tracing::debug_span;
+
+use crate::{BuildError, Document, Entry, Object, Payload, TreeBuilder, Value};
+
+/// What a parse did and where its time went (see
+/// [`Document::parse_with_stats`]).
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ParseStats {
+    /// Length of the source in bytes.
+    pub bytes: usize,
+    /// Tokens produced by the tokenizer, including whitespace and comments.
+    pub tokens: usize,
+    /// Lexemes produced by the lexer.
+    pub lexemes: usize,
+    /// Events produced by the parser.
+    pub events: usize,
+    /// Values in the document, counting keys and the root.
+    pub nodes: usize,
+    /// Heap blocks the finished document retains: strings and entry or item
+    /// lists. Temporary allocations made during the parse are not counted.
+    pub allocations: usize,
+    /// Total capacity of those blocks in bytes.
+    pub allocated_bytes: usize,
+    /// Time spent tokenizing.
+    pub tokenize_time: Duration,
+    /// Estimated time spent turning tokens into lexemes: a lexing pass less
+    /// a tokenizing pass.
+    pub lex_time: Duration,
+    /// Estimated time spent turning lexemes into events: a parsing pass less
+    /// a lexing pass.
+    pub parse_time: Duration,
+    /// Time spent building the tree from already-parsed events.
+    pub build_time: Duration,
+}
+
+impl ParseStats {
+    /// Time spent in all phases.
+    pub fn total_time(&self) -> Duration {
+        self.tokenize_time + self.lex_time + self.parse_time + self.build_time
+    }
+}
+
+impl Document {
+    /// Parse a Styx document, recording what each phase of the parse did.
+    ///
+    /// Returns the same document or error as [`Document::parse`], with stats
+    /// either way (node and allocation counts are zero on error). The source
+    /// is tokenized three times to time the phases separately, so this takes
+    /// two to three times as long as a plain parse. The stats are estimates:
+    /// the lexing and parsing times are one pass less the pass before it, and
+    /// the allocation counts are the heap blocks the finished document
+    /// retains, not every allocation the parse made. Each phase also runs in
+    /// a `tracing` span, and the stats are logged at debug level.
+    pub fn parse_with_stats(source: &str) -> (Result<Self, BuildError>, ParseStats) {
+        let mut stats = ParseStats {
+            bytes: source.len(),
+            ..ParseStats::default()
+        };
+
+        let start = Instant::now();
+        stats.tokens = debug_span!("tokenize").in_scope(|| Tokenizer::new(source).count());
+        let tokenized = start.elapsed();
+
+        let start = Instant::now();
+        stats.lexemes = debug_span!("lex").in_scope(|| Lexer::new(source).count());
+        let lexed = start.elapsed();
+
+        let start = Instant::now();
+        let events = debug_span!("parse").in_scope(|| Parser::new(source).parse_to_vec());
+        let parsed = start.elapsed();
+        stats.events = events.len();
+
+        // Each pass repeats the ones before it; subtract them back out.
+        stats.tokenize_time = tokenized;
+        stats.lex_time = lexed.saturating_sub(tokenized);
+        stats.parse_time = parsed.saturating_sub(lexed);
+
+        let start = Instant::now();
+        let result = debug_span!("build").in_scope(|| {
+            let mut builder = TreeBuilder::new();
+            for event in events {
+                builder.event(event);
+            }
+            Document::from_root_value(builder.finish()?)
+        });
+        stats.build_time = start.elapsed();
+
+        if let Ok(doc) = &result {
+            let mut counter = Counter::default();
+            counter.object(&doc.root);
+            stats.nodes = counter.nodes + 1;
+            stats.allocations = counter.allocations;
+            stats.allocated_bytes = counter.bytes;
+        }
+
+        tracing::debug!(?stats, "parsed document");
+        (result, stats)
+    }
+}
+
+/// Tallies nodes and heap blocks in a tree.
+#[derive(Default)]
+struct Counter {
+    nodes: usize,
+    allocations: usize,
+    bytes: usize,
+}
+
+impl Counter {
+    fn block(&mut self, capacity: usize, size: usize) {
+        if capacity > 0 && size > 0 {
+            self.allocations += 1;
+            self.bytes += capacity * size;
+        }
+    }
+
+    fn string(&mut self, text: &String) {
+        self.block(text.capacity(), 1);
+    }
+
+    fn object(&mut self, obj: &Object) {
+        self.block(obj.capacity(), size_of::<Entry>());
+        for entry in obj.entries() {
+            self.value(&entry.key);
+            self.value(&entry.value);
+            if let Some(doc) = &entry.doc_comment {
+                self.string(doc);
+            }
+        }
+    }
+
+    fn value(&mut self, value: &Value) {
+        self.nodes += 1;
+        if let Some(tag) = &value.tag {
+            self.string(&tag.name);
+        }
+        match &value.payload {
+            Some(Payload::Scalar(scalar)) => self.string(&scalar.text),
+            Some(Payload::Sequence(seq)) => {
+                self.block(seq.items.capacity(), size_of::<Value>());
+                for item in &seq.items {
+                    self.value(item);
+                }
+            }
+            Some(Payload::Object(obj)) => self.object(obj),
+            None => {}
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_counts() {
+        let source = "a 1\nb (x @t\"y z\")";
+        let (doc, stats) = Document::parse_with_stats(source);
+        assert_eq!(doc.unwrap(), Document::parse(source).unwrap());
+        assert_eq!(stats.bytes, source.len());
+        assert_eq!(stats.tokens, Tokenizer::new(source).count());
+        assert_eq!(stats.lexemes, Lexer::new(source).count());
+        assert_eq!(stats.events, Parser::new(source).parse_to_vec().len());
+        // Root, two keys, `1`, the sequence and its two items.
+        assert_eq!(stats.nodes, 7);
+        // Root entries, `b`'s items, and the strings a, 1, b, x, t and `y z`.
+        assert_eq!(stats.allocations, 8);
+        assert!(stats.allocated_bytes > 2 * size_of::<Entry>());
+        assert_eq!(
+            stats.total_time(),
+            stats.tokenize_time + stats.lex_time + stats.parse_time + stats.build_time
+        );
+    }
+
+    #[test]
+    fn test_errors_keep_front_end_counts() {
+        let source = "a {b 1";
+        let (doc, stats) = Document::parse_with_stats(source);
+        assert_eq!(
+            doc.map_err(|e| e.to_string()),
+            Document::parse(source).map_err(|e| e.to_string())
+        );
+        assert!(stats.tokens > 0 && stats.events > 0);
+        assert_eq!((stats.nodes, stats.allocations), (0, 0));
+    }
+}
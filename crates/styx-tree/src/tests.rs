@@ -49,7 +49,7 @@ fn test_schema_tree_structure() {
 
     // schema has one entry with a unit key
     assert_eq!(schema_obj.len(), 1);
-    let entry = &schema_obj.entries[0];
+    let entry = &schema_obj.entries()[0];
 
     // Key is unit (@ as a key means unit key)
     assert!(
@@ -78,7 +78,7 @@ fn test_schema_tree_structure() {
     assert_eq!(payload_obj.len(), 1);
 
     // "name" entry
-    let name_entry = &payload_obj.entries[0];
+    let name_entry = &payload_obj.entries()[0];
     assert_eq!(name_entry.key.as_str(), Some("name"));
 
     // Value is tagged with "string", no payload
@@ -92,3 +92,37 @@ fn test_schema_tree_structure() {
         "@string should have no payload"
     );
 }
+
+#[test]
+fn test_document_build_indexes() {
+    let mut source = String::from("routes {\n");
+    for i in 0..100 {
+        source.push_str(&format!("  r{i} {{target t{i}}}\n"));
+    }
+    source.push_str("}\nname small\n");
+    let doc = Document::parse(&source).unwrap();
+    doc.build_indexes();
+
+    let routes = doc.root.get("routes").and_then(|v| v.as_object()).unwrap();
+    assert!(routes.has_index());
+    assert!(!doc.root.has_index());
+    assert_eq!(
+        doc.get("routes.r42.target").and_then(|v| v.as_str()),
+        Some("t42")
+    );
+}
+
+#[test]
+fn test_build_indexes_leaves_lazy_objects_unparsed() {
+    let mut source = String::from("name small\n");
+    for i in 0..100 {
+        source.push_str(&format!("r{i} {{target t{i}}}\n"));
+    }
+    let doc = Document::parse_lazy(&source).unwrap();
+    doc.build_indexes();
+
+    assert!(doc.root.has_index());
+    let route = doc.root.get("r42").and_then(|v| v.as_object()).unwrap();
+    assert!(route.is_deferred());
+    assert_eq!(doc.get("r42.target").and_then(|v| v.as_str()), Some("t42"));
+}
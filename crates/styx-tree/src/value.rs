@@ -11,8 +11,15 @@
 //! - `@seq(a b)` is `Value { tag: Some("seq"), payload: Some(Payload::Sequence(...)) }`
 //! - `@object{...}` is `Value { tag: Some("object"), payload: Some(Payload::Object(...)) }`
 
+use std::sync::Arc;
+
 use styx_parse::{ScalarKind, Span};
 
+use crate::BuildError;
+use crate::hash::SubtreeHash;
+use crate::index::{KeyIndex, key_hash};
+use crate::lazy::Deferred;
+
 /// A Styx value: optional tag + optional payload.
 #[derive(Debug, Clone, PartialEq)]
 #[cfg_attr(feature = "facet", derive(facet::Facet))]
@@ -75,14 +82,48 @@ pub struct Sequence {
 }
 
 /// An object (mapping of keys to values).
-#[derive(Debug, Clone, PartialEq)]
+///
+/// Objects with many entries lazily build a hashed key index on first lookup
+/// (see [`INDEX_THRESHOLD`](crate::INDEX_THRESHOLD)), and every object caches
+/// its [`subtree_hash`](Object::subtree_hash). The entries are only reachable
+/// through methods, so both caches are always current: every mutable path,
+/// including [`Object::entries_mut`], drops them, and reaching a nested
+/// object mutably goes through each of its ancestors.
+///
+/// Objects from [`Document::parse_lazy`](crate::Document::parse_lazy) are
+/// parsed on first read; the accessors do that transparently.
+#[derive(Clone, Default)]
 #[cfg_attr(feature = "facet", derive(facet::Facet))]
 #[cfg_attr(feature = "facet", facet(skip_all_unless_truthy))]
 pub struct Object {
-    /// Entries in the object.
-    pub entries: Vec<Entry>,
+    /// Entries in the object (see [`Object::entries`]).
+    entries: Vec<Entry>,
     /// Source span.
     pub span: Option<Span>,
+    /// Lazily built key index.
+    #[cfg_attr(feature = "facet", facet(skip, opaque))]
+    index: KeyIndex,
+    /// Cached structural hash.
+    #[cfg_attr(feature = "facet", facet(skip, opaque))]
+    hash: SubtreeHash,
+    /// Source of a lazily parsed object.
+    #[cfg_attr(feature = "facet", facet(skip, opaque))]
+    deferred: Option<Arc<Deferred>>,
+}
+
+impl std::fmt::Debug for Object {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("Object")
+            .field("entries", &self.entries())
+            .field("span", &self.span)
+            .finish()
+    }
+}
+
+impl PartialEq for Object {
+    fn eq(&self, other: &Self) -> bool {
+        self.entries() == other.entries() && self.span == other.span
+    }
 }
 
 /// An entry in an object.
@@ -170,11 +211,7 @@ impl Value {
     pub fn object() -> Self {
         Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: Vec::new(),
-
-                span: None,
-            })),
+            payload: Some(Payload::Object(Object::new(Vec::new(), None))),
             span: None,
         }
     }
@@ -224,7 +261,11 @@ impl Value {
     /// Get as mutable object (payload only).
     pub fn as_object_mut(&mut self) -> Option<&mut Object> {
         match &mut self.payload {
-            Some(Payload::Object(o)) => Some(o),
+            Some(Payload::Object(o)) => {
+                o.materialize();
+                o.hash = SubtreeHash::default();
+                Some(o)
+            }
             _ => None,
         }
     }
@@ -258,6 +299,9 @@ impl Value {
     ///
     /// Path segments are separated by `.`.
     /// Use `[n]` for sequence indexing.
+    ///
+    /// For paths that are looked up repeatedly, [`Path`](crate::Path) avoids
+    /// re-parsing the path string each time.
     pub fn get(&self, path: &str) -> Option<&Value> {
         if path.is_empty() {
             return Some(self);
@@ -328,25 +372,161 @@ impl Value {
 }
 
 impl Object {
+    /// Create an object from entries.
+    pub fn new(entries: Vec<Entry>, span: Option<Span>) -> Self {
+        Object {
+            entries,
+            span,
+            index: KeyIndex::default(),
+            hash: SubtreeHash::default(),
+            deferred: None,
+        }
+    }
+
+    /// A lazily parsed object whose entries are the `{...}` block at `span`.
+    pub(crate) fn deferred(source: Arc<str>, span: Span) -> Self {
+        Object {
+            deferred: Some(Arc::new(Deferred::new(source, span))),
+            ..Object::new(Vec::new(), Some(span))
+        }
+    }
+
+    /// The object's entries, parsing them first if the object is lazy.
+    ///
+    /// A lazy object whose source fails to parse has no entries; see
+    /// [`Object::try_entries`].
+    pub fn entries(&self) -> &[Entry] {
+        self.try_entries().unwrap_or(&[])
+    }
+
+    /// Like [`Object::entries`], but reports the error if the object is lazy
+    /// and its source fails to parse.
+    pub fn try_entries(&self) -> Result<&[Entry], &BuildError> {
+        match &self.deferred {
+            Some(deferred) => deferred.entries(),
+            None => Ok(&self.entries),
+        }
+    }
+
+    /// Whether this is a lazy object that has not been parsed yet.
+    pub fn is_deferred(&self) -> bool {
+        self.deferred.as_ref().is_some_and(|d| !d.is_built())
+    }
+
+    /// Mutable access to the entries, parsing them first if the object is
+    /// lazy.
+    ///
+    /// Drops the key index and the cached hash, which are rebuilt on demand.
+    /// Prefer [`Object::insert`] and [`Object::push`] for appending, which
+    /// keep the index.
+    pub fn entries_mut(&mut self) -> &mut Vec<Entry> {
+        self.materialize();
+        self.invalidate_index();
+        &mut self.entries
+    }
+
+    /// Number of entries the object has room for without reallocating.
+    pub(crate) fn capacity(&self) -> usize {
+        self.entries.capacity()
+    }
+
+    /// Take the entries, parsing them first if the object is lazy.
+    pub fn into_entries(mut self) -> Vec<Entry> {
+        self.materialize();
+        self.entries
+    }
+
+    /// Append an entry, keeping any duplicate of its key.
+    pub fn push(&mut self, entry: Entry) {
+        self.materialize();
+        self.hash = SubtreeHash::default();
+        self.entries.push(entry);
+        self.index.pushed(&self.entries);
+    }
+
+    /// Parse a lazy object's entries now, so later reads do not have to.
+    /// Does nothing for other objects.
+    pub fn materialize(&mut self) {
+        if let Some(deferred) = self.deferred.take() {
+            let mut entries = deferred.into_entries();
+            entries.append(&mut self.entries);
+            self.entries = entries;
+            self.index = KeyIndex::default();
+        }
+    }
+
+    /// Find the position of the entry with the given key (for untagged scalar keys).
+    pub fn position(&self, key: &str) -> Option<usize> {
+        self.position_hashed(key, key_hash(key))
+    }
+
+    /// Like [`Object::position`], with the key's [`key_hash`](crate::key_hash)
+    /// computed by the caller.
+    pub fn position_hashed(&self, key: &str, hash: u64) -> Option<usize> {
+        let entries = self.entries();
+        match self.index.lookup(entries, key, hash) {
+            Some(found) => found,
+            None => entries.iter().position(|e| e.key.as_str() == Some(key)),
+        }
+    }
+
     /// Get entry value by key (for untagged scalar keys).
     pub fn get(&self, key: &str) -> Option<&Value> {
-        self.entries
-            .iter()
-            .find(|e| e.key.as_str() == Some(key))
-            .map(|e| &e.value)
+        self.position(key).map(|i| &self.entries()[i].value)
+    }
+
+    /// Like [`Object::get`], with the key's [`key_hash`](crate::key_hash)
+    /// computed by the caller.
+    pub fn get_hashed(&self, key: &str, hash: u64) -> Option<&Value> {
+        self.position_hashed(key, hash)
+            .map(|i| &self.entries()[i].value)
     }
 
     /// Get mutable entry value by key.
     pub fn get_mut(&mut self, key: &str) -> Option<&mut Value> {
-        self.entries
-            .iter_mut()
-            .find(|e| e.key.as_str() == Some(key))
-            .map(|e| &mut e.value)
+        self.materialize();
+        self.hash = SubtreeHash::default();
+        self.position(key).map(|i| &mut self.entries[i].value)
+    }
+
+    /// Build the key index now, regardless of object size.
+    ///
+    /// Useful before sharing a document across threads, so no reader pays for
+    /// the first lookup.
+    pub fn build_index(&self) {
+        self.index.build(self.entries());
+    }
+
+    /// Whether the key index has been built.
+    pub fn has_index(&self) -> bool {
+        self.index.is_built()
+    }
+
+    /// Whether the key index is built and found no key in two entries.
+    pub(crate) fn keys_are_unique(&self) -> bool {
+        self.index.keys_are_unique()
+    }
+
+    /// Drop the key index and cached hash. They are dropped automatically
+    /// whenever the entries may change; this only frees the memory.
+    pub fn invalidate_index(&mut self) {
+        self.index = KeyIndex::default();
+        self.hash = SubtreeHash::default();
+    }
+
+    /// Structural hash of the object's entries, ignoring spans and doc
+    /// comments.
+    ///
+    /// Objects built by [`TreeBuilder`](crate::TreeBuilder) have it computed
+    /// already; otherwise it is computed on first use and cached. Equal
+    /// objects have equal hashes.
+    pub fn subtree_hash(&self) -> u64 {
+        self.hash.get(self)
     }
 
     /// Get entry by unit key (`@`).
     pub fn get_unit(&self) -> Option<&Value> {
-        self.entries
+        self.entries()
             .iter()
             .find(|e| e.key.is_unit())
             .map(|e| &e.value)
@@ -354,6 +534,8 @@ impl Object {
 
     /// Get mutable entry by unit key.
     pub fn get_unit_mut(&mut self) -> Option<&mut Value> {
+        self.materialize();
+        self.hash = SubtreeHash::default();
         self.entries
             .iter_mut()
             .find(|e| e.key.is_unit())
@@ -362,49 +544,50 @@ impl Object {
 
     /// Iterate over entries as (key, value) pairs.
     pub fn iter(&self) -> impl Iterator<Item = (&Value, &Value)> {
-        self.entries.iter().map(|e| (&e.key, &e.value))
+        self.entries().iter().map(|e| (&e.key, &e.value))
     }
 
     /// Check if key exists.
     pub fn contains_key(&self, key: &str) -> bool {
-        self.entries.iter().any(|e| e.key.as_str() == Some(key))
+        self.position(key).is_some()
     }
 
     /// Check if unit key exists.
     pub fn contains_unit_key(&self) -> bool {
-        self.entries.iter().any(|e| e.key.is_unit())
+        self.entries().iter().any(|e| e.key.is_unit())
     }
 
     /// Number of entries.
     pub fn len(&self) -> usize {
-        self.entries.len()
+        self.entries().len()
     }
 
     /// Check if empty.
     pub fn is_empty(&self) -> bool {
-        self.entries.is_empty()
+        self.entries().is_empty()
     }
 
     /// Insert or update an entry with a string key.
     pub fn insert(&mut self, key: impl Into<String>, value: Value) {
+        self.materialize();
+        self.hash = SubtreeHash::default();
         let key_str = key.into();
-        if let Some(entry) = self
-            .entries
-            .iter_mut()
-            .find(|e| e.key.as_str() == Some(&key_str))
-        {
-            entry.value = value;
+        if let Some(i) = self.position(&key_str) {
+            self.entries[i].value = value;
         } else {
             self.entries.push(Entry {
                 key: Value::scalar(key_str),
                 value,
                 doc_comment: None,
             });
+            self.index.pushed(&self.entries);
         }
     }
 
     /// Insert or update an entry with a unit key.
     pub fn insert_unit(&mut self, value: Value) {
+        self.materialize();
+        self.hash = SubtreeHash::default();
         if let Some(entry) = self.entries.iter_mut().find(|e| e.key.is_unit()) {
             entry.value = value;
         } else {
@@ -413,6 +596,7 @@ impl Object {
                 value,
                 doc_comment: None,
             });
+            self.index.pushed(&self.entries);
         }
     }
 }
@@ -450,7 +634,7 @@ impl Sequence {
 }
 
 /// Split path at first `.` or `[`.
-fn split_path(path: &str) -> (&str, &str) {
+pub(crate) fn split_path(path: &str) -> (&str, &str) {
     // Handle [n] at start
     if path.starts_with('[')
         && let Some(end) = path.find(']')
@@ -515,15 +699,14 @@ mod tests {
 
     #[test]
     fn test_object_get() {
-        let mut obj = Object {
-            entries: vec![Entry {
+        let mut obj = Object::new(
+            vec![Entry {
                 key: Value::scalar("name"),
                 value: Value::scalar("Alice"),
                 doc_comment: None,
             }],
-
-            span: None,
-        };
+            None,
+        );
 
         assert_eq!(obj.get("name").and_then(|v| v.as_str()), Some("Alice"));
         assert_eq!(obj.get("missing"), None);
@@ -534,11 +717,7 @@ mod tests {
 
     #[test]
     fn test_object_unit_key() {
-        let mut obj = Object {
-            entries: vec![],
-
-            span: None,
-        };
+        let mut obj = Object::new(vec![], None);
 
         obj.insert_unit(Value::scalar("root"));
         assert!(obj.contains_unit_key());
@@ -549,21 +728,20 @@ mod tests {
     fn test_value_path_access() {
         let value = Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: vec![
+            payload: Some(Payload::Object(Object::new(
+                vec![
                     Entry {
                         key: Value::scalar("user"),
                         value: Value {
                             tag: None,
-                            payload: Some(Payload::Object(Object {
-                                entries: vec![Entry {
+                            payload: Some(Payload::Object(Object::new(
+                                vec![Entry {
                                     key: Value::scalar("name"),
                                     value: Value::scalar("Alice"),
                                     doc_comment: None,
                                 }],
-
-                                span: None,
-                            })),
+                                None,
+                            ))),
                             span: None,
                         },
                         doc_comment: None,
@@ -585,9 +763,8 @@ mod tests {
                         doc_comment: None,
                     },
                 ],
-
-                span: None,
-            })),
+                None,
+            ))),
             span: None,
         };
 
@@ -607,8 +784,8 @@ mod tests {
         // Build a complicated Value
         let value = Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: vec![
+            payload: Some(Payload::Object(Object::new(
+                vec![
                     // Schema declaration
                     Entry {
                         key: Value::tag("schema"),
@@ -632,8 +809,8 @@ mod tests {
                         key: Value::scalar("server"),
                         value: Value {
                             tag: None,
-                            payload: Some(Payload::Object(Object {
-                                entries: vec![
+                            payload: Some(Payload::Object(Object::new(
+                                vec![
                                     Entry {
                                         key: Value::scalar("host"),
                                         value: Value::scalar("localhost"),
@@ -646,8 +823,8 @@ mod tests {
                                                 name: "object".to_string(),
                                                 span: None,
                                             }),
-                                            payload: Some(Payload::Object(Object {
-                                                entries: vec![
+                                            payload: Some(Payload::Object(Object::new(
+                                                vec![
                                                     Entry {
                                                         key: Value::scalar("cert"),
                                                         value: Value::scalar("/path/to/cert.pem"),
@@ -659,17 +836,15 @@ mod tests {
                                                         doc_comment: None,
                                                     },
                                                 ],
-
-                                                span: None,
-                                            })),
+                                                None,
+                                            ))),
                                             span: None,
                                         },
                                         doc_comment: Some("TLS configuration".to_string()),
                                     },
                                 ],
-
-                                span: None,
-                            })),
+                                None,
+                            ))),
                             span: None,
                         },
                         doc_comment: Some("Server settings".to_string()),
@@ -698,9 +873,8 @@ mod tests {
                         doc_comment: None,
                     },
                 ],
-
-                span: Some(Span::new(0, 100)),
-            })),
+                Some(Span::new(0, 100)),
+            ))),
             span: Some(Span::new(0, 100)),
         };
 
@@ -733,8 +907,8 @@ mod tests {
         // Nested object (recursive structure)
         let v = Value {
             tag: None,
-            payload: Some(Payload::Object(Object {
-                entries: vec![
+            payload: Some(Payload::Object(Object::new(
+                vec![
                     Entry {
                         key: Value::scalar("name"),
                         value: Value::scalar("Alice"),
@@ -744,23 +918,21 @@ mod tests {
                         key: Value::scalar("nested"),
                         value: Value {
                             tag: None,
-                            payload: Some(Payload::Object(Object {
-                                entries: vec![Entry {
+                            payload: Some(Payload::Object(Object::new(
+                                vec![Entry {
                                     key: Value::scalar("inner"),
                                     value: Value::scalar("value"),
                                     doc_comment: None,
                                 }],
-
-                                span: None,
-                            })),
+                                None,
+                            ))),
                             span: None,
                         },
                         doc_comment: Some("A nested object".to_string()),
                     },
                 ],
-
-                span: None,
-            })),
+                None,
+            ))),
             span: None,
         };
         let bytes = facet_postcard::to_vec(&v).expect("serialize nested");
@@ -6,7 +6,7 @@
 
 use serde::Serialize;
 use serde_json::json;
-use styx_parse::ScalarKind;
+use styx_parse::{ParserBuffers, ScalarKind};
 use styx_tree::{Entry, Object, Payload, Scalar, Sequence, Tag, Value};
 use wasm_bindgen::prelude::*;
 
@@ -43,7 +43,34 @@ pub struct ParseResult {
 /// Returns a JSON object with `success` boolean and `diagnostics` array.
 #[wasm_bindgen]
 pub fn parse(source: &str) -> JsValue {
-    let mut parser = styx_parse::Parser::new(source);
+    let result = diagnose(&mut styx_parse::Parser::new(source));
+    to_js_value(&result).unwrap_or(JsValue::NULL)
+}
+
+/// Parse many Styx documents in one call and return their diagnostics.
+///
+/// Returns an array holding, for each source in order, the object [`parse`]
+/// would return for it. The batch crosses between JavaScript and WebAssembly
+/// once rather than once per document, and the parser's buffers are reused
+/// from one document to the next. Documents are parsed one after another:
+/// the `wasm32-unknown-unknown` target has no threads.
+#[wasm_bindgen]
+pub fn parse_batch(sources: Vec<String>) -> JsValue {
+    let mut buffers = ParserBuffers::default();
+    let results: Vec<ParseResult> = sources
+        .iter()
+        .map(|source| {
+            let mut parser = styx_parse::Parser::with_buffers(source, std::mem::take(&mut buffers));
+            let result = diagnose(&mut parser);
+            buffers = parser.into_buffers();
+            result
+        })
+        .collect();
+    to_js_value(&results).unwrap_or(JsValue::NULL)
+}
+
+/// Run `parser` to the end, collecting its errors as diagnostics.
+fn diagnose(parser: &mut styx_parse::Parser<'_>) -> ParseResult {
     let mut diagnostics = Vec::new();
 
     while let Some(event) = parser.next_event() {
@@ -61,12 +88,10 @@ pub fn parse(source: &str) -> JsValue {
         }
     }
 
-    let result = ParseResult {
+    ParseResult {
         success: diagnostics.is_empty(),
         diagnostics,
-    };
-
-    to_js_value(&result).unwrap_or(JsValue::NULL)
+    }
 }
 
 /// Convert a Styx document to JSON.
@@ -148,7 +173,7 @@ fn sequence_to_json(seq: &Sequence) -> serde_json::Value {
 fn object_to_json(obj: &Object) -> serde_json::Value {
     let mut map = serde_json::Map::new();
 
-    for entry in &obj.entries {
+    for entry in obj.entries() {
         // Get key as string
         let key = if entry.key.is_unit() {
             "@".to_string()
@@ -337,10 +362,7 @@ fn json_to_value(json: &serde_json::Value) -> Value {
 
             Value {
                 tag: None,
-                payload: Some(Payload::Object(Object {
-                    entries,
-                    span: None,
-                })),
+                payload: Some(Payload::Object(Object::new(entries, None))),
                 span: None,
             }
         }
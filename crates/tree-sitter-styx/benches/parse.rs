@@ -0,0 +1,113 @@
+//! Tree-sitter parse latency on documents dominated by embedded text.
+//!
+//! Run with `cargo bench -p tree-sitter-styx`. `parse` is a parse from
+//! scratch. `reparse` types one character in the middle of the embedded text,
+//! applies the edit to the previous tree and reparses incrementally, then
+//! collects the changed ranges: the work an editor does after a keystroke
+//! before it can re-highlight.
+
+use std::hint::black_box;
+
+use criterion::{BatchSize, BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use styx_testhelpers::{BenchInput, heredoc_heavy, large_heredoc, raw_string_heavy};
+use tree_sitter::{InputEdit, Parser, Point};
+
+/// The inputs, each with a word that only occurs in its embedded text.
+fn inputs() -> Vec<(BenchInput, &'static str)> {
+    vec![
+        (
+            BenchInput {
+                name: "large_heredoc",
+                source: large_heredoc(20_000),
+            },
+            "INSERT",
+        ),
+        (
+            BenchInput {
+                name: "heredoc_heavy",
+                source: heredoc_heavy(2_000),
+            },
+            "echo",
+        ),
+        (
+            BenchInput {
+                name: "raw_string_heavy",
+                source: raw_string_heavy(2_000),
+            },
+            "match",
+        ),
+    ]
+}
+
+fn parser() -> Parser {
+    let mut parser = Parser::new();
+    parser
+        .set_language(&tree_sitter_styx::language())
+        .expect("Error loading Styx grammar");
+    parser
+}
+
+/// The row and column of byte `offset`.
+fn point(source: &str, offset: usize) -> Point {
+    let before = &source[..offset];
+    Point {
+        row: before.matches('\n').count(),
+        column: offset - before.rfind('\n').map_or(0, |i| i + 1),
+    }
+}
+
+fn parse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("parse");
+    let mut parser = parser();
+    for (input, _) in inputs() {
+        group.throughput(Throughput::Bytes(input.source.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(input.name),
+            &input.source,
+            |b, source| b.iter(|| parser.parse(black_box(source), None).unwrap()),
+        );
+    }
+    group.finish();
+}
+
+fn reparse(c: &mut Criterion) {
+    let mut group = c.benchmark_group("reparse");
+    let mut parser = parser();
+    for (input, word) in inputs() {
+        let tree = parser.parse(&input.source, None).unwrap();
+        let middle = input.source.len() / 2;
+        let at = middle + input.source[middle..].find(word).unwrap();
+        let mut edited = input.source.clone();
+        edited.insert(at, 'x');
+        let start = point(&input.source, at);
+        let edit = InputEdit {
+            start_byte: at,
+            old_end_byte: at,
+            new_end_byte: at + 1,
+            start_position: start,
+            old_end_position: start,
+            new_end_position: Point {
+                row: start.row,
+                column: start.column + 1,
+            },
+        };
+        group.bench_function(BenchmarkId::from_parameter(input.name), |b| {
+            b.iter_batched(
+                || {
+                    let mut old = tree.clone();
+                    old.edit(&edit);
+                    old
+                },
+                |old| {
+                    let new = parser.parse(black_box(&edited), Some(&old)).unwrap();
+                    old.changed_ranges(&new).count()
+                },
+                BatchSize::SmallInput,
+            )
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, parse, reparse);
+criterion_main!(benches);
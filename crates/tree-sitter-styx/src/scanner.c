@@ -30,6 +30,11 @@ enum TokenType {
 // Maximum # count for raw strings
 #define MAX_HASH_COUNT 255
 
+// Flags in the first byte of the serialized state
+#define STATE_HEREDOC 0x1
+#define STATE_HEREDOC_LANG_CHECK 0x2
+#define STATE_RAW_STRING 0x4
+
 typedef struct {
   // For heredocs: the delimiter string
   char heredoc_delimiter[MAX_DELIMITER_LEN + 1];
@@ -46,6 +51,15 @@ static inline void advance(TSLexer *lexer) { lexer->advance(lexer, false); }
 
 static inline void skip(TSLexer *lexer) { lexer->advance(lexer, true); }
 
+// EOF reads as a zero lookahead, so only ask the lexer when we see one
+static inline bool at_eof(TSLexer *lexer) {
+  return lexer->lookahead == 0 && lexer->eof(lexer);
+}
+
+static inline bool at_line_end(TSLexer *lexer) {
+  return lexer->lookahead == '\n' || lexer->lookahead == '\r' || at_eof(lexer);
+}
+
 // Check if character is valid for heredoc delimiter start: [A-Z]
 static inline bool is_delimiter_start(int32_t c) {
   return c >= 'A' && c <= 'Z';
@@ -79,19 +93,27 @@ static inline bool is_tag_name_char(int32_t c) {
 }
 
 // Serialize scanner state
+//
+// Tree-sitter stores this after every token and only reuses subtrees whose
+// state matches, so outside heredocs and raw strings the state is empty:
+// the delimiter and # count are only meaningful inside one.
 unsigned tree_sitter_styx_external_scanner_serialize(void *payload,
                                                       char *buffer) {
   Scanner *scanner = (Scanner *)payload;
   unsigned i = 0;
 
-  buffer[i++] = scanner->in_heredoc;
-  buffer[i++] = scanner->heredoc_needs_lang_check;
-  buffer[i++] = scanner->heredoc_delimiter_len;
-  for (uint8_t j = 0; j < scanner->heredoc_delimiter_len; j++) {
-    buffer[i++] = scanner->heredoc_delimiter[j];
+  if (scanner->in_heredoc) {
+    buffer[i++] = STATE_HEREDOC | (scanner->heredoc_needs_lang_check
+                                       ? STATE_HEREDOC_LANG_CHECK
+                                       : 0);
+    buffer[i++] = scanner->heredoc_delimiter_len;
+    memcpy(&buffer[i], scanner->heredoc_delimiter,
+           scanner->heredoc_delimiter_len);
+    i += scanner->heredoc_delimiter_len;
+  } else if (scanner->in_raw_string) {
+    buffer[i++] = STATE_RAW_STRING;
+    buffer[i++] = scanner->raw_string_hash_count;
   }
-  buffer[i++] = scanner->in_raw_string;
-  buffer[i++] = scanner->raw_string_hash_count;
 
   return i;
 }
@@ -108,26 +130,23 @@ void tree_sitter_styx_external_scanner_deserialize(void *payload,
   scanner->in_raw_string = false;
   scanner->raw_string_hash_count = 0;
 
-  if (length > 0) {
-    unsigned i = 0;
-    scanner->in_heredoc = buffer[i++];
-    if (i < length) {
-      scanner->heredoc_needs_lang_check = buffer[i++];
-    }
-    if (i < length) {
-      scanner->heredoc_delimiter_len = buffer[i++];
-      for (uint8_t j = 0; j < scanner->heredoc_delimiter_len && i < length;
-           j++) {
-        scanner->heredoc_delimiter[j] = buffer[i++];
-      }
-      scanner->heredoc_delimiter[scanner->heredoc_delimiter_len] = '\0';
-    }
-    if (i < length) {
-      scanner->in_raw_string = buffer[i++];
-    }
-    if (i < length) {
-      scanner->raw_string_hash_count = buffer[i++];
+  if (length < 2) {
+    return;
+  }
+  uint8_t flags = (uint8_t)buffer[0];
+  if (flags & STATE_HEREDOC) {
+    uint8_t len = (uint8_t)buffer[1];
+    if (len > MAX_DELIMITER_LEN || len > length - 2) {
+      return;
     }
+    scanner->in_heredoc = true;
+    scanner->heredoc_needs_lang_check = flags & STATE_HEREDOC_LANG_CHECK;
+    scanner->heredoc_delimiter_len = len;
+    memcpy(scanner->heredoc_delimiter, &buffer[2], len);
+    scanner->heredoc_delimiter[len] = '\0';
+  } else if (flags & STATE_RAW_STRING) {
+    scanner->in_raw_string = true;
+    scanner->raw_string_hash_count = (uint8_t)buffer[1];
   }
 }
 
@@ -246,9 +265,11 @@ static bool scan_heredoc_content_or_end(Scanner *scanner, TSLexer *lexer) {
       advance(lexer);
     }
 
-    // Check if we're at the delimiter
-    bool at_delimiter = true;
-    for (uint8_t i = 0; i < scanner->heredoc_delimiter_len; i++) {
+    // Check if we're at the delimiter. Most lines fail on the first
+    // character and go straight to the scan for the newline below.
+    bool at_delimiter = lexer->lookahead == scanner->heredoc_delimiter[0];
+    for (uint8_t i = 0; at_delimiter && i < scanner->heredoc_delimiter_len;
+         i++) {
       if (lexer->lookahead != scanner->heredoc_delimiter[i]) {
         at_delimiter = false;
         break;
@@ -258,8 +279,7 @@ static bool scan_heredoc_content_or_end(Scanner *scanner, TSLexer *lexer) {
 
     if (at_delimiter) {
       // Check that delimiter is followed by newline or EOF
-      if (lexer->lookahead == '\n' || lexer->lookahead == '\r' ||
-          lexer->eof(lexer)) {
+      if (at_line_end(lexer)) {
         // This is the end delimiter
         if (has_content) {
           // Return the content first, we'll get the end on next call
@@ -276,8 +296,7 @@ static bool scan_heredoc_content_or_end(Scanner *scanner, TSLexer *lexer) {
 
     // Not at delimiter, consume this line as content
     has_content = true;
-    while (lexer->lookahead != '\n' && lexer->lookahead != '\r' &&
-           !lexer->eof(lexer)) {
+    while (!at_line_end(lexer)) {
       advance(lexer);
     }
 
@@ -287,7 +306,7 @@ static bool scan_heredoc_content_or_end(Scanner *scanner, TSLexer *lexer) {
     if (lexer->lookahead == '\n')
       advance(lexer);
 
-    if (lexer->eof(lexer)) {
+    if (at_eof(lexer)) {
       // Unterminated heredoc - return what we have
       lexer->mark_end(lexer);
       return has_content;
@@ -331,7 +350,13 @@ static bool scan_raw_string_content_or_end(Scanner *scanner, TSLexer *lexer) {
   lexer->result_symbol = RAW_STRING_CONTENT;
 
   while (true) {
-    if (lexer->eof(lexer)) {
+    // Everything up to the next quote is content
+    while (lexer->lookahead != '"' && !at_eof(lexer)) {
+      has_content = true;
+      advance(lexer);
+    }
+
+    if (at_eof(lexer)) {
       // Unterminated raw string
       if (has_content) {
         lexer->mark_end(lexer);
@@ -369,9 +394,6 @@ static bool scan_raw_string_content_or_end(Scanner *scanner, TSLexer *lexer) {
       // Not the end, the " and any # are part of content
       has_content = true;
       // Continue from current position (after the #s we consumed)
-    } else {
-      has_content = true;
-      advance(lexer);
     }
   }
 }